@@ -7,9 +7,6 @@
 #include <string.h>
 #include <stdio.h>
 
-/* 前向声明 */
-static int bignum_compare_local(const BHS *a, const BHS *b);
-
 /* 辅助函数：复制字符串 */
 static char* ast_strdup(const char *str) {
     if (!str) return NULL;
@@ -537,6 +534,13 @@ void ast_destroy(ASTNode *node) {
         case AST_IMPORT:
             free(node->data.import_stmt.package_name);
             break;
+        
+        case AST_BITMAP_SET:
+        case AST_BITMAP_GET:
+        case AST_BITMAP_COUNT:
+        case AST_BITMAP_FLIP:
+            free(node->data.bitmap_op.operation);
+            break;
     }
     
     free(node);
@@ -640,7 +644,7 @@ int ast_execute(ASTNode *node, void *ctx, void *func_registry, void *pkg_manager
             
             while (1) {
                 /* 检查循环条件 */
-                int cmp = bignum_compare_local(&current, &end_val);
+                int cmp = bignum_compare(&current, &end_val);
                 if (cmp >= 0) break;  /* current >= end */
                 
                 /* 设置循环变量 */
@@ -655,15 +659,15 @@ int ast_execute(ASTNode *node, void *ctx, void *func_registry, void *pkg_manager
                     break;
                 }
                 
-                /* 增加步长 */
+                /* 增加步长（结果直接移交给 current，省去一次复制） */
                 BHS *next = bignum_add(&current, &step_val);
                 if (!next) {
                     ret = EVAL_ERROR;
                     break;
                 }
                 bignum_free(&current);
-                bignum_copy(next, &current);
-                bignum_destroy(next);
+                current = *next;
+                free(next);
             }
             
             bignum_free(&start_val);
@@ -768,42 +772,3 @@ int ast_execute(ASTNode *node, void *ctx, void *func_registry, void *pkg_manager
             return EVAL_ERROR;
     }
 }
-
-/* 辅助函数：比较两个大数（需要在这里实现，因为evaluator.c中的是静态函数） */
-static int bignum_compare_local(const BHS *a, const BHS *b) {
-    if (a == NULL || b == NULL) return 0;
-    
-    /* 处理符号 */
-    if (a->type_data.num.is_negative && !b->type_data.num.is_negative) return -1;  /* 负数 < 正数 */
-    if (!a->type_data.num.is_negative && b->type_data.num.is_negative) return 1;   /* 正数 > 负数 */
-    
-    /* 同号情况 */
-    /* 先比较整数部分长度 */
-    int a_int_len = a->length - a->type_data.num.decimal_pos;
-    int b_int_len = b->length - b->type_data.num.decimal_pos;
-    
-    int sign_multiplier = a->type_data.num.is_negative ? -1 : 1;
-    
-    if (a_int_len > b_int_len) return 1 * sign_multiplier;
-    if (a_int_len < b_int_len) return -1 * sign_multiplier;
-    
-    char *a_digits = BIGNUM_DIGITS(a);
-    char *b_digits = BIGNUM_DIGITS(b);
-    
-    /* 从高位到低位比较 */
-    for (int i = a->length - 1; i >= 0; i--) {
-        int b_idx = i - a->type_data.num.decimal_pos + b->type_data.num.decimal_pos;
-        int b_digit = (b_idx >= 0 && b_idx < b->length) ? b_digits[b_idx] : 0;
-        int a_digit = a_digits[i];
-        
-        if (a_digit > b_digit) return 1 * sign_multiplier;
-        if (a_digit < b_digit) return -1 * sign_multiplier;
-    }
-    
-    /* 检查b是否有更多的小数位 */
-    for (int i = a->type_data.num.decimal_pos; i < b->type_data.num.decimal_pos; i++) {
-        if (i < b->length && b_digits[i] != 0) return -1 * sign_multiplier;
-    }
-    
-    return 0;
-}
@@ -8,9 +8,15 @@
 #include "builtin.h"
 #include "lib/list.h"
 #include "lib/bitmap.h"
+#include "lib/hll.h"
+#include "lib/filter.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
+#ifndef LOGEX_BUILD
+#include "lib/env.h"
+#endif
 
 /* ========== LIST 操作函数 ========== */
 
@@ -39,7 +45,7 @@ static int builtin_lpush(const BHS *args, int arg_count, BHS *result, int precis
     /* 复制列表 */
     if (bignum_copy(&args[0], result) != 0) return -1;
     
-    LIST *list = bignum_get_list(result);
+    LIST *list = bignum_get_list_mutable(result);
     if (!list) return -1;
     
     /* 创建元素副本 */
@@ -69,7 +75,7 @@ static int builtin_rpush(const BHS *args, int arg_count, BHS *result, int precis
     
     if (bignum_copy(&args[0], result) != 0) return -1;
     
-    LIST *list = bignum_get_list(result);
+    LIST *list = bignum_get_list_mutable(result);
     if (!list) return -1;
     
     BHS *element = bignum_create();
@@ -88,52 +94,92 @@ static int builtin_rpush(const BHS *args, int arg_count, BHS *result, int precis
     return 0;
 }
 
-/* lpop(list) - 左侧弹出 */
-static int builtin_lpop(const BHS *args, int arg_count, BHS *result, int precision) {
+/*
+ * lpop/rpop：参数按值传递，不能修改 args[0]。弹出作用在自己持有的副本上：
+ * 副本与参数共享块，弹出时只复制一端的块，返回弹出的元素后释放副本
+ */
+static int builtin_pop(const BHS *args, int arg_count, BHS *result, int precision, int left) {
     (void)precision;
     
     if (arg_count != 1) return -1;
     if (!bignum_is_list(&args[0])) return -1;
     
-    LIST *list = bignum_get_list((BHS*)&args[0]);
-    if (!list || list_size(list) == 0) return -1;
-    
-    Obj obj = list_lpop(list);
-    if ((intptr_t)obj == -1) return -1;
-    
-    BHS *value = (BHS*)obj;
-    int ret = bignum_copy(value, result);
-    bignum_destroy(value);
+    BHS owned;
+    bignum_init(&owned);
+    if (bignum_copy(&args[0], &owned) != 0) return -1;
+    
+    int ret = -1;
+    LIST *list = bignum_get_list_mutable(&owned);
+    if (list && list_size(list) > 0) {
+        Obj obj = left ? list_lpop(list) : list_rpop(list);
+        if ((intptr_t)obj != -1) {
+            BHS *value = (BHS*)obj;
+            ret = bignum_copy(value, result);
+            bignum_destroy(value);
+        }
+    }
     
+    bignum_free(&owned);
     return ret;
 }
 
-/* rpop(list) - 右侧弹出 */
+/* lpop(list) - 左侧弹出，返回弹出的元素 */
+static int builtin_lpop(const BHS *args, int arg_count, BHS *result, int precision) {
+    return builtin_pop(args, arg_count, result, precision, 1);
+}
+
+/* rpop(list) - 右侧弹出，返回弹出的元素 */
 static int builtin_rpop(const BHS *args, int arg_count, BHS *result, int precision) {
-    (void)precision;
-    
-    if (arg_count != 1) return -1;
-    if (!bignum_is_list(&args[0])) return -1;
+    return builtin_pop(args, arg_count, result, precision, 0);
+}
+
+/* 把 [st, ed] 中的元素按顺序复制到新列表，按块成段遍历，不逐个定位 */
+static int builtin_lget_range(const BHS *args, BHS *result) {
+    if (!bignum_is_number(&args[2])) return -1;
     
-    LIST *list = bignum_get_list((BHS*)&args[0]);
-    if (!list || list_size(list) == 0) return -1;
+    char st_str[64], ed_str[64];
+    if (bignum_to_string(&args[1], st_str, sizeof(st_str), 0) != 0) return -1;
+    if (bignum_to_string(&args[2], ed_str, sizeof(ed_str), 0) != 0) return -1;
     
-    Obj obj = list_rpop(list);
-    if ((intptr_t)obj == -1) return -1;
+    size_t st = (size_t)strtoull(st_str, NULL, 10);
+    size_t ed = (size_t)strtoull(ed_str, NULL, 10);
     
-    BHS *value = (BHS*)obj;
-    int ret = bignum_copy(value, result);
-    bignum_destroy(value);
+    LIST *list = bignum_get_list((BHS*)&args[0]);
+    BHS *list_num = bignum_create_list();
+    if (!list || !list_num) {
+        bignum_destroy(list_num);
+        return -1;
+    }
     
-    return ret;
+    LIST *out = bignum_get_list_mutable(list_num);
+    ListIter it;
+    Obj *span;
+    size_t n;
+    int ret = out ? 0 : -1;
+    size_t end = ed < list_size(list) ? ed + 1 : list_size(list);
+    if (ret == 0) ret = list_iter_range(list, st, end, &it);
+    while (ret == 0 && (n = list_iter_next(&it, &span)) > 0) {
+        for (size_t i = 0; i < n && ret == 0; i++) {
+            BHS *element = bignum_create();
+            if (!element || bignum_copy((BHS*)span[it.reversed ? n - 1 - i : i], element) != 0 ||
+                list_rpush(out, (Obj)element) != 0) {
+                bignum_destroy(element);
+                ret = -1;
+            }
+        }
+    }
+    if (ret == 0) ret = bignum_copy(list_num, result);
+    bignum_destroy(list_num);
+    return ret == 0 ? 0 : -1;
 }
 
-/* lget(list, index) - 获取元素 */
+/* lget(list, index) - 获取元素；lget(list, st, ed) - 取出 [st, ed] 中的元素 */
 static int builtin_lget(const BHS *args, int arg_count, BHS *result, int precision) {
     (void)precision;
     
-    if (arg_count != 2) return -1;
+    if (arg_count != 2 && arg_count != 3) return -1;
     if (!bignum_is_list(&args[0]) || !bignum_is_number(&args[1])) return -1;
+    if (arg_count == 3) return builtin_lget_range(args, result);
     
     LIST *list = bignum_get_list((BHS*)&args[0]);
     if (!list) return -1;
@@ -167,6 +213,250 @@ static int builtin_llen(const BHS *args, int arg_count, BHS *result, int precisi
     return bignum_from_string_legacy(size_str, result);
 }
 
+/* 排序比较：数字按大小，字符串按字节序，不同类型按类型编号（数字在字符串之前） */
+static int builtin_list_cmp(Obj a, Obj b) {
+    const BHS *x = (const BHS *)a;
+    const BHS *y = (const BHS *)b;
+    if (x->type != y->type) return x->type < y->type ? -1 : 1;
+    if (bignum_is_number(x)) return bignum_compare(x, y);
+    if (bignum_is_string(x)) {
+        size_t n = x->length < y->length ? x->length : y->length;
+        int c = memcmp(BIGNUM_DIGITS(x), BIGNUM_DIGITS(y), n);
+        if (c != 0) return c;
+        return (x->length > y->length) - (x->length < y->length);
+    }
+    return 0;
+}
+
+static int builtin_hash_value(const BHS *value, int exact, uint64_t *hash);
+
+/* 去重用的哈希：builtin_list_eq 相等的值哈希也相同，不会失败 */
+static uint64_t builtin_list_hash(Obj value) {
+    uint64_t hash = 0;
+    builtin_hash_value((const BHS *)value, 0, &hash);
+    return hash;
+}
+
+/* 两个位图的长度和每一位都相同（与编码无关） */
+static int builtin_bitmap_eq(const BHS *x, const BHS *y) {
+    if (x->length != y->length) return 0;
+    if (!BITMAP_IS_ROARING(x) && !BITMAP_IS_ROARING(y)) {
+        const unsigned char *xd = (const unsigned char *)BIGNUM_DIGITS(x);
+        const unsigned char *yd = (const unsigned char *)BIGNUM_DIGITS(y);
+        size_t full = x->length / 8;
+        if (memcmp(xd, yd, full) != 0) return 0;
+        unsigned char mask = (unsigned char)((1u << (x->length % 8)) - 1);
+        return mask == 0 || ((xd[full] ^ yd[full]) & mask) == 0;
+    }
+    
+    /* 有压缩编码时成批取出为 1 的位置逐批比较 */
+    uint64_t xs[BITMAP_ITER_BATCH], ys[BITMAP_ITER_BATCH];
+    uint64_t xc = 0, yc = 0;
+    for (;;) {
+        int64_t xn = bitmap_extract_set(x, &xc, UINT64_MAX, xs, BITMAP_ITER_BATCH);
+        int64_t yn = bitmap_extract_set(y, &yc, UINT64_MAX, ys, BITMAP_ITER_BATCH);
+        if (xn < 0 || xn != yn) return 0;
+        if (xn == 0) return 1;
+        if (memcmp(xs, ys, (size_t)xn * sizeof(uint64_t)) != 0) return 0;
+    }
+}
+
+static int builtin_list_eq(Obj a, Obj b);
+
+/* 两个列表的长度和每个元素都相等 */
+static int builtin_lists_eq(const LIST *x, const LIST *y) {
+    if (x == y) return 1;
+    if (!x || !y) return list_size(x ? x : y) == 0;
+    if (list_size(x) != list_size(y)) return 0;
+    
+    /* 两个迭代器同步前进，两边的分段位置不一定相同 */
+    ListIter ix, iy;
+    Obj *sx = NULL, *sy = NULL;
+    size_t nx = 0, ny = 0, i = 0, j = 0;
+    if (list_iter_range(x, 0, list_size(x), &ix) != 0) return 0;
+    if (list_iter_range(y, 0, list_size(y), &iy) != 0) return 0;
+    while (1) {
+        if (i == nx) {
+            if ((nx = list_iter_next(&ix, &sx)) == 0) return 1;
+            i = 0;
+        }
+        if (j == ny) {
+            if ((ny = list_iter_next(&iy, &sy)) == 0) return 0;
+            j = 0;
+        }
+        for (; i < nx && j < ny; i++, j++) {
+            Obj a = sx[ix.reversed ? nx - 1 - i : i];
+            Obj b = sy[iy.reversed ? ny - 1 - j : j];
+            if (!builtin_list_eq(a, b)) return 0;
+        }
+    }
+}
+
+/*
+ * 按结构比较：数字按大小，字符串按字节，位图按长度和各位，列表逐个元素比较，
+ * HLL 按寄存器，过滤器按数组内容；其他类型只有同一个对象才相等
+ */
+static int builtin_list_eq(Obj a, Obj b) {
+    const BHS *x = (const BHS *)a;
+    const BHS *y = (const BHS *)b;
+    if (x->type != y->type) return 0;
+    if (bignum_is_number(x)) return bignum_compare(x, y) == 0;
+    if (bignum_is_string(x)) {
+        return x->length == y->length && memcmp(BIGNUM_DIGITS(x), BIGNUM_DIGITS(y), x->length) == 0;
+    }
+    if (bignum_is_bitmap(x)) return builtin_bitmap_eq(x, y);
+    if (bignum_is_list(x)) return builtin_lists_eq((const LIST *)bignum_get_list(x), (const LIST *)bignum_get_list(y));
+    if (check_if_hll(x)) return hll_equal(x, y);
+    if (check_if_filter(x)) return filter_equal(x, y);
+    return x == y;
+}
+
+/* 排序线程数：Mhuixs 中为线程池大小 Env.threadslimit，Logex 中为在线 CPU 数 */
+static int builtin_sort_threads(void) {
+#ifdef LOGEX_BUILD
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return Env.threadslimit;
+#endif
+}
+
+/* lsort(list[, order]) - 稳定排序，order 为 "desc" 或非 0 数字时降序 */
+static int builtin_lsort(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (!bignum_is_list(&args[0])) return -1;
+    
+    int desc = 0;
+    if (arg_count == 2) {
+        if (bignum_is_string(&args[1])) {
+            const char *order = BIGNUM_DIGITS(&args[1]);
+            if (args[1].length == 4 && (memcmp(order, "desc", 4) == 0 || memcmp(order, "DESC", 4) == 0)) desc = 1;
+            else if (!(args[1].length == 3 && (memcmp(order, "asc", 3) == 0 || memcmp(order, "ASC", 3) == 0))) return -1;
+        } else if (bignum_is_number(&args[1])) {
+            char order_str[64];
+            if (bignum_to_string(&args[1], order_str, sizeof(order_str), 0) != 0) return -1;
+            desc = atoi(order_str) != 0;
+        } else {
+            return -1;
+        }
+    }
+    
+    if (bignum_copy(&args[0], result) != 0) return -1;
+    
+    LIST *list = bignum_get_list_mutable(result);
+    if (!list) return -1;
+    
+    return list_sort(list, builtin_list_cmp, desc, builtin_sort_threads());
+}
+
+/* lunique(list) - 去重，保留每个值第一次出现的位置 */
+static int builtin_lunique(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 1) return -1;
+    if (!bignum_is_list(&args[0])) return -1;
+    
+    if (bignum_copy(&args[0], result) != 0) return -1;
+    
+    LIST *list = bignum_get_list_mutable(result);
+    if (!list) return -1;
+    
+    return list_unique(list, builtin_list_hash, builtin_list_eq);
+}
+
+/* lreverse(list) - 反转 */
+static int builtin_lreverse(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 1) return -1;
+    if (!bignum_is_list(&args[0])) return -1;
+    
+    if (bignum_copy(&args[0], result) != 0) return -1;
+    
+    LIST *list = bignum_get_list_mutable(result);
+    if (!list) return -1;
+    
+    list_reverse(list);
+    return 0;
+}
+
+/* 元素与给定值是否相等，同 lunique */
+static int builtin_list_match(const BHS *elem, const BHS *value) {
+    return builtin_list_eq((Obj)elem, (Obj)value);
+}
+
+/*
+ * 按块成段顺序扫描列表，返回第一个等于 value 的元素下标，没有时返回 -1。
+ * count 为 NULL 时找到第一个就停；否则扫完整个列表并统计相等的个数
+ */
+static int64_t builtin_list_scan(const LIST *list, const BHS *value, size_t *count) {
+    ListIter it;
+    Obj *span;
+    size_t n, base = 0;
+    int64_t first = -1;
+    if (count) *count = 0;
+    if (list_iter_range(list, 0, list_size(list), &it) != 0) return -1;
+    
+    while ((n = list_iter_next(&it, &span)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (!builtin_list_match((const BHS *)span[it.reversed ? n - 1 - i : i], value)) continue;
+            if (first < 0) first = (int64_t)(base + i);
+            if (!count) return first;
+            (*count)++;
+        }
+        base += n;
+    }
+    return first;
+}
+
+/* lcount(list, value) - 等于 value 的元素个数 */
+static int builtin_lcount(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 2) return -1;
+    if (!bignum_is_list(&args[0])) return -1;
+    
+    LIST *list = bignum_get_list((BHS*)&args[0]);
+    if (!list) return -1;
+    
+    size_t count;
+    builtin_list_scan(list, &args[1], &count);
+    
+    char count_str[64];
+    snprintf(count_str, sizeof(count_str), "%zu", count);
+    return bignum_from_string_legacy(count_str, result);
+}
+
+/* lfind(list, value) - 第一个等于 value 的元素下标，没有时为 -1 */
+static int builtin_lfind(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 2) return -1;
+    if (!bignum_is_list(&args[0])) return -1;
+    
+    LIST *list = bignum_get_list((BHS*)&args[0]);
+    if (!list) return -1;
+    
+    char idx_str[64];
+    snprintf(idx_str, sizeof(idx_str), "%lld", (long long)builtin_list_scan(list, &args[1], NULL));
+    return bignum_from_string_legacy(idx_str, result);
+}
+
+/* lexists(list, value) - 列表中有等于 value 的元素时为 1，否则为 0 */
+static int builtin_lexists(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 2) return -1;
+    if (!bignum_is_list(&args[0])) return -1;
+    
+    LIST *list = bignum_get_list((BHS*)&args[0]);
+    if (!list) return -1;
+    
+    return bignum_from_string_legacy(builtin_list_scan(list, &args[1], NULL) >= 0 ? "1" : "0", result);
+}
+
 /* ========== TYPE 转换函数 ========== */
 
 /* num(value) - 转换为数字 */
@@ -289,12 +579,43 @@ static int builtin_bset(const BHS *args, int arg_count, BHS *result, int precisi
     return 0;
 }
 
-/* bget(bitmap, offset) - 获取位 */
+/* 把 [st, ed] 中为 1 的位置逐个追加到列表 */
+static int builtin_bget_push(uint64_t pos, void *ctx) {
+    BHS *element = bignum_from_int64((int64_t)pos);
+    if (!element) return 1;
+    if (list_rpush((LIST *)ctx, (Obj)element) != 0) {
+        bignum_destroy(element);
+        return 1;
+    }
+    return 0;
+}
+
+/* bget(bitmap, st, ed) - [st, ed] 中为 1 的位置列表 */
+static int builtin_bget_range(const BHS *args, BHS *result) {
+    char st_str[64], ed_str[64];
+    if (bignum_to_string(&args[1], st_str, sizeof(st_str), 0) != 0) return -1;
+    if (bignum_to_string(&args[2], ed_str, sizeof(ed_str), 0) != 0) return -1;
+    
+    uint64_t st = (uint64_t)strtoull(st_str, NULL, 10);
+    uint64_t ed = (uint64_t)strtoull(ed_str, NULL, 10);
+    
+    BHS *list_num = bignum_create_list();
+    if (!list_num) return -1;
+    
+    LIST *list = bignum_get_list_mutable(list_num);
+    int ret = list ? bitmap_foreach_set(&args[0], st, ed, builtin_bget_push, list) : -1;
+    if (ret == 0) ret = bignum_copy(list_num, result);
+    bignum_destroy(list_num);
+    return ret == 0 ? 0 : -1;
+}
+
+/* bget(bitmap, offset) - 获取位；bget(bitmap, st, ed) - 取出一段中为 1 的位置 */
 static int builtin_bget(const BHS *args, int arg_count, BHS *result, int precision) {
     (void)precision;
     
-    if (arg_count != 2) return -1;
+    if (arg_count != 2 && arg_count != 3) return -1;
     if (!check_if_bitmap((BHS*)&args[0])) return -1;
+    if (arg_count == 3) return builtin_bget_range(args, result);
     
     char offset_str[64];
     if (bignum_to_string(&args[1], offset_str, sizeof(offset_str), 0) != 0) return -1;
@@ -303,7 +624,7 @@ static int builtin_bget(const BHS *args, int arg_count, BHS *result, int precisi
     int bit = bitmap_get((BHS*)&args[0], offset);
     if (bit < 0) return -1;
     
-    char bit_str[8];
+    char bit_str[16];
     snprintf(bit_str, sizeof(bit_str), "%d", bit);
     return bignum_from_string_legacy(bit_str, result);
 }
@@ -329,6 +650,392 @@ static int builtin_bcount(const BHS *args, int arg_count, BHS *result, int preci
     return bignum_from_string_legacy(count_str, result);
 }
 
+/* brank(bitmap, offset) - [0, offset) 中 1 的个数 */
+static int builtin_brank(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 2) return -1;
+    if (!check_if_bitmap((BHS*)&args[0])) return -1;
+    
+    char offset_str[64];
+    if (bignum_to_string(&args[1], offset_str, sizeof(offset_str), 0) != 0) return -1;
+    uint64_t offset = (uint64_t)strtoull(offset_str, NULL, 10);
+    if (offset > args[0].length) return -1;
+    
+    uint64_t rank = bitmap_rank((BHS*)&args[0], offset);
+    
+    char rank_str[64];
+    snprintf(rank_str, sizeof(rank_str), "%llu", (unsigned long long)rank);
+    return bignum_from_string_legacy(rank_str, result);
+}
+
+/* bselect(bitmap, k) - 第 k 个（从 0 开始）1 的位置，不存在时返回 -1 */
+static int builtin_bselect(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count != 2) return -1;
+    if (!check_if_bitmap((BHS*)&args[0])) return -1;
+    
+    char k_str[64];
+    if (bignum_to_string(&args[1], k_str, sizeof(k_str), 0) != 0) return -1;
+    uint64_t k = (uint64_t)strtoull(k_str, NULL, 10);
+    
+    int64_t pos = bitmap_select((BHS*)&args[0], k);
+    
+    char pos_str[64];
+    snprintf(pos_str, sizeof(pos_str), "%lld", (long long)pos);
+    return bignum_from_string_legacy(pos_str, result);
+}
+
+/*
+ * 多路聚合的公共部分：band/bor/bthreshold 及其 *count 形式
+ * 阈值模式第一个参数是 k，其余参数都必须是位图
+ */
+static int builtin_bagg(const BHS *args, int arg_count, int op, int count_only, BHS *result) {
+    int first = (op == BITMAP_AGG_THRESHOLD) ? 1 : 0;
+    size_t k = 0;
+    
+    if (first) {
+        char k_str[64];
+        if (bignum_to_string(&args[0], k_str, sizeof(k_str), 0) != 0) return -1;
+        k = (size_t)strtoull(k_str, NULL, 10);
+    }
+    
+    size_t n = (size_t)(arg_count - first);
+    const BHS **bms = malloc(n * sizeof(BHS*));
+    if (!bms) return -1;
+    for (size_t i = 0; i < n; i++) {
+        bms[i] = &args[first + i];
+    }
+    
+    int ret = -1;
+    if (count_only) {
+        uint64_t count;
+        if (bitmap_aggregate_count(bms, n, op, k, &count) == 0) {
+            char count_str[64];
+            snprintf(count_str, sizeof(count_str), "%llu", (unsigned long long)count);
+            ret = bignum_from_string_legacy(count_str, result);
+        }
+    } else {
+        BHS *bmp = bitmap_aggregate(bms, n, op, k);
+        if (bmp) {
+            ret = bignum_copy(bmp, result);
+            free_bitmap(bmp);
+        }
+    }
+    
+    free(bms);
+    return ret;
+}
+
+/* band(b1, b2, ...) - 多个位图的交集 */
+static int builtin_band(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    return builtin_bagg(args, arg_count, BITMAP_AGG_AND, 0, result);
+}
+
+/* bor(b1, b2, ...) - 多个位图的并集 */
+static int builtin_bor(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    return builtin_bagg(args, arg_count, BITMAP_AGG_OR, 0, result);
+}
+
+/* bthreshold(k, b1, b2, ...) - 至少 k 个位图为 1 的位 */
+static int builtin_bthreshold(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    return builtin_bagg(args, arg_count, BITMAP_AGG_THRESHOLD, 0, result);
+}
+
+/* bandcount(b1, b2, ...) - 交集中 1 的个数，不生成结果位图 */
+static int builtin_bandcount(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    return builtin_bagg(args, arg_count, BITMAP_AGG_AND, 1, result);
+}
+
+/* borcount(b1, b2, ...) - 并集中 1 的个数 */
+static int builtin_borcount(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    return builtin_bagg(args, arg_count, BITMAP_AGG_OR, 1, result);
+}
+
+/* bthresholdcount(k, b1, b2, ...) - 至少 k 个为 1 的位数 */
+static int builtin_bthresholdcount(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    return builtin_bagg(args, arg_count, BITMAP_AGG_THRESHOLD, 1, result);
+}
+
+/* ========== HLL 操作函数 ========== */
+
+/* 把 x 混入累积的哈希值 h */
+static uint64_t builtin_hash_mix(uint64_t h, uint64_t x) {
+    h = (h ^ x) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+/* 位图的哈希：长度和为 1 的位置，按 bitmap_extract_set 成批取出，与编码无关，不展开成文本 */
+static uint64_t builtin_bitmap_hash(const BHS *value) {
+    uint64_t pos[BITMAP_ITER_BATCH];
+    uint64_t cursor = 0, len = value->length;
+    uint64_t h = hll_hash(&len, sizeof(len));
+    int64_t n;
+    while ((n = bitmap_extract_set(value, &cursor, UINT64_MAX, pos, BITMAP_ITER_BATCH)) > 0) {
+        h = builtin_hash_mix(h, hll_hash(pos, (size_t)n * sizeof(uint64_t)));
+    }
+    return h;
+}
+
+/* 列表的哈希：长度和按逻辑顺序的各元素哈希 */
+static int builtin_list_value_hash(const BHS *value, int exact, uint64_t *hash) {
+    const LIST *list = bignum_get_list(value);
+    uint64_t len = list_size(list);
+    uint64_t h = hll_hash(&len, sizeof(len));
+    if (len > 0) {
+        ListIter it;
+        Obj *span;
+        size_t n;
+        if (list_iter_range(list, 0, len, &it) != 0) return -1;
+        while ((n = list_iter_next(&it, &span)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                uint64_t eh;
+                if (builtin_hash_value((const BHS *)span[it.reversed ? n - 1 - i : i], exact, &eh) != 0) return -1;
+                h = builtin_hash_mix(h, eh);
+            }
+        }
+    }
+    *hash = h;
+    return 0;
+}
+
+/*
+ * 值的哈希：字符串按原始字节，数字按 bignum_to_string 的结果（因此数字 5 与字符串 "5" 相同），
+ * 位图和列表按结构，其他类型按摘要文本（不超过 64 字节）。
+ * exact 为 0 时文本超过 4096 字节的数字只按符号分桶，不分配内存，不会失败（供去重用，相等判断仍是精确的）；
+ * exact 非 0 时为其分配足够的缓冲区，只在内存不足时返回 -1
+ */
+static int builtin_hash_value(const BHS *value, int exact, uint64_t *hash) {
+    if (bignum_is_string(value)) {
+        *hash = hll_hash(BIGNUM_DIGITS(value), value->length);
+        return 0;
+    }
+    if (bignum_is_bitmap(value)) {
+        *hash = builtin_bitmap_hash(value);
+        return 0;
+    }
+    if (bignum_is_list(value)) return builtin_list_value_hash(value, exact, hash);
+    
+    /* 数字文本的长度上限：全部位数、补齐的前导 0、符号和小数点 */
+    char small[4096];
+    size_t cap = 64;
+    if (bignum_is_number(value)) {
+        cap = value->length * BIGNUM_LIMB_DIGITS + (size_t)value->type_data.num.decimal_pos + 4;
+        if (cap > sizeof(small) && !exact) {
+            *hash = builtin_hash_mix(value->type_data.num.is_negative, value->type);
+            return 0;
+        }
+    }
+    
+    char *value_str = cap <= sizeof(small) ? small : malloc(cap);
+    if (!value_str) return -1;
+    
+    int ret = -1;
+    if (bignum_to_string(value, value_str, cap, -1) == 0) {
+        *hash = hll_hash(value_str, strlen(value_str));
+        ret = 0;
+    }
+    if (value_str != small) free(value_str);
+    return ret;
+}
+
+/* HLL 和过滤器中元素的哈希值，见 builtin_hash_value */
+static int builtin_value_hash(const BHS *value, uint64_t *hash) {
+    return builtin_hash_value(value, 1, hash);
+}
+
+/* 把一个值加入 HLL */
+static int builtin_hll_add_value(BHS *h, const BHS *value) {
+    uint64_t hash;
+    if (builtin_value_hash(value, &hash) != 0) return -1;
+    return hll_add_hash(h, hash) < 0 ? -1 : 0;
+}
+
+/* 多个 HLL 参数收集为指针数组，有参数不是 HLL 时返回 NULL */
+static const BHS **builtin_hll_args(const BHS *args, int arg_count) {
+    const BHS **hs = malloc((size_t)arg_count * sizeof(BHS*));
+    if (!hs) return NULL;
+    for (int i = 0; i < arg_count; i++) {
+        if (!check_if_hll(&args[i])) {
+            free(hs);
+            return NULL;
+        }
+        hs[i] = &args[i];
+    }
+    return hs;
+}
+
+/* hll(v1, v2, ...) - 新建 HLL 并加入给定的值 */
+static int builtin_hll(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    BHS *h = hll_create();
+    if (!h) return -1;
+    
+    int ret = 0;
+    for (int i = 0; i < arg_count && ret == 0; i++) {
+        ret = builtin_hll_add_value(h, &args[i]);
+    }
+    if (ret == 0) ret = bignum_copy(h, result);
+    free_hll(h);
+    return ret;
+}
+
+/* pfadd(h, v1, v2, ...) - 加入元素后的 HLL */
+static int builtin_pfadd(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (arg_count < 2) return -1;
+    if (!check_if_hll(&args[0])) return -1;
+    
+    /* 复制 HLL（共享数据区，第一次修改时才复制） */
+    if (bignum_copy(&args[0], result) != 0) return -1;
+    
+    for (int i = 1; i < arg_count; i++) {
+        if (builtin_hll_add_value(result, &args[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+/* pfcount(h1, h2, ...) - 估计基数，多个时估计并集的基数 */
+static int builtin_pfcount(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    const BHS **hs = builtin_hll_args(args, arg_count);
+    if (!hs) return -1;
+    
+    uint64_t count;
+    int ret = -1;
+    if (hll_count_union(hs, (size_t)arg_count, &count) == 0) {
+        char count_str[64];
+        snprintf(count_str, sizeof(count_str), "%llu", (unsigned long long)count);
+        ret = bignum_from_string_legacy(count_str, result);
+    }
+    
+    free(hs);
+    return ret;
+}
+
+/* pfmerge(h1, h2, ...) - 合并多个 HLL */
+static int builtin_pfmerge(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    const BHS **hs = builtin_hll_args(args, arg_count);
+    if (!hs) return -1;
+    
+    int ret = -1;
+    BHS *h = hll_merge(hs, (size_t)arg_count);
+    if (h) {
+        ret = bignum_copy(h, result);
+        free_hll(h);
+    }
+    
+    free(hs);
+    return ret;
+}
+
+/* ========== FILTER 操作函数 ========== */
+
+/* bloom(expected[, fpp]) - 新建分块布隆过滤器，fpp 默认 0.01 */
+static int builtin_bloom(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    char n_str[64], p_str[64];
+    if (bignum_to_string(&args[0], n_str, sizeof(n_str), 0) != 0) return -1;
+    uint64_t expected = (uint64_t)strtoull(n_str, NULL, 10);
+    
+    double fpp = 0.01;
+    if (arg_count > 1) {
+        if (bignum_to_string(&args[1], p_str, sizeof(p_str), -1) != 0) return -1;
+        fpp = strtod(p_str, NULL);
+    }
+    
+    BHS *f = filter_create_bloom(expected, fpp);
+    if (!f) return -1;
+    int ret = bignum_copy(f, result);
+    free_filter(f);
+    return ret;
+}
+
+/* cuckoo(expected) - 新建布谷鸟过滤器（支持删除） */
+static int builtin_cuckoo(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    (void)arg_count;
+    
+    char n_str[64];
+    if (bignum_to_string(&args[0], n_str, sizeof(n_str), 0) != 0) return -1;
+    
+    BHS *f = filter_create_cuckoo((uint64_t)strtoull(n_str, NULL, 10));
+    if (!f) return -1;
+    int ret = bignum_copy(f, result);
+    free_filter(f);
+    return ret;
+}
+
+/* fadd(f, v1, v2, ...) - 加入元素后的过滤器，布谷鸟过滤器装满时报错 */
+static int builtin_fadd(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (!check_if_filter(&args[0])) return -1;
+    
+    /* 复制过滤器（共享数据区，第一次修改时才复制） */
+    if (bignum_copy(&args[0], result) != 0) return -1;
+    
+    for (int i = 1; i < arg_count; i++) {
+        uint64_t hash;
+        if (builtin_value_hash(&args[i], &hash) != 0) return -1;
+        if (filter_add_hash(result, hash) != 0) return -1;
+    }
+    return 0;
+}
+
+/* fhas(f, v1, v2, ...) - 可能存在的元素个数，为 0 时一定都不存在 */
+static int builtin_fhas(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (!check_if_filter(&args[0])) return -1;
+    
+    size_t n = (size_t)(arg_count - 1);
+    uint64_t *hashes = malloc(n * sizeof(uint64_t));
+    if (!hashes) return -1;
+    for (size_t i = 0; i < n; i++) {
+        if (builtin_value_hash(&args[i + 1], &hashes[i]) != 0) {
+            free(hashes);
+            return -1;
+        }
+    }
+    
+    int64_t hits = filter_test_hashes(&args[0], hashes, n, NULL);
+    free(hashes);
+    if (hits < 0) return -1;
+    
+    char hits_str[64];
+    snprintf(hits_str, sizeof(hits_str), "%lld", (long long)hits);
+    return bignum_from_string_legacy(hits_str, result);
+}
+
+/* fdel(f, v1, v2, ...) - 删除元素后的布谷鸟过滤器，不存在的元素忽略 */
+static int builtin_fdel(const BHS *args, int arg_count, BHS *result, int precision) {
+    (void)precision;
+    
+    if (!check_if_filter(&args[0]) || !FILTER_IS_CUCKOO(&args[0])) return -1;
+    if (bignum_copy(&args[0], result) != 0) return -1;
+    
+    for (int i = 1; i < arg_count; i++) {
+        uint64_t hash;
+        if (builtin_value_hash(&args[i], &hash) != 0) return -1;
+        filter_remove_hash(result, hash);
+    }
+    return 0;
+}
+
 /* ========== 内置函数表 ========== */
 
 static const BuiltinFunctionInfo builtin_functions[] = {
@@ -338,8 +1045,14 @@ static const BuiltinFunctionInfo builtin_functions[] = {
     {"rpush",  builtin_rpush,  2, 2},
     {"lpop",   builtin_lpop,   1, 1},
     {"rpop",   builtin_rpop,   1, 1},
-    {"lget",   builtin_lget,   2, 2},
+    {"lget",   builtin_lget,   2, 3},
     {"llen",   builtin_llen,   1, 1},
+    {"lsort",  builtin_lsort,  1, 2},
+    {"lunique", builtin_lunique, 1, 1},
+    {"lreverse", builtin_lreverse, 1, 1},
+    {"lcount", builtin_lcount, 2, 2},
+    {"lfind",  builtin_lfind,  2, 2},
+    {"lexists", builtin_lexists, 2, 2},
     
     /* TYPE 转换 */
     {"num",    builtin_num,    1, 1},
@@ -348,8 +1061,29 @@ static const BuiltinFunctionInfo builtin_functions[] = {
     
     /* BITMAP 操作 */
     {"bset",   builtin_bset,   3, 3},
-    {"bget",   builtin_bget,   2, 2},
+    {"bget",   builtin_bget,   2, 3},
     {"bcount", builtin_bcount, 3, 3},
+    {"brank",  builtin_brank,  2, 2},
+    {"bselect", builtin_bselect, 2, 2},
+    {"band",   builtin_band,   1, -1},
+    {"bor",    builtin_bor,    1, -1},
+    {"bthreshold", builtin_bthreshold, 2, -1},
+    {"bandcount",  builtin_bandcount,  1, -1},
+    {"borcount",   builtin_borcount,   1, -1},
+    {"bthresholdcount", builtin_bthresholdcount, 2, -1},
+    
+    /* HLL 操作 */
+    {"hll",     builtin_hll,     0, -1},
+    {"pfadd",   builtin_pfadd,   2, -1},
+    {"pfcount", builtin_pfcount, 1, -1},
+    {"pfmerge", builtin_pfmerge, 1, -1},
+    
+    /* FILTER 操作 */
+    {"bloom",   builtin_bloom,   1, 2},
+    {"cuckoo",  builtin_cuckoo,  1, 1},
+    {"fadd",    builtin_fadd,    2, -1},
+    {"fhas",    builtin_fhas,    2, -1},
+    {"fdel",    builtin_fdel,    2, -1},
     
     {NULL, NULL, 0, 0}  /* 结束标记 */
 };
@@ -11,49 +11,36 @@
 #include <ctype.h>
 #include <stdio.h>
 
-/* 辅助函数：比较两个大数（考虑符号）
- * 返回: 1 if a>b, 0 if a==b, -1 if a<b */
-static int bignum_compare(const BHS *a, const BHS *b) {
-    if (a == NULL || b == NULL) return 0;
-    
-    /* 处理符号 */
-    if (a->type_data.num.is_negative && !b->type_data.num.is_negative) return -1;  /* 负数 < 正数 */
-    if (!a->type_data.num.is_negative && b->type_data.num.is_negative) return 1;   /* 正数 > 负数 */
-    
-    /* 同号情况 */
-    /* 先比较整数部分长度 */
-    int a_int_len = a->length - a->type_data.num.decimal_pos;
-    int b_int_len = b->length - b->type_data.num.decimal_pos;
-    
-    int sign_multiplier = a->type_data.num.is_negative ? -1 : 1;
-    
-    if (a_int_len > b_int_len) return 1 * sign_multiplier;
-    if (a_int_len < b_int_len) return -1 * sign_multiplier;
+/* 辅助函数：判断大数是否为真 */
+int bignum_is_true(const BHS *num) {
+    if (num == NULL) return 0;
     
-    char *a_digits = BIGNUM_DIGITS(a);
-    char *b_digits = BIGNUM_DIGITS(b);
+    /* 数字类型：检查是否所有 limb 都是0（立即数最多两个 limb，直接判断） */
+    if (num->type == BIGNUM_TYPE_NUMBER) {
+        bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+        if (BIGNUM_IS_IMM(num)) {
+            return limbs[0] != 0 || (num->length == BIGNUM_IMM_LIMBS && limbs[1] != 0);
+        }
+        for (size_t i = 0; i < num->length; i++) {
+            if (limbs[i] != 0) return 1;
+        }
+        return 0;
+    }
     
-    /* 从高位到低位比较 */
-    for (int i = a->length - 1; i >= 0; i--) {
-        int b_idx = i - a->type_data.num.decimal_pos + b->type_data.num.decimal_pos;
-        int b_digit = (b_idx >= 0 && b_idx < b->length) ? b_digits[b_idx] : 0;
-        int a_digit = a_digits[i];
-        
-        if (a_digit > b_digit) return 1 * sign_multiplier;
-        if (a_digit < b_digit) return -1 * sign_multiplier;
+    /* 位图类型：查找第一个 1（压缩编码的位图没有平铺数据可读） */
+    if (num->type == BIGNUM_TYPE_BITMAP) {
+        return num->length > 0 && bitmap_find(num, 1, 0, num->length - 1) >= 0;
     }
     
-    /* 检查b是否有更多的小数位 */
-    for (int i = a->type_data.num.decimal_pos; i < b->type_data.num.decimal_pos; i++) {
-        if (i < b->length && b_digits[i] != 0) return -1 * sign_multiplier;
+    /* HLL 类型：稀疏编码没有条目时为空，平铺编码必然非空 */
+    if (num->type == BIGNUM_TYPE_HLL) {
+        return num->length > 0;
     }
     
-    return 0;
-}
-
-/* 辅助函数：判断大数是否为真 */
-int bignum_is_true(const BHS *num) {
-    if (num == NULL) return 0;
+    /* 过滤器类型：加入过元素即为真 */
+    if (num->type == BIGNUM_TYPE_FILTER) {
+        return num->length > 0;
+    }
     
     char *digits = BIGNUM_DIGITS(num);
     
@@ -248,12 +235,7 @@ static int parse_primary(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry
         int is_true = bignum_is_true(&temp);
         bignum_free(&temp);
         
-        bignum_init(result);
-        char *digits = BIGNUM_DIGITS(result);
-        digits[0] = is_true ? 0 : 1;
-        result->length = 1;
-        result->type_data.num.decimal_pos = 0;
-        result->type_data.num.is_negative = 0;
+        bignum_from_int64_legacy(is_true ? 0 : 1, result);
         return EVAL_SUCCESS;
     }
     
@@ -274,19 +256,15 @@ static int parse_primary(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry
             return EVAL_ERROR;
         }
         
-        BHS *bitwise_result = bignum_bitnot(&temp);
+        if (bignum_bitnot_inplace(&temp) != 0) {
         bignum_free(&temp);
-        
-        if (bitwise_result == NULL) {
             return EVAL_ERROR;
         }
         
-        if (bignum_copy(bitwise_result, result) != BIGNUM_SUCCESS) {
-            bignum_destroy(bitwise_result);
-            return EVAL_ERROR;
-        }
-        bignum_destroy(bitwise_result);
-        return EVAL_SUCCESS;
+        /* large_data 按写时复制共享，这里的拷贝不复制位数据 */
+        ret = bignum_copy(&temp, result);
+        bignum_free(&temp);
+        return ret == BIGNUM_SUCCESS ? EVAL_SUCCESS : EVAL_ERROR;
     }
     
     /* 括号 */
@@ -467,24 +445,17 @@ static int parse_shift(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *
             return EVAL_ERROR;
         }
         
-        BHS *temp = NULL;
+        /* 直接在左操作数上移位，不分配临时位图 */
         if (op == TOK_BITSHL) {
-            temp = bignum_bitshl(result, &right);
+            ret = bignum_bitshl_inplace(result, &right);
         } else {
-            temp = bignum_bitshr(result, &right);
+            ret = bignum_bitshr_inplace(result, &right);
         }
         bignum_free(&right);
         
-        if (temp == NULL) {
-            return EVAL_ERROR;
-        }
-        
-        bignum_free(result);
-        if (bignum_copy(temp, result) != BIGNUM_SUCCESS) {
-            bignum_destroy(temp);
+        if (ret != 0) {
             return EVAL_ERROR;
         }
-        bignum_destroy(temp);
     }
     
     return EVAL_SUCCESS;
@@ -538,12 +509,7 @@ static int parse_comparison(Lexer *lex, BHS *result, Context *ctx, FunctionRegis
         }
         
         bignum_free(result);
-        bignum_init(result);
-        char *digits = BIGNUM_DIGITS(result);
-        digits[0] = bool_result;
-        result->length = 1;
-        result->type_data.num.decimal_pos = 0;
-        result->type_data.num.is_negative = 0;
+        bignum_from_int64_legacy(bool_result, result);
     }
     
     return EVAL_SUCCESS;
@@ -571,19 +537,13 @@ static int parse_bitand(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry
             return EVAL_ERROR;
         }
         
-        BHS *temp = bignum_bitand(result, &right);
+        /* 直接在左操作数上运算，链式表达式不产生临时位图 */
+        ret = bignum_bitand_inplace(result, &right);
         bignum_free(&right);
         
-        if (temp == NULL) {
+        if (ret != 0) {
             return EVAL_ERROR;
         }
-        
-        bignum_free(result);
-        if (bignum_copy(temp, result) != BIGNUM_SUCCESS) {
-            bignum_destroy(temp);
-            return EVAL_ERROR;
-        }
-        bignum_destroy(temp);
     }
     
     return EVAL_SUCCESS;
@@ -611,19 +571,13 @@ static int parse_bitor(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *
             return EVAL_ERROR;
         }
         
-        BHS *temp = bignum_bitor(result, &right);
+        /* 直接在左操作数上运算，链式表达式不产生临时位图 */
+        ret = bignum_bitor_inplace(result, &right);
         bignum_free(&right);
         
-        if (temp == NULL) {
-            return EVAL_ERROR;
-        }
-        
-        bignum_free(result);
-        if (bignum_copy(temp, result) != BIGNUM_SUCCESS) {
-            bignum_destroy(temp);
+        if (ret != 0) {
             return EVAL_ERROR;
         }
-        bignum_destroy(temp);
     }
     
     return EVAL_SUCCESS;
@@ -648,19 +602,12 @@ static int parse_and(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *fu
         /* 根据操作数类型选择操作 */
         if (result->type == BIGNUM_TYPE_BITMAP && right.type == BIGNUM_TYPE_BITMAP) {
             /* 位图类型：^ 表示异或 */
-            BHS *temp = bignum_bitxor(result, &right);
+            ret = bignum_bitxor_inplace(result, &right);
             bignum_free(&right);
             
-            if (temp == NULL) {
-                return EVAL_ERROR;
-            }
-            
-            bignum_free(result);
-            if (bignum_copy(temp, result) != BIGNUM_SUCCESS) {
-                bignum_destroy(temp);
+            if (ret != 0) {
                 return EVAL_ERROR;
             }
-            bignum_destroy(temp);
         } else {
             /* 布尔 AND: 两边都为真则为真 */
             int left_true = bignum_is_true(result);
@@ -668,12 +615,7 @@ static int parse_and(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *fu
             bignum_free(&right);
             
             bignum_free(result);
-            bignum_init(result);
-            char *digits = BIGNUM_DIGITS(result);
-            digits[0] = (left_true && right_true) ? 1 : 0;
-            result->length = 1;
-            result->type_data.num.decimal_pos = 0;
-            result->type_data.num.is_negative = 0;
+            bignum_from_int64_legacy((left_true && right_true) ? 1 : 0, result);
         }
     }
     
@@ -702,12 +644,7 @@ static int parse_or(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *fun
         bignum_free(&right);
         
         bignum_free(result);
-        bignum_init(result);
-        char *digits = BIGNUM_DIGITS(result);
-        digits[0] = (left_true || right_true) ? 1 : 0;
-        result->length = 1;
-        result->type_data.num.decimal_pos = 0;
-        result->type_data.num.is_negative = 0;
+        bignum_from_int64_legacy((left_true || right_true) ? 1 : 0, result);
     }
     
     return EVAL_SUCCESS;
@@ -735,12 +672,7 @@ static int parse_impl(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *f
         bignum_free(&right);
         
         bignum_free(result);
-        bignum_init(result);
-        char *digits = BIGNUM_DIGITS(result);
-        digits[0] = (!left_true || right_true) ? 1 : 0;
-        result->length = 1;
-        result->type_data.num.decimal_pos = 0;
-        result->type_data.num.is_negative = 0;
+        bignum_from_int64_legacy((!left_true || right_true) ? 1 : 0, result);
     }
     
     return EVAL_SUCCESS;
@@ -768,12 +700,7 @@ static int parse_iff(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *fu
         bignum_free(&right);
         
         bignum_free(result);
-        bignum_init(result);
-        char *digits = BIGNUM_DIGITS(result);
-        digits[0] = (left_true == right_true) ? 1 : 0;
-        result->length = 1;
-        result->type_data.num.decimal_pos = 0;
-        result->type_data.num.is_negative = 0;
+        bignum_from_int64_legacy((left_true == right_true) ? 1 : 0, result);
     }
     
     return EVAL_SUCCESS;
@@ -801,12 +728,7 @@ static int parse_xor(Lexer *lex, BHS *result, Context *ctx, FunctionRegistry *fu
         bignum_free(&right);
         
         bignum_free(result);
-        bignum_init(result);
-        char *digits = BIGNUM_DIGITS(result);
-        digits[0] = (left_true != right_true) ? 1 : 0;
-        result->length = 1;
-        result->type_data.num.decimal_pos = 0;
-        result->type_data.num.is_negative = 0;
+        bignum_from_int64_legacy((left_true != right_true) ? 1 : 0, result);
     }
     
     return EVAL_SUCCESS;
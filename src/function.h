@@ -12,7 +12,7 @@
 
 #define MAX_FUNCTIONS 256      /* 最大函数数量 */
 #define MAX_FUNC_NAME_LEN 64   /* 函数名最大长度 */
-#define MAX_FUNC_ARGS 10       /* 函数最大参数数量 */
+#define MAX_FUNC_ARGS 64       /* 函数最大参数数量（band/bor 等多路聚合需要较多参数） */
 
 /* 函数指针类型定义 */
 typedef int (*NativeFunction)(const BHS *args, int arg_count, BHS *result, int precision);
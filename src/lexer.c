@@ -171,6 +171,7 @@ static TokenType check_keyword(const char *value) {
     if (strcmp(value, "date") == 0) return TOK_DATE;
     if (strcmp(value, "time") == 0) return TOK_TIME;
     if (strcmp(value, "datetime") == 0) return TOK_DATETIME;
+    if (strcmp(value, "decimal") == 0) return TOK_DECIMAL;
     
     /* NAQL 约束关键字 */
     if (strcmp(value, "PKEY") == 0) return TOK_PKEY;
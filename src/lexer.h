@@ -157,6 +157,7 @@ typedef enum {
     TOK_DATE,        /* date */
     TOK_TIME,        /* time */
     TOK_DATETIME,    /* datetime */
+    TOK_DECIMAL,     /* decimal(p,s) */
     
     /* NAQL 约束关键字 */
     TOK_PKEY,        /* PKEY (Primary Key) */
@@ -4,6 +4,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>  /* for SIZE_MAX */
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "lib/list.h"
 
@@ -11,9 +19,13 @@
 static int bignum_add_internal(const BHS *a, const BHS *b, BHS *result);
 static int bignum_sub_internal(const BHS *a, const BHS *b, BHS *result);
 static int bignum_mul_internal(const BHS *a, const BHS *b, BHS *result);
+static int bignum_mul_scaled(const BHS *a, const BHS *b, BHS *result, int scale);
 static int bignum_div_internal(const BHS *a, const BHS *b, BHS *result, int precision);
 static int bignum_pow_internal(const BHS *base, const BHS *exponent, BHS *result, int precision);
 static int bignum_mod_internal(const BHS *a, const BHS *b, BHS *result);
+static int bignum_pow_frac(const BHS *base, const BHS *exponent, BHS *result, int precision);
+static double bignum_log10_abs(const BHS *num);
+static void bignum_release_data(BHS *num);
 
 /* 创建并初始化一个新的 BHS */
 BHS* bignum_create(void) {
@@ -35,20 +47,8 @@ BHS* bignum_create(void) {
 void bignum_destroy(BHS *num) {
     if (num == NULL) return;
     
-    /* 根据类型释放内部数据 */
-    if (num->type == BIGNUM_TYPE_LIST) {
-        /* 释放 LIST 类型的数据 */
-        if (num->data.list != NULL) {
-            free_list(num->data.list);
-            num->data.list = NULL;
-        }
-    } else {
-        /* 释放其他类型的数据（数字、字符串、位图） */
-        if (num->is_large && num->data.large_data != NULL) {
-            free(num->data.large_data);
-            num->data.large_data = NULL;
-        }
-    }
+    /* 释放内部数据的引用 */
+    bignum_release_data(num);
     
     /* 然后释放结构体本身 */
     free(num);
@@ -69,25 +69,855 @@ void bignum_init(BHS *num) {
 void bignum_free(BHS *num) {
     if (num == NULL) return;
     
-    /* 根据类型释放内存 */
+    /* 释放内部数据的引用 */
+    bignum_release_data(num);
+    
+    num->is_large = 0;
+    num->length = 0;
+    num->capacity = 0;
+    num->type = BIGNUM_TYPE_NULL;
+}
+
+/* ========== 写时复制的共享数据 ========== */
+
+/* large_data 之前的引用计数头，16 字节保证数据区按 16 字节对齐 */
+typedef struct {
+    size_t refcount;
+    void *aux;          /* 由数据区派生的附属索引，随数据区释放 */
+} bignum_payload_header;
+
+#define BIGNUM_PAYLOAD_HEADER(data) ((bignum_payload_header *)((char *)(data) - sizeof(bignum_payload_header)))
+
+char* bignum_payload_alloc(size_t size) {
+    bignum_payload_header *header = (bignum_payload_header *)malloc(sizeof(bignum_payload_header) + size);
+    if (header == NULL) return NULL;
+    header->refcount = 1;
+    header->aux = NULL;
+    return (char *)(header + 1);
+}
+
+char* bignum_payload_realloc(char *data, size_t size) {
+    if (data == NULL) return bignum_payload_alloc(size);
+    
+    bignum_payload_header *header = (bignum_payload_header *)realloc(BIGNUM_PAYLOAD_HEADER(data),
+                                                                     sizeof(bignum_payload_header) + size);
+    if (header == NULL) return NULL;
+    return (char *)(header + 1);
+}
+
+char* bignum_payload_share(char *data) {
+    if (data != NULL) {
+        __atomic_add_fetch(&BIGNUM_PAYLOAD_HEADER(data)->refcount, 1, __ATOMIC_RELAXED);
+    }
+    return data;
+}
+
+void bignum_payload_release(char *data) {
+    if (data == NULL) return;
+    
+    bignum_payload_header *header = BIGNUM_PAYLOAD_HEADER(data);
+    if (__atomic_sub_fetch(&header->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(header->aux);
+        free(header);
+    }
+}
+
+void* bignum_payload_aux(const char *data) {
+    if (data == NULL) return NULL;
+    return __atomic_load_n(&BIGNUM_PAYLOAD_HEADER(data)->aux, __ATOMIC_ACQUIRE);
+}
+
+int bignum_payload_attach_aux(char *data, void *aux) {
+    if (data == NULL) return BIGNUM_ERROR;
+    
+    void *expected = NULL;
+    if (!__atomic_compare_exchange_n(&BIGNUM_PAYLOAD_HEADER(data)->aux, &expected, aux,
+                                     0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return BIGNUM_ERROR;
+    }
+    return BIGNUM_SUCCESS;
+}
+
+void bignum_payload_drop_aux(char *data) {
+    if (data == NULL) return;
+    
+    bignum_payload_header *header = BIGNUM_PAYLOAD_HEADER(data);
+    free(header->aux);
+    header->aux = NULL;
+}
+
+/* 数据区是否被多个 BHS 共享 */
+static int bignum_payload_is_shared(const char *data) {
+    return __atomic_load_n(&BIGNUM_PAYLOAD_HEADER(data)->refcount, __ATOMIC_ACQUIRE) > 1;
+}
+
+/* 列表元素的复制（bignum_copy，元素自身的数据区仍然共享）和销毁，
+   由 LIST 在写时复制块和释放最后一个块引用时调用 */
+static Obj bignum_list_elem_clone(Obj value) {
+    BHS *elem = bignum_create();
+    if (elem != NULL && bignum_copy((const BHS *)value, elem) != BIGNUM_SUCCESS) {
+        bignum_destroy(elem);
+        elem = NULL;
+    }
+    return (Obj)elem;
+}
+
+static void bignum_list_elem_destroy(Obj value) {
+    bignum_destroy((BHS *)value);
+}
+
+/* 释放列表的一个引用，最后一个引用释放时连同元素一起销毁（共享的块由其他列表保留） */
+static void bignum_list_release(LIST *list) {
+    if (list == NULL) return;
+    if (__atomic_sub_fetch(&list->refcount, 1, __ATOMIC_ACQ_REL) != 0) return;
+    free_list(list);
+}
+
+/* 复制列表：只复制块节点，块数据共享，某块首次被修改时才逐个复制其中的元素 */
+static LIST *bignum_list_clone(const LIST *list) {
+    LIST *copy = list_copy(list);
+    if (copy == NULL) return NULL;
+    
+    /* 原列表不管理元素时（不是由 bignum_create_list 创建），立即复制全部元素 */
+    if (list->clone == NULL) {
+        list_set_elem_ops(copy, bignum_list_elem_clone, bignum_list_elem_destroy);
+        if (list_unshare(copy) != 0) {
+            free_list(copy);
+            return NULL;
+        }
+    }
+    return copy;
+}
+
+/* 释放 num 持有的数据引用（不修改其他字段） */
+static void bignum_release_data(BHS *num) {
+    if (num->type == BIGNUM_TYPE_LIST) {
+        bignum_list_release((LIST *)num->data.list);
+        num->data.list = NULL;
+    } else if (num->is_large && num->data.large_data != NULL) {
+        bignum_payload_release(num->data.large_data);
+        num->data.large_data = NULL;
+    }
+}
+
+int bignum_make_unique(BHS *num) {
+    if (num == NULL) return BIGNUM_ERROR;
+    
     if (num->type == BIGNUM_TYPE_LIST) {
-        /* 列表类型：释放LIST结构 */
-        if (num->data.list != NULL) {
-            free_list(num->data.list);
-            num->data.list = NULL;
+        LIST *list = (LIST *)num->data.list;
+        if (list == NULL || __atomic_load_n(&list->refcount, __ATOMIC_ACQUIRE) == 1) {
+            return BIGNUM_SUCCESS;
         }
+        LIST *copy = bignum_list_clone(list);
+        if (copy == NULL) return BIGNUM_ERROR;
+        bignum_list_release(list);
+        num->data.list = (struct LIST *)copy;
+        return BIGNUM_SUCCESS;
+    }
+    
+    if (!num->is_large || num->data.large_data == NULL || !bignum_payload_is_shared(num->data.large_data)) {
+        return BIGNUM_SUCCESS;
+    }
+    
+    char *copy = bignum_payload_alloc(num->capacity);
+    if (copy == NULL) return BIGNUM_ERROR;
+    memcpy(copy, num->data.large_data, num->capacity);
+    bignum_payload_release(num->data.large_data);
+    num->data.large_data = copy;
+    return BIGNUM_SUCCESS;
+}
+
+/* ========== limb 级辅助函数（NUMBER 类型内部表示） ========== */
+
+/* 单次计算临时空间允许的最大 limb 数（最终结果最多 BIGNUM_MAX_DIGITS 位十进制数） */
+#define BIGNUM_MAX_LIMBS ((BIGNUM_MAX_DIGITS + BIGNUM_LIMB_DIGITS - 1) / BIGNUM_LIMB_DIGITS + 1)
+
+static const bignum_limb_t bignum_pow10[BIGNUM_LIMB_DIGITS + 1] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+/* 去除高位的零 limb，返回有效长度（至少为1） */
+static size_t limbs_normalize(const bignum_limb_t *a, size_t n) {
+    while (n > 1 && a[n - 1] == 0) n--;
+    return n;
+}
+
+/* 十进制位数（0 视为 1 位） */
+static size_t limbs_digit_count(const bignum_limb_t *a, size_t n) {
+    bignum_limb_t top = a[n - 1];
+    size_t digits = 1;
+    while (top >= 10) {
+        top /= 10;
+        digits++;
+    }
+    return (n - 1) * BIGNUM_LIMB_DIGITS + digits;
+}
+
+/* 比较两个已规范化的 limb 数组 (返回: 1 if a>b, 0 if a==b, -1 if a<b) */
+static int limbs_cmp(const bignum_limb_t *a, size_t an, const bignum_limb_t *b, size_t bn) {
+    if (an != bn) return an > bn ? 1 : -1;
+    for (size_t i = an; i-- > 0;) {
+        if (a[i] != b[i]) return a[i] > b[i] ? 1 : -1;
+    }
+    return 0;
+}
+
+/* r = a + b，r 需要 max(an, bn) + 1 个 limb，可与 a 或 b 重叠，返回结果长度 */
+static size_t limbs_add(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                        const bignum_limb_t *b, size_t bn) {
+    if (an < bn) {
+        const bignum_limb_t *t = a; a = b; b = t;
+        size_t tn = an; an = bn; bn = tn;
+    }
+    bignum_limb_t carry = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        bignum_limb_t sum = a[i] + b[i] + carry;
+        carry = sum >= BIGNUM_LIMB_BASE;
+        r[i] = carry ? sum - BIGNUM_LIMB_BASE : sum;
+    }
+    for (; i < an; i++) {
+        bignum_limb_t sum = a[i] + carry;
+        carry = sum >= BIGNUM_LIMB_BASE;
+        r[i] = carry ? sum - BIGNUM_LIMB_BASE : sum;
+    }
+    if (carry) r[i++] = carry;
+    return i;
+}
+
+/* r = a - b（要求 a >= b），r 需要 an 个 limb，可与 a 重叠，返回规范化后的长度 */
+static size_t limbs_sub(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                        const bignum_limb_t *b, size_t bn) {
+    bignum_limb_t borrow = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        bignum_limb_t sub = b[i] + borrow;
+        borrow = a[i] < sub;
+        r[i] = borrow ? a[i] + BIGNUM_LIMB_BASE - sub : a[i] - sub;
+    }
+    for (; i < an; i++) {
+        bignum_limb_t cur = a[i];
+        r[i] = cur < borrow ? cur + BIGNUM_LIMB_BASE - borrow : cur - borrow;
+        borrow = cur < borrow;
+    }
+    return limbs_normalize(r, an);
+}
+
+/* r = a * m + add（m, add < 10^9），r 需要 an + 1 个 limb，可与 a 重叠，返回结果长度 */
+static size_t limbs_mul_small(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                              bignum_limb_t m, bignum_limb_t add) {
+    uint64_t carry = add;
+    for (size_t i = 0; i < an; i++) {
+        uint64_t cur = (uint64_t)a[i] * m + carry;
+        r[i] = (bignum_limb_t)(cur % BIGNUM_LIMB_BASE);
+        carry = cur / BIGNUM_LIMB_BASE;
+    }
+    if (carry) r[an++] = (bignum_limb_t)carry;
+    return limbs_normalize(r, an);
+}
+
+/* q = a / d（d < 10^9，d != 0），q 可与 a 重叠，返回余数 */
+static bignum_limb_t limbs_div_small(bignum_limb_t *q, const bignum_limb_t *a, size_t an, bignum_limb_t d) {
+    uint64_t rem = 0;
+    for (size_t i = an; i-- > 0;) {
+        uint64_t cur = rem * BIGNUM_LIMB_BASE + a[i];
+        q[i] = (bignum_limb_t)(cur / d);
+        rem = cur % d;
+    }
+    return (bignum_limb_t)rem;
+}
+
+/* r = a * b（逐 limb 相乘的基础算法），r 需要 an + bn 个 limb，不能与 a/b 重叠 */
+static void limbs_mul_basecase(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                               const bignum_limb_t *b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof(bignum_limb_t));
+    for (size_t i = 0; i < an; i++) {
+        uint64_t ai = a[i];
+        if (ai == 0) continue;
+        uint64_t carry = 0;
+        for (size_t j = 0; j < bn; j++) {
+            uint64_t cur = r[i + j] + ai * b[j] + carry;
+            r[i + j] = (bignum_limb_t)(cur % BIGNUM_LIMB_BASE);
+            carry = cur / BIGNUM_LIMB_BASE;
+        }
+        r[i + bn] = (bignum_limb_t)carry;
+    }
+}
+
+/* r[0..rn) += x[0..xn)，进位向高位传播（调用者保证不会溢出 rn） */
+static void limbs_add_into(bignum_limb_t *r, size_t rn, const bignum_limb_t *x, size_t xn) {
+    bignum_limb_t carry = 0;
+    size_t i = 0;
+    for (; i < xn; i++) {
+        bignum_limb_t sum = r[i] + x[i] + carry;
+        carry = sum >= BIGNUM_LIMB_BASE;
+        r[i] = carry ? sum - BIGNUM_LIMB_BASE : sum;
+    }
+    for (; carry && i < rn; i++) {
+        bignum_limb_t sum = r[i] + 1;
+        carry = sum >= BIGNUM_LIMB_BASE;
+        r[i] = carry ? 0 : sum;
+    }
+}
+
+/*
+ * 乘法分级：
+ * - 较短操作数 < BIGNUM_KARATSUBA_THRESHOLD 个 limb 时使用基础算法
+ * - 两操作数长度悬殊时按较短操作数的长度分块相乘
+ * - 较短操作数 >= BIGNUM_TOOM3_THRESHOLD 时使用 Toom-3，否则使用 Karatsuba
+ * 所有递归层共用一次性分配的临时空间（大小由 limbs_mul_scratch_size 计算）
+ */
+#define BIGNUM_KARATSUBA_THRESHOLD 32
+#define BIGNUM_TOOM3_THRESHOLD     128
+
+static void limbs_mul_dispatch(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                               const bignum_limb_t *b, size_t bn, bignum_limb_t *scratch);
+
+/* Toom-3 求值/插值用的带符号中间值（数据区来自临时空间） */
+typedef struct {
+    bignum_limb_t *d;
+    size_t n;
+    int neg;
+} limbs_signed;
+
+/* x = y + z（带符号），x 可与 y 或 z 共用数据区 */
+static void limbs_signed_add(limbs_signed *x, limbs_signed y, limbs_signed z) {
+    if (y.neg == z.neg) {
+        x->n = limbs_add(x->d, y.d, y.n, z.d, z.n);
+        x->neg = y.neg;
+    } else if (limbs_cmp(y.d, y.n, z.d, z.n) >= 0) {
+        x->n = limbs_sub(x->d, y.d, y.n, z.d, z.n);
+        x->neg = y.neg;
     } else {
-        /* 其他类型：释放数据内存 */
-        if (num->is_large && num->data.large_data != NULL) {
-            free(num->data.large_data);
-            num->data.large_data = NULL;
+        x->n = limbs_sub(x->d, z.d, z.n, y.d, y.n);
+        x->neg = z.neg;
+    }
+    if (x->n == 1 && x->d[0] == 0) x->neg = 0;
+}
+
+/* x = y - z（带符号） */
+static void limbs_signed_sub(limbs_signed *x, limbs_signed y, limbs_signed z) {
+    z.neg = !z.neg;
+    limbs_signed_add(x, y, z);
+}
+
+/* x /= d（整除，d < 10^9） */
+static void limbs_signed_div_exact(limbs_signed *x, bignum_limb_t d) {
+    limbs_div_small(x->d, x->d, x->n, d);
+    x->n = limbs_normalize(x->d, x->n);
+}
+
+/* 将 [p, p+n) 视为非负数 */
+static limbs_signed limbs_signed_view(const bignum_limb_t *p, size_t n) {
+    limbs_signed v;
+    v.d = (bignum_limb_t *)p;
+    v.n = n > 0 ? limbs_normalize(p, n) : 0;
+    v.neg = 0;
+    if (n == 0) {
+        /* 空段按 0 处理，指向常量 0 */
+        static const bignum_limb_t zero = 0;
+        v.d = (bignum_limb_t *)&zero;
+        v.n = 1;
+    }
+    return v;
+}
+
+/* Karatsuba：要求 an >= bn >= (an + 1) / 2 */
+static void limbs_mul_karatsuba(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                                const bignum_limb_t *b, size_t bn, bignum_limb_t *scratch) {
+    size_t m = (an + 1) / 2;
+    size_t a1n = an - m;
+    size_t b1n = bn - m;
+    
+    /* z0 = a0 * b0 写入 r 低半部分，z2 = a1 * b1 写入 r 高半部分 */
+    limbs_mul_dispatch(r, a, m, b, m, scratch);
+    limbs_mul_dispatch(r + 2 * m, a + m, a1n, b + m, b1n, scratch);
+    
+    /* z1 = (a0 + a1) * (b0 + b1) - z0 - z2 */
+    bignum_limb_t *sa = scratch;
+    bignum_limb_t *sb = sa + (m + 1);
+    bignum_limb_t *z1 = sb + (m + 1);
+    bignum_limb_t *next = z1 + 2 * (m + 1);
+    
+    size_t san = limbs_add(sa, a, m, a + m, a1n);
+    size_t sbn = limbs_add(sb, b, m, b + m, b1n);
+    
+    limbs_mul_dispatch(z1, sa, san, sb, sbn, next);
+    size_t z1n = limbs_normalize(z1, san + sbn);
+    z1n = limbs_sub(z1, z1, z1n, r, limbs_normalize(r, 2 * m));
+    if (a1n + b1n > 0) {
+        z1n = limbs_sub(z1, z1, z1n, r + 2 * m, limbs_normalize(r + 2 * m, a1n + b1n));
+    }
+    
+    limbs_add_into(r + m, an + bn - m, z1, z1n);
+}
+
+/* Toom-3（求值点 0, 1, -1, -2, ∞）：要求 an >= bn > 2 * ((an + 2) / 3) */
+static void limbs_mul_toom3(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                            const bignum_limb_t *b, size_t bn, bignum_limb_t *scratch) {
+    size_t k = (an + 2) / 3;
+    size_t ecap = k + 2;        /* 求值结果容量 */
+    size_t pcap = 2 * ecap;     /* 点值乘积容量 */
+    
+    limbs_signed a0 = limbs_signed_view(a, k);
+    limbs_signed a1 = limbs_signed_view(a + k, k);
+    limbs_signed a2 = limbs_signed_view(a + 2 * k, an - 2 * k);
+    limbs_signed b0 = limbs_signed_view(b, k);
+    limbs_signed b1 = limbs_signed_view(b + k, k);
+    limbs_signed b2 = limbs_signed_view(b + 2 * k, bn - 2 * k);
+    
+    limbs_signed p1 = { scratch, 0, 0 };
+    limbs_signed pm1 = { p1.d + ecap, 0, 0 };
+    limbs_signed pm2 = { pm1.d + ecap, 0, 0 };
+    limbs_signed q1 = { pm2.d + ecap, 0, 0 };
+    limbs_signed qm1 = { q1.d + ecap, 0, 0 };
+    limbs_signed qm2 = { qm1.d + ecap, 0, 0 };
+    limbs_signed t = { qm2.d + ecap, 0, 0 };
+    limbs_signed r1 = { t.d + ecap, 0, 0 };
+    limbs_signed rm1 = { r1.d + pcap, 0, 0 };
+    limbs_signed rm2 = { rm1.d + pcap, 0, 0 };
+    bignum_limb_t *next = rm2.d + pcap;
+    
+    /* 求值：p(1) = a0 + a1 + a2, p(-1) = a0 - a1 + a2, p(-2) = (p(-1) + a2) * 2 - a0 */
+    limbs_signed_add(&t, a0, a2);
+    limbs_signed_add(&p1, t, a1);
+    limbs_signed_sub(&pm1, t, a1);
+    limbs_signed_add(&pm2, pm1, a2);
+    pm2.n = limbs_mul_small(pm2.d, pm2.d, pm2.n, 2, 0);
+    limbs_signed_sub(&pm2, pm2, a0);
+    
+    limbs_signed_add(&t, b0, b2);
+    limbs_signed_add(&q1, t, b1);
+    limbs_signed_sub(&qm1, t, b1);
+    limbs_signed_add(&qm2, qm1, b2);
+    qm2.n = limbs_mul_small(qm2.d, qm2.d, qm2.n, 2, 0);
+    limbs_signed_sub(&qm2, qm2, b0);
+    
+    /* 逐点相乘：r(0) 与 r(∞) 直接写入结果的低端和高端 */
+    memset(r, 0, (an + bn) * sizeof(bignum_limb_t));
+    limbs_mul_dispatch(r, a, k, b, k, next);
+    limbs_mul_dispatch(r + 4 * k, a + 2 * k, an - 2 * k, b + 2 * k, bn - 2 * k, next);
+    limbs_signed r0 = limbs_signed_view(r, 2 * k);
+    limbs_signed rinf = limbs_signed_view(r + 4 * k, an + bn - 4 * k);
+    
+    limbs_mul_dispatch(r1.d, p1.d, p1.n, q1.d, q1.n, next);
+    r1.n = limbs_normalize(r1.d, p1.n + q1.n);
+    limbs_mul_dispatch(rm1.d, pm1.d, pm1.n, qm1.d, qm1.n, next);
+    rm1.n = limbs_normalize(rm1.d, pm1.n + qm1.n);
+    rm1.neg = (pm1.neg != qm1.neg) && !(rm1.n == 1 && rm1.d[0] == 0);
+    limbs_mul_dispatch(rm2.d, pm2.d, pm2.n, qm2.d, qm2.n, next);
+    rm2.n = limbs_normalize(rm2.d, pm2.n + qm2.n);
+    rm2.neg = (pm2.neg != qm2.neg) && !(rm2.n == 1 && rm2.d[0] == 0);
+    
+    /* 插值（Bodrato 序列），r3 复用 rm2，r2 复用 rm1 */
+    limbs_signed *r3 = &rm2;
+    limbs_signed *r2 = &rm1;
+    limbs_signed_sub(r3, rm2, r1);
+    limbs_signed_div_exact(r3, 3);
+    limbs_signed_sub(&r1, r1, rm1);
+    limbs_signed_div_exact(&r1, 2);
+    limbs_signed_sub(r2, rm1, r0);
+    limbs_signed_sub(r3, *r2, *r3);
+    limbs_signed_div_exact(r3, 2);
+    limbs_signed_add(r3, *r3, rinf);
+    limbs_signed_add(r3, *r3, rinf);
+    limbs_signed_add(r2, *r2, r1);
+    limbs_signed_sub(r2, *r2, rinf);
+    limbs_signed_sub(&r1, r1, *r3);
+    
+    /* 重组：r += r1·B^k + r2·B^2k + r3·B^3k（各系数均非负） */
+    limbs_add_into(r + k, an + bn - k, r1.d, r1.n);
+    limbs_add_into(r + 2 * k, an + bn - 2 * k, r2->d, r2->n);
+    limbs_add_into(r + 3 * k, an + bn - 3 * k, r3->d, r3->n);
+}
+
+/*
+ * limbs_mul_dispatch 所需的临时空间上界（limb 个数）
+ * 三种分级算法每层使用的临时空间都不超过 5n + 40，且下一层规模不超过 n/2 + 2
+ */
+static size_t limbs_mul_scratch_size(size_t an, size_t bn) {
+    size_t n = an > bn ? an : bn;
+    size_t lo = an < bn ? an : bn;
+    if (lo < BIGNUM_KARATSUBA_THRESHOLD) return 0;
+    
+    size_t need = 0;
+    while (n >= BIGNUM_KARATSUBA_THRESHOLD) {
+        need += 5 * n + 40;
+        n = n / 2 + 2;
+    }
+    return need;
+}
+
+static void limbs_mul_dispatch(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                               const bignum_limb_t *b, size_t bn, bignum_limb_t *scratch) {
+    if (an < bn) {
+        const bignum_limb_t *t = a; a = b; b = t;
+        size_t tn = an; an = bn; bn = tn;
+    }
+    if (bn == 0) {
+        memset(r, 0, an * sizeof(bignum_limb_t));
+        return;
+    }
+    if (bn < BIGNUM_KARATSUBA_THRESHOLD) {
+        limbs_mul_basecase(r, a, an, b, bn);
+        return;
+    }
+    
+    if (2 * bn < an + 1) {
+        /* 长度悬殊：按 bn 分块，逐块相乘后累加 */
+        bignum_limb_t *prod = scratch;
+        memset(r, 0, (an + bn) * sizeof(bignum_limb_t));
+        for (size_t off = 0; off < an; off += bn) {
+            size_t chunk = an - off < bn ? an - off : bn;
+            limbs_mul_dispatch(prod, a + off, chunk, b, bn, scratch + 2 * bn);
+            limbs_add_into(r + off, an + bn - off, prod, chunk + bn);
         }
+        return;
     }
     
-    num->is_large = 0;
-    num->length = 0;
-    num->capacity = 0;
-    num->type = BIGNUM_TYPE_NULL;
+    if (bn >= BIGNUM_TOOM3_THRESHOLD && bn > 2 * ((an + 2) / 3)) {
+        limbs_mul_toom3(r, a, an, b, bn, scratch);
+    } else {
+        limbs_mul_karatsuba(r, a, an, b, bn, scratch);
+    }
+}
+
+/* r = a * b，r 需要 an + bn 个 limb，不能与 a/b 重叠 */
+static int limbs_mul(bignum_limb_t *r, const bignum_limb_t *a, size_t an,
+                     const bignum_limb_t *b, size_t bn) {
+    size_t need = limbs_mul_scratch_size(an, bn);
+    bignum_limb_t *scratch = NULL;
+    if (need > 0) {
+        scratch = (bignum_limb_t *)malloc(need * sizeof(bignum_limb_t));
+        if (scratch == NULL) return BIGNUM_ERROR;
+    }
+    
+    limbs_mul_dispatch(r, a, an, b, bn, scratch);
+    
+    free(scratch);
+    return BIGNUM_SUCCESS;
+}
+
+/*
+ * 除法分级：
+ * - 单 limb 除数使用 limbs_div_small，双 limb（机器字）除数使用 limbs_div_word
+ * - 除数达到 BIGNUM_NEWTON_THRESHOLD 个 limb、商在 BIGNUM_RECIPROCAL_THRESHOLD 与除数长度之间时，
+ *   用牛顿迭代求倒数再乘法求商（倒数本身短于 BIGNUM_RECIPROCAL_THRESHOLD 时直接做长除法）
+ * - 其余情况使用 Knuth 算法 D（商比除数长时倒数规模会随之变大，牛顿迭代反而更慢）
+ */
+#define BIGNUM_NEWTON_THRESHOLD     384
+#define BIGNUM_RECIPROCAL_THRESHOLD 96
+
+#ifdef __SIZEOF_INT128__
+/* q = a / d（10^9 <= d < 10^18，要求 a 的最高 limb 小于 d），q 需要 an - 1 个 limb，可与 a 重叠，返回余数 */
+static uint64_t limbs_div_word(bignum_limb_t *q, const bignum_limb_t *a, size_t an, uint64_t d) {
+    uint64_t rem = a[an - 1];
+    for (size_t i = an - 1; i-- > 0;) {
+        unsigned __int128 cur = (unsigned __int128)rem * BIGNUM_LIMB_BASE + a[i];
+        q[i] = (bignum_limb_t)(cur / d);
+        rem = (uint64_t)(cur % d);
+    }
+    return rem;
+}
+#endif
+
+/*
+ * 长除法（Knuth 算法 D，基数 10^9）：q = u / v, r = u % v
+ * 要求 un >= vn >= 2 且 v 已规范化；q 需要 un - vn + 1 个 limb，r 需要 vn 个 limb（可为 NULL）
+ */
+static int limbs_divmod_basecase(bignum_limb_t *q, bignum_limb_t *r,
+                                 const bignum_limb_t *u, size_t un, const bignum_limb_t *v, size_t vn) {
+    bignum_limb_t *nu = (bignum_limb_t *)malloc((un + 1 + vn) * sizeof(bignum_limb_t));
+    if (nu == NULL) return BIGNUM_ERROR;
+    bignum_limb_t *nv = nu + un + 1;
+    
+    /* 规范化：使除数最高 limb >= BASE/2 */
+    bignum_limb_t d = BIGNUM_LIMB_BASE / (v[vn - 1] + 1);
+    memset(nu, 0, (un + 1) * sizeof(bignum_limb_t));
+    limbs_mul_small(nu, u, un, d, 0);
+    limbs_mul_small(nv, v, vn, d, 0);
+    
+    uint64_t vtop = nv[vn - 1];
+    uint64_t vsec = nv[vn - 2];
+    
+    for (size_t j = un - vn + 1; j-- > 0;) {
+        uint64_t num = (uint64_t)nu[j + vn] * BIGNUM_LIMB_BASE + nu[j + vn - 1];
+        uint64_t qhat = num / vtop;
+        uint64_t rhat = num % vtop;
+        while (qhat >= BIGNUM_LIMB_BASE || qhat * vsec > rhat * BIGNUM_LIMB_BASE + nu[j + vn - 2]) {
+            qhat--;
+            rhat += vtop;
+            if (rhat >= BIGNUM_LIMB_BASE) break;
+        }
+        
+        /* nu[j..j+vn] -= qhat * nv */
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < vn; i++) {
+            uint64_t p = qhat * nv[i] + carry;
+            carry = p / BIGNUM_LIMB_BASE;
+            int64_t t = (int64_t)nu[i + j] - (int64_t)(p % BIGNUM_LIMB_BASE) - borrow;
+            borrow = t < 0;
+            nu[i + j] = (bignum_limb_t)(t < 0 ? t + BIGNUM_LIMB_BASE : t);
+        }
+        int64_t top = (int64_t)nu[j + vn] - (int64_t)carry - borrow;
+        
+        /* 估计值大了 1，加回一次除数 */
+        if (top < 0) {
+            qhat--;
+            bignum_limb_t c = 0;
+            for (size_t i = 0; i < vn; i++) {
+                bignum_limb_t sum = nu[i + j] + nv[i] + c;
+                c = sum >= BIGNUM_LIMB_BASE;
+                nu[i + j] = c ? sum - BIGNUM_LIMB_BASE : sum;
+            }
+            top += c;
+        }
+        nu[j + vn] = (bignum_limb_t)top;
+        q[j] = (bignum_limb_t)qhat;
+    }
+    
+    if (r != NULL) {
+        limbs_div_small(r, nu, vn, d);
+    }
+    free(nu);
+    return BIGNUM_SUCCESS;
+}
+
+/*
+ * 牛顿迭代求倒数：x ≈ B^(2n) / v（B = 10^9），v 为 n 个 limb 且最高 limb 非0
+ * 结果满足 B^(2n)/v - 3 <= x <= B^(2n)/v；x 需要 n + 2 个 limb，返回 x 的长度，失败返回0
+ */
+static size_t limbs_reciprocal(bignum_limb_t *x, const bignum_limb_t *v, size_t n) {
+    static const bignum_limb_t one = 1;
+    if (n < BIGNUM_RECIPROCAL_THRESHOLD) {
+        /* 规模较小时直接用长除法求 B^(2n) / v */
+        bignum_limb_t *num = (bignum_limb_t *)calloc(2 * n + 1, sizeof(bignum_limb_t));
+        if (num == NULL) return 0;
+        num[2 * n] = 1;
+        int ret = BIGNUM_SUCCESS;
+        if (n == 1) {
+            limbs_div_small(x, num, 2 * n + 1, v[0]);
+        } else {
+            ret = limbs_divmod_basecase(x, NULL, num, 2 * n + 1, v, n);
+        }
+        free(num);
+        return ret == BIGNUM_SUCCESS ? limbs_normalize(x, n + 2) : 0;
+    }
+    
+    /*
+     * 先求高 h 个 limb 的倒数 xh，x0 = xh * B^(n-h) 已有约 h 个 limb 的精度
+     * 一次牛顿迭代：x = x0 + x0 * (B^(2n) - v * x0) / B^(2n)
+     *               = x0 + xh * (B^(n+h) - v * xh) / B^(2h)
+     * 多取两个 limb 保证迭代后误差不超过 3
+     */
+    size_t h = (n + 1) / 2 + 2;
+    size_t en = n + h + 2;
+    bignum_limb_t *work = (bignum_limb_t *)malloc((h + 2 + 2 * en + (h + 2 + en)) * sizeof(bignum_limb_t));
+    if (work == NULL) return 0;
+    bignum_limb_t *xh = work;
+    bignum_limb_t *p = xh + h + 2;
+    bignum_limb_t *pw = p + en;
+    bignum_limb_t *t = pw + en;
+    
+    size_t xhn = limbs_reciprocal(xh, v + n - h, h);
+    if (xhn == 0 || limbs_mul(p, v, n, xh, xhn) != BIGNUM_SUCCESS) {
+        free(work);
+        return 0;
+    }
+    size_t pn = limbs_normalize(p, n + xhn);
+    
+    /* e = |B^(n+h) - v * xh|，结果写回 p */
+    memset(pw, 0, (n + h + 1) * sizeof(bignum_limb_t));
+    pw[n + h] = 1;
+    int negative = limbs_cmp(p, pn, pw, n + h + 1) > 0;
+    if (negative) {
+        pn = limbs_sub(p, p, pn, pw, n + h + 1);
+    } else {
+        pn = limbs_sub(p, pw, n + h + 1, p, pn);
+    }
+    
+    /* 修正量 c = xh * e / B^(2h)（x 需要减去时向上取整，保证结果不超过真实倒数） */
+    if (limbs_mul(t, xh, xhn, p, pn) != BIGNUM_SUCCESS) {
+        free(work);
+        return 0;
+    }
+    size_t tn = limbs_normalize(t, xhn + pn);
+    bignum_limb_t *c = t + 2 * h;
+    size_t cn = tn > 2 * h ? tn - 2 * h : 0;
+    if (negative) {
+        int inexact = 0;
+        for (size_t i = 0; i < 2 * h && i < tn; i++) {
+            if (t[i] != 0) {
+                inexact = 1;
+                break;
+            }
+        }
+        if (cn == 0) {
+            c = t;
+            c[0] = 0;
+            cn = 1;
+        }
+        if (inexact) cn = limbs_add(c, c, cn, &one, 1);
+    }
+    
+    /* x = xh * B^(n-h) ± c */
+    memset(x, 0, (n + 2) * sizeof(bignum_limb_t));
+    memcpy(x + n - h, xh, xhn * sizeof(bignum_limb_t));
+    if (negative) {
+        limbs_sub(x, x, n + 2, c, cn);
+    } else if (cn > 0) {
+        limbs_add_into(x, n + 2, c, cn);
+    }
+    
+    free(work);
+    return limbs_normalize(x, n + 2);
+}
+
+/*
+ * 牛顿迭代除法：q = u / v, r = u % v（要求 un >= vn，v 已规范化）
+ * 用除数高 m 个 limb 的倒数乘以被除数得到估计商，再用完整余数修正
+ * q 需要 un - vn + 1 个 limb，r 需要 vn 个 limb（可为 NULL）
+ */
+static int limbs_divmod_newton(bignum_limb_t *q, bignum_limb_t *r,
+                               const bignum_limb_t *u, size_t un, const bignum_limb_t *v, size_t vn) {
+    static const bignum_limb_t one = 1;
+    size_t k = un - vn + 1;
+    
+    /*
+     * 倒数需要 m = k + 2 个 limb 的精度，估计商的误差才不超过几个单位：
+     * 除数更长时只取高 m 个 limb（被除数同样去掉低 s 个 limb）；
+     * 除数更短时在低位补 z 个零 limb，相当于被除数和除数同乘 B^z
+     */
+    size_t m = k + 2;
+    size_t s = vn > m ? vn - m : 0;
+    size_t z = vn < m ? m - vn : 0;
+    const bignum_limb_t *ut = u + s;
+    size_t utn = un - s;
+    
+    bignum_limb_t *work = (bignum_limb_t *)malloc((m + (m + 2) + (utn + m + 2) + (k + 2) + (un + 3)) *
+                                                  sizeof(bignum_limb_t));
+    if (work == NULL) return BIGNUM_ERROR;
+    bignum_limb_t *vt = work;
+    bignum_limb_t *x = vt + m;
+    bignum_limb_t *t = x + m + 2;
+    bignum_limb_t *qe = t + utn + m + 2;
+    bignum_limb_t *p = qe + k + 2;
+    memset(vt, 0, z * sizeof(bignum_limb_t));
+    memcpy(vt + z, v + s, (m - z) * sizeof(bignum_limb_t));
+    
+    size_t xn = limbs_reciprocal(x, vt, m);
+    if (xn == 0 || limbs_mul(t, ut, utn, x, xn) != BIGNUM_SUCCESS) {
+        free(work);
+        return BIGNUM_ERROR;
+    }
+    
+    /* 估计商 qe = ut * B^z * x / B^(2m) */
+    size_t tn = limbs_normalize(t, utn + xn);
+    size_t sh = 2 * m - z;
+    size_t qn = 1;
+    memset(qe, 0, (k + 2) * sizeof(bignum_limb_t));
+    if (tn > sh) {
+        qn = tn - sh;
+        memcpy(qe, t + sh, qn * sizeof(bignum_limb_t));
+    }
+    
+    /* 用 p = qe * v 修正：估计商偏大时逐次减一 */
+    if (limbs_mul(p, qe, qn, v, vn) != BIGNUM_SUCCESS) {
+        free(work);
+        return BIGNUM_ERROR;
+    }
+    size_t pn = limbs_normalize(p, qn + vn);
+    while (limbs_cmp(p, pn, u, un) > 0) {
+        qn = limbs_sub(qe, qe, qn, &one, 1);
+        pn = limbs_sub(p, p, pn, v, vn);
+    }
+    
+    /* 余数 = u - p，估计商偏小时逐次加一 */
+    pn = limbs_sub(p, u, un, p, pn);
+    while (limbs_cmp(p, pn, v, vn) >= 0) {
+        qn = limbs_add(qe, qe, qn, &one, 1);
+        pn = limbs_sub(p, p, pn, v, vn);
+    }
+    
+    memset(q, 0, k * sizeof(bignum_limb_t));
+    memcpy(q, qe, (qn < k ? qn : k) * sizeof(bignum_limb_t));
+    if (r != NULL) {
+        memset(r, 0, vn * sizeof(bignum_limb_t));
+        memcpy(r, p, pn * sizeof(bignum_limb_t));
+    }
+    
+    free(work);
+    return BIGNUM_SUCCESS;
+}
+
+/*
+ * q = u / v, r = u % v（u、v 已规范化，v != 0）
+ * q 需要 max(un - vn + 1, 1) 个 limb，r 需要 vn 个 limb（可为 NULL）
+ */
+static int limbs_divmod(bignum_limb_t *q, bignum_limb_t *r,
+                        const bignum_limb_t *u, size_t un, const bignum_limb_t *v, size_t vn) {
+    if (un < vn) {
+        q[0] = 0;
+        if (r != NULL) {
+            memset(r, 0, vn * sizeof(bignum_limb_t));
+            memcpy(r, u, un * sizeof(bignum_limb_t));
+        }
+        return BIGNUM_SUCCESS;
+    }
+    
+    if (vn == 1) {
+        bignum_limb_t rem = limbs_div_small(q, u, un, v[0]);
+        if (r != NULL) r[0] = rem;
+        return BIGNUM_SUCCESS;
+    }
+
+#ifdef __SIZEOF_INT128__
+    if (vn == 2) {
+        uint64_t d = (uint64_t)v[1] * BIGNUM_LIMB_BASE + v[0];
+        uint64_t rem = limbs_div_word(q, u, un, d);
+        if (r != NULL) {
+            r[0] = (bignum_limb_t)(rem % BIGNUM_LIMB_BASE);
+            r[1] = (bignum_limb_t)(rem / BIGNUM_LIMB_BASE);
+        }
+        return BIGNUM_SUCCESS;
+    }
+#endif
+
+    size_t k = un - vn + 1;
+    if (vn >= BIGNUM_NEWTON_THRESHOLD && k >= BIGNUM_RECIPROCAL_THRESHOLD && k <= vn) {
+        return limbs_divmod_newton(q, r, u, un, v, vn);
+    }
+    return limbs_divmod_basecase(q, r, u, un, v, vn);
+}
+
+/* dst = src * 10^k，dst 需要 n + k/9 + 1 个 limb，可与 src 相同，返回规范化后的长度 */
+static size_t limbs_shl_dec(bignum_limb_t *dst, const bignum_limb_t *src, size_t n, size_t k) {
+    size_t shift = k / BIGNUM_LIMB_DIGITS;
+    size_t rem = k % BIGNUM_LIMB_DIGITS;
+    memmove(dst + shift, src, n * sizeof(bignum_limb_t));
+    memset(dst, 0, shift * sizeof(bignum_limb_t));
+    n += shift;
+    if (rem > 0) {
+        n = limbs_mul_small(dst, dst, n, bignum_pow10[rem], 0);
+    }
+    return limbs_normalize(dst, n);
+}
+
+/* a = floor(a / 10^k)（原地），返回规范化后的长度 */
+static size_t limbs_shr_dec(bignum_limb_t *a, size_t n, size_t k) {
+    size_t shift = k / BIGNUM_LIMB_DIGITS;
+    size_t rem = k % BIGNUM_LIMB_DIGITS;
+    if (shift >= n) {
+        a[0] = 0;
+        return 1;
+    }
+    memmove(a, a + shift, (n - shift) * sizeof(bignum_limb_t));
+    n -= shift;
+    if (rem > 0) {
+        limbs_div_small(a, a, n, bignum_pow10[rem]);
+    }
+    return limbs_normalize(a, n);
 }
 
 /* 确保有足够容量，必要时扩展 */
@@ -95,12 +925,16 @@ static int bignum_ensure_capacity(BHS *num, int required_capacity) {
     if (num == NULL) return BIGNUM_ERROR;
     
     /* 检查数字类型的限制 - 临时计算允许使用更大空间 */
-    if (num->type == BIGNUM_TYPE_NUMBER && required_capacity > BIGNUM_MAX_DIGITS * 2) {
+    if (num->type == BIGNUM_TYPE_NUMBER &&
+        required_capacity > (int)(BIGNUM_MAX_LIMBS * 2 * sizeof(bignum_limb_t))) {
         return BIGNUM_ERROR;  /* 临时计算空间最多允许 2 倍限制 */
     }
     
+    /* 调用者随后会原地写入，共享的数据区先复制一份 */
+    if (bignum_make_unique(num) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
+    
     /* 字符串类型无限制，数字类型有限制 */
-    if (required_capacity <= num->capacity) {
+    if (required_capacity <= (int)num->capacity) {
         return BIGNUM_SUCCESS;  /* 容量足够 */
     }
     
@@ -114,14 +948,17 @@ static int bignum_ensure_capacity(BHS *num, int required_capacity) {
         }
         
         /* 需要切换到大数据模式 */
-        char *new_data = (char *)malloc(new_capacity);
+        char *new_data = bignum_payload_alloc(new_capacity);
         if (new_data == NULL) return BIGNUM_ERROR;
         
-        /* 复制旧数据 - 对于 bitmap 类型，需要转换位数到字节数 */
+        /* 复制旧数据 - 对于 bitmap 类型，需要转换位数到字节数；数字类型按 limb 计算 */
         size_t copy_size = num->length;
         if (num->type == BIGNUM_TYPE_BITMAP) {
             copy_size = (num->length + 7) / 8;
+        } else if (num->type == BIGNUM_TYPE_NUMBER) {
+            copy_size = num->length * sizeof(bignum_limb_t);
         }
+        if (copy_size > BIGNUM_SMALL_SIZE) copy_size = BIGNUM_SMALL_SIZE;
         memcpy(new_data, num->data.small_data, copy_size);
         memset(new_data + copy_size, 0, new_capacity - copy_size);
         
@@ -131,11 +968,11 @@ static int bignum_ensure_capacity(BHS *num, int required_capacity) {
         num->capacity = new_capacity;
     } else {
         /* 已经是大数据模式，重新分配 */
-        char *new_data = (char *)realloc(num->data.large_data, new_capacity);
+        char *new_data = bignum_payload_realloc(num->data.large_data, new_capacity);
         if (new_data == NULL) return BIGNUM_ERROR;
         
         /* 清零新分配的部分 */
-        if (new_capacity > num->capacity) {
+        if (new_capacity > (int)num->capacity) {
             memset(new_data + num->capacity, 0, new_capacity - num->capacity);
         }
         
@@ -146,12 +983,30 @@ static int bignum_ensure_capacity(BHS *num, int required_capacity) {
     return BIGNUM_SUCCESS;
 }
 
+/* 确保数字类型至少能容纳 limbs 个 limb */
+static int bignum_reserve_limbs(BHS *num, size_t limbs) {
+    return bignum_ensure_capacity(num, (int)(limbs * sizeof(bignum_limb_t)));
+}
+
+/* 判断数字是否为0 */
+static int bignum_is_zero(const BHS *num) {
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    return limbs_normalize(limbs, num->length) == 1 && limbs[0] == 0;
+}
+
+/* 数字的十进制位数（含小数部分） */
+static size_t bignum_digit_count(const BHS *num) {
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    return limbs_digit_count(limbs, limbs_normalize(limbs, num->length));
+}
+
 /* 复制BigNum */
 int bignum_copy(const BHS *src, BHS *dst) {
     if (src == NULL || dst == NULL) return BIGNUM_ERROR;
+    if (src == dst) return BIGNUM_SUCCESS;
     
     /* 检查源数据长度是否在最终结果的合法范围内 */
-    if (src->type == BIGNUM_TYPE_NUMBER && src->length > BIGNUM_MAX_DIGITS) {
+    if (src->type == BIGNUM_TYPE_NUMBER && bignum_digit_count(src) > BIGNUM_MAX_DIGITS) {
         return BIGNUM_ERROR;  /* 最终结果超出限制 */
     }
     
@@ -165,32 +1020,29 @@ int bignum_copy(const BHS *src, BHS *dst) {
     
     /* 根据类型复制数据 */
     if (src->type == BIGNUM_TYPE_LIST) {
-        /* 列表类型：复制LIST指针 */
-        if (src->data.list != NULL) {
-            LIST *new_list = list_copy(src->data.list);
-            if (new_list == NULL) {
-                return BIGNUM_ERROR;
-            }
-            dst->data.list = new_list;
-        } else {
-            dst->data.list = NULL;
+        /* 列表类型：共享LIST，修改前由 bignum_make_unique() 复制 */
+        LIST *list = (LIST *)src->data.list;
+        if (list != NULL) {
+            __atomic_add_fetch(&list->refcount, 1, __ATOMIC_RELAXED);
         }
+        dst->data.list = src->data.list;
         dst->is_large = 0;  /* 列表类型不使用large_data */
         dst->capacity = 0;
     } else {
         /* 其他类型：复制数据内容 */
         size_t copy_size = src->length;
-        /* 对于 bitmap 类型，length 是位数，需要转换为字节数 */
+        /* 对于 bitmap 类型，length 是位数，需要转换为字节数；数字类型 length 是 limb 数 */
         if (src->type == BIGNUM_TYPE_BITMAP) {
             copy_size = (src->length + 7) / 8;
+        } else if (src->type == BIGNUM_TYPE_NUMBER) {
+            copy_size = src->length * sizeof(bignum_limb_t);
         }
         
         if (src->is_large) {
-            /* 源是大数据 */
-            if (bignum_ensure_capacity(dst, src->capacity) != BIGNUM_SUCCESS) {
-                return BIGNUM_ERROR;
-            }
-            memcpy(BIGNUM_DIGITS(dst), BIGNUM_DIGITS(src), copy_size);
+            /* 源是大数据：共享数据区 */
+            dst->is_large = 1;
+            dst->capacity = src->capacity;
+            dst->data.large_data = bignum_payload_share(src->data.large_data);
         } else {
             /* 源是小数据 */
             dst->is_large = 0;
@@ -202,166 +1054,347 @@ int bignum_copy(const BHS *src, BHS *dst) {
     return BIGNUM_SUCCESS;
 }
 
-/* 移除前导零 */
+/* 移除高位零 limb 和小数部分末尾的0 */
 static void bignum_trim(BHS *num) {
-    char *digits = BIGNUM_DIGITS(num);
-    
-    /* 去除高位的0 */
-    while (num->length > 1 && digits[num->length - 1] == 0) {
-        num->length--;
-    }
-    
-    /* 去除小数部分低位的0 */
-    if (num->type == BIGNUM_TYPE_NUMBER && num->type_data.num.decimal_pos > 0) {
-        int trailing_zeros = 0;
-        /* 从最低位开始数有多少个连续的0 */
-        for (int i = 0; i < num->type_data.num.decimal_pos && i < num->length; i++) {
-            if (digits[i] == 0) {
-                trailing_zeros++;
-            } else {
-                break;
-            }
+    if (num->type != BIGNUM_TYPE_NUMBER) return;
+    if (bignum_make_unique(num) != BIGNUM_SUCCESS) return;  /* 无法复制时保持原样，数值不变 */
+    
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
+    int scale = num->type_data.num.decimal_pos;
+    
+    /* 去除小数部分低位整个为0的 limb */
+    size_t drop = 0;
+    while (scale >= BIGNUM_LIMB_DIGITS && drop + 1 < n && limbs[drop] == 0) {
+        drop++;
+        scale -= BIGNUM_LIMB_DIGITS;
+    }
+    if (drop > 0) {
+        memmove(limbs, limbs + drop, (n - drop) * sizeof(bignum_limb_t));
+        n -= drop;
+    }
+    
+    /* 去除剩余不足一个 limb 的末尾0 */
+    if (scale > 0 && !(n == 1 && limbs[0] == 0)) {
+        int k = 0;
+        bignum_limb_t low = limbs[0];
+        while (k < scale && k < BIGNUM_LIMB_DIGITS && low % 10 == 0) {
+            low /= 10;
+            k++;
         }
-        
-        /* 如果有尾部的0，需要移除它们 */
-        if (trailing_zeros > 0) {
-            /* 将数字向左移动（去除低位的0） */
-            for (size_t i = 0; i < num->length - trailing_zeros; i++) {
-                digits[i] = digits[i + trailing_zeros];
-            }
-            num->length -= trailing_zeros;
-            num->type_data.num.decimal_pos -= trailing_zeros;
+        if (k > 0) {
+            limbs_div_small(limbs, limbs, n, bignum_pow10[k]);
+            n = limbs_normalize(limbs, n);
+            scale -= k;
         }
     }
     
-    /* 如果结果是0，设置为正数（仅数字类型） */
-    if (num->type == BIGNUM_TYPE_NUMBER && num->length == 1 && digits[0] == 0) {
+    num->length = n;
+    num->type_data.num.decimal_pos = scale;
+    
+    /* 如果结果是0，设置为正数 */
+    if (n == 1 && limbs[0] == 0) {
         num->type_data.num.is_negative = 0;
         num->type_data.num.decimal_pos = 0;
     }
 }
 
-/* 比较两个大数的绝对值 (返回: 1 if a>b, 0 if a==b, -1 if a<b) */
-static int bignum_compare_abs(const BHS *a, const BHS *b) {
-    /* 先比较整数部分长度 */
-    int a_int_len = a->length - a->type_data.num.decimal_pos;
-    int b_int_len = b->length - b->type_data.num.decimal_pos;
+/* 截断小数位数到 precision 位（直接舍去） */
+static void bignum_truncate_scale(BHS *num, int precision) {
+    if (num->type_data.num.decimal_pos <= precision) return;
+    if (bignum_make_unique(num) != BIGNUM_SUCCESS) return;
+    
+    size_t excess = (size_t)(num->type_data.num.decimal_pos - precision);
+    num->length = limbs_shr_dec(BIGNUM_LIMBS(num), num->length, excess);
+    num->type_data.num.decimal_pos = precision;
+    bignum_trim(num);
+}
+
+/* 总位数超过 BIGNUM_MAX_DIGITS 时优先舍弃小数位，整数部分仍超限则返回错误 */
+static int bignum_clamp_digits(BHS *num) {
+    size_t digits = bignum_digit_count(num);
+    if (digits <= BIGNUM_MAX_DIGITS) return BIGNUM_SUCCESS;
     
-    if (a_int_len > b_int_len) return 1;
-    if (a_int_len < b_int_len) return -1;
+    int to_remove = (int)(digits - BIGNUM_MAX_DIGITS);
+    if (to_remove > num->type_data.num.decimal_pos) {
+        to_remove = num->type_data.num.decimal_pos;
+    }
+    if (to_remove > 0) {
+        bignum_truncate_scale(num, num->type_data.num.decimal_pos - to_remove);
+    }
     
-    char *a_digits = BIGNUM_DIGITS(a);
-    char *b_digits = BIGNUM_DIGITS(b);
+    return bignum_digit_count(num) > BIGNUM_MAX_DIGITS ? BIGNUM_ERROR : BIGNUM_SUCCESS;
+}
+
+/*
+ * 取 num 在小数位数 scale（>= 自身小数位数）下的 limb 表示
+ * 小数位数相同时直接返回内部数组；否则分配新数组写入 *owned，由调用者释放
+ */
+static const bignum_limb_t *bignum_aligned_limbs(const BHS *num, int scale, size_t *out_len,
+                                                 bignum_limb_t **owned) {
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
+    *owned = NULL;
     
-    /* 从高位到低位比较 */
-    for (int i = a->length - 1; i >= 0; i--) {
-        int b_idx = i - a->type_data.num.decimal_pos + b->type_data.num.decimal_pos;
-        int b_digit = (b_idx >= 0 && b_idx < b->length) ? b_digits[b_idx] : 0;
-        int a_digit = a_digits[i];
-        
-        if (a_digit > b_digit) return 1;
-        if (a_digit < b_digit) return -1;
+    if (scale <= num->type_data.num.decimal_pos) {
+        *out_len = n;
+        return limbs;
     }
     
-    /* 检查b是否有更多的小数位 */
-    for (int i = a->type_data.num.decimal_pos; i < b->type_data.num.decimal_pos; i++) {
-        if (i < b->length && b_digits[i] != 0) return -1;
-    }
+    size_t k = (size_t)(scale - num->type_data.num.decimal_pos);
+    bignum_limb_t *buf = (bignum_limb_t *)malloc((n + k / BIGNUM_LIMB_DIGITS + 1) * sizeof(bignum_limb_t));
+    if (buf == NULL) return NULL;
     
-    return 0;
+    *out_len = limbs_shl_dec(buf, limbs, n, k);
+    *owned = buf;
+    return buf;
 }
 
-/* 大数绝对值加法（忽略符号） */
-static int bignum_add_abs(const BHS *a, const BHS *b, BHS *result) {
-    int max_decimal = (a->type_data.num.decimal_pos > b->type_data.num.decimal_pos) ? a->type_data.num.decimal_pos : b->type_data.num.decimal_pos;
-    int max_len = ((a->length - a->type_data.num.decimal_pos) > (b->length - b->type_data.num.decimal_pos)) ? 
-                   (a->length - a->type_data.num.decimal_pos) : (b->length - b->type_data.num.decimal_pos);
-    max_len += max_decimal;
+/* 比较两个大数的绝对值 (返回: 1 if a>b, 0 if a==b, -1 if a<b) */
+static int bignum_compare_abs(const BHS *a, const BHS *b) {
+    int a_zero = bignum_is_zero(a);
+    int b_zero = bignum_is_zero(b);
+    if (a_zero || b_zero) return b_zero - a_zero;
+    
+    /* 先比较最高有效位的数量级（整数部分位数） */
+    long a_mag = (long)bignum_digit_count(a) - a->type_data.num.decimal_pos;
+    long b_mag = (long)bignum_digit_count(b) - b->type_data.num.decimal_pos;
+    if (a_mag != b_mag) return a_mag > b_mag ? 1 : -1;
+    
+    /* 对齐小数位后逐 limb 比较 */
+    int scale = a->type_data.num.decimal_pos > b->type_data.num.decimal_pos ?
+                a->type_data.num.decimal_pos : b->type_data.num.decimal_pos;
+    bignum_limb_t *a_owned, *b_owned;
+    size_t an, bn;
+    const bignum_limb_t *al = bignum_aligned_limbs(a, scale, &an, &a_owned);
+    const bignum_limb_t *bl = bignum_aligned_limbs(b, scale, &bn, &b_owned);
+    
+    int cmp = 0;
+    if (al != NULL && bl != NULL) {
+        cmp = limbs_cmp(al, an, bl, bn);
+    }
+    
+    free(a_owned);
+    free(b_owned);
+    return cmp;
+}
+
+/* 大数绝对值加法/减法（忽略符号），subtract 为真时计算 |a| - |b|（假设 |a| >= |b|） */
+static int bignum_addsub_abs(const BHS *a, const BHS *b, BHS *result, int subtract) {
+    int max_decimal = (a->type_data.num.decimal_pos > b->type_data.num.decimal_pos) ?
+                      a->type_data.num.decimal_pos : b->type_data.num.decimal_pos;
+    
+    bignum_limb_t *a_owned, *b_owned;
+    size_t an, bn;
+    const bignum_limb_t *al = bignum_aligned_limbs(a, max_decimal, &an, &a_owned);
+    const bignum_limb_t *bl = bignum_aligned_limbs(b, max_decimal, &bn, &b_owned);
+    if (al == NULL || bl == NULL) {
+        free(a_owned);
+        free(b_owned);
+        return BIGNUM_ERROR;
+    }
     
     bignum_free(result);
     bignum_init(result);
     result->type = a->type;  /* 继承类型 */
     
-    /* 确保容量足够（需要max_len + 1用于进位） */
-    if (bignum_ensure_capacity(result, max_len + 2) != BIGNUM_SUCCESS) {
+    /* 确保容量足够（需要 +1 用于进位） */
+    size_t max_len = (an > bn ? an : bn) + 1;
+    if (bignum_reserve_limbs(result, max_len) != BIGNUM_SUCCESS) {
+        free(a_owned);
+        free(b_owned);
         return BIGNUM_ERROR;
     }
     
-    result->type_data.num.decimal_pos = max_decimal;
-    
-    char *a_digits = BIGNUM_DIGITS(a);
-    char *b_digits = BIGNUM_DIGITS(b);
-    char *result_digits = BIGNUM_DIGITS(result);
-    
-    int carry = 0;
-    int result_len = 0;
-    
-    for (int i = 0; i < max_len + 1; i++) {
-        int a_idx = i - max_decimal + a->type_data.num.decimal_pos;
-        int b_idx = i - max_decimal + b->type_data.num.decimal_pos;
-        
-        int a_digit = (a_idx >= 0 && a_idx < a->length) ? a_digits[a_idx] : 0;
-        int b_digit = (b_idx >= 0 && b_idx < b->length) ? b_digits[b_idx] : 0;
-        
-        int sum = a_digit + b_digit + carry;
-        result_digits[i] = sum % 10;
-        carry = sum / 10;
-        result_len = i + 1;
-        
-        if (i >= max_len && carry == 0) break;
+    bignum_limb_t *result_limbs = BIGNUM_LIMBS(result);
+    if (subtract) {
+        result->length = limbs_sub(result_limbs, al, an, bl, bn);
+    } else {
+        result->length = limbs_add(result_limbs, al, an, bl, bn);
     }
+    result->type_data.num.decimal_pos = max_decimal;
     
-    result->length = result_len;
+    free(a_owned);
+    free(b_owned);
     bignum_trim(result);
     return BIGNUM_SUCCESS;
 }
 
+/* 大数绝对值加法（忽略符号） */
+static int bignum_add_abs(const BHS *a, const BHS *b, BHS *result) {
+    return bignum_addsub_abs(a, b, result, 0);
+}
+
 /* 大数绝对值减法（a - b，假设 a >= b） */
 static int bignum_sub_abs(const BHS *a, const BHS *b, BHS *result) {
-    int max_decimal = (a->type_data.num.decimal_pos > b->type_data.num.decimal_pos) ? a->type_data.num.decimal_pos : b->type_data.num.decimal_pos;
+    return bignum_addsub_abs(a, b, result, 1);
+}
+
+/* 判断数字是否含有非零小数部分 */
+static int bignum_has_fraction(const BHS *num) {
+    int scale = num->type_data.num.decimal_pos;
+    if (scale <= 0) return 0;
     
-    bignum_free(result);
-    bignum_init(result);
-    result->type = a->type;  /* 继承类型 */
-    result->type_data.num.decimal_pos = max_decimal;
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
+    size_t full = (size_t)scale / BIGNUM_LIMB_DIGITS;
+    size_t rem = (size_t)scale % BIGNUM_LIMB_DIGITS;
     
-    int max_len = (a->length > max_decimal) ? a->length : max_decimal;
-    if (bignum_ensure_capacity(result, max_len + 1) != BIGNUM_SUCCESS) {
-        return BIGNUM_ERROR;
+    for (size_t i = 0; i < full && i < n; i++) {
+        if (limbs[i] != 0) return 1;
     }
-    
-    char *a_digits = BIGNUM_DIGITS(a);
-    char *b_digits = BIGNUM_DIGITS(b);
-    char *result_digits = BIGNUM_DIGITS(result);
-    
-    int borrow = 0;
-    int result_len = 0;
-    
-    for (int i = 0; i < a->length || i < max_decimal; i++) {
-        int a_idx = i - max_decimal + a->type_data.num.decimal_pos;
-        int b_idx = i - max_decimal + b->type_data.num.decimal_pos;
-        
-        int a_digit = (a_idx >= 0 && a_idx < a->length) ? a_digits[a_idx] : 0;
-        int b_digit = (b_idx >= 0 && b_idx < b->length) ? b_digits[b_idx] : 0;
-        
-        int diff = a_digit - b_digit - borrow;
-        if (diff < 0) {
-            diff += 10;
-            borrow = 1;
-        } else {
-            borrow = 0;
+    if (full < n && rem > 0 && limbs[full] % bignum_pow10[rem] != 0) return 1;
+    return 0;
+}
+
+/* 取数字整数部分的绝对值（截断小数），溢出返回 BIGNUM_ERROR */
+static int bignum_int_part_u64(const BHS *num, uint64_t *out) {
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
+    bignum_limb_t stack_buf[BIGNUM_SMALL_SIZE / sizeof(bignum_limb_t)];
+    bignum_limb_t *buf = stack_buf;
+    
+    if (n > BIGNUM_SMALL_SIZE / sizeof(bignum_limb_t)) {
+        buf = (bignum_limb_t *)malloc(n * sizeof(bignum_limb_t));
+        if (buf == NULL) return BIGNUM_ERROR;
+    }
+    memcpy(buf, limbs, n * sizeof(bignum_limb_t));
+    n = limbs_shr_dec(buf, n, (size_t)num->type_data.num.decimal_pos);
+    
+    int ret = BIGNUM_SUCCESS;
+    uint64_t value = 0;
+    for (size_t i = n; i-- > 0;) {
+        if (value > (UINT64_MAX - buf[i]) / BIGNUM_LIMB_BASE) {
+            ret = BIGNUM_ERROR;
+            break;
         }
-        
-        result_digits[i] = diff;
-        result_len = i + 1;
+        value = value * BIGNUM_LIMB_BASE + buf[i];
     }
     
-    result->length = result_len;
-    bignum_trim(result);
-    return BIGNUM_SUCCESS;
+    if (buf != stack_buf) free(buf);
+    *out = value;
+    return ret;
+}
+
+/* 读取立即数的值（调用前需确认 BIGNUM_IS_IMM） */
+static inline int64_t bignum_imm_get(const BHS *num) {
+    const bignum_limb_t *limbs = (const bignum_limb_t *)num->data.small_data;
+    int64_t value = limbs[0];
+    if (num->length == BIGNUM_IMM_LIMBS) {
+        value += (int64_t)limbs[1] * BIGNUM_LIMB_BASE;
+    }
+    return num->type_data.num.is_negative ? -value : value;
 }
 
 
+/* ========== 十进制数字串转换（SIMD 加速，无 SIMD 时退回标量实现） ========== */
+
+/* s[0..n) 是否全部为 '0'~'9'（字节按有符号比较，>= 0x80 的字节必然不通过） */
+static int dec_all_digits(const char *s, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i lo32 = _mm256_set1_epi8('0' - 1);
+    const __m256i hi32 = _mm256_set1_epi8('9' + 1);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(v, lo32), _mm256_cmpgt_epi8(hi32, v));
+        if (_mm256_movemask_epi8(ok) != -1) return 0;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i lo16 = _mm_set1_epi8('0' - 1);
+    const __m128i hi16 = _mm_set1_epi8('9' + 1);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, lo16), _mm_cmpgt_epi8(hi16, v));
+        if (_mm_movemask_epi8(ok) != 0xFFFF) return 0;
+    }
+#endif
+    for (; i < n; i++) {
+        if ((unsigned char)(s[i] - '0') > 9) return 0;
+    }
+    return 1;
+}
+
+/* 把 s[0..n) 中最后一个不是 '0' 的字符位置 + 1 返回，全为 '0' 时返回 0 */
+static size_t dec_trim_zeros(const char *s, size_t n) {
+#if defined(__SSE2__)
+    const __m128i zero = _mm_set1_epi8('0');
+    while (n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + n - 16));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) ^ 0xFFFFu;
+        if (mask != 0) return n - 16 + (32 - (size_t)__builtin_clz(mask));
+        n -= 16;
+    }
+#endif
+    while (n > 0 && s[n - 1] == '0') n--;
+    return n;
+}
+
+/* 8 位 ASCII 数字（已校验）转为整数，每步把相邻两组合并（SWAR） */
+static inline bignum_limb_t dec_parse8(const char *s) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t v;
+    memcpy(&v, s, sizeof(v));
+    v &= 0x0F0F0F0F0F0F0F0FULL;
+    v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+    return (bignum_limb_t)v;
+#else
+    bignum_limb_t v = 0;
+    for (int i = 0; i < 8; i++) v = v * 10 + (bignum_limb_t)(s[i] - '0');
+    return v;
+#endif
+}
+
+/* 连续数字串 s[0..n)（已校验，高位在前）转为 limb 数组，返回 limb 个数 */
+static size_t dec_to_limbs(const char *s, size_t n, bignum_limb_t *limbs) {
+    size_t idx = 0;
+    
+    /* 从最低位开始每 9 位一个 limb：1 位 + 8 位 */
+    while (n >= BIGNUM_LIMB_DIGITS) {
+        n -= BIGNUM_LIMB_DIGITS;
+        limbs[idx++] = (bignum_limb_t)(s[n] - '0') * 100000000u + dec_parse8(s + n + 1);
+    }
+    if (n > 0) {
+        bignum_limb_t limb = 0;
+        for (size_t i = 0; i < n; i++) limb = limb * 10 + (bignum_limb_t)(s[i] - '0');
+        limbs[idx++] = limb;
+    }
+    return idx;
+}
+
+/* 写出 v（< 10^8）的 8 位数字（补前导零） */
+static inline void dec_format8(bignum_limb_t v, char *out) {
+#if defined(__SSE2__)
+    /* abcdefgh -> abcd, efgh，再并行求出 a, ab, abc, abcd, e, ef, efg, efgh，相邻相减得到各位 */
+    const __m128i x = _mm_cvtsi32_si128((int)v);
+    const __m128i abcd = _mm_srli_epi64(_mm_mul_epu32(x, _mm_set1_epi32((int)0xD1B71759)), 45);
+    const __m128i efgh = _mm_sub_epi32(x, _mm_mul_epu32(abcd, _mm_set1_epi32(10000)));
+    const __m128i v1 = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+    const __m128i v1x2 = _mm_unpacklo_epi16(v1, v1);
+    const __m128i v2 = _mm_unpacklo_epi32(v1x2, v1x2);
+    const __m128i v3 = _mm_mulhi_epu16(v2, _mm_setr_epi16(8389, 5243, 13108, (short)32768,
+                                                           8389, 5243, 13108, (short)32768));
+    const __m128i v4 = _mm_mulhi_epu16(v3, _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, (short)(1 << 15),
+                                                           1 << 7, 1 << 11, 1 << 13, (short)(1 << 15)));
+    const __m128i v5 = _mm_slli_epi64(_mm_mullo_epi16(v4, _mm_set1_epi16(10)), 16);
+    const __m128i d = _mm_packus_epi16(_mm_sub_epi16(v4, v5), _mm_setzero_si128());
+    _mm_storel_epi64((__m128i *)out, _mm_add_epi8(d, _mm_set1_epi8('0')));
+#else
+    static const char dec_digit_pairs[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    bignum_limb_t hi = v / 10000, lo = v % 10000;
+    memcpy(out, dec_digit_pairs + 2 * (hi / 100), 2);
+    memcpy(out + 2, dec_digit_pairs + 2 * (hi % 100), 2);
+    memcpy(out + 4, dec_digit_pairs + 2 * (lo / 100), 2);
+    memcpy(out + 6, dec_digit_pairs + 2 * (lo % 100), 2);
+#endif
+}
+
 /* API 实现 */
 
 /* 旧版本 API - 保留用于兼容 */
@@ -370,10 +1403,10 @@ int bignum_from_string_legacy(const char *str, BHS *num) {
     
     bignum_init(num);
     
-    int len = strlen(str);
+    size_t len = strlen(str);
     if (len == 0) return BIGNUM_ERROR;
     
-    int pos = 0;
+    size_t pos = 0;
     int is_negative = 0;
     
     /* 处理符号 */
@@ -385,58 +1418,44 @@ int bignum_from_string_legacy(const char *str, BHS *num) {
     }
     
     /* 查找小数点 */
-    int decimal_point = -1;
-    for (int i = pos; i < len; i++) {
-        if (str[i] == '.') {
-            decimal_point = i;
-            break;
-        }
-    }
-    
-    /* 计算需要的位数 */
-    int digit_count = 0;
-    int decimal_digits = 0;
-    
-    if (decimal_point >= 0) {
-        decimal_digits = len - decimal_point - 1;
-        digit_count = len - pos - 1;  /* 减去符号和小数点 */
-    } else {
-        digit_count = len - pos;
-    }
+    const char *dot = (const char *)memchr(str + pos, '.', len - pos);
+    size_t int_len = dot != NULL ? (size_t)(dot - str) - pos : len - pos;
+    size_t decimal_digits = dot != NULL ? len - pos - int_len - 1 : 0;
+    size_t digit_count = int_len + decimal_digits;
     
     if (digit_count == 0) return BIGNUM_ERROR;
     if (digit_count > BIGNUM_MAX_DIGITS) return BIGNUM_ERROR;
     
-    /* 确保容量足够 */
-    if (bignum_ensure_capacity(num, digit_count + 1) != BIGNUM_SUCCESS) {
-        return BIGNUM_ERROR;
+    /* 有小数点时把整数部分和小数部分拼成连续的数字串 */
+    char stack_buf[128];
+    const char *digits = str + pos;
+    char *joined = NULL;
+    if (dot != NULL) {
+        joined = digit_count <= sizeof(stack_buf) ? stack_buf : (char *)malloc(digit_count);
+        if (joined == NULL) return BIGNUM_ERROR;
+        memcpy(joined, str + pos, int_len);
+        memcpy(joined + int_len, dot + 1, decimal_digits);
+        digits = joined;
     }
     
-    char *digits = BIGNUM_DIGITS(num);
-    int idx = 0;
+    int ret = BIGNUM_ERROR;
+    if (!dec_all_digits(digits, digit_count)) goto done;
     
-    /* 先处理小数部分（从后往前） */
-    if (decimal_point >= 0) {
-        for (int i = len - 1; i > decimal_point; i--) {
-            if (!isdigit(str[i])) return BIGNUM_ERROR;
-            digits[idx++] = str[i] - '0';
-        }
-    }
-    
-    /* 处理整数部分（从后往前） */
-    int end_pos = (decimal_point >= 0) ? decimal_point : len;
-    for (int i = end_pos - 1; i >= pos; i--) {
-        if (!isdigit(str[i])) return BIGNUM_ERROR;
-        digits[idx++] = str[i] - '0';
-    }
+    /* 确保容量足够 */
+    size_t limb_count = (digit_count + BIGNUM_LIMB_DIGITS - 1) / BIGNUM_LIMB_DIGITS;
+    if (bignum_reserve_limbs(num, limb_count) != BIGNUM_SUCCESS) goto done;
     
-    num->length = idx;
-    num->type_data.num.decimal_pos = decimal_digits;
+    num->length = dec_to_limbs(digits, digit_count, BIGNUM_LIMBS(num));
+    num->type_data.num.decimal_pos = (int)decimal_digits;
     num->type_data.num.is_negative = is_negative;
     num->type = BIGNUM_TYPE_NUMBER;
     
     bignum_trim(num);
-    return BIGNUM_SUCCESS;
+    ret = BIGNUM_SUCCESS;
+
+done:
+    if (joined != NULL && joined != stack_buf) free(joined);
+    return ret;
 }
 
 /* 新版本 API - 返回堆分配的 BHS */
@@ -446,12 +1465,64 @@ BHS* bignum_from_string(const char *str) {
     BHS *num = bignum_create();
     if (num == NULL) return NULL;
     
-    if (bignum_from_string_legacy(str, num) != BIGNUM_SUCCESS) {
-        bignum_destroy(num);
-        return NULL;
+    if (bignum_from_string_legacy(str, num) != BIGNUM_SUCCESS) {
+        bignum_destroy(num);
+        return NULL;
+    }
+    
+    return num;
+}
+
+/* 从 64 位整数创建 - 旧版本 */
+int bignum_from_int64_legacy(int64_t value, BHS *num) {
+    if (num == NULL) return BIGNUM_ERROR;
+    
+    bignum_init(num);
+    
+    uint64_t mag = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);  /* 最多 3 个 limb，总在内联存储中 */
+    size_t n = 0;
+    do {
+        limbs[n++] = (bignum_limb_t)(mag % BIGNUM_LIMB_BASE);
+        mag /= BIGNUM_LIMB_BASE;
+    } while (mag > 0);
+    
+    num->length = n;
+    num->type_data.num.is_negative = value < 0;
+    return BIGNUM_SUCCESS;
+}
+
+/* 新版本 API - 返回堆分配的 BHS */
+BHS* bignum_from_int64(int64_t value) {
+    BHS *num = bignum_create();
+    if (num == NULL) return NULL;
+    
+    bignum_from_int64_legacy(value, num);
+    return num;
+}
+
+int bignum_to_int64(const BHS *num, int64_t *value) {
+    if (num == NULL || value == NULL || num->type != BIGNUM_TYPE_NUMBER) return BIGNUM_ERROR;
+    
+    if (BIGNUM_IS_IMM(num)) {
+        *value = bignum_imm_get(num);
+        return BIGNUM_SUCCESS;
     }
     
-    return num;
+    if (bignum_has_fraction(num)) return BIGNUM_ERROR;
+    
+    uint64_t mag = 0;
+    if (bignum_int_part_u64(num, &mag) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
+    
+    /* 负数允许取到 INT64_MIN */
+    if (num->type_data.num.is_negative) {
+        if (mag > (uint64_t)INT64_MAX + 1) return BIGNUM_ERROR;
+        *value = mag == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)mag;
+    } else {
+        if (mag > (uint64_t)INT64_MAX) return BIGNUM_ERROR;
+        *value = (int64_t)mag;
+    }
+    return BIGNUM_SUCCESS;
 }
 
 /* 从原始字符串创建字符串类型的 BHS - 旧版本 */
@@ -459,6 +1530,7 @@ int bignum_from_raw_string_legacy(const char *str, BHS *num) {
     if (str == NULL || num == NULL) return BIGNUM_ERROR;
     
     bignum_init(num);
+    num->type = BIGNUM_TYPE_STRING;  /* 先设置类型，字符串不受数字长度限制 */
     
     int len = strlen(str);
     
@@ -474,7 +1546,6 @@ int bignum_from_raw_string_legacy(const char *str, BHS *num) {
     num->length = len;
     num->type_data.str.reserved1 = 0;
     num->type_data.str.reserved2 = 0;
-    num->type = BIGNUM_TYPE_STRING;  /* 设置为字符串类型 */
     
     return BIGNUM_SUCCESS;
 }
@@ -494,6 +1565,30 @@ BHS* bignum_from_raw_string(const char *str) {
     return num;
 }
 
+/* 将 limb 数组展开为十进制数字串（高位在前，无前导零），返回写入的位数 */
+static size_t limbs_to_decimal(const bignum_limb_t *limbs, size_t n, char *out) {
+    size_t pos = 0;
+    
+    /* 最高 limb 不补零 */
+    char tmp[BIGNUM_LIMB_DIGITS];
+    bignum_limb_t top = limbs[n - 1];
+    tmp[0] = (char)('0' + top / 100000000u);
+    dec_format8(top % 100000000u, tmp + 1);
+    size_t skip = 0;
+    while (skip < BIGNUM_LIMB_DIGITS - 1 && tmp[skip] == '0') skip++;
+    memcpy(out, tmp + skip, BIGNUM_LIMB_DIGITS - skip);
+    pos = BIGNUM_LIMB_DIGITS - skip;
+    
+    /* 其余 limb 固定 9 位 */
+    for (size_t i = n - 1; i-- > 0;) {
+        bignum_limb_t v = limbs[i];
+        out[pos] = (char)('0' + v / 100000000u);
+        dec_format8(v % 100000000u, out + pos + 1);
+        pos += BIGNUM_LIMB_DIGITS;
+    }
+    return pos;
+}
+
 int bignum_to_string(const BHS *num, char *str, size_t max_len, int precision) {
     if (num == NULL || str == NULL || max_len == 0) return BIGNUM_ERROR;
     
@@ -513,9 +1608,16 @@ int bignum_to_string(const BHS *num, char *str, size_t max_len, int precision) {
     if (num->type == BIGNUM_TYPE_BITMAP) {
         if (num->length + 2 > max_len) return BIGNUM_ERROR;  /* +2 for 'B' and null */
         str[0] = 'B';
-        unsigned char *bitmap_data = (unsigned char *)digits;
-        for (size_t i = 0; i < num->length; i++) {
-            str[i + 1] = ((bitmap_data[i / 8] >> (i % 8)) & 1) ? '1' : '0';
+        if (BITMAP_IS_ROARING(num)) {
+            /* 压缩编码逐位查询 */
+            for (size_t i = 0; i < num->length; i++) {
+                str[i + 1] = bitmap_get(num, i) == 1 ? '1' : '0';
+            }
+        } else {
+            unsigned char *bitmap_data = (unsigned char *)digits;
+            for (size_t i = 0; i < num->length; i++) {
+                str[i + 1] = ((bitmap_data[i / 8] >> (i % 8)) & 1) ? '1' : '0';
+            }
         }
         str[num->length + 1] = '\0';
         return BIGNUM_SUCCESS;
@@ -535,67 +1637,85 @@ int bignum_to_string(const BHS *num, char *str, size_t max_len, int precision) {
         return BIGNUM_SUCCESS;
     }
     
+    /* 如果是 HLL 类型，输出为 HLL(估计基数) 格式 */
+    if (num->type == BIGNUM_TYPE_HLL) {
+        int written = snprintf(str, max_len, "HLL(%llu)", (unsigned long long)hll_count(num));
+        if (written < 0 || written >= (int)max_len) return BIGNUM_ERROR;
+        return BIGNUM_SUCCESS;
+    }
+    
+    /* 如果是过滤器类型，输出为 BLOOM(元素数) 或 CUCKOO(元素数) 格式 */
+    if (num->type == BIGNUM_TYPE_FILTER) {
+        int written = snprintf(str, max_len, "%s(%zu)", FILTER_IS_CUCKOO(num) ? "CUCKOO" : "BLOOM", num->length);
+        if (written < 0 || written >= (int)max_len) return BIGNUM_ERROR;
+        return BIGNUM_SUCCESS;
+    }
+    
     if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
     
-    int pos = 0;
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
+    int is_zero = (n == 1 && limbs[0] == 0);
+    size_t scale = num->type_data.num.decimal_pos > 0 ? (size_t)num->type_data.num.decimal_pos : 0;
     
-    /* 添加符号 */
-    if (num->type_data.num.is_negative && !(num->length == 1 && digits[0] == 0)) {
-        if (pos >= (int)max_len - 1) return BIGNUM_ERROR;
-        str[pos++] = '-';
+    /* 展开为十进制数字串 */
+    char stack_buf[128];
+    char *dec = stack_buf;
+    size_t total = n * BIGNUM_LIMB_DIGITS;
+    if (total > sizeof(stack_buf)) {
+        dec = (char *)malloc(total);
+        if (dec == NULL) return BIGNUM_ERROR;
     }
+    size_t dec_len = limbs_to_decimal(limbs, n, dec);
     
-    /* 计算整数部分长度 */
-    int int_len = num->length - num->type_data.num.decimal_pos;
-    if (int_len <= 0) int_len = 1;
+    int ret = BIGNUM_ERROR;
+    size_t pos = 0;
     
-    /* 输出整数部分 */
-    int started = 0;
-    for (int i = num->length - 1; i >= num->type_data.num.decimal_pos; i--) {
-        if (digits[i] != 0 || started || i == num->type_data.num.decimal_pos) {
-            if (pos >= (int)max_len - 1) return BIGNUM_ERROR;
-            str[pos++] = digits[i] + '0';
-            started = 1;
-        }
+    /* 添加符号 */
+    if (num->type_data.num.is_negative && !is_zero) {
+        if (pos >= max_len - 1) goto done;
+        str[pos++] = '-';
     }
     
-    if (!started) {
-        if (pos >= (int)max_len - 1) return BIGNUM_ERROR;
+    /* 输出整数部分 */
+    if (dec_len > scale) {
+        size_t int_len = dec_len - scale;
+        if (pos + int_len >= max_len) goto done;
+        memcpy(str + pos, dec, int_len);
+        pos += int_len;
+    } else {
+        if (pos >= max_len - 1) goto done;
         str[pos++] = '0';
     }
     
-    /* 输出小数部分 */
-    if (num->type_data.num.decimal_pos > 0 || precision > 0) {
-        if (pos >= (int)max_len - 1) return BIGNUM_ERROR;
-        str[pos++] = '.';
-        
-        int decimal_output = (precision < num->type_data.num.decimal_pos) ? precision : num->type_data.num.decimal_pos;
-        for (int i = num->type_data.num.decimal_pos - 1; i >= num->type_data.num.decimal_pos - decimal_output; i--) {
-            if (pos >= (int)max_len - 1) return BIGNUM_ERROR;
-            if (i >= 0) {
-                str[pos++] = digits[i] + '0';
-            } else {
-                str[pos++] = '0';
-            }
-        }
+    /* 输出小数部分（截断到 precision 位，并移除尾随的零） */
+    size_t frac_out = scale < (size_t)precision ? scale : (size_t)precision;
+    if (frac_out > 0) {
+        size_t lead_zeros = scale > dec_len ? scale - dec_len : 0;
+        const char *frac = dec_len > scale ? dec + (dec_len - scale) : dec;
         
-        /* 如果需要更多精度，补0 */
-        for (int i = num->type_data.num.decimal_pos; i < precision; i++) {
-            if (pos >= (int)max_len - 1) return BIGNUM_ERROR;
-            str[pos++] = '0';
+        /* 只保留到最后一个非零位 */
+        size_t last = 0;
+        if (frac_out > lead_zeros) {
+            size_t nz = dec_trim_zeros(frac, frac_out - lead_zeros);
+            if (nz > 0) last = lead_zeros + nz;
         }
         
-        /* 移除尾随的零 */
-        while (pos > 0 && str[pos - 1] == '0') {
-            pos--;
-        }
-        if (pos > 0 && str[pos - 1] == '.') {
-            pos--;
+        if (last > 0) {
+            if (pos + 1 + last >= max_len) goto done;
+            str[pos++] = '.';
+            memset(str + pos, '0', lead_zeros);
+            memcpy(str + pos + lead_zeros, frac, last - lead_zeros);
+            pos += last;
         }
     }
     
     str[pos] = '\0';
-    return BIGNUM_SUCCESS;
+    ret = BIGNUM_SUCCESS;
+
+done:
+    if (dec != stack_buf) free(dec);
+    return ret;
 }
 
 static int bignum_add_internal(const BHS *a, const BHS *b, BHS *result) {
@@ -606,10 +1726,18 @@ static int bignum_add_internal(const BHS *a, const BHS *b, BHS *result) {
         return BIGNUM_ERROR;
     }
     
+    /* 立即数快速路径：|a|, |b| < 10^18，和不会溢出 int64 */
+    if (BIGNUM_IS_IMM(a) && BIGNUM_IS_IMM(b)) {
+        int64_t sum = bignum_imm_get(a) + bignum_imm_get(b);
+        bignum_free(result);
+        return bignum_from_int64_legacy(sum, result);
+    }
+    
     /* 同号相加 */
     if (a->type_data.num.is_negative == b->type_data.num.is_negative) {
         if (bignum_add_abs(a, b, result) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
         result->type_data.num.is_negative = a->type_data.num.is_negative;
+        bignum_trim(result);
         return BIGNUM_SUCCESS;
     }
     
@@ -623,6 +1751,7 @@ static int bignum_add_internal(const BHS *a, const BHS *b, BHS *result) {
         result->type_data.num.is_negative = b->type_data.num.is_negative;
     }
     
+    bignum_trim(result);
     return BIGNUM_SUCCESS;
 }
 
@@ -634,10 +1763,18 @@ static int bignum_sub_internal(const BHS *a, const BHS *b, BHS *result) {
         return BIGNUM_ERROR;
     }
     
+    /* 立即数快速路径：|a|, |b| < 10^18，差不会溢出 int64 */
+    if (BIGNUM_IS_IMM(a) && BIGNUM_IS_IMM(b)) {
+        int64_t diff = bignum_imm_get(a) - bignum_imm_get(b);
+        bignum_free(result);
+        return bignum_from_int64_legacy(diff, result);
+    }
+    
     /* 异号相加 */
     if (a->type_data.num.is_negative != b->type_data.num.is_negative) {
         if (bignum_add_abs(a, b, result) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
         result->type_data.num.is_negative = a->type_data.num.is_negative;
+        bignum_trim(result);
         return BIGNUM_SUCCESS;
     }
     
@@ -651,10 +1788,16 @@ static int bignum_sub_internal(const BHS *a, const BHS *b, BHS *result) {
         result->type_data.num.is_negative = !a->type_data.num.is_negative;
     }
     
+    bignum_trim(result);
     return BIGNUM_SUCCESS;
 }
 
 static int bignum_mul_internal(const BHS *a, const BHS *b, BHS *result) {
+    return bignum_mul_scaled(a, b, result, BIGNUM_DEFAULT_PRECISION);
+}
+
+/* result = a * b，小数位数截断到 scale 位（result 可与 a/b 相同） */
+static int bignum_mul_scaled(const BHS *a, const BHS *b, BHS *result, int scale) {
     if (a == NULL || b == NULL || result == NULL) return BIGNUM_ERROR;
     
     /* 类型检查 */
@@ -662,82 +1805,53 @@ static int bignum_mul_internal(const BHS *a, const BHS *b, BHS *result) {
         return BIGNUM_ERROR;
     }
     
+    /* 立即数快速路径：乘积溢出 int64 时回到任意精度乘法 */
+    if (BIGNUM_IS_IMM(a) && BIGNUM_IS_IMM(b)) {
+        int64_t prod;
+        if (!__builtin_mul_overflow(bignum_imm_get(a), bignum_imm_get(b), &prod)) {
+            bignum_free(result);
+            return bignum_from_int64_legacy(prod, result);
+        }
+    }
+    
     BHS temp;
     bignum_init(&temp);
     temp.type = BIGNUM_TYPE_NUMBER;
     
-    int total_decimal = a->type_data.num.decimal_pos + b->type_data.num.decimal_pos;
-    int max_result_len = a->length + b->length;  /* 两个n位数相乘最多2n位，不需要+1 */
+    bignum_limb_t *a_limbs = BIGNUM_LIMBS(a);
+    bignum_limb_t *b_limbs = BIGNUM_LIMBS(b);
+    size_t an = limbs_normalize(a_limbs, a->length);
+    size_t bn = limbs_normalize(b_limbs, b->length);
     
-    if (bignum_ensure_capacity(&temp, max_result_len) != BIGNUM_SUCCESS) {
+    if (bignum_reserve_limbs(&temp, an + bn) != BIGNUM_SUCCESS) {
         bignum_free(&temp);
         return BIGNUM_ERROR;
     }
     
-    char *a_digits = BIGNUM_DIGITS(a);
-    char *b_digits = BIGNUM_DIGITS(b);
-    char *temp_digits = BIGNUM_DIGITS(&temp);
-    
-    /* 逐位相乘 */
-    for (int i = 0; i < a->length; i++) {
-        int carry = 0;
-        for (int j = 0; j < b->length || carry > 0; j++) {
-            int b_digit = (j < b->length) ? b_digits[j] : 0;
-            int current = temp_digits[i + j] + a_digits[i] * b_digit + carry;
-            temp_digits[i + j] = current % 10;
-            carry = current / 10;
-            if (i + j + 1 > temp.length) temp.length = i + j + 1;
-        }
+    /* 按操作数规模选择乘法算法 */
+    if (limbs_mul(BIGNUM_LIMBS(&temp), a_limbs, an, b_limbs, bn) != BIGNUM_SUCCESS) {
+        bignum_free(&temp);
+        return BIGNUM_ERROR;
     }
+    temp.length = an + bn;
     
-    temp.type_data.num.decimal_pos = total_decimal;
+    temp.type_data.num.decimal_pos = a->type_data.num.decimal_pos + b->type_data.num.decimal_pos;
     temp.type_data.num.is_negative = (a->type_data.num.is_negative != b->type_data.num.is_negative);
     
     bignum_trim(&temp);
     
-    /* 立即截断小数位数到默认精度，防止小数位数爆炸 */
-    if (temp.type_data.num.decimal_pos > BIGNUM_DEFAULT_PRECISION) {
-        int excess = temp.type_data.num.decimal_pos - BIGNUM_DEFAULT_PRECISION;
-        char *digits = BIGNUM_DIGITS(&temp);
-        if (excess < temp.length) {
-            memmove(digits, digits + excess, temp.length - excess);
-            temp.length -= excess;
-        } else {
-            digits[0] = 0;
-            temp.length = 1;
-        }
-        temp.type_data.num.decimal_pos = BIGNUM_DEFAULT_PRECISION;
-        bignum_trim(&temp);
-    }
+    /* 立即截断小数位数，防止小数位数爆炸 */
+    bignum_truncate_scale(&temp, scale);
     
     /* 检查总长度是否超过最大限制，优先舍弃小数 */
-    if (temp.length > BIGNUM_MAX_DIGITS) {
-        int to_remove = temp.length - BIGNUM_MAX_DIGITS;
-        /* 最多只能删除小数部分 */
-        if (to_remove > temp.type_data.num.decimal_pos) {
-            to_remove = temp.type_data.num.decimal_pos;
-        }
-        if (to_remove > 0) {
-            char *digits = BIGNUM_DIGITS(&temp);
-            memmove(digits, digits + to_remove, temp.length - to_remove);
-            temp.length -= to_remove;
-            temp.type_data.num.decimal_pos -= to_remove;
-            bignum_trim(&temp);
-        }
-        /* 如果还是超限，说明整数部分太大，返回错误 */
-        if (temp.length > BIGNUM_MAX_DIGITS) {
-            bignum_free(&temp);
-            return BIGNUM_ERROR;
-        }
-    }
-    
-    /* 复制结果 */
-    if (bignum_copy(&temp, result) != BIGNUM_SUCCESS) {
+    if (bignum_clamp_digits(&temp) != BIGNUM_SUCCESS) {
         bignum_free(&temp);
         return BIGNUM_ERROR;
     }
     
-    bignum_free(&temp);
+    /* 移交结果（result 可能与 a/b 相同，此时乘积已经算完） */
+    bignum_free(result);
+    *result = temp;
     return BIGNUM_SUCCESS;
 }
 
@@ -750,28 +1864,10 @@ static int bignum_div_internal(const BHS *a, const BHS *b, BHS *result, int prec
     }
     
     /* 检查除零 */
-    char *b_digits = BIGNUM_DIGITS(b);
-    if (b->length == 1 && b_digits[0] == 0) return BIGNUM_DIV_ZERO;
+    if (bignum_is_zero(b)) return BIGNUM_DIV_ZERO;
     
     if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
     
-    bignum_free(result);
-    bignum_init(result);
-    result->type = BIGNUM_TYPE_NUMBER;
-    
-    /* 创建被除数的副本 */
-    BHS dividend, divisor;
-    bignum_init(&dividend);
-    bignum_init(&divisor);
-    
-    if (bignum_copy(a, &dividend) != BIGNUM_SUCCESS) {
-        return BIGNUM_ERROR;
-    }
-    if (bignum_copy(b, &divisor) != BIGNUM_SUCCESS) {
-        bignum_free(&dividend);
-        return BIGNUM_ERROR;
-    }
-    
     /* 为了获得足够的精度，我们需要扩展被除数 */
     int extra_scale = precision + 10;
     
@@ -779,429 +1875,964 @@ static int bignum_div_internal(const BHS *a, const BHS *b, BHS *result, int prec
     int a_decimal = a->type_data.num.decimal_pos;
     int b_decimal = b->type_data.num.decimal_pos;
     
-    /* 先将小数转换为整数：
-     * 对于 2.5，digits=[5,2], decimal_pos=1，我们需要保持这个表示不变
-     * 但将 decimal_pos 设为 0，这样它就代表整数 25
-     * 
-     * 除法公式：a/b = (a的整数值 * 10^a_decimal) / (b的整数值 * 10^b_decimal)
-     *              = (a的整数值 / b的整数值) * 10^(a_decimal - b_decimal)
-     * 
-     * 为了获得小数精度，我们需要：
-     * (a的整数值 * 10^extra_scale) / b的整数值，结果的小数位是 extra_scale - (a_decimal - b_decimal)
+    /*
+     * 除法公式：a/b = (a的整数值 * 10^-a_decimal) / (b的整数值 * 10^-b_decimal)
+     * 我们计算 (a的整数值 * 10^(extra_scale + b_decimal)) / b的整数值，
+     * 结果的小数位数为 extra_scale + a_decimal（除数的小数位不会吃掉精度）
      */
-    dividend.type_data.num.decimal_pos = 0;
-    divisor.type_data.num.decimal_pos = 0;
+    bignum_limb_t *a_limbs = BIGNUM_LIMBS(a);
+    bignum_limb_t *b_limbs = BIGNUM_LIMBS(b);
+    size_t an = limbs_normalize(a_limbs, a->length);
+    size_t bn = limbs_normalize(b_limbs, b->length);
+    size_t shift = (size_t)extra_scale + (size_t)b_decimal;
     
     /* 移位被除数以获得精度 */
-    for (int i = 0; i < extra_scale; i++) {
-        int carry = 0;
-        char *div_digits = BIGNUM_DIGITS(&dividend);
-        
-        if (bignum_ensure_capacity(&dividend, dividend.length + 2) != BIGNUM_SUCCESS) {
-            bignum_free(&dividend);
-            bignum_free(&divisor);
-            return BIGNUM_ERROR;
+    size_t un_cap = an + shift / BIGNUM_LIMB_DIGITS + 1;
+    bignum_limb_t *dividend = (bignum_limb_t *)malloc(un_cap * sizeof(bignum_limb_t));
+    if (dividend == NULL) return BIGNUM_ERROR;
+    size_t un = limbs_shl_dec(dividend, a_limbs, an, shift);
+    
+    BHS quotient;
+    bignum_init(&quotient);
+    size_t qn = un >= bn ? un - bn + 1 : 1;
+    if (bignum_reserve_limbs(&quotient, qn) != BIGNUM_SUCCESS) {
+        free(dividend);
+        return BIGNUM_ERROR;
+    }
+    bignum_limb_t *q = BIGNUM_LIMBS(&quotient);
+    
+    /* 按除数规模选择短除法、长除法或牛顿迭代 */
+    if (limbs_divmod(q, NULL, dividend, un, b_limbs, bn) != BIGNUM_SUCCESS) {
+        free(dividend);
+        bignum_free(&quotient);
+        return BIGNUM_ERROR;
+    }
+    free(dividend);
+    quotient.length = limbs_normalize(q, qn);
+    
+    int result_scale = extra_scale + a_decimal;
+    quotient.type_data.num.decimal_pos = result_scale;
+    quotient.type_data.num.is_negative = (a->type_data.num.is_negative != b->type_data.num.is_negative);
+    bignum_trim(&quotient);
+    
+    bignum_free(result);
+    *result = quotient;
+    return BIGNUM_SUCCESS;
+}
+
+/* 非负整数次幂：二进制快速幂，每次乘法后截断到 scale 位小数 */
+static int bignum_pow_uint(const BHS *base, uint64_t exp_value, BHS *result, int scale) {
+    BHS current_power, acc;
+    bignum_init(&current_power);
+    bignum_from_int64_legacy(1, &acc);
+    
+    if (bignum_copy(base, &current_power) != BIGNUM_SUCCESS) {
+        return BIGNUM_ERROR;
+    }
+    
+    while (exp_value > 0) {
+        if (exp_value & 1) {
+            /* 指数为奇数，累乘到结果 */
+            if (bignum_mul_scaled(&acc, &current_power, &acc, scale) != BIGNUM_SUCCESS) {
+                bignum_free(&current_power);
+                bignum_free(&acc);
+                return BIGNUM_ERROR;
+            }
         }
-        div_digits = BIGNUM_DIGITS(&dividend);  /* 重新获取指针 */
         
-        for (int j = 0; j < dividend.length || carry > 0; j++) {
-            int current = (j < dividend.length ? div_digits[j] : 0) * 10 + carry;
-            div_digits[j] = current % 10;
-            carry = current / 10;
-            if (j >= dividend.length) dividend.length = j + 1;
+        exp_value >>= 1;
+        if (exp_value > 0) {
+            /* 底数自乘 */
+            if (bignum_mul_scaled(&current_power, &current_power, &current_power, scale) != BIGNUM_SUCCESS) {
+                bignum_free(&current_power);
+                bignum_free(&acc);
+                return BIGNUM_ERROR;
+            }
         }
     }
     
-    /* 长除法 */
-    BHS remainder;
-    bignum_init(&remainder);
+    bignum_free(&current_power);
+    bignum_free(result);
+    *result = acc;
+    return BIGNUM_SUCCESS;
+}
+
+static int bignum_pow_internal(const BHS *base, const BHS *exponent, BHS *result, int precision) {
+    if (base == NULL || exponent == NULL || result == NULL) return BIGNUM_ERROR;
     
-    int max_result_len = dividend.length + 10;
-    char *temp_result = (char *)malloc(max_result_len);
-    if (temp_result == NULL) {
-        bignum_free(&dividend);
-        bignum_free(&divisor);
-        bignum_free(&remainder);
+    /* 类型检查 */
+    if (base->type != BIGNUM_TYPE_NUMBER || exponent->type != BIGNUM_TYPE_NUMBER) {
         return BIGNUM_ERROR;
     }
-    int result_len = 0;
     
-    char *div_digits = BIGNUM_DIGITS(&dividend);
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
     
-    /* 从高位到低位处理 */
-    for (int i = dividend.length - 1; i >= 0; i--) {
-        int carry = div_digits[i];
-        char *rem_digits = BIGNUM_DIGITS(&remainder);
-        
-        if (bignum_ensure_capacity(&remainder, remainder.length + 2) != BIGNUM_SUCCESS) {
-            free(temp_result);
-            bignum_free(&dividend);
-            bignum_free(&divisor);
-            bignum_free(&remainder);
-            return BIGNUM_ERROR;
-        }
-        rem_digits = BIGNUM_DIGITS(&remainder);
-        
-        for (int j = 0; j < remainder.length || carry > 0; j++) {
-            int current = (j < remainder.length ? rem_digits[j] : 0) * 10 + carry;
-            rem_digits[j] = current % 10;
-            carry = current / 10;
-            if (j >= remainder.length) remainder.length = j + 1;
+    /* 非整数指数走 exp/ln */
+    if (bignum_has_fraction(exponent)) return bignum_pow_frac(base, exponent, result, precision);
+    
+    /* 将指数转换为整数 */
+    uint64_t exp_value = 0;
+    if (bignum_int_part_u64(exponent, &exp_value) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
+    int negative = exponent->type_data.num.is_negative && exp_value != 0;
+    
+    /* 特殊情况：0 次幂为 1，0 的正整数次幂为 0 */
+    if (exp_value == 0 || bignum_is_zero(base)) {
+        if (negative) return BIGNUM_DIV_ZERO;
+        bignum_free(result);
+        return bignum_from_int64_legacy(exp_value == 0 ? 1 : 0, result);
+    }
+    
+    /*
+     * 按结果的数量级 l = n·log10|base| 决定中间精度：正指数时整数部分越长，
+     * 截断误差被放大得越多；负指数时取倒数会把 x^n 的相对误差放大 10^(-2l) 倍
+     */
+    double l = (double)exp_value * bignum_log10_abs(base);
+    if ((negative ? -l : l) > BIGNUM_MAX_DIGITS) return BIGNUM_ERROR;
+    double extra = negative ? (l < 0 ? -2 * l : 0) : (l > 0 ? l : 0);
+    extra += log10((double)exp_value) + 3;
+    int scale = precision + extra > BIGNUM_MAX_DIGITS ? BIGNUM_MAX_DIGITS : precision + (int)extra;
+    
+    BHS power;
+    bignum_init(&power);
+    int ret = bignum_pow_uint(base, exp_value, &power, scale);
+    if (ret == BIGNUM_SUCCESS && negative) {
+        BHS one;
+        bignum_from_int64_legacy(1, &one);
+        ret = bignum_div_internal(&one, &power, &power, precision);
+    }
+    if (ret != BIGNUM_SUCCESS) {
+        bignum_free(&power);
+        return ret;
+    }
+    
+    bignum_truncate_scale(&power, precision);
+    bignum_trim(&power);
+    bignum_free(result);
+    *result = power;
+    return BIGNUM_SUCCESS;
+}
+
+/*
+ * 模幂：result = base^exponent mod modulus（C 风格，符号与 base^exponent 相同）
+ * 从高位到低位扫描指数的二进制位，每次乘法后立即取模，不会展开完整的幂
+ */
+static int bignum_powmod_internal(const BHS *base, const BHS *exponent, const BHS *modulus, BHS *result) {
+    if (base == NULL || exponent == NULL || modulus == NULL || result == NULL) return BIGNUM_ERROR;
+    if (base->type != BIGNUM_TYPE_NUMBER || exponent->type != BIGNUM_TYPE_NUMBER ||
+        modulus->type != BIGNUM_TYPE_NUMBER) {
+        return BIGNUM_ERROR;
+    }
+    if (bignum_is_zero(modulus)) return BIGNUM_DIV_ZERO;
+    if (bignum_has_fraction(base) || bignum_has_fraction(exponent) || bignum_has_fraction(modulus)) {
+        return BIGNUM_ERROR;
+    }
+    if (exponent->type_data.num.is_negative && !bignum_is_zero(exponent)) return BIGNUM_ERROR;
+    
+    BHS e, b, acc;
+    bignum_init(&e);
+    bignum_init(&b);
+    bignum_from_int64_legacy(1, &acc);
+    uint32_t *bits = NULL;
+    int ret = BIGNUM_ERROR;
+    
+    /* 指数按 2^29 一组转为二进制（2^29 < 10^9，可以直接短除） */
+    if (bignum_copy(exponent, &e) != BIGNUM_SUCCESS || bignum_make_unique(&e) != BIGNUM_SUCCESS) goto done;
+    bignum_truncate_scale(&e, 0);
+    bignum_limb_t *el = BIGNUM_LIMBS(&e);
+    size_t en = limbs_normalize(el, e.length);
+    bits = (uint32_t *)malloc((en * 32 / 29 + 2) * sizeof(uint32_t));
+    if (bits == NULL) goto done;
+    size_t groups = 0;
+    while (en > 1 || el[0] != 0) {
+        bits[groups++] = limbs_div_small(el, el, en, 1u << 29);
+        en = limbs_normalize(el, en);
+    }
+    
+    if ((ret = bignum_mod_internal(base, modulus, &b)) != BIGNUM_SUCCESS) goto done;
+    for (size_t g = groups; g-- > 0;) {
+        for (int i = 28; i >= 0; i--) {
+            if ((ret = bignum_mul_internal(&acc, &acc, &acc)) != BIGNUM_SUCCESS) goto done;
+            if ((ret = bignum_mod_internal(&acc, modulus, &acc)) != BIGNUM_SUCCESS) goto done;
+            if ((bits[g] >> i) & 1) {
+                if ((ret = bignum_mul_internal(&acc, &b, &acc)) != BIGNUM_SUCCESS) goto done;
+                if ((ret = bignum_mod_internal(&acc, modulus, &acc)) != BIGNUM_SUCCESS) goto done;
+            }
         }
-        bignum_trim(&remainder);
-        
-        /* 计算商的当前位 */
-        int quotient_digit = 0;
-        while (bignum_compare_abs(&remainder, &divisor) >= 0) {
-            BHS temp;
-            bignum_init(&temp);
-            bignum_sub_abs(&remainder, &divisor, &temp);
-            bignum_free(&remainder);
-            remainder = temp;
-            quotient_digit++;
-            if (quotient_digit >= 10) break;
+    }
+    
+    /* 指数为 0 且 |modulus| = 1 时结果为 0 */
+    if ((ret = bignum_mod_internal(&acc, modulus, &acc)) != BIGNUM_SUCCESS) goto done;
+    bignum_free(result);
+    *result = acc;
+    bignum_init(&acc);
+
+done:
+    free(bits);
+    bignum_free(&e);
+    bignum_free(&b);
+    bignum_free(&acc);
+    return ret;
+}
+
+static int bignum_mod_internal(const BHS *a, const BHS *b, BHS *result) {
+    if (a == NULL || b == NULL || result == NULL) return BIGNUM_ERROR;
+    
+    /* 类型检查 */
+    if (a->type != BIGNUM_TYPE_NUMBER || b->type != BIGNUM_TYPE_NUMBER) {
+        return BIGNUM_ERROR;
+    }
+    
+    /* 检查除零 */
+    if (bignum_is_zero(b)) return BIGNUM_DIV_ZERO;
+    
+    /* 取模运算要求操作数为整数 */
+    if (bignum_has_fraction(a) || bignum_has_fraction(b)) return BIGNUM_ERROR;
+    
+    /* 快速路径：两个操作数都不超过两个 limb（< 10^18）时直接用机器字取模 */
+    if (a->type_data.num.decimal_pos == 0 && b->type_data.num.decimal_pos == 0) {
+        bignum_limb_t *al = BIGNUM_LIMBS(a);
+        bignum_limb_t *bl = BIGNUM_LIMBS(b);
+        size_t an = limbs_normalize(al, a->length);
+        size_t bn = limbs_normalize(bl, b->length);
+        if (an <= 2 && bn <= 2) {
+            uint64_t x = an == 2 ? (uint64_t)al[1] * BIGNUM_LIMB_BASE + al[0] : al[0];
+            uint64_t y = bn == 2 ? (uint64_t)bl[1] * BIGNUM_LIMB_BASE + bl[0] : bl[0];
+            int64_t m = (int64_t)(x % y);
+            if (a->type_data.num.is_negative) m = -m;
+            bignum_free(result);
+            return bignum_from_int64_legacy(m, result);
         }
-        
-        temp_result[result_len++] = quotient_digit;
     }
     
-    /* 确保结果有足够容量 */
-    if (bignum_ensure_capacity(result, result_len + 1) != BIGNUM_SUCCESS) {
-        free(temp_result);
+    /* 创建a和b的整数副本（去除值为0的小数位） */
+    BHS dividend, divisor;
+    bignum_init(&dividend);
+    bignum_init(&divisor);
+    
+    if (bignum_copy(a, &dividend) != BIGNUM_SUCCESS) {
+        return BIGNUM_ERROR;
+    }
+    if (bignum_copy(b, &divisor) != BIGNUM_SUCCESS || bignum_make_unique(&dividend) != BIGNUM_SUCCESS) {
         bignum_free(&dividend);
         bignum_free(&divisor);
-        bignum_free(&remainder);
         return BIGNUM_ERROR;
     }
+    bignum_truncate_scale(&dividend, 0);
+    bignum_truncate_scale(&divisor, 0);
     
-    char *result_digits = BIGNUM_DIGITS(result);
+    /* 保存符号：C风格取模，余数符号与被除数相同 */
+    int dividend_negative = a->type_data.num.is_negative;
     
-    /* 将临时结果逆序复制到result */
-    for (int i = 0; i < result_len; i++) {
-        result_digits[i] = temp_result[result_len - 1 - i];
-    }
+    bignum_limb_t *u = BIGNUM_LIMBS(&dividend);
+    bignum_limb_t *v = BIGNUM_LIMBS(&divisor);
+    size_t un = limbs_normalize(u, dividend.length);
+    size_t vn = limbs_normalize(v, divisor.length);
     
-    result->length = result_len;
-    /* 结果的小数位数 = extra_scale + a_decimal - b_decimal
-     * 因为我们计算的是 (a_int * 10^extra_scale) / b_int
-     * 其中 a_int 是 a 去掉小数点后的整数（相当于 a * 10^a_decimal）
-     * b_int 是 b 去掉小数点后的整数（相当于 b * 10^b_decimal）
-     * 所以结果 = (a * 10^a_decimal * 10^extra_scale) / (b * 10^b_decimal)
-     *         = (a / b) * 10^(a_decimal + extra_scale - b_decimal)
-     * 因此小数位数 = extra_scale + a_decimal - b_decimal
-     */
-    result->type_data.num.decimal_pos = extra_scale + a_decimal - b_decimal;
-    result->type_data.num.is_negative = (a->type_data.num.is_negative != b->type_data.num.is_negative);
+    BHS remainder;
+    bignum_init(&remainder);
+    if (bignum_reserve_limbs(&remainder, vn) != BIGNUM_SUCCESS) {
+        bignum_free(&dividend);
+        bignum_free(&divisor);
+        return BIGNUM_ERROR;
+    }
+    bignum_limb_t *r = BIGNUM_LIMBS(&remainder);
     
-    bignum_trim(result);
+    int ret = BIGNUM_SUCCESS;
+    if (limbs_cmp(u, un, v, vn) < 0) {
+        memcpy(r, u, un * sizeof(bignum_limb_t));
+        remainder.length = un;
+    } else if (vn == 1) {
+        /* 单 limb 除数：短除法原地进行，商直接丢弃 */
+        r[0] = limbs_div_small(u, u, un, v[0]);
+        remainder.length = 1;
+    } else {
+        bignum_limb_t *q = (bignum_limb_t *)malloc((un - vn + 1) * sizeof(bignum_limb_t));
+        if (q == NULL || limbs_divmod(q, r, u, un, v, vn) != BIGNUM_SUCCESS) {
+            ret = BIGNUM_ERROR;
+        }
+        free(q);
+        remainder.length = limbs_normalize(r, vn);
+    }
     
-    free(temp_result);
     bignum_free(&dividend);
     bignum_free(&divisor);
-    bignum_free(&remainder);
+    if (ret != BIGNUM_SUCCESS) {
+        bignum_free(&remainder);
+        return ret;
+    }
+    
+    remainder.type_data.num.is_negative = dividend_negative;
+    
+    /* 如果结果为0，符号应该为正 */
+    bignum_trim(&remainder);
     
+    bignum_free(result);
+    *result = remainder;
     return BIGNUM_SUCCESS;
 }
 
-static int bignum_pow_internal(const BHS *base, const BHS *exponent, BHS *result, int precision) {
-    if (base == NULL || exponent == NULL || result == NULL) return BIGNUM_ERROR;
-    
-    /* 类型检查 */
-    if (base->type != BIGNUM_TYPE_NUMBER || exponent->type != BIGNUM_TYPE_NUMBER) {
+/* ========== 数学函数（任意精度） ========== */
+
+#define BIGNUM_MATH_GUARD 10                 /* 中间计算额外保留的小数位 */
+#define BIGNUM_MATH_GUARD_MAX 640            /* 截断结果不确定时 guard 位的加倍上限 */
+#define BIGNUM_LOG10_E    0.4342944819032518 /* log10(e)，只用于估算 */
+#define BIGNUM_LOG10_2    0.3010299956639812 /* log10(2)，只用于估算 */
+#define BIGNUM_LN2_APPROX 0.6931471805599453 /* ln(2)，只用于估算 */
+
+/* 常量缓存：保存已算出的最高精度，更低精度的请求直接截断复用 */
+typedef struct {
+    pthread_mutex_t lock;  /* 保护 value/scale 的检查、替换与复制 */
+    BHS value;
+    int scale;  /* 已缓存的小数位数，-1 表示尚未计算 */
+} bignum_const_cache;
+
+#define BIGNUM_CONST_CACHE_INIT { .lock = PTHREAD_MUTEX_INITIALIZER, .scale = -1 }
+
+static bignum_const_cache bignum_pi_cache = BIGNUM_CONST_CACHE_INIT;
+static bignum_const_cache bignum_e_cache = BIGNUM_CONST_CACHE_INIT;
+static bignum_const_cache bignum_ln2_cache = BIGNUM_CONST_CACHE_INIT;
+static bignum_const_cache bignum_ln10_cache = BIGNUM_CONST_CACHE_INIT;
+
+/* 写入整数值（先释放旧数据） */
+static void bignum_set_int(BHS *num, int64_t value) {
+    bignum_free(num);
+    bignum_from_int64_legacy(value, num);
+}
+
+/* |num| 的常用对数近似值（num 非 0），不受 double 范围限制 */
+static double bignum_log10_abs(const BHS *num) {
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
+    double top = limbs[n - 1];
+    if (n >= 2) top += limbs[n - 2] / (double)BIGNUM_LIMB_BASE;
+    return log10(top) + (double)(n - 1) * BIGNUM_LIMB_DIGITS - num->type_data.num.decimal_pos;
+}
+
+/* num 的 limb 乘以 10^k（k < 0 时截断），小数位数不变 */
+static int bignum_shift_dec(BHS *num, int k) {
+    size_t n = limbs_normalize(BIGNUM_LIMBS(num), num->length);
+    if (k >= 0) {
+        if (bignum_reserve_limbs(num, n + (size_t)k / BIGNUM_LIMB_DIGITS + 1) != BIGNUM_SUCCESS) {
+            return BIGNUM_ERROR;
+        }
+        num->length = limbs_shl_dec(BIGNUM_LIMBS(num), BIGNUM_LIMBS(num), n, (size_t)k);
+    } else {
+        if (bignum_make_unique(num) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
+        num->length = limbs_shr_dec(BIGNUM_LIMBS(num), n, (size_t)-k);
+    }
+    return BIGNUM_SUCCESS;
+}
+
+/* 定点运算：result 可以与操作数相同 */
+static int bignum_fx_add(const BHS *a, const BHS *b, BHS *result) {
+    BHS temp;
+    bignum_init(&temp);
+    if (bignum_add_internal(a, b, &temp) != BIGNUM_SUCCESS) {
+        bignum_free(&temp);
         return BIGNUM_ERROR;
     }
-    
-    /* 检查指数是否为负数 */
-    if (exponent->type_data.num.is_negative) return BIGNUM_ERROR;
-    
-    char *exp_digits = BIGNUM_DIGITS(exponent);
-    
-    /* 检查指数是否有小数部分 */
-    if (exponent->type_data.num.decimal_pos > 0) {
-        for (int i = 0; i < exponent->type_data.num.decimal_pos; i++) {
-            if (exp_digits[i] != 0) return BIGNUM_ERROR;
+    bignum_free(result);
+    *result = temp;
+    return BIGNUM_SUCCESS;
+}
+
+static int bignum_fx_sub(const BHS *a, const BHS *b, BHS *result) {
+    BHS temp;
+    bignum_init(&temp);
+    if (bignum_sub_internal(a, b, &temp) != BIGNUM_SUCCESS) {
+        bignum_free(&temp);
+        return BIGNUM_ERROR;
+    }
+    bignum_free(result);
+    *result = temp;
+    return BIGNUM_SUCCESS;
+}
+
+/* result = a / b，截断到 scale 位小数 */
+static int bignum_fx_div(const BHS *a, const BHS *b, BHS *result, int scale) {
+    if (bignum_div_internal(a, b, result, scale) != BIGNUM_SUCCESS) return BIGNUM_ERROR;
+    bignum_truncate_scale(result, scale);
+    return BIGNUM_SUCCESS;
+}
+
+static int bignum_fx_div_int(const BHS *a, int64_t d, BHS *result, int scale) {
+    BHS divisor;
+    bignum_from_int64_legacy(d, &divisor);
+    return bignum_fx_div(a, &divisor, result, scale);
+}
+
+/* result = Σ coef[i]·atan(1/k[i])（alternate 为 1）或 Σ coef[i]·atanh(1/k[i])（alternate 为 0） */
+static int bignum_atan_inv_sum(const int64_t *coef, const int64_t *k, int count, int alternate,
+                               BHS *result, int scale) {
+    BHS sum, power, term, c;
+    bignum_init(&sum);
+    bignum_init(&power);
+    bignum_init(&term);
+    bignum_init(&c);
+    int ret = BIGNUM_ERROR;
+    
+    for (int j = 0; j < count; j++) {
+        /* power = 1/k^(2n+1)，term = power/(2n+1) */
+        bignum_set_int(&term, 1);
+        if (bignum_fx_div_int(&term, k[j], &power, scale) != BIGNUM_SUCCESS) goto done;
+        bignum_set_int(&c, coef[j]);
+        if (bignum_mul_scaled(&power, &c, &term, scale) != BIGNUM_SUCCESS) goto done;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+        
+        for (int64_t n = 1;; n++) {
+            if (bignum_fx_div_int(&power, k[j] * k[j], &power, scale) != BIGNUM_SUCCESS) goto done;
+            if (bignum_is_zero(&power)) break;
+            if (bignum_mul_scaled(&power, &c, &term, scale) != BIGNUM_SUCCESS) goto done;
+            if (bignum_fx_div_int(&term, 2 * n + 1, &term, scale) != BIGNUM_SUCCESS) goto done;
+            if (alternate && (n & 1)) {
+                if (bignum_fx_sub(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+            } else {
+                if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+            }
         }
     }
     
-    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    bignum_free(result);
+    *result = sum;
+    bignum_init(&sum);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&sum);
+    bignum_free(&power);
+    bignum_free(&term);
+    bignum_free(&c);
+    return ret;
+}
+
+/* Machin 公式：π = 16·atan(1/5) − 4·atan(1/239) */
+static int bignum_compute_pi(BHS *result, int scale) {
+    static const int64_t coef[] = { 16, -4 };
+    static const int64_t k[] = { 5, 239 };
+    return bignum_atan_inv_sum(coef, k, 2, 1, result, scale);
+}
+
+/* ln2 = 18·atanh(1/26) − 2·atanh(1/4801) + 8·atanh(1/8749) */
+static int bignum_compute_ln2(BHS *result, int scale) {
+    static const int64_t coef[] = { 18, -2, 8 };
+    static const int64_t k[] = { 26, 4801, 8749 };
+    return bignum_atan_inv_sum(coef, k, 3, 0, result, scale);
+}
+
+static int bignum_cached_const(bignum_const_cache *cache, int (*compute)(BHS *, int), BHS *result, int scale);
+
+/* ln10 = 3·ln2 + 2·atanh(1/9)（ln1.25 = 2·atanh(1/9)） */
+static int bignum_compute_ln10(BHS *result, int scale) {
+    static const int64_t coef[] = { 2 };
+    static const int64_t k[] = { 9 };
+    BHS ln2, three;
+    bignum_init(&ln2);
+    bignum_from_int64_legacy(3, &three);
+    int ret = BIGNUM_ERROR;
+    
+    if (bignum_atan_inv_sum(coef, k, 1, 0, result, scale) != BIGNUM_SUCCESS) goto done;
+    if (bignum_cached_const(&bignum_ln2_cache, bignum_compute_ln2, &ln2, scale) != BIGNUM_SUCCESS) goto done;
+    if (bignum_mul_scaled(&ln2, &three, &ln2, scale) != BIGNUM_SUCCESS) goto done;
+    ret = bignum_fx_add(result, &ln2, result);
+
+done:
+    bignum_free(&ln2);
+    return ret;
+}
+
+/* e = Σ 1/n! */
+static int bignum_compute_e(BHS *result, int scale) {
+    BHS sum, term;
+    bignum_from_int64_legacy(1, &sum);
+    bignum_from_int64_legacy(1, &term);
+    int ret = BIGNUM_ERROR;
     
-    /* 将指数转换为整数 */
-    unsigned long long exp_value = 0;
-    for (int i = exponent->length - 1; i >= exponent->type_data.num.decimal_pos; i--) {
-        exp_value = exp_value * 10 + exp_digits[i];
-        if (exp_value > 100000) return BIGNUM_ERROR;  /* 限制指数大小，防止计算时间过长 */
+    for (int64_t n = 1;; n++) {
+        if (bignum_fx_div_int(&term, n, &term, scale) != BIGNUM_SUCCESS) goto done;
+        if (bignum_is_zero(&term)) break;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
     }
     
-    /* 初始化结果为1（先清理可能存在的旧数据） */
     bignum_free(result);
-    bignum_init(result);
-    result->type = BIGNUM_TYPE_NUMBER;
-    char *result_digits = BIGNUM_DIGITS(result);
-    result_digits[0] = 1;
-    result->length = 1;
-    
-    /* 特殊情况：0的幂 */
-    if (exp_value == 0) {
-        return BIGNUM_SUCCESS;
-    }
-    
-    /* 使用快速幂算法 */
-    BHS current_power, temp;
-    bignum_init(&current_power);
-    bignum_init(&temp);
-    
-    if (bignum_copy(base, &current_power) != BIGNUM_SUCCESS) {
-        return BIGNUM_ERROR;
+    *result = sum;
+    bignum_init(&sum);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&sum);
+    bignum_free(&term);
+    return ret;
+}
+
+/* 从缓存取常量（截断到 scale 位），缓存精度不足时重新计算并替换缓存
+ * 整个过程持有该缓存的锁；ln10 的计算会再取 ln2 的锁，加锁顺序固定，不会死锁 */
+static int bignum_cached_const(bignum_const_cache *cache, int (*compute)(BHS *, int), BHS *result, int scale) {
+    int ret = BIGNUM_ERROR;
+    pthread_mutex_lock(&cache->lock);
+    
+    if (cache->scale < scale) {
+        BHS value;
+        bignum_init(&value);
+        if (compute(&value, scale + BIGNUM_MATH_GUARD) != BIGNUM_SUCCESS) {
+            bignum_free(&value);
+            goto done;
+        }
+        bignum_truncate_scale(&value, scale);
+        bignum_free(&cache->value);
+        cache->value = value;
+        cache->scale = scale;
     }
     
-    while (exp_value > 0) {
-        if (exp_value & 1) {
-            /* 指数为奇数，累乘到结果 */
-            if (bignum_mul_internal(result, &current_power, &temp) != BIGNUM_SUCCESS) {
-                bignum_free(&current_power);
-                bignum_free(&temp);
-                return BIGNUM_ERROR;
-            }
-            /* 交换 result 和 temp 的内容 */
-            BHS swap = *result;
-            *result = temp;
-            temp = swap;
-            /* 清空被交换出去的temp（它现在持有旧result），供下次使用 */
-            bignum_free(&temp);
-            bignum_init(&temp);
-            /* 截断小数精度，防止小数位数无限增长 */
-            if (result->type_data.num.decimal_pos > precision) {
-                int excess = result->type_data.num.decimal_pos - precision;
-                char *digits = BIGNUM_DIGITS(result);
-                /* 移除最低的 excess 位小数 */
-                if (excess < result->length) {
-                    memmove(digits, digits + excess, result->length - excess);
-                    result->length -= excess;
-                } else {
-                    digits[0] = 0;
-                    result->length = 1;
-                }
-                result->type_data.num.decimal_pos = precision;
-                bignum_trim(result);
-            }
-            /* 检查总长度是否超限 */
-            if (result->length > BIGNUM_MAX_DIGITS) {
-                /* 优先舍弃小数部分 */
-                int to_remove = result->length - BIGNUM_MAX_DIGITS;
-                if (to_remove >= result->type_data.num.decimal_pos) {
-                    /* 需要舍弃的超过小数部分，也要舍弃整数 */
-                    to_remove = result->type_data.num.decimal_pos;
-                }
-                if (to_remove > 0) {
-                    char *digits = BIGNUM_DIGITS(result);
-                    memmove(digits, digits + to_remove, result->length - to_remove);
-                    result->length -= to_remove;
-                    result->type_data.num.decimal_pos -= to_remove;
-                    bignum_trim(result);
-                }
-            }
+    /* 共享缓存的数据区，截断时才会复制 */
+    if (bignum_copy(&cache->value, result) != BIGNUM_SUCCESS) goto done;
+    ret = BIGNUM_SUCCESS;
+
+done:
+    pthread_mutex_unlock(&cache->lock);
+    if (ret == BIGNUM_SUCCESS) bignum_truncate_scale(result, scale);
+    return ret;
+}
+
+/* 小数第 precision+1 ~ precision+count 位是否全为 0 或全为 9（decimal_pos 之后的位视为 0） */
+static int bignum_guard_ambiguous(const BHS *num, int precision, int count) {
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    int zeros = 1, nines = 1;
+    
+    for (int i = 1; i <= count && (zeros || nines); i++) {
+        int pos = num->type_data.num.decimal_pos - precision - i;  /* 距最低位的十进制偏移 */
+        int digit = 0;
+        if (pos >= 0 && (size_t)(pos / BIGNUM_LIMB_DIGITS) < num->length) {
+            digit = limbs[pos / BIGNUM_LIMB_DIGITS] / bignum_pow10[pos % BIGNUM_LIMB_DIGITS] % 10;
         }
-        
-        exp_value >>= 1;
-        if (exp_value > 0) {
-            /* 底数自乘 */
-            if (bignum_mul_internal(&current_power, &current_power, &temp) != BIGNUM_SUCCESS) {
-                bignum_free(&current_power);
-                bignum_free(&temp);
-                return BIGNUM_ERROR;
-            }
-            /* 交换 current_power 和 temp 的内容 */
-            BHS swap = current_power;
-            current_power = temp;
-            temp = swap;
-            /* 清空被交换出去的temp（它现在持有旧current_power），供下次使用 */
+        zeros = zeros && digit == 0;
+        nines = nines && digit == 9;
+    }
+    return zeros || nines;
+}
+
+/*
+ * 以 precision + guard 位调用 kernel，guard 位（除去末 2 位误差）全为 0 或全为 9 时
+ * 无法确定截断方向（如 cos(1e-40) 应截断为 0.999…），加倍 guard 重新计算
+ */
+static int bignum_math_refine(int (*kernel)(const BHS *, int, BHS *, int), const BHS *x, int arg,
+                              BHS *result, int precision) {
+    BHS value;
+    bignum_init(&value);
+    
+    for (int guard = BIGNUM_MATH_GUARD;; guard *= 2) {
+        BHS temp;
+        bignum_init(&temp);
+        if (kernel(x, arg, &temp, precision + guard) != BIGNUM_SUCCESS) {
             bignum_free(&temp);
-            bignum_init(&temp);
-            /* 截断小数精度，防止小数位数无限增长 */
-            if (current_power.type_data.num.decimal_pos > precision) {
-                int excess = current_power.type_data.num.decimal_pos - precision;
-                char *digits = BIGNUM_DIGITS(&current_power);
-                /* 移除最低的 excess 位小数 */
-                if (excess < current_power.length) {
-                    memmove(digits, digits + excess, current_power.length - excess);
-                    current_power.length -= excess;
-                } else {
-                    digits[0] = 0;
-                    current_power.length = 1;
-                }
-                current_power.type_data.num.decimal_pos = precision;
-                bignum_trim(&current_power);
-            }
-            /* 检查总长度是否超限 */
-            if (current_power.length > BIGNUM_MAX_DIGITS) {
-                /* 优先舍弃小数部分 */
-                int to_remove = current_power.length - BIGNUM_MAX_DIGITS;
-                if (to_remove >= current_power.type_data.num.decimal_pos) {
-                    /* 需要舍弃的超过小数部分，也要舍弃整数 */
-                    to_remove = current_power.type_data.num.decimal_pos;
-                }
-                if (to_remove > 0) {
-                    char *digits = BIGNUM_DIGITS(&current_power);
-                    memmove(digits, digits + to_remove, current_power.length - to_remove);
-                    current_power.length -= to_remove;
-                    current_power.type_data.num.decimal_pos -= to_remove;
-                    bignum_trim(&current_power);
-                }
-            }
+            if (guard == BIGNUM_MATH_GUARD) return BIGNUM_ERROR;
+            break;  /* 更高精度超出位数限制，沿用上一次的结果 */
         }
+        bignum_free(&value);
+        value = temp;
+        if (guard >= BIGNUM_MATH_GUARD_MAX || !bignum_guard_ambiguous(&value, precision, guard - 2)) break;
     }
     
-    bignum_trim(result);
-    bignum_free(&current_power);
-    bignum_free(&temp);
+    bignum_truncate_scale(&value, precision);
+    bignum_trim(&value);
+    bignum_free(result);
+    *result = value;
     return BIGNUM_SUCCESS;
 }
 
-static int bignum_mod_internal(const BHS *a, const BHS *b, BHS *result) {
-    if (a == NULL || b == NULL || result == NULL) return BIGNUM_ERROR;
-    
-    /* 类型检查 */
-    if (a->type != BIGNUM_TYPE_NUMBER || b->type != BIGNUM_TYPE_NUMBER) {
-        return BIGNUM_ERROR;
+/* 平方根：sqrt(x) = isqrt(x · 10^(2·precision)) / 10^precision，结果按位截断 */
+static int bignum_sqrt_internal(const BHS *x, BHS *result, int precision) {
+    if (x == NULL || result == NULL || x->type != BIGNUM_TYPE_NUMBER) return BIGNUM_ERROR;
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    if (bignum_is_zero(x)) {
+        bignum_set_int(result, 0);
+        return BIGNUM_SUCCESS;
     }
+    if (x->type_data.num.is_negative) return BIGNUM_ERROR;
     
-    char *b_digits = BIGNUM_DIGITS(b);
-    
-    /* 检查除零 */
-    if (b->length == 1 && b_digits[0] == 0) return BIGNUM_DIV_ZERO;
+    BHS n, y, q, next;
+    bignum_init(&n);
+    bignum_init(&y);
+    bignum_init(&q);
+    bignum_init(&next);
+    int ret = BIGNUM_ERROR;
     
-    char *a_digits = BIGNUM_DIGITS(a);
+    if (bignum_copy(x, &n) != BIGNUM_SUCCESS) goto done;
+    if (bignum_shift_dec(&n, 2 * precision - n.type_data.num.decimal_pos) != BIGNUM_SUCCESS) goto done;
+    n.type_data.num.decimal_pos = 0;
     
-    /* 检查除数和被除数是否有小数部分 */
-    int has_decimal = 0;
-    if (a->type_data.num.decimal_pos > 0) {
-        for (int i = 0; i < a->type_data.num.decimal_pos; i++) {
-            if (a_digits[i] != 0) {
-                has_decimal = 1;
-                break;
-            }
+    if (bignum_is_zero(&n)) {
+        bignum_set_int(&y, 0);
+    } else {
+        /* 用 double 估出前 15 位作为初值 */
+        double half = bignum_log10_abs(&n) / 2;
+        int e = half > 15 ? (int)half - 15 : 0;
+        bignum_set_int(&y, (int64_t)pow(10.0, half - e) + 1);
+        if (bignum_shift_dec(&y, e) != BIGNUM_SUCCESS) goto done;
+        
+        /* 牛顿迭代 y = (y + n/y) / 2：第一步之后 y >= isqrt(n)，随后单调下降，不再下降时即为结果 */
+        for (int first = 1;; first = 0) {
+            if (bignum_div_internal(&n, &y, &q, 0) != BIGNUM_SUCCESS) goto done;
+            bignum_truncate_scale(&q, 0);
+            if (bignum_fx_add(&y, &q, &next) != BIGNUM_SUCCESS) goto done;
+            if (bignum_fx_div_int(&next, 2, &next, 0) != BIGNUM_SUCCESS) goto done;
+            if (!first && bignum_compare(&next, &y) >= 0) break;
+            BHS t = y;
+            y = next;
+            next = t;
         }
     }
-    if (!has_decimal && b->type_data.num.decimal_pos > 0) {
-        for (int i = 0; i < b->type_data.num.decimal_pos; i++) {
-            if (b_digits[i] != 0) {
-                has_decimal = 1;
-                break;
-            }
+    
+    y.type_data.num.decimal_pos = precision;
+    bignum_trim(&y);
+    bignum_free(result);
+    *result = y;
+    bignum_init(&y);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&n);
+    bignum_free(&y);
+    bignum_free(&q);
+    bignum_free(&next);
+    return ret;
+}
+
+/*
+ * 指数函数：x = m·ln2 + r（|r| <= ln2/2），再把 r 缩小 2^k 倍后求泰勒级数，
+ * 平方 k 次还原，最后乘以 2^m；结果截断到 scale 位小数
+ */
+static int bignum_exp_kernel(const BHS *x, int arg, BHS *result, int scale) {
+    (void)arg;
+    double xd = bignum_to_double(x);
+    int extra = xd > 0 ? (int)(xd * BIGNUM_LOG10_E) + 1 : 0;
+    int k = 4 + (int)sqrt((double)scale);
+    if (k > 60) k = 60;
+    int wp = scale + extra + k * 3 / 10 + 5;  /* 平方 k 次放大误差约 k·log10(2) 位 */
+    int64_t m = (int64_t)floor(xd / BIGNUM_LN2_APPROX + 0.5);
+    
+    BHS ln2, r, sum, term, t;
+    bignum_init(&ln2);
+    bignum_init(&r);
+    bignum_from_int64_legacy(1, &sum);
+    bignum_from_int64_legacy(1, &term);
+    bignum_from_int64_legacy(m, &t);
+    int ret = BIGNUM_ERROR;
+    
+    /* r = (x - m·ln2) / 2^k */
+    if (bignum_cached_const(&bignum_ln2_cache, bignum_compute_ln2, &ln2, wp + 6) != BIGNUM_SUCCESS) goto done;
+    if (bignum_mul_scaled(&ln2, &t, &t, wp + 6) != BIGNUM_SUCCESS) goto done;
+    if (bignum_fx_sub(x, &t, &r) != BIGNUM_SUCCESS) goto done;
+    if (bignum_fx_div_int(&r, (int64_t)1 << k, &r, wp) != BIGNUM_SUCCESS) goto done;
+    
+    for (int64_t i = 1;; i++) {
+        if (bignum_mul_scaled(&term, &r, &term, wp) != BIGNUM_SUCCESS) goto done;
+        if (bignum_fx_div_int(&term, i, &term, wp) != BIGNUM_SUCCESS) goto done;
+        if (bignum_is_zero(&term)) break;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+    }
+    for (int i = 0; i < k; i++) {
+        if (bignum_mul_scaled(&sum, &sum, &sum, wp) != BIGNUM_SUCCESS) goto done;
+    }
+    
+    if (m != 0) {
+        BHS two, power;
+        bignum_from_int64_legacy(2, &two);
+        bignum_set_int(&t, m < 0 ? -m : m);
+        bignum_init(&power);
+        int step = bignum_pow_internal(&two, &t, &power, 0);
+        if (step == BIGNUM_SUCCESS) {
+            step = m > 0 ? bignum_mul_scaled(&sum, &power, &sum, wp) : bignum_fx_div(&sum, &power, &sum, wp);
         }
+        bignum_free(&power);
+        if (step != BIGNUM_SUCCESS) goto done;
     }
     
-    /* 取模运算要求操作数为整数 */
-    if (has_decimal) return BIGNUM_ERROR;
-    
-    /* 创建a和b的整数副本 */
-    BHS dividend, divisor;
-    bignum_init(&dividend);
-    bignum_init(&divisor);
-    
-    if (bignum_copy(a, &dividend) != BIGNUM_SUCCESS) {
-        return BIGNUM_ERROR;
+    bignum_truncate_scale(&sum, scale);
+    bignum_free(result);
+    *result = sum;
+    bignum_init(&sum);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&ln2);
+    bignum_free(&r);
+    bignum_free(&sum);
+    bignum_free(&term);
+    bignum_free(&t);
+    return ret;
+}
+
+static int bignum_exp_internal(const BHS *x, BHS *result, int precision) {
+    if (x == NULL || result == NULL || x->type != BIGNUM_TYPE_NUMBER) return BIGNUM_ERROR;
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    if (bignum_is_zero(x)) {
+        bignum_set_int(result, 1);
+        return BIGNUM_SUCCESS;
     }
-    if (bignum_copy(b, &divisor) != BIGNUM_SUCCESS) {
-        bignum_free(&dividend);
-        return BIGNUM_ERROR;
+    
+    /* 结果整数部分超出限制时报错，小于精度时为 0 */
+    double xd = bignum_log10_abs(x) > 6 ? (x->type_data.num.is_negative ? -1e6 : 1e6) : bignum_to_double(x);
+    if (xd * BIGNUM_LOG10_E > BIGNUM_MAX_DIGITS) return BIGNUM_ERROR;
+    if (-xd * BIGNUM_LOG10_E > precision + 1) {
+        bignum_set_int(result, 0);
+        return BIGNUM_SUCCESS;
     }
     
-    char *div_digits = BIGNUM_DIGITS(&dividend);
-    char *divisor_digits = BIGNUM_DIGITS(&divisor);
+    return bignum_math_refine(bignum_exp_kernel, x, 0, result, precision);
+}
+
+/*
+ * 自然对数：x = m·2^e2·10^d（m 接近 1），ln x = 2·atanh((m-1)/(m+1)) + e2·ln2 + d·ln10；
+ * 结果截断到 scale 位小数
+ */
+static int bignum_ln_kernel(const BHS *x, int arg, BHS *result, int scale) {
+    (void)arg;
+    int wp = scale + 5;
+    double l10 = bignum_log10_abs(x);
+    int d = (int)floor(l10);
+    int e2 = (int)floor((l10 - d) / BIGNUM_LOG10_2 + 0.5);  /* 0 ~ 3 */
+    
+    BHS m, z, z2, power, term, sum, c;
+    bignum_init(&m);
+    bignum_init(&z);
+    bignum_init(&z2);
+    bignum_init(&power);
+    bignum_init(&term);
+    bignum_init(&sum);
+    bignum_init(&c);
+    int ret = BIGNUM_ERROR;
+    
+    /* m = x / 10^d / 2^e2 */
+    if (bignum_copy(x, &m) != BIGNUM_SUCCESS) goto done;
+    int m_scale = m.type_data.num.decimal_pos + d;
+    if (m_scale < 0) {
+        if (bignum_shift_dec(&m, -m_scale) != BIGNUM_SUCCESS) goto done;
+        m_scale = 0;
+    }
+    m.type_data.num.decimal_pos = m_scale;
+    bignum_truncate_scale(&m, wp);
+    if (bignum_fx_div_int(&m, (int64_t)1 << e2, &m, wp) != BIGNUM_SUCCESS) goto done;
+    
+    /* z = (m - 1) / (m + 1)，ln m = 2·Σ z^(2i+1)/(2i+1) */
+    bignum_set_int(&c, 1);
+    if (bignum_fx_sub(&m, &c, &z) != BIGNUM_SUCCESS) goto done;
+    if (bignum_fx_add(&m, &c, &m) != BIGNUM_SUCCESS) goto done;
+    if (bignum_fx_div(&z, &m, &z, wp) != BIGNUM_SUCCESS) goto done;
+    if (bignum_mul_scaled(&z, &z, &z2, wp) != BIGNUM_SUCCESS) goto done;
+    if (bignum_copy(&z, &sum) != BIGNUM_SUCCESS || bignum_copy(&z, &power) != BIGNUM_SUCCESS) goto done;
+    for (int64_t i = 1;; i++) {
+        if (bignum_mul_scaled(&power, &z2, &power, wp) != BIGNUM_SUCCESS) goto done;
+        if (bignum_is_zero(&power)) break;
+        if (bignum_fx_div_int(&power, 2 * i + 1, &term, wp) != BIGNUM_SUCCESS) goto done;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+    }
+    if (bignum_fx_add(&sum, &sum, &sum) != BIGNUM_SUCCESS) goto done;
+    
+    /* 加上 e2·ln2 + d·ln10（常量多取 6 位，抵消乘以 d 的误差放大） */
+    if (e2 != 0) {
+        if (bignum_cached_const(&bignum_ln2_cache, bignum_compute_ln2, &term, wp) != BIGNUM_SUCCESS) goto done;
+        bignum_set_int(&c, e2);
+        if (bignum_mul_scaled(&term, &c, &term, wp) != BIGNUM_SUCCESS) goto done;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+    }
+    if (d != 0) {
+        if (bignum_cached_const(&bignum_ln10_cache, bignum_compute_ln10, &term, wp + 6) != BIGNUM_SUCCESS) goto done;
+        bignum_set_int(&c, d);
+        if (bignum_mul_scaled(&term, &c, &term, wp + 6) != BIGNUM_SUCCESS) goto done;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
+    }
+    
+    bignum_truncate_scale(&sum, scale);
+    bignum_free(result);
+    *result = sum;
+    bignum_init(&sum);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&m);
+    bignum_free(&z);
+    bignum_free(&z2);
+    bignum_free(&power);
+    bignum_free(&term);
+    bignum_free(&sum);
+    bignum_free(&c);
+    return ret;
+}
+
+static int bignum_ln_internal(const BHS *x, BHS *result, int precision) {
+    if (x == NULL || result == NULL || x->type != BIGNUM_TYPE_NUMBER) return BIGNUM_ERROR;
+    if (bignum_is_zero(x) || x->type_data.num.is_negative) return BIGNUM_ERROR;
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
     
-    /* 去除小数点 */
-    if (dividend.type_data.num.decimal_pos > 0) {
-        for (int i = dividend.type_data.num.decimal_pos; i < dividend.length; i++) {
-            div_digits[i - dividend.type_data.num.decimal_pos] = div_digits[i];
-        }
-        dividend.length -= dividend.type_data.num.decimal_pos;
-        dividend.type_data.num.decimal_pos = 0;
+    BHS one;
+    bignum_from_int64_legacy(1, &one);
+    if (bignum_compare(x, &one) == 0) {
+        bignum_set_int(result, 0);
+        return BIGNUM_SUCCESS;
     }
     
-    if (divisor.type_data.num.decimal_pos > 0) {
-        for (int i = divisor.type_data.num.decimal_pos; i < divisor.length; i++) {
-            divisor_digits[i - divisor.type_data.num.decimal_pos] = divisor_digits[i];
-        }
-        divisor.length -= divisor.type_data.num.decimal_pos;
-        divisor.type_data.num.decimal_pos = 0;
+    return bignum_math_refine(bignum_ln_kernel, x, 0, result, precision);
+}
+
+/* 非整数指数：x^y = exp(y·ln x)，要求 x >= 0 */
+static int bignum_pow_frac(const BHS *base, const BHS *exponent, BHS *result, int precision) {
+    if (bignum_is_zero(base)) {
+        if (exponent->type_data.num.is_negative) return BIGNUM_DIV_ZERO;
+        bignum_set_int(result, 0);
+        return BIGNUM_SUCCESS;
     }
+    if (base->type_data.num.is_negative) return BIGNUM_ERROR;
     
-    bignum_trim(&dividend);
-    bignum_trim(&divisor);
-    
-    /* 保存符号 */
-    int dividend_negative = dividend.type_data.num.is_negative;
-    
-    /* 取绝对值进行运算 */
-    dividend.type_data.num.is_negative = 0;
-    divisor.type_data.num.is_negative = 0;
-    
-    /* 使用长除法计算余数 */
-    BHS remainder;
-    bignum_init(&remainder);
+    /* z = log10(x^y)：结果的整数位数决定 ln x 需要的精度，y 的位数决定乘法放大的误差 */
+    double ly = bignum_log10_abs(exponent);
+    double y = ly > 6 ? (exponent->type_data.num.is_negative ? -1e6 : 1e6) : bignum_to_double(exponent);
+    double z = y * bignum_log10_abs(base);
+    if (z > BIGNUM_MAX_DIGITS) return BIGNUM_ERROR;
+    if (z < -(precision + 1)) {
+        bignum_set_int(result, 0);
+        return BIGNUM_SUCCESS;
+    }
+    int scale = precision + (z > 0 ? (int)z + 1 : 0) + BIGNUM_MATH_GUARD;
+    int y_digits = ly > 0 ? (int)ly + 1 : 0;
+    if (scale + y_digits > BIGNUM_MAX_DIGITS) return BIGNUM_ERROR;
     
-    div_digits = BIGNUM_DIGITS(&dividend);
+    BHS t;
+    bignum_init(&t);
+    int ret = bignum_ln_internal(base, &t, scale + y_digits);
+    if (ret == BIGNUM_SUCCESS) ret = bignum_mul_scaled(exponent, &t, &t, scale);
+    if (ret == BIGNUM_SUCCESS) ret = bignum_exp_internal(&t, result, precision);
+    bignum_free(&t);
+    return ret;
+}
+
+/* |r| <= π/4 时的泰勒级数：odd 为 1 求 sin(r)，为 0 求 cos(r) */
+static int bignum_sincos_series(const BHS *r, int odd, BHS *result, int scale) {
+    BHS r2, term, sum;
+    bignum_init(&r2);
+    bignum_init(&term);
+    bignum_init(&sum);
+    int ret = BIGNUM_ERROR;
+    
+    if (odd) {
+        if (bignum_copy(r, &term) != BIGNUM_SUCCESS) goto done;
+    } else {
+        bignum_set_int(&term, 1);
+    }
+    if (bignum_copy(&term, &sum) != BIGNUM_SUCCESS) goto done;
+    if (bignum_mul_scaled(r, r, &r2, scale) != BIGNUM_SUCCESS) goto done;
     
-    /* 从高位到低位处理被除数 */
-    for (int i = dividend.length - 1; i >= 0; i--) {
-        int carry = div_digits[i];
-        char *rem_digits = BIGNUM_DIGITS(&remainder);
-        
-        if (bignum_ensure_capacity(&remainder, remainder.length + 2) != BIGNUM_SUCCESS) {
-            bignum_free(&dividend);
-            bignum_free(&divisor);
-            bignum_free(&remainder);
-            return BIGNUM_ERROR;
-        }
-        rem_digits = BIGNUM_DIGITS(&remainder);
-        
-        for (int j = 0; j < remainder.length || carry > 0; j++) {
-            int current = (j < remainder.length ? rem_digits[j] : 0) * 10 + carry;
-            rem_digits[j] = current % 10;
-            carry = current / 10;
-            if (j >= remainder.length) remainder.length = j + 1;
-        }
-        bignum_trim(&remainder);
-        
-        /* 尽可能多地从余数中减去除数 */
-        while (bignum_compare_abs(&remainder, &divisor) >= 0) {
-            BHS temp;
-            bignum_init(&temp);
-            bignum_sub_abs(&remainder, &divisor, &temp);
-            bignum_free(&remainder);
-            remainder = temp;
-        }
+    for (int64_t i = odd;; i += 2) {
+        if (bignum_mul_scaled(&term, &r2, &term, scale) != BIGNUM_SUCCESS) goto done;
+        if (bignum_fx_div_int(&term, (i + 1) * (i + 2), &term, scale) != BIGNUM_SUCCESS) goto done;
+        if (bignum_is_zero(&term)) break;
+        term.type_data.num.is_negative = !term.type_data.num.is_negative;
+        if (bignum_fx_add(&sum, &term, &sum) != BIGNUM_SUCCESS) goto done;
     }
     
-    /* 复制结果 */
-    if (bignum_copy(&remainder, result) != BIGNUM_SUCCESS) {
-        bignum_free(&dividend);
-        bignum_free(&divisor);
-        bignum_free(&remainder);
-        return BIGNUM_ERROR;
+    bignum_free(result);
+    *result = sum;
+    bignum_init(&sum);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&r2);
+    bignum_free(&term);
+    bignum_free(&sum);
+    return ret;
+}
+
+/*
+ * 正弦（want_cos 为 0）或余弦：x = k·π/2 + r，按 k mod 4 选择 ±sin(r) 或 ±cos(r)；
+ * 结果截断到 scale 位小数
+ */
+static int bignum_sincos_kernel(const BHS *x, int want_cos, BHS *result, int scale) {
+    /* 整数部分越长，π 需要的位数越多 */
+    double l10 = bignum_log10_abs(x);
+    int int_digits = l10 > 0 ? (int)l10 + 1 : 0;
+    int wp = scale + 5;
+    int pi_scale = wp + int_digits;
+    if (int_digits + pi_scale > BIGNUM_MAX_DIGITS) return BIGNUM_ERROR;
+    
+    BHS half_pi, k, r, c;
+    bignum_init(&half_pi);
+    bignum_init(&k);
+    bignum_init(&r);
+    bignum_init(&c);
+    int ret = BIGNUM_ERROR;
+    
+    if (bignum_cached_const(&bignum_pi_cache, bignum_compute_pi, &half_pi, pi_scale + 1) != BIGNUM_SUCCESS) goto done;
+    if (bignum_fx_div_int(&half_pi, 2, &half_pi, pi_scale + 1) != BIGNUM_SUCCESS) goto done;
+    
+    /* k = round(x / (π/2)) */
+    if (bignum_fx_div(x, &half_pi, &k, 1) != BIGNUM_SUCCESS) goto done;
+    bignum_from_int64_legacy(5, &c);
+    c.type_data.num.decimal_pos = 1;
+    c.type_data.num.is_negative = k.type_data.num.is_negative;
+    if (bignum_fx_add(&k, &c, &k) != BIGNUM_SUCCESS) goto done;
+    bignum_truncate_scale(&k, 0);
+    
+    /* 10^9 是 4 的倍数，最低 limb 即可决定 k mod 4 */
+    int quadrant = (int)(BIGNUM_LIMBS(&k)[0] & 3);
+    if (k.type_data.num.is_negative) quadrant = (4 - quadrant) & 3;
+    
+    /* r = x - k·π/2 */
+    if (bignum_mul_scaled(&k, &half_pi, &r, pi_scale + 1) != BIGNUM_SUCCESS) goto done;
+    if (bignum_fx_sub(x, &r, &r) != BIGNUM_SUCCESS) goto done;
+    bignum_truncate_scale(&r, wp);
+    
+    /* sin(x) 依次为 sin r, cos r, -sin r, -cos r；cos(x) 相当于象限加 1 */
+    if (want_cos) quadrant = (quadrant + 1) & 3;
+    if (bignum_sincos_series(&r, !(quadrant & 1), &c, wp) != BIGNUM_SUCCESS) goto done;
+    if (quadrant >= 2) c.type_data.num.is_negative = !c.type_data.num.is_negative;
+    
+    bignum_truncate_scale(&c, scale);
+    bignum_free(result);
+    *result = c;
+    bignum_init(&c);
+    ret = BIGNUM_SUCCESS;
+
+done:
+    bignum_free(&half_pi);
+    bignum_free(&k);
+    bignum_free(&r);
+    bignum_free(&c);
+    return ret;
+}
+
+static int bignum_sincos_internal(const BHS *x, int want_cos, BHS *result, int precision) {
+    if (x == NULL || result == NULL || x->type != BIGNUM_TYPE_NUMBER) return BIGNUM_ERROR;
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    if (bignum_is_zero(x)) {
+        bignum_set_int(result, want_cos ? 1 : 0);
+        return BIGNUM_SUCCESS;
     }
     
-    /* C风格取模：余数符号与被除数相同 */
-    result->type_data.num.is_negative = dividend_negative;
+    return bignum_math_refine(bignum_sincos_kernel, x, want_cos, result, precision);
+}
+
+/* 比较两个数字（考虑符号） */
+int bignum_compare(const BHS *a, const BHS *b) {
+    if (a == NULL || b == NULL) return 0;
+    if (a->type != BIGNUM_TYPE_NUMBER || b->type != BIGNUM_TYPE_NUMBER) return 0;
     
-    /* 如果结果为0，符号应该为正 */
-    char *result_digits = BIGNUM_DIGITS(result);
-    if (result->length == 1 && result_digits[0] == 0) {
-        result->type_data.num.is_negative = 0;
+    if (BIGNUM_IS_IMM(a) && BIGNUM_IS_IMM(b)) {
+        int64_t x = bignum_imm_get(a);
+        int64_t y = bignum_imm_get(b);
+        return (x > y) - (x < y);
     }
     
-    bignum_trim(result);
-    
-    bignum_free(&dividend);
-    bignum_free(&divisor);
-    bignum_free(&remainder);
+    /* 0 不区分正负 */
+    int a_sign = bignum_is_zero(a) ? 0 : (a->type_data.num.is_negative ? -1 : 1);
+    int b_sign = bignum_is_zero(b) ? 0 : (b->type_data.num.is_negative ? -1 : 1);
+    if (a_sign != b_sign) return a_sign > b_sign ? 1 : -1;
+    if (a_sign == 0) return 0;
     
-    return BIGNUM_SUCCESS;
+    return bignum_compare_abs(a, b) * a_sign;
 }
 
 /* 类型判断和转换函数 */
 
+
 int bignum_is_number(const BHS *num) {
     if (num == NULL) return 0;
     return num->type == BIGNUM_TYPE_NUMBER;
@@ -1217,6 +2848,16 @@ int bignum_is_bitmap(const BHS *num) {
     return num->type == BIGNUM_TYPE_BITMAP;
 }
 
+int bignum_is_hll(const BHS *num) {
+    if (num == NULL) return 0;
+    return num->type == BIGNUM_TYPE_HLL;
+}
+
+int bignum_is_filter(const BHS *num) {
+    if (num == NULL) return 0;
+    return num->type == BIGNUM_TYPE_FILTER;
+}
+
 int bignum_is_list(const BHS *num) {
     if (num == NULL) return 0;
     return num->type == BIGNUM_TYPE_LIST;
@@ -1309,6 +2950,8 @@ BHS* bignum_div(const BHS *a, const BHS *b, int precision) {
         return NULL;
     }
     
+    /* 内部多算的保护位只供内部调用者使用，对外截断到 precision 位小数 */
+    bignum_truncate_scale(result, precision < 0 ? BIGNUM_DEFAULT_PRECISION : precision);
     return result;
 }
 
@@ -1340,6 +2983,90 @@ BHS* bignum_mod(const BHS *a, const BHS *b) {
     return result;
 }
 
+BHS* bignum_powmod(const BHS *base, const BHS *exponent, const BHS *modulus) {
+    if (base == NULL || exponent == NULL || modulus == NULL) return NULL;
+    
+    BHS *result = bignum_create();
+    if (result == NULL) return NULL;
+    
+    if (bignum_powmod_internal(base, exponent, modulus, result) != BIGNUM_SUCCESS) {
+        bignum_destroy(result);
+        return NULL;
+    }
+    
+    return result;
+}
+
+/* 一元数学函数的公共包装：分配结果，失败时释放并返回 NULL */
+static BHS* bignum_math_unary(int (*fn)(const BHS *, BHS *, int), const BHS *x, int precision) {
+    if (x == NULL) return NULL;
+    
+    BHS *result = bignum_create();
+    if (result == NULL) return NULL;
+    
+    if (fn(x, result, precision) != BIGNUM_SUCCESS) {
+        bignum_destroy(result);
+        return NULL;
+    }
+    
+    return result;
+}
+
+static int bignum_sin_internal(const BHS *x, BHS *result, int precision) {
+    return bignum_sincos_internal(x, 0, result, precision);
+}
+
+static int bignum_cos_internal(const BHS *x, BHS *result, int precision) {
+    return bignum_sincos_internal(x, 1, result, precision);
+}
+
+BHS* bignum_sqrt(const BHS *x, int precision) {
+    return bignum_math_unary(bignum_sqrt_internal, x, precision);
+}
+
+BHS* bignum_exp(const BHS *x, int precision) {
+    return bignum_math_unary(bignum_exp_internal, x, precision);
+}
+
+BHS* bignum_ln(const BHS *x, int precision) {
+    return bignum_math_unary(bignum_ln_internal, x, precision);
+}
+
+BHS* bignum_sin(const BHS *x, int precision) {
+    return bignum_math_unary(bignum_sin_internal, x, precision);
+}
+
+BHS* bignum_cos(const BHS *x, int precision) {
+    return bignum_math_unary(bignum_cos_internal, x, precision);
+}
+
+/* 常量的公共包装：从缓存取值 */
+static BHS* bignum_math_const(bignum_const_cache *cache, int (*compute)(BHS *, int), int precision) {
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    
+    BHS *result = bignum_create();
+    if (result == NULL) return NULL;
+    
+    if (bignum_cached_const(cache, compute, result, precision) != BIGNUM_SUCCESS) {
+        bignum_destroy(result);
+        return NULL;
+    }
+    
+    return result;
+}
+
+BHS* bignum_pi(int precision) {
+    return bignum_math_const(&bignum_pi_cache, bignum_compute_pi, precision);
+}
+
+BHS* bignum_e(int precision) {
+    return bignum_math_const(&bignum_e_cache, bignum_compute_e, precision);
+}
+
+BHS* bignum_ln2(int precision) {
+    return bignum_math_const(&bignum_ln2_cache, bignum_compute_ln2, precision);
+}
+
 BHS* bignum_string_to_number(const BHS *str_num) {
     if (str_num == NULL) return NULL;
     
@@ -1373,6 +3100,7 @@ BHS* bignum_number_to_string_type(const BHS *num, int precision) {
  * bignum 模块现在专注于基础的大数运算
  */
 
+
 /* ========== Bitmap 类型支持 ========== */
 /* 注意：大部分bitmap函数使用lib/bitmap.h中的实现 */
 
@@ -1381,50 +3109,46 @@ BHS* bignum_number_to_bitmap(const BHS *num) {
     if (num == NULL || num->type != BIGNUM_TYPE_NUMBER) return NULL;
     
     /* 不支持小数和负数 */
-    if (num->type_data.num.is_negative) return NULL;
-    if (num->type_data.num.decimal_pos > 0) {
-        char *digits = BIGNUM_DIGITS(num);
-        for (int i = 0; i < num->type_data.num.decimal_pos; i++) {
-            if (digits[i] != 0) return NULL;
-        }
+    if (num->type_data.num.is_negative && !bignum_is_zero(num)) return NULL;
+    if (bignum_has_fraction(num)) return NULL;
+    
+    /* 特殊情况：0 */
+    if (bignum_is_zero(num)) {
+        return bignum_from_binary_string("0");
     }
     
     /* 将整数转换为二进制字符串 */
     char binary[BIGNUM_MAX_DIGITS * 4];  /* 每个十进制位最多4个二进制位 */
     int binary_len = 0;
     
-    /* 创建数字的副本进行处理 */
+    /* 创建整数部分的副本进行处理 */
     BHS temp;
     bignum_init(&temp);
-    if (bignum_copy(num, &temp) != BIGNUM_SUCCESS) {
+    if (bignum_copy(num, &temp) != BIGNUM_SUCCESS || bignum_make_unique(&temp) != BIGNUM_SUCCESS) {
+        bignum_free(&temp);
         return NULL;
     }
+    bignum_truncate_scale(&temp, 0);
     
-    char *temp_digits = BIGNUM_DIGITS(&temp);
-    
-    /* 特殊情况：0 */
-    if (temp.length == 1 && temp_digits[0] == 0) {
-        bignum_free(&temp);
-        return bignum_from_binary_string("0");
-    }
+    bignum_limb_t *limbs = BIGNUM_LIMBS(&temp);
+    size_t n = limbs_normalize(limbs, temp.length);
     
-    /* 不断除以2，取余数 */
-    while (!(temp.length == 1 && temp_digits[0] == 0)) {
-        /* 除以2，余数是最低位 */
-        int remainder = 0;
-        for (int i = temp.length - 1; i >= temp.type_data.num.decimal_pos; i--) {
-            int current = remainder * 10 + temp_digits[i];
-            temp_digits[i] = current / 2;
-            remainder = current % 2;
+    /* 不断除以 2^16，每次取出低 16 位（从低位到高位） */
+    while (!(n == 1 && limbs[0] == 0)) {
+        bignum_limb_t chunk = limbs_div_small(limbs, limbs, n, 1u << 16);
+        n = limbs_normalize(limbs, n);
+        for (int i = 0; i < 16; i++) {
+            binary[binary_len++] = (char)('0' + ((chunk >> i) & 1));
         }
-        
-        binary[binary_len++] = '0' + remainder;
-        bignum_trim(&temp);
-        temp_digits = BIGNUM_DIGITS(&temp);
     }
     
     bignum_free(&temp);
     
+    /* 去除最后一组带来的高位0 */
+    while (binary_len > 1 && binary[binary_len - 1] == '0') {
+        binary_len--;
+    }
+    
     /* 反转二进制字符串（因为我们是从低位到高位构建的）*/
     for (int i = 0; i < binary_len / 2; i++) {
         char t = binary[i];
@@ -1443,49 +3167,18 @@ BHS* bignum_bitmap_to_number(const BHS *bitmap) {
     BHS *result = bignum_create();
     if (result == NULL) return NULL;
     
-    char *result_digits = BIGNUM_DIGITS(result);
-    result_digits[0] = 0;
-    result->length = 1;
-    result->type_data.num.decimal_pos = 0;
-    result->type_data.num.is_negative = 0;
-    
     unsigned char *bitmap_data = (unsigned char *)BIGNUM_DIGITS(bitmap);
     
-    /* 从高位到低位处理，使用二进制转十进制算法 */
+    /* 从高位到低位处理：result = result * 2 + bit */
     for (int i = (int)bitmap->length - 1; i >= 0; i--) {
-        /* result = result * 2 */
-        int carry = 0;
-        for (int j = 0; j < result->length; j++) {
-            int current = result_digits[j] * 2 + carry;
-            result_digits[j] = current % 10;
-            carry = current / 10;
-        }
-        if (carry > 0) {
-            if (bignum_ensure_capacity(result, result->length + 1) != BIGNUM_SUCCESS) {
-                bignum_destroy(result);
-                return NULL;
-            }
-            result_digits = BIGNUM_DIGITS(result);
-            result_digits[result->length++] = carry;
-        }
-        
-        /* 加上当前位 */
-        if ((bitmap_data[i / 8] >> (i % 8)) & 1) {
-            carry = 1;
-            for (int j = 0; j < result->length && carry > 0; j++) {
-                int current = result_digits[j] + carry;
-                result_digits[j] = current % 10;
-                carry = current / 10;
-            }
-            if (carry > 0) {
-                if (bignum_ensure_capacity(result, result->length + 1) != BIGNUM_SUCCESS) {
-                    bignum_destroy(result);
-                    return NULL;
-                }
-                result_digits = BIGNUM_DIGITS(result);
-                result_digits[result->length++] = carry;
-            }
+        if (bignum_reserve_limbs(result, result->length + 1) != BIGNUM_SUCCESS) {
+            bignum_destroy(result);
+            return NULL;
         }
+        bignum_limb_t *result_limbs = BIGNUM_LIMBS(result);
+        bignum_limb_t bit = BITMAP_IS_ROARING(bitmap) ? (bitmap_get(bitmap, i) == 1)
+                                                      : (bitmap_data[i / 8] >> (i % 8)) & 1;
+        result->length = limbs_mul_small(result_limbs, result_limbs, result->length, 2, bit);
     }
     
     bignum_trim(result);
@@ -1499,14 +3192,8 @@ BHS* bignum_bitshl(const BHS *a, const BHS *shift) {
     if (shift->type_data.num.is_negative) return NULL;
     
     /* 将BigNum shift转换为uint64_t，检测溢出 */
-    char *shift_digits = BIGNUM_DIGITS(shift);
     uint64_t shift_amount = 0;
-    for (int i = shift->length - 1; i >= shift->type_data.num.decimal_pos; i--) {
-        uint64_t old_amount = shift_amount;
-        shift_amount = shift_amount * 10 + shift_digits[i];
-        /* 检测溢出：如果新值小于旧值，说明溢出了 */
-        if (shift_amount < old_amount) return NULL;
-    }
+    if (bignum_int_part_u64(shift, &shift_amount) != BIGNUM_SUCCESS) return NULL;
     
     /* 检查结果长度是否会超过 SIZE_MAX - 1 */
     if (shift_amount > SIZE_MAX - 1 - a->length) return NULL;
@@ -1521,18 +3208,36 @@ BHS* bignum_bitshr(const BHS *a, const BHS *shift) {
     if (shift->type_data.num.is_negative) return NULL;
     
     /* 将BigNum shift转换为uint64_t，检测溢出 */
-    char *shift_digits = BIGNUM_DIGITS(shift);
     uint64_t shift_amount = 0;
-    for (int i = shift->length - 1; i >= shift->type_data.num.decimal_pos; i--) {
-        uint64_t old_amount = shift_amount;
-        shift_amount = shift_amount * 10 + shift_digits[i];
-        /* 检测溢出：如果新值小于旧值，说明溢出了 */
-        if (shift_amount < old_amount) return NULL;
-    }
+    if (bignum_int_part_u64(shift, &shift_amount) != BIGNUM_SUCCESS) return NULL;
     
     return bitmap_bitshr(a, shift_amount);
 }
 
+/* 位图原地左移（包装函数：将BigNum转换为uint64_t后调用bitmap_shl_inplace） */
+int bignum_bitshl_inplace(BHS *a, const BHS *shift) {
+    if (a == NULL || shift == NULL) return -1;
+    if (a->type != BIGNUM_TYPE_BITMAP || shift->type != BIGNUM_TYPE_NUMBER) return -1;
+    if (shift->type_data.num.is_negative) return -1;
+    
+    uint64_t shift_amount = 0;
+    if (bignum_int_part_u64(shift, &shift_amount) != BIGNUM_SUCCESS) return -1;
+    
+    return bitmap_shl_inplace(a, shift_amount);
+}
+
+/* 位图原地右移（包装函数：将BigNum转换为uint64_t后调用bitmap_shr_inplace） */
+int bignum_bitshr_inplace(BHS *a, const BHS *shift) {
+    if (a == NULL || shift == NULL) return -1;
+    if (a->type != BIGNUM_TYPE_BITMAP || shift->type != BIGNUM_TYPE_NUMBER) return -1;
+    if (shift->type_data.num.is_negative) return -1;
+    
+    uint64_t shift_amount = 0;
+    if (bignum_int_part_u64(shift, &shift_amount) != BIGNUM_SUCCESS) return -1;
+    
+    return bitmap_shr_inplace(a, shift_amount);
+}
+
 /* ========== LIST 类型相关函数实现 ========== */
 
 BHS* bignum_create_list(void) {
@@ -1544,6 +3249,7 @@ BHS* bignum_create_list(void) {
         bignum_destroy(num);
         return NULL;
     }
+    list_set_elem_ops(list, bignum_list_elem_clone, bignum_list_elem_destroy);
     
     num->type = BIGNUM_TYPE_LIST;
     num->data.list = list;
@@ -1558,8 +3264,8 @@ BHS* bignum_from_list(struct LIST *list) {
     BHS *num = bignum_create();
     if (num == NULL) return NULL;
     
-    /* 复制列表 */
-    LIST *new_list = list_copy(list);
+    /* 复制列表及元素，调用者仍持有原列表 */
+    LIST *new_list = bignum_list_clone((LIST *)list);
     if (new_list == NULL) {
         bignum_destroy(num);
         return NULL;
@@ -1577,23 +3283,30 @@ struct LIST* bignum_get_list(const BHS *num) {
     return num->data.list;
 }
 
+struct LIST* bignum_get_list_mutable(BHS *num) {
+    if (num == NULL || num->type != BIGNUM_TYPE_LIST) return NULL;
+    if (bignum_make_unique(num) != BIGNUM_SUCCESS) return NULL;
+    return num->data.list;
+}
+
+
 double bignum_to_double(const BHS *num) {
     if (num == NULL || num->type != BIGNUM_TYPE_NUMBER) return 0.0;
     
-    char *digits = BIGNUM_DIGITS(num);
+    bignum_limb_t *limbs = BIGNUM_LIMBS(num);
+    size_t n = limbs_normalize(limbs, num->length);
     double result = 0.0;
-    double decimal_multiplier = 1.0;
     
-    /* 处理整数部分 */
-    for (int i = num->length - 1; i >= num->type_data.num.decimal_pos; i--) {
-        result = result * 10.0 + digits[i];
+    /* 只累加最高的 3 个 limb（27 位十进制，已超过 double 的精度），避免长数字中间溢出 */
+    size_t low = n > 3 ? n - 3 : 0;
+    for (size_t i = n; i-- > low;) {
+        result = result * (double)BIGNUM_LIMB_BASE + limbs[i];
     }
     
-    /* 处理小数部分 */
-    for (int i = num->type_data.num.decimal_pos - 1; i >= 0; i--) {
-        decimal_multiplier /= 10.0;
-        result += digits[i] * decimal_multiplier;
-    }
+    /* 按十进制指数调整小数点位置，分两步乘以避免 10 的幂本身溢出 */
+    int exp10 = (int)low * BIGNUM_LIMB_DIGITS - num->type_data.num.decimal_pos;
+    result *= pow(10.0, exp10 / 2);
+    result *= pow(10.0, exp10 - exp10 / 2);
     
     /* 处理符号 */
     if (num->type_data.num.is_negative) {
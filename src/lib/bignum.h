@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 /* ========================================
  * BHS 类型定义（原 share/obj.h）
@@ -23,6 +24,8 @@
 
 #define BIGNUM_TYPE_HOOK    6         /* 钩子类型 */
 #define BIGNUM_TYPE_KEY     7         /* 键类型 */
+#define BIGNUM_TYPE_HLL     8         /* HyperLogLog 基数估计类型 */
+#define BIGNUM_TYPE_FILTER  9         /* 成员过滤器类型（布隆/布谷鸟） */
 
 /* BHS 结构体定义 - 固定64字节 */
 typedef struct {
@@ -38,16 +41,28 @@ typedef struct {
         /* HOOK *hook; */
     } data;                                   /* 32字节（联合体取最大） */    
     size_t capacity;                          /* 分配的容量（4字节） */    
-    size_t length;                            /* 数字长度或字符串长度（4字节） */
+    size_t length;                            /* 数字 limb 个数或字符串长度（4字节） */
     union {
         struct {
-            int decimal_pos;                  /* 小数点位置（从右边数）（4字节） */
+            int decimal_pos;                  /* 小数位数（十进制位，从右边数）（4字节） */
             int is_negative;                  /* 是否为负数（4字节） */
         } num;                                /* 数字类型专有字段 */
         struct {
             int reserved1;                    /* 保留字段1（4字节） */
             int reserved2;                    /* 保留字段2（4字节） */
         } str;                                /* 字符串类型专有字段（未来扩展） */
+        struct {
+            int encoding;                     /* 位图编码：0 平铺，1 压缩（4字节） */
+            int reserved;                     /* 保留字段（4字节） */
+        } bm;                                 /* 位图类型专有字段 */
+        struct {
+            int encoding;                     /* HLL 编码：0 稀疏，1 平铺（4字节） */
+            int reserved;                     /* 保留字段（4字节） */
+        } hll;                                /* HLL 类型专有字段 */
+        struct {
+            int encoding;                     /* 过滤器编码：0 布隆，1 布谷鸟（4字节） */
+            int reserved;                     /* 保留字段（4字节） */
+        } filter;                             /* 过滤器类型专有字段 */
         char padding[8];                      /* 确保联合体为8字节 */
     } type_data;                              /* 8字节（类型特定数据） */
 } BHS, BigNum, basic_handle_struct, bhs;  /* BHS 是推荐的类型名，BigNum 保留兼容 */
@@ -61,9 +76,13 @@ typedef BHS* Obj;
 #ifdef LOGEX_BUILD
 /* Logex 简化模式 - 仅包含必要的头文件 */
 #include "lib/bitmap.h"
+#include "lib/hll.h"
+#include "lib/filter.h"
 #else
 /* Mhuixs 完整模式 - 包含所有依赖 */
 #include "lib/bitmap.h"
+#include "lib/hll.h"
+#include "lib/filter.h"
 #include "tblh.h"
 #include "list.h"
 #endif
@@ -78,6 +97,8 @@ typedef BHS* Obj;
  * - LIST: 列表
  * - TABLE: 表格
  * - KVALOT: 键值对
+ * - HLL: HyperLogLog 基数估计
+ * - FILTER: 成员过滤器
  * 
  * 函数前缀 bignum_* 保留以保持 Logex 的可读性
  * 
@@ -98,6 +119,33 @@ typedef BHS* Obj;
 /* 获取digits指针的辅助宏 */
 #define BIGNUM_DIGITS(num) ((num)->is_large ? (num)->data.large_data : (char *)(num)->data.small_data)
 
+/*
+ * NUMBER 类型的内部表示
+ * 
+ * 数值的绝对值以 10^9 为基数存放在 32 位 limb 数组中（低位 limb 在前），
+ * length 为 limb 个数，decimal_pos 为十进制小数位数：
+ *   值 = (Σ limbs[i] * (10^9)^i) / 10^decimal_pos
+ * 例如：123.45 存储为 limbs=[12345], decimal_pos=2
+ * 内联存储可容纳 8 个 limb（72 位十进制数），超出后切换到 large_data
+ */
+typedef uint32_t bignum_limb_t;
+#define BIGNUM_LIMB_BASE   1000000000u  /* 每个 limb 的基数 10^9 */
+#define BIGNUM_LIMB_DIGITS 9            /* 每个 limb 的十进制位数 */
+
+/* 获取 NUMBER 类型 limb 数组指针的辅助宏 */
+#define BIGNUM_LIMBS(num) ((bignum_limb_t *)BIGNUM_DIGITS(num))
+
+/*
+ * 小整数立即数
+ * 
+ * 内联存储、小数位数为 0 且不超过 2 个 limb 的数字（|值| < 10^18）视为立即数，
+ * 其值可以直接按 int64 读写。加、减、乘和比较在操作数都是立即数时走机器字路径，
+ * 结果超出立即数范围（乘法溢出 int64）时自动回到任意精度路径
+ */
+#define BIGNUM_IMM_LIMBS 2
+#define BIGNUM_IS_IMM(obj) ((obj)->type == BIGNUM_TYPE_NUMBER && !(obj)->is_large && \
+                            (obj)->type_data.num.decimal_pos == 0 && (obj)->length <= BIGNUM_IMM_LIMBS)
+
 /* 返回值宏 */
 #define BIGNUM_SUCCESS  0      /* 成功 */
 #define BIGNUM_ERROR   -1      /* 错误 */
@@ -136,12 +184,96 @@ void bignum_free(BHS *num);
 /**
  * 复制大数
  * 
+ * large_data 与 LIST 按写时复制共享，只增加引用计数，复杂度 O(1)
+ * 
  * @param src 源 BHS
  * @param dst 目标 BHS
  * @return 0 成功, -1 失败
  */
 int bignum_copy(const BHS *src, BHS *dst);
 
+/*
+ * 写时复制（COW）
+ * 
+ * large_data 指向带引用计数头的共享数据区，LIST 类型的 data.list 同样带引用计数，
+ * 多个 BHS 可以共享同一份数据。原地修改 large_data 或列表之前必须先调用
+ * bignum_make_unique()，数据被共享时会先复制出独占的一份。
+ * large_data 只能通过 bignum_payload_* 分配和释放，不能直接 malloc/free。
+ * 列表拥有其中的元素（BHS*），最后一个引用释放时元素随列表一起销毁。
+ */
+
+/**
+ * 分配共享数据区（引用计数为 1，内容未初始化）
+ * 
+ * @param size 数据区字节数
+ * @return 数据区指针，失败返回 NULL
+ */
+char* bignum_payload_alloc(size_t size);
+
+/**
+ * 调整数据区大小（数据区必须未被共享）
+ * 
+ * @param data 原数据区，为 NULL 时等同于 bignum_payload_alloc()
+ * @param size 新的字节数
+ * @return 新的数据区指针，失败返回 NULL（原数据区保持不变）
+ */
+char* bignum_payload_realloc(char *data, size_t size);
+
+/**
+ * 增加数据区引用计数
+ * 
+ * @param data 数据区指针
+ * @return data 本身
+ */
+char* bignum_payload_share(char *data);
+
+/**
+ * 释放一个数据区引用，引用计数归零时释放内存
+ * 
+ * @param data 数据区指针（可为 NULL）
+ */
+void bignum_payload_release(char *data);
+
+/*
+ * 数据区附属索引
+ * 
+ * 每个数据区可以挂一块由其内容派生的索引（如位图的 rank/select 目录），
+ * 必须是单块 malloc 内存，数据区最后一个引用释放时一起 free。
+ * bignum_make_unique() 复制出的数据区不带附属索引，需要时重新建立。
+ */
+
+/**
+ * 获取数据区的附属索引
+ * 
+ * @param data 数据区指针（可为 NULL）
+ * @return 附属索引，没有时返回 NULL
+ */
+void* bignum_payload_aux(const char *data);
+
+/**
+ * 为数据区挂上附属索引（并发建立时只有一个能挂上）
+ * 
+ * @param data 数据区指针
+ * @param aux 附属索引，成功后归数据区所有
+ * @return 0 成功, -1 已有附属索引（aux 仍归调用者）
+ */
+int bignum_payload_attach_aux(char *data, void *aux);
+
+/**
+ * 释放数据区的附属索引（数据区必须未被共享）
+ * 
+ * @param data 数据区指针（可为 NULL）
+ */
+void bignum_payload_drop_aux(char *data);
+
+/**
+ * 确保 num 独占自己的 large_data 或列表，被共享时复制一份
+ * 
+ * @param num BHS 指针
+ * @return 0 成功, -1 失败
+ */
+int bignum_make_unique(BHS *num);
+
 /**
  * 从字符串创建大数（返回新分配的 BHS）
  * 
@@ -150,6 +282,32 @@ int bignum_copy(const BHS *src, BHS *dst);
  */
 BHS* bignum_from_string(const char *str);
 
+/**
+ * 从 64 位整数创建大数（返回新分配的 BHS）
+ * 
+ * @param value 整数值
+ * @return 新创建的 BHS 指针，失败返回 NULL
+ */
+BHS* bignum_from_int64(int64_t value);
+
+/**
+ * 将 64 位整数写入已有的 BHS（会先重新初始化 num）
+ * 
+ * @param value 整数值
+ * @param num 输出的 BHS 结构
+ * @return 0 成功, -1 失败
+ */
+int bignum_from_int64_legacy(int64_t value, BHS *num);
+
+/**
+ * 将整数值的大数转换为 64 位整数
+ * 
+ * @param num 数字类型的 BHS
+ * @param value 输出的整数值
+ * @return 0 成功, -1 失败（非数字、含小数部分或超出 int64 范围）
+ */
+int bignum_to_int64(const BHS *num, int64_t *value);
+
 /**
  * 从原始字符串创建字符串类型的 BHS（返回新分配的 BHS）
  * 
@@ -227,6 +385,8 @@ BHS* bignum_mul(const BHS *a, const BHS *b);
 /**
  * 大数除法（返回新分配的 BHS）
  * 
+ * 商向零截断到 precision 位小数，结果的小数位数不超过 precision（末尾的 0 会被去掉）
+ * 
  * @param a 被除数
  * @param b 除数
  * @param precision 除法精度（小数位数，-1表示使用默认精度）
@@ -237,13 +397,28 @@ BHS* bignum_div(const BHS *a, const BHS *b, int precision);
 /**
  * 大数幂运算（返回新分配的 BHS）
  * 
+ * 整数指数使用二进制快速幂（负指数取倒数），中间结果按所需精度截断；
+ * 非整数指数按 exp(exponent·ln base) 计算，此时底数不能为负。
+ * 
  * @param base 底数
- * @param exponent 指数（必须为非负整数）
+ * @param exponent 指数
  * @param precision 计算精度（小数位数，-1表示使用默认精度）
  * @return 结果 BHS 指针，失败返回 NULL
  */
 BHS* bignum_pow(const BHS *base, const BHS *exponent, int precision);
 
+/**
+ * 模幂运算 base^exponent mod modulus（返回新分配的 BHS）
+ * 
+ * 每步乘法后立即取模，不展开完整的幂；余数符号规则与 bignum_mod 相同。
+ * 
+ * @param base 底数（整数）
+ * @param exponent 指数（非负整数）
+ * @param modulus 模数（非零整数）
+ * @return 结果 BHS 指针，失败返回 NULL
+ */
+BHS* bignum_powmod(const BHS *base, const BHS *exponent, const BHS *modulus);
+
 /**
  * 大数取模运算（返回新分配的 BHS）
  * 
@@ -253,6 +428,44 @@ BHS* bignum_pow(const BHS *base, const BHS *exponent, int precision);
  */
 BHS* bignum_mod(const BHS *a, const BHS *b);
 
+/**
+ * 任意精度数学函数（返回新分配的 BHS）
+ * 
+ * 结果截断到 precision 位小数（-1 表示使用默认精度），不经过 double。
+ * sqrt 使用牛顿迭代；exp 先按 ln2 约化再求泰勒级数；ln 约化到 1 附近后求 atanh 级数；
+ * sin/cos 先按 π/2 约化象限。
+ * 
+ * @param x 自变量（sqrt 要求 x >= 0，ln 要求 x > 0）
+ * @param precision 小数位数
+ * @return 结果 BHS 指针，定义域错误或结果超出位数限制时返回 NULL
+ */
+BHS* bignum_sqrt(const BHS *x, int precision);
+BHS* bignum_exp(const BHS *x, int precision);
+BHS* bignum_ln(const BHS *x, int precision);
+BHS* bignum_sin(const BHS *x, int precision);
+BHS* bignum_cos(const BHS *x, int precision);
+
+/**
+ * 数学常量 π、e、ln2（返回新分配的 BHS）
+ * 
+ * 各常量按已计算过的最高精度缓存，更低精度的请求直接截断缓存值。
+ * 
+ * @param precision 小数位数（-1 表示使用默认精度）
+ * @return 结果 BHS 指针，失败返回 NULL
+ */
+BHS* bignum_pi(int precision);
+BHS* bignum_e(int precision);
+BHS* bignum_ln2(int precision);
+
+/**
+ * 比较两个数字类型的 BHS（考虑符号）
+ * 
+ * @param a 左操作数
+ * @param b 右操作数
+ * @return 1 if a>b, 0 if a==b, -1 if a<b（任一参数为 NULL 或非数字时返回 0）
+ */
+int bignum_compare(const BHS *a, const BHS *b);
+
 /**
  * 判断 BHS 是否为数字类型
  * 
@@ -277,6 +490,22 @@ int bignum_is_string(const BHS *num);
  */
 int bignum_is_bitmap(const BHS *num);
 
+/**
+ * 判断 BHS 是否为 HLL 类型
+ * 
+ * @param num BHS 结构
+ * @return 1 是 HLL, 0 不是
+ */
+int bignum_is_hll(const BHS *num);
+
+/**
+ * 判断 BHS 是否为过滤器类型
+ * 
+ * @param num BHS 结构
+ * @return 1 是过滤器, 0 不是
+ */
+int bignum_is_filter(const BHS *num);
+
 /**
  * 判断 BHS 是否为列表类型
  * 
@@ -330,9 +559,17 @@ BHS* bignum_number_to_string_type(const BHS *num, int precision);
 #define bignum_bitxor(a, b)   bitmap_bitxor(a, b)
 #define bignum_bitnot(a)      bitmap_bitnot(a)
 
+/* 原地位运算：dst op= src，成功返回 0，失败返回 -1 */
+#define bignum_bitand_inplace(dst, src)  bitmap_and_inplace(dst, src)
+#define bignum_bitor_inplace(dst, src)   bitmap_or_inplace(dst, src)
+#define bignum_bitxor_inplace(dst, src)  bitmap_xor_inplace(dst, src)
+#define bignum_bitnot_inplace(dst)       bitmap_not_inplace(dst)
+
 /* 移位运算需要转换接口（在bignum.c中实现） */
 BHS* bignum_bitshl(const BHS *a, const BHS *shift);
 BHS* bignum_bitshr(const BHS *a, const BHS *shift);
+int bignum_bitshl_inplace(BHS *a, const BHS *shift);   /* 原地移位，成功返回 0，失败返回 -1 */
+int bignum_bitshr_inplace(BHS *a, const BHS *shift);
 
 /* 类型转换函数（在type_package.c中实现，这里仅声明供内部使用） */
 BHS* bignum_number_to_bitmap(const BHS *num);
@@ -347,7 +584,7 @@ BHS* bignum_bitmap_to_number(const BHS *bitmap);
 BHS* bignum_create_list(void);
 
 /**
- * 从现有 LIST 创建列表类型 BHS
+ * 从现有 LIST 创建列表类型 BHS（复制列表及其中的元素，不接管 list）
  * 
  * @param list 现有的 LIST 指针
  * @return 新的列表类型 BHS 指针，失败返回 NULL
@@ -362,6 +599,14 @@ BHS* bignum_from_list(struct LIST *list);
  */
 struct LIST* bignum_get_list(const BHS *num);
 
+/**
+ * 获取可修改的底层 LIST 指针（列表被共享时先复制一份）
+ * 
+ * @param num 列表类型的 BHS
+ * @return LIST 指针，失败返回 NULL
+ */
+struct LIST* bignum_get_list_mutable(BHS *num);
+
 /**
  * 将 BHS 转换为 double（用于数值计算）
  * 
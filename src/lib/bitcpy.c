@@ -10,14 +10,15 @@
  *
  * 实现细节:
  *   - 阶段1: 处理前导位,使目标对齐到字节边界
- *   - 阶段2: 64位块批量处理,利用 CPU 64位加载能力
+ *   - 阶段2: 源也字节对齐时整段 memmove；否则按 64 位字拼接
+ *            (funnel shift),相邻两个源字各加载一次
  *   - 阶段3: 字节级处理剩余数据
  *   - 阶段4: 处理尾部剩余的 1-7 位
  *
  * 性能优化:
- *   - 字节对齐时直接使用 memcpy
+ *   - 源与目标位偏移相同(对齐后源也对齐)时直接使用 memmove
  *   - 预计算的位掩码表 (mask_low[], mask_high[])
- *   - 64位块处理减少循环次数
+ *   - 64位字拼接时保留上一个源字,每输出 8 字节只加载 8 字节
  *   - 边界检查优化,避免不必要的分支
  *
  * 算法复杂度:
@@ -30,7 +31,7 @@
 void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,uint64_t len){    
     if (len == 0) return;
     if ((src_bit | dest_bit) == 0 && (len & 7) == 0) {
-        memcpy(dest, src, len >> 3);
+        memmove(dest, src, len >> 3);   // 自拷贝时区域可能重叠
         return;
     }
     static const uint8_t mask_low[8] = {0x00, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F};
@@ -66,35 +67,47 @@ void bitcpy(uint8_t* dest, uint8_t dest_bit,const uint8_t* src, uint8_t src_bit,
     }
     
     // 此时 dest 已字节对齐
-    // 计算源可读字节数：(src_bit + remaining + 7) / 8
-    // 64位块需要读取8字节（对齐）或9字节（非对齐）
-    
-    // 阶段2：64位块处理
-    while (remaining >= 64) {
-        uint64_t data;
-        if (src_bit == 0) {
-            // 源对齐：直接读取8字节
-            memcpy(&data, src, 8);
-        } else {
-            // 源非对齐：需要读取9字节拼接
-            // 检查：remaining >= 64 意味着至少还有64位
-            // 从当前src读取需要 ceil((src_bit + 64) / 8) = (src_bit + 64 + 7) / 8 字节
-            // 当 src_bit > 0 时，需要9字节，但我们只能保证 (src_bit + 64 - 1) / 8 + 1 字节可用
-            // 即 (src_bit + 63) / 8 + 1 = 7 或 8 或 9 字节
-            // 为安全起见，当 remaining 刚好等于64且src_bit!=0时，退回字节处理
-            if (remaining == 64) break;
+    // 阶段2：源也对齐时整段 memmove，否则按 64 位字拼接
+    if (src_bit == 0) {
+        uint64_t bytes = remaining >> 3;
+        memmove(dest, src, bytes);
+        dest += bytes;
+        src += bytes;
+        remaining &= 7;
+    } else if (remaining >= 64) {
+        // 源可读字节数为 (src_bit + remaining + 7) / 8，输出 n 个字要读 n + 1 个源字，
+        // 读不满的部分交给字节级处理
+        uint64_t avail = (src_bit + remaining + 7) >> 3;
+        uint64_t n = remaining >> 6;
+        if (n > (avail >> 3) - 1) n = (avail >> 3) - 1;
+        uint8_t back = 64 - src_bit;
+        uint64_t cur;
+        memcpy(&cur, src, 8);
+        
+        // 每次两个字，上一个源字留在寄存器中
+        for (uint64_t i = 0; i + 2 <= n; i += 2) {
+            uint64_t w1, w2;
+            memcpy(&w1, src + 8, 8);
+            memcpy(&w2, src + 16, 8);
+            uint64_t out1 = (cur >> src_bit) | (w1 << back);
+            uint64_t out2 = (w1 >> src_bit) | (w2 << back);
+            memcpy(dest, &out1, 8);
+            memcpy(dest + 8, &out2, 8);
+            cur = w2;
             
-            uint64_t part1;
-            memcpy(&part1, src, 8);
-            uint8_t part2 = src[8];
-            data = (part1 >> src_bit) | ((uint64_t)part2 << (64 - src_bit));
+            dest += 16;
+            src += 16;
         }
-        
-        memcpy(dest, &data, 8);
-        
-        dest += 8;
-        src += 8;
-        remaining -= 64;
+        if (n & 1) {
+            uint64_t w1;
+            memcpy(&w1, src + 8, 8);
+            uint64_t out1 = (cur >> src_bit) | (w1 << back);
+            memcpy(dest, &out1, 8);
+            
+            dest += 8;
+            src += 8;
+        }
+        remaining -= n << 6;
     }
     
     // 阶段3：字节级处理
@@ -12,9 +12,9 @@
  *
  * 主要功能:
  *   - 支持任意位偏移的内存拷贝 (0-7位)
- *   - 自动优化对齐拷贝,使用 memcpy 加速
- *   - 支持自拷贝 (源和目标可以是同一区域)
- *   - 高效的三阶段处理: 前导位对齐 + 64位块 + 尾部处理
+ *   - 源与目标位偏移相同时使用 memcpy 加速
+ *   - 支持自拷贝 (源和目标可以是同一区域,目标不晚于源)
+ *   - 高效的三阶段处理: 前导位对齐 + 64位字拼接 + 尾部处理
  *
  * 性能特性:
  *   - 字节对齐时直接使用 memcpy
@@ -44,7 +44,8 @@
  * - len 必须 >= 0
  * - dest 缓冲区至少需要 (dest_bit + len + 7) / 8 字节
  * - src 缓冲区至少需要 (src_bit + len + 7) / 8 字节
- * - 当 len > 0 时，dest 和 src 可以指向同一内存区域（支持自拷贝）
+ * - 当 len > 0 时，dest 和 src 可以指向同一内存区域（支持自拷贝），
+ *   重叠时目标起始位置不能晚于源起始位置（按从低到高的顺序拷贝）
  *
  * === 未定义行为 ===
  * 如果违反以下任何条件，行为未定义：
@@ -59,8 +60,8 @@
  * - 位 0 是字节的最低有效位（LSB）
  * - 位 7 是字节的最高有效位（MSB）
  * === 性能特点 ===
- * - 最优情况：字节对齐且长度为8的倍数，接近 memcpy 性能
- * - 次优情况：目标对齐后的大块数据（>=64位），充分利用内存带宽
+ * - 最优情况：源与目标位偏移相同，中间部分直接 memcpy
+ * - 次优情况：位偏移不同的大块数据（>=64位），按 64 位字拼接，每字一次加载
  * - 一般情况：通过分阶段处理减少位操作次数
  * - 查找表优化：mask_low[] 和 mask_high[] 避免运行时计算
  */
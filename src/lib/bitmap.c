@@ -1,4 +1,9 @@
 #include "bitmap.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define BITMAP_X86_DISPATCH 1  /* 运行时按 CPUID 选择 POPCNT / AVX2 内核 */
+#endif
 /*
 #版权所有 (c) Mhuixs-team 2024
 #许可证协议:
@@ -35,6 +40,524 @@ static inline uint8_t* get_bitmap_data(const BHS* bm) {
     return (uint8_t*)(bm->is_large ? bm->data.large_data : bm->data.small_data);
 }
 
+/**
+ * 获取可写的 bitmap 数据指针，保留 rank/select 目录，由调用者负责更新
+ * large_data 被其他 BHS 共享时先复制一份（写时复制）
+ */
+static inline uint8_t* get_bitmap_data_unique(BHS* bm) {
+    if (!bm || bignum_make_unique(bm) != BIGNUM_SUCCESS) return NULL;
+    return get_bitmap_data(bm);
+}
+
+/**
+ * 获取可写的 bitmap 数据指针，rank/select 目录随之失效
+ */
+static inline uint8_t* get_bitmap_data_mut(BHS* bm) {
+    uint8_t* data = get_bitmap_data_unique(bm);
+    if (data && bm->is_large) bignum_payload_drop_aux(bm->data.large_data);
+    return data;
+}
+
+/**
+ * 读取第 word_idx 个 64 位字（位 i 对应字内第 i % 64 位）
+ * 数据区按字节分配，最后一个字可能不满 8 字节，不足部分补 0
+ */
+static inline uint64_t bitmap_load_word(const uint8_t* data, uint64_t byte_num, uint64_t word_idx) {
+    uint64_t w = 0;
+    uint64_t offset = word_idx * 8;
+    uint64_t n = byte_num - offset < 8 ? byte_num - offset : 8;
+    memcpy(&w, data + offset, n);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+/* 单个 64 位字的 1 的个数（SWAR，不依赖 CPU 指令） */
+static inline uint64_t popcount64_swar(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+/* 标量内核：统计从 p 开始 n 个完整 64 位字中 1 的个数 */
+static uint64_t popcount_words_scalar(const uint8_t* p, uint64_t n) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t w;
+        memcpy(&w, p + i * 8, 8);
+        sum += popcount64_swar(w);
+    }
+    return sum;
+}
+
+#ifdef BITMAP_X86_DISPATCH
+/* POPCNT 内核：四路累加，隐藏 popcnt 的延迟 */
+__attribute__((target("popcnt")))
+static uint64_t popcount_words_popcnt(const uint8_t* p, uint64_t n) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint64_t w[4];
+        memcpy(w, p + i * 8, 32);
+        s0 += (uint64_t)__builtin_popcountll(w[0]);
+        s1 += (uint64_t)__builtin_popcountll(w[1]);
+        s2 += (uint64_t)__builtin_popcountll(w[2]);
+        s3 += (uint64_t)__builtin_popcountll(w[3]);
+    }
+    for (; i < n; i++) {
+        uint64_t w;
+        memcpy(&w, p + i * 8, 8);
+        s0 += (uint64_t)__builtin_popcountll(w);
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+/* 每个 64 位通道内的 1 的个数（半字节查表 + SAD 横向求和） */
+__attribute__((target("avx2")))
+static inline __m256i popcount256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+/* 进位保存加法器：a + b + c = 2 * h + l（逐位） */
+#define BITMAP_CSA(h, l, a, b, c) do { \
+    __m256i u_ = _mm256_xor_si256((a), (b)); \
+    (h) = _mm256_or_si256(_mm256_and_si256((a), (b)), _mm256_and_si256(u_, (c))); \
+    (l) = _mm256_xor_si256(u_, (c)); \
+} while (0)
+
+#define BITMAP_LOAD256(p, i) _mm256_loadu_si256((const __m256i*)((p) + (i) * 32))
+
+/*
+ * AVX2 Harley-Seal 内核（Muła、Kurz、Lemire）
+ * 每 16 个 256 位块经 CSA 树压成 ones/twos/fours/eights/sixteens 五个计数向量，
+ * 每 16 块只对 sixteens 做一次 popcount，其余在循环结束后按权重合并
+ */
+__attribute__((target("avx2,popcnt")))
+static uint64_t popcount_words_avx2(const uint8_t* p, uint64_t n) {
+    uint64_t blocks = n / 4;  /* 256 位块数 */
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256();
+    __m256i twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256();
+    __m256i eights = _mm256_setzero_si256();
+    __m256i sixteens, twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+    
+    uint64_t i = 0;
+    for (; i + 16 <= blocks; i += 16) {
+        BITMAP_CSA(twos_a, ones, ones, BITMAP_LOAD256(p, i + 0), BITMAP_LOAD256(p, i + 1));
+        BITMAP_CSA(twos_b, ones, ones, BITMAP_LOAD256(p, i + 2), BITMAP_LOAD256(p, i + 3));
+        BITMAP_CSA(fours_a, twos, twos, twos_a, twos_b);
+        BITMAP_CSA(twos_a, ones, ones, BITMAP_LOAD256(p, i + 4), BITMAP_LOAD256(p, i + 5));
+        BITMAP_CSA(twos_b, ones, ones, BITMAP_LOAD256(p, i + 6), BITMAP_LOAD256(p, i + 7));
+        BITMAP_CSA(fours_b, twos, twos, twos_a, twos_b);
+        BITMAP_CSA(eights_a, fours, fours, fours_a, fours_b);
+        BITMAP_CSA(twos_a, ones, ones, BITMAP_LOAD256(p, i + 8), BITMAP_LOAD256(p, i + 9));
+        BITMAP_CSA(twos_b, ones, ones, BITMAP_LOAD256(p, i + 10), BITMAP_LOAD256(p, i + 11));
+        BITMAP_CSA(fours_a, twos, twos, twos_a, twos_b);
+        BITMAP_CSA(twos_a, ones, ones, BITMAP_LOAD256(p, i + 12), BITMAP_LOAD256(p, i + 13));
+        BITMAP_CSA(twos_b, ones, ones, BITMAP_LOAD256(p, i + 14), BITMAP_LOAD256(p, i + 15));
+        BITMAP_CSA(fours_b, twos, twos, twos_a, twos_b);
+        BITMAP_CSA(eights_b, fours, fours, fours_a, fours_b);
+        BITMAP_CSA(sixteens, eights, eights, eights_a, eights_b);
+        total = _mm256_add_epi64(total, popcount256(sixteens));
+    }
+    
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount256(twos), 1));
+    total = _mm256_add_epi64(total, popcount256(ones));
+    for (; i < blocks; i++) {
+        total = _mm256_add_epi64(total, popcount256(BITMAP_LOAD256(p, i)));
+    }
+    
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, total);
+    uint64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    
+    /* 不足一个 256 位块的剩余字 */
+    for (uint64_t w_idx = blocks * 4; w_idx < n; w_idx++) {
+        uint64_t w;
+        memcpy(&w, p + w_idx * 8, 8);
+        sum += (uint64_t)__builtin_popcountll(w);
+    }
+    return sum;
+}
+
+#undef BITMAP_LOAD256
+#undef BITMAP_CSA
+#endif
+
+typedef uint64_t (*popcount_words_fn)(const uint8_t* p, uint64_t n);
+
+/* 按 CPU 特性选择内核 */
+static popcount_words_fn popcount_words_select(void) {
+#ifdef BITMAP_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return popcount_words_avx2;
+    if (__builtin_cpu_supports("popcnt")) return popcount_words_popcnt;
+#endif
+    return popcount_words_scalar;
+}
+
+/**
+ * 统计从 p 开始 n 个完整 64 位字中 1 的个数
+ * 首次调用时选定内核，之后直接走函数指针（多线程下重复选择结果相同，无害）
+ */
+static uint64_t popcount_words(const uint8_t* p, uint64_t n) {
+    static popcount_words_fn kernel = NULL;
+    if (!kernel) kernel = popcount_words_select();
+    return kernel(p, n);
+}
+
+// ============================================================================
+// 按位运算内核
+// ============================================================================
+
+/* 内核支持的运算：与、或、异或沿用 ROARING_OP_* 的取值，另加取反 */
+#define BITWISE_AND ROARING_OP_AND
+#define BITWISE_OR  ROARING_OP_OR
+#define BITWISE_XOR ROARING_OP_XOR
+#define BITWISE_NOT 3
+
+#define BITWISE_EXPR_AND(x, y) ((x) & (y))
+#define BITWISE_EXPR_OR(x, y)  ((x) | (y))
+#define BITWISE_EXPR_XOR(x, y) ((x) ^ (y))
+#define BITWISE_EXPR_NOT(x, y) (~(x))
+
+/* 按 op 展开循环体，switch 留在循环外 */
+#define BITWISE_DISPATCH(LOOP) do { \
+    switch (op) { \
+        case BITWISE_AND: LOOP(AND); break; \
+        case BITWISE_OR:  LOOP(OR);  break; \
+        case BITWISE_XOR: LOOP(XOR); break; \
+        default:          LOOP(NOT); break; \
+    } \
+} while (0)
+
+/**
+ * 标量内核：dst = a op b，共 n 个完整 64 位字（取反时不读 b）
+ * dst 可以与 a 或 b 相同；用 memcpy 读写，不要求对齐
+ */
+static void bitwise_words_scalar(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint64_t n, int op) {
+#define BITWISE_SCALAR_LOOP(OP) \
+    for (uint64_t i = 0; i < n; i++) { \
+        uint64_t x, y = 0, r; \
+        memcpy(&x, a + i * 8, 8); \
+        if (op != BITWISE_NOT) memcpy(&y, b + i * 8, 8); \
+        r = BITWISE_EXPR_##OP(x, y); \
+        memcpy(dst + i * 8, &r, 8); \
+    }
+    BITWISE_DISPATCH(BITWISE_SCALAR_LOOP);
+#undef BITWISE_SCALAR_LOOP
+}
+
+#ifdef BITMAP_X86_DISPATCH
+/* 第二个参数是 b 中对应块的地址，取反时不展开，也就不读 b */
+#define BITWISE_LOAD256(p) _mm256_loadu_si256((const __m256i*)(p))
+#define BITWISE_EXPR256_AND(x, p) _mm256_and_si256(x, BITWISE_LOAD256(p))
+#define BITWISE_EXPR256_OR(x, p)  _mm256_or_si256(x, BITWISE_LOAD256(p))
+#define BITWISE_EXPR256_XOR(x, p) _mm256_xor_si256(x, BITWISE_LOAD256(p))
+#define BITWISE_EXPR256_NOT(x, p) _mm256_xor_si256(x, _mm256_set1_epi64x(-1))
+
+/**
+ * AVX2 内核：每次处理 4 个 256 位块（128 字节），剩余不足一块的字交给标量内核
+ * 非对齐读写，dst 与 a/b 同址时每块先读后写，结果不变
+ */
+__attribute__((target("avx2")))
+static void bitwise_words_avx2(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint64_t n, int op) {
+    uint64_t blocks = n / 4;  /* 256 位块数 */
+    uint64_t i = 0;
+#define BITWISE_AVX2_LOOP(OP) \
+    for (; i + 4 <= blocks; i += 4) { \
+        __m256i x0 = BITWISE_LOAD256(a + i * 32); \
+        __m256i x1 = BITWISE_LOAD256(a + i * 32 + 32); \
+        __m256i x2 = BITWISE_LOAD256(a + i * 32 + 64); \
+        __m256i x3 = BITWISE_LOAD256(a + i * 32 + 96); \
+        x0 = BITWISE_EXPR256_##OP(x0, b + i * 32); \
+        x1 = BITWISE_EXPR256_##OP(x1, b + i * 32 + 32); \
+        x2 = BITWISE_EXPR256_##OP(x2, b + i * 32 + 64); \
+        x3 = BITWISE_EXPR256_##OP(x3, b + i * 32 + 96); \
+        _mm256_storeu_si256((__m256i*)(dst + i * 32), x0); \
+        _mm256_storeu_si256((__m256i*)(dst + i * 32 + 32), x1); \
+        _mm256_storeu_si256((__m256i*)(dst + i * 32 + 64), x2); \
+        _mm256_storeu_si256((__m256i*)(dst + i * 32 + 96), x3); \
+    } \
+    for (; i < blocks; i++) { \
+        __m256i x = BITWISE_LOAD256(a + i * 32); \
+        _mm256_storeu_si256((__m256i*)(dst + i * 32), BITWISE_EXPR256_##OP(x, b + i * 32)); \
+    }
+    BITWISE_DISPATCH(BITWISE_AVX2_LOOP);
+#undef BITWISE_AVX2_LOOP
+    uint64_t done = blocks * 32;
+    bitwise_words_scalar(dst + done, a + done, b ? b + done : NULL, n - blocks * 4, op);
+}
+
+#undef BITWISE_LOAD256
+#undef BITWISE_EXPR256_AND
+#undef BITWISE_EXPR256_OR
+#undef BITWISE_EXPR256_XOR
+#undef BITWISE_EXPR256_NOT
+#endif
+
+typedef void (*bitwise_words_fn)(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint64_t n, int op);
+
+static bitwise_words_fn bitwise_words_select(void) {
+#ifdef BITMAP_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return bitwise_words_avx2;
+#endif
+    return bitwise_words_scalar;
+}
+
+/**
+ * dst = a op b，共 byte_num 字节；整字部分走选定的内核，末尾不足 8 字节逐字节处理
+ * 取反时 b 可以为 NULL
+ */
+static void bitwise_bytes(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint64_t byte_num, int op) {
+    static bitwise_words_fn kernel = NULL;
+    if (!kernel) kernel = bitwise_words_select();
+    
+    uint64_t words = byte_num / 8;
+    if (words) kernel(dst, a, b, words, op);
+    for (uint64_t i = words * 8; i < byte_num; i++) {
+        switch (op) {
+            case BITWISE_AND: dst[i] = a[i] & b[i]; break;
+            case BITWISE_OR:  dst[i] = a[i] | b[i]; break;
+            case BITWISE_XOR: dst[i] = a[i] ^ b[i]; break;
+            default:          dst[i] = (uint8_t)~a[i]; break;
+        }
+    }
+}
+
+/**
+ * dst = a op b，共 byte_num 字节，op 为 ROARING_OP_AND / OR / XOR
+ * 供压缩编码等内部模块复用同一套内核
+ */
+void bitmap_words_op(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint64_t byte_num, int op) {
+    bitwise_bytes(dst, a, b, byte_num, op);
+}
+
+/**
+ * 统计从 p 开始 n 个完整 64 位字中 1 的个数
+ */
+uint64_t bitmap_words_popcount(const uint8_t* p, uint64_t n) {
+    return popcount_words(p, n);
+}
+
+/**
+ * 字 w 中第 r 个（从 0 开始，r 小于 w 中 1 的个数）1 的位置
+ * 先按字节跳过，再在字节内逐个清掉最低位的 1
+ */
+uint32_t bitmap_word_select(uint64_t w, uint32_t r) {
+    uint32_t base = 0;
+    uint32_t c;
+    while (r >= (c = (uint32_t)popcount64_swar(w & 0xFF))) {
+        r -= c;
+        w >>= 8;
+        base += 8;
+    }
+    while (r--) {
+        w &= w - 1;
+    }
+    return base + (uint32_t)__builtin_ctzll(w);
+}
+
+#undef BITWISE_DISPATCH
+#undef BITWISE_EXPR_AND
+#undef BITWISE_EXPR_OR
+#undef BITWISE_EXPR_XOR
+#undef BITWISE_EXPR_NOT
+
+/**
+ * 平铺数据中 [from_word * 64, pos) 内 1 的个数，pos 不超过数据位数
+ */
+static uint64_t bitmap_count_span(const uint8_t* data, uint64_t byte_num, uint64_t from_word, uint64_t pos) {
+    uint64_t last_word = pos / 64;
+    uint64_t sum = popcount_words(data + from_word * 8, last_word - from_word);
+    if (pos % 64) {
+        sum += popcount64_swar(bitmap_load_word(data, byte_num, last_word) & ((1ULL << (pos % 64)) - 1));
+    }
+    return sum;
+}
+
+// ============================================================================
+// rank/select 目录
+// ============================================================================
+
+/*
+较大的平铺位图在第一次 rank/select（或大范围统计）时建立目录，挂在数据区的
+附属索引上（bignum_payload_aux），随数据区一起共享和释放：
+- block[b]：第 b 个 512 位超块之前、同一 64K 位块内 1 的个数
+- cnt[c]：第 c 个 64K 位块中 1 的个数
+- rank[c]：第 c 个 64K 位块之前 1 的个数，只保证 rank[0..valid] 是最新的
+rank 为 O(1)，select 在 rank 和 block 上二分为 O(log n)。
+修改单个位或一段位时只更新涉及的块并把 valid 退回，rank 在下次查询时从 valid
+向后补齐；其余写操作经 get_bitmap_data_mut 直接丢弃目录。
+目录按数据区字节数建立，长度之外的残留位只可能出现在最后一个字节，查询时不会越过长度。
+*/
+#define RANK_BLOCK_BITS       512
+#define RANK_CHUNK_BITS       65536
+#define RANK_BLOCKS_PER_CHUNK (RANK_CHUNK_BITS / RANK_BLOCK_BITS)
+
+typedef struct {
+    uint64_t bytes;         // 建立目录时数据区的字节数
+    uint64_t chunks;        // 64K 位块数
+    uint64_t blocks;        // 512 位超块数
+    uint64_t valid;         // rank[0..valid] 有效
+    uint8_t lock;           // 补齐 rank 时的自旋锁（只读的共享数据区可能被并发查询）
+    uint64_t* rank;         // chunks + 1 项
+    uint32_t* cnt;          // chunks 项
+    uint16_t* block;        // blocks 项
+} rank_dir;
+
+/* 重新统计第 c0 ~ c1 个 64K 位块 */
+static void rank_dir_refresh(rank_dir* dir, const uint8_t* data, uint64_t c0, uint64_t c1) {
+    uint64_t bits = dir->bytes * 8;
+    for (uint64_t c = c0; c <= c1 && c < dir->chunks; c++) {
+        uint64_t b_end = (c + 1) * RANK_BLOCKS_PER_CHUNK;
+        if (b_end > dir->blocks) b_end = dir->blocks;
+        
+        uint32_t sum = 0;
+        for (uint64_t b = c * RANK_BLOCKS_PER_CHUNK; b < b_end; b++) {
+            uint64_t pos = (b + 1) * RANK_BLOCK_BITS < bits ? (b + 1) * RANK_BLOCK_BITS : bits;
+            dir->block[b] = (uint16_t)sum;
+            sum += (uint32_t)bitmap_count_span(data, dir->bytes, b * (RANK_BLOCK_BITS / 64), pos);
+        }
+        dir->cnt[c] = sum;
+    }
+    if (dir->valid > c0) dir->valid = c0;
+}
+
+static rank_dir* rank_dir_build(const uint8_t* data, uint64_t bytes) {
+    uint64_t chunks = (bytes * 8 + RANK_CHUNK_BITS - 1) / RANK_CHUNK_BITS;
+    uint64_t blocks = (bytes * 8 + RANK_BLOCK_BITS - 1) / RANK_BLOCK_BITS;
+    rank_dir* dir = (rank_dir*)malloc(sizeof(rank_dir) + (chunks + 1) * sizeof(uint64_t) +
+                                      chunks * sizeof(uint32_t) + blocks * sizeof(uint16_t));
+    if (!dir) return NULL;
+    
+    dir->bytes = bytes;
+    dir->chunks = chunks;
+    dir->blocks = blocks;
+    dir->valid = chunks;
+    dir->lock = 0;
+    dir->rank = (uint64_t*)(dir + 1);
+    dir->cnt = (uint32_t*)(dir->rank + chunks + 1);
+    dir->block = (uint16_t*)(dir->cnt + chunks);
+    
+    rank_dir_refresh(dir, data, 0, chunks - 1);
+    dir->rank[0] = 0;
+    for (uint64_t c = 0; c < chunks; c++) {
+        dir->rank[c + 1] = dir->rank[c] + dir->cnt[c];
+    }
+    dir->valid = chunks;
+    return dir;
+}
+
+/**
+ * 取位图的目录
+ * build 为 1 时没有目录就建立一个；数据区太小或是压缩编码时返回 NULL
+ */
+static rank_dir* bitmap_rank_dir(const BHS* bm, int build) {
+    uint64_t bytes = (bm->length + 7) / 8;
+    if (!bm->is_large || BITMAP_IS_ROARING(bm) || bytes < BITMAP_RANK_MIN_BYTES) return NULL;
+    
+    rank_dir* dir = (rank_dir*)bignum_payload_aux(bm->data.large_data);
+    if (!dir && build) {
+        dir = rank_dir_build(get_bitmap_data(bm), bytes);
+        if (dir && bignum_payload_attach_aux(bm->data.large_data, dir) != BIGNUM_SUCCESS) {
+            // 其他查询已经建好
+            free(dir);
+            dir = (rank_dir*)bignum_payload_aux(bm->data.large_data);
+        }
+    }
+    return dir && dir->bytes == bytes ? dir : NULL;
+}
+
+/* 第 c 个 64K 位块之前 1 的个数，必要时从 valid 向后补齐 */
+static uint64_t rank_dir_chunk_rank(rank_dir* dir, uint64_t c) {
+    if (c <= __atomic_load_n(&dir->valid, __ATOMIC_ACQUIRE)) return dir->rank[c];
+    
+    while (__atomic_test_and_set(&dir->lock, __ATOMIC_ACQUIRE)) {
+        // 等待另一个查询补齐
+    }
+    for (uint64_t i = dir->valid; i < c; i++) {
+        dir->rank[i + 1] = dir->rank[i] + dir->cnt[i];
+    }
+    if (c > dir->valid) __atomic_store_n(&dir->valid, c, __ATOMIC_RELEASE);
+    __atomic_clear(&dir->lock, __ATOMIC_RELEASE);
+    return dir->rank[c];
+}
+
+/* [0, pos) 中 1 的个数，pos 不超过数据位数 */
+static uint64_t rank_dir_rank(rank_dir* dir, const uint8_t* data, uint64_t pos) {
+    if (pos == dir->bytes * 8) return rank_dir_chunk_rank(dir, dir->chunks);
+    
+    uint64_t b = pos / RANK_BLOCK_BITS;
+    return rank_dir_chunk_rank(dir, pos / RANK_CHUNK_BITS) + dir->block[b] +
+           bitmap_count_span(data, dir->bytes, b * (RANK_BLOCK_BITS / 64), pos);
+}
+
+/* 第 k 个（从 0 开始）1 的位置，不存在时返回 -1 */
+static int64_t rank_dir_select(rank_dir* dir, const uint8_t* data, uint64_t k) {
+    if (k >= rank_dir_chunk_rank(dir, dir->chunks)) return merr;
+    
+    // 最后一个 rank[c] <= k 的块
+    uint64_t lo = 0, hi = dir->chunks - 1;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (dir->rank[mid] <= k) lo = mid;
+        else hi = mid - 1;
+    }
+    uint64_t c = lo;
+    uint32_t r = (uint32_t)(k - dir->rank[c]);
+    
+    // 块内最后一个 block[b] <= r 的超块
+    lo = c * RANK_BLOCKS_PER_CHUNK;
+    hi = (c + 1) * RANK_BLOCKS_PER_CHUNK < dir->blocks ? (c + 1) * RANK_BLOCKS_PER_CHUNK - 1 : dir->blocks - 1;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (dir->block[mid] <= r) lo = mid;
+        else hi = mid - 1;
+    }
+    r -= dir->block[lo];
+    
+    uint64_t word_num = (dir->bytes + 7) / 8;
+    for (uint64_t i = lo * (RANK_BLOCK_BITS / 64); i < word_num; i++) {
+        uint64_t w = bitmap_load_word(data, dir->bytes, i);
+        uint32_t n = (uint32_t)popcount64_swar(w);
+        if (r < n) return (int64_t)(i * 64 + bitmap_word_select(w, r));
+        r -= n;
+    }
+    return merr;
+}
+
+/* bitmap_set 改变了 pos 位后更新目录，delta 为 +1 或 -1 */
+static void rank_dir_adjust(rank_dir* dir, uint64_t pos, int delta) {
+    uint64_t c = pos / RANK_CHUNK_BITS;
+    uint64_t b_end = (c + 1) * RANK_BLOCKS_PER_CHUNK < dir->blocks ? (c + 1) * RANK_BLOCKS_PER_CHUNK : dir->blocks;
+    
+    dir->cnt[c] += delta;
+    for (uint64_t b = pos / RANK_BLOCK_BITS + 1; b < b_end; b++) {
+        dir->block[b] = (uint16_t)(dir->block[b] + delta);
+    }
+    if (dir->valid > c) dir->valid = c;
+}
+
+/* 平铺数据的 [first, last] 位被修改后重新统计涉及的块（没有目录时什么也不做） */
+static void bitmap_rank_dir_touch(BHS* bm, uint64_t first, uint64_t last) {
+    rank_dir* dir = bitmap_rank_dir(bm, 0);
+    if (dir) rank_dir_refresh(dir, get_bitmap_data(bm), first / RANK_CHUNK_BITS, last / RANK_CHUNK_BITS);
+}
+
 /**
  * 扩展 bitmap 大小（支持扩大和缩小）
  * @param bm bitmap 指针
@@ -44,6 +567,13 @@ static inline uint8_t* get_bitmap_data(const BHS* bm) {
 static int bitmap_rexpand(BHS* bm, uint64_t new_bit_num) {
     if (!check_if_bitmap(bm)) return merr;
     
+    // 压缩编码不按位数分配空间，缩小时清掉截去的位即可
+    if (BITMAP_IS_ROARING(bm)) {
+        if (new_bit_num < bm->length && roaring_truncate(bm, new_bit_num) != 0) return merr;
+        bm->length = new_bit_num;
+        return 0;
+    }
+    
     uint64_t old_bit_num = bm->length;
     uint64_t old_byte_num = (old_bit_num + 7) / 8;
     uint64_t new_byte_num = (new_bit_num + 7) / 8;
@@ -56,7 +586,7 @@ static int bitmap_rexpand(BHS* bm, uint64_t new_bit_num) {
     
     // 处理 small_data 到 large_data 的转换
     if (!bm->is_large && new_byte_num > BIGNUM_SMALL_SIZE) {
-        char* new_data = (char*)malloc(new_byte_num);
+        char* new_data = bignum_payload_alloc(new_byte_num);
         if (!new_data) return merr;
         
         // 复制旧数据
@@ -78,7 +608,7 @@ static int bitmap_rexpand(BHS* bm, uint64_t new_bit_num) {
         char temp[BIGNUM_SMALL_SIZE];
         memcpy(temp, bm->data.large_data, new_byte_num);
         
-        free(bm->data.large_data);
+        bignum_payload_release(bm->data.large_data);
         memcpy(bm->data.small_data, temp, new_byte_num);
         if (new_byte_num < BIGNUM_SMALL_SIZE) {
             memset(bm->data.small_data + new_byte_num, 0, BIGNUM_SMALL_SIZE - new_byte_num);
@@ -92,7 +622,8 @@ static int bitmap_rexpand(BHS* bm, uint64_t new_bit_num) {
     
     // 处理 large_data 的扩大或缩小
     if (bm->is_large) {
-        char* new_data = (char*)realloc(bm->data.large_data, new_byte_num);
+        if (!get_bitmap_data_mut(bm)) return merr;
+        char* new_data = bignum_payload_realloc(bm->data.large_data, new_byte_num);
         if (!new_data) return merr;
         
         // 如果是扩大，清零新增部分
@@ -119,6 +650,52 @@ static int bitmap_rexpand(BHS* bm, uint64_t new_bit_num) {
     return merr;
 }
 
+static inline int floor_log2(uint64_t x) {
+    return 63 - __builtin_clzll(x);
+}
+
+/**
+ * 扩展到 new_bit_num 位，调用者随后将写入约 new_ones 个 1
+ * 平铺位图扩展到较大尺寸时，若足够稀疏就先转为压缩编码，避免按位数分配内存；
+ * 只在字节数跨过 2 的幂时统计密度，逐位追加不会反复统计
+ * @return 0 成功, -1 失败
+ */
+static int bitmap_grow(BHS* bm, uint64_t new_bit_num, uint64_t new_ones) {
+    if (BITMAP_IS_ROARING(bm)) return bitmap_rexpand(bm, new_bit_num);
+    
+    uint64_t old_byte_num = (bm->length + 7) / 8;
+    uint64_t new_byte_num = (new_bit_num + 7) / 8;
+    if (new_byte_num > BITMAP_ROARING_MIN_BYTES &&
+        (old_byte_num == 0 || floor_log2(new_byte_num) > floor_log2(old_byte_num))) {
+        uint64_t ones = bitmap_count_span(get_bitmap_data(bm), old_byte_num, 0, bm->length);
+        if ((ones + new_ones) * BITMAP_SPARSE_RATIO < new_bit_num) {
+            if (roaring_from_dense(bm) != 0) return merr;
+            bm->length = new_bit_num;
+            return 0;
+        }
+    }
+    return bitmap_rexpand(bm, new_bit_num);
+}
+
+/**
+ * 压缩编码比平铺还大时转回平铺
+ * @return 0 成功, -1 失败
+ */
+static int bitmap_settle(BHS* bm) {
+    if (!bm || !BITMAP_IS_ROARING(bm)) return 0;
+    if (roaring_size_bytes(bm) <= (bm->length + 7) / 8) return 0;
+    return roaring_to_dense(bm);
+}
+
+/* 运算结果按实际密度选择编码，失败时释放结果 */
+static BHS* bitmap_settled(BHS* result) {
+    if (result && bitmap_settle(result) != 0) {
+        free_bitmap(result);
+        return NULL;
+    }
+    return result;
+}
+
 // ============================================================================
 // 构造和析构函数
 // ============================================================================
@@ -140,12 +717,18 @@ BHS* bitmap_create(void) {
 }
 
 /**
- * 创建指定大小的 bitmap
+ * 创建指定大小的平铺 bitmap（全 0）
+ * 供需要直接写数据区的内部函数使用
  */
-BHS* bitmap_create_with_size(uint64_t bit_num) {
+static BHS* bitmap_create_dense(uint64_t bit_num) {
     /* 检查 bit_num 是否超过 SIZE_MAX - 1 */
     if (bit_num > SIZE_MAX - 1) return NULL;
     
+    uint64_t byte_num = (bit_num + 7) / 8;
+    
+    /* 检查 byte_num 是否合理（避免分配过大内存导致系统崩溃） */
+    if (byte_num > SIZE_MAX / 2) return NULL;  /* 限制为系统最大内存的一半 */
+    
     BHS* bm = (BHS*)malloc(sizeof(BHS));
     if (!bm) return NULL;
     
@@ -153,11 +736,6 @@ BHS* bitmap_create_with_size(uint64_t bit_num) {
     bm->type = BIGNUM_TYPE_BITMAP;
     bm->length = (size_t)bit_num;   // 位数
     
-    uint64_t byte_num = (bit_num + 7) / 8;
-    
-    /* 检查 byte_num 是否合理（避免分配过大内存导致系统崩溃） */
-    if (byte_num > SIZE_MAX / 2) return NULL;  /* 限制为系统最大内存的一半 */
-    
     // 判断使用 small_data 还是 large_data
     if (byte_num <= BIGNUM_SMALL_SIZE) {
         bm->is_large = 0;
@@ -166,7 +744,7 @@ BHS* bitmap_create_with_size(uint64_t bit_num) {
     } else {
         bm->is_large = 1;
         bm->capacity = byte_num;
-        bm->data.large_data = (char*)calloc(byte_num, 1);
+        bm->data.large_data = bignum_payload_alloc(byte_num);
         if (!bm->data.large_data) {
             #ifdef bitmap_debug
             perror("BITMAP memory init failed!");
@@ -174,11 +752,31 @@ BHS* bitmap_create_with_size(uint64_t bit_num) {
             free(bm);
             return NULL;
         }
+        memset(bm->data.large_data, 0, byte_num);
     }
     
     return bm;
 }
 
+/**
+ * 创建指定大小的 bitmap（全 0）
+ * 较大的空位图直接使用压缩编码，写入后再按实际密度决定编码
+ */
+BHS* bitmap_create_with_size(uint64_t bit_num) {
+    if (bit_num > SIZE_MAX - 1) return NULL;
+    if ((bit_num + 7) / 8 <= BITMAP_ROARING_MIN_BYTES) return bitmap_create_dense(bit_num);
+    
+    BHS* bm = bitmap_create();
+    if (!bm) return NULL;
+    
+    bm->length = (size_t)bit_num;
+    if (roaring_init(bm) != 0) {
+        free(bm);
+        return NULL;
+    }
+    return bm;
+}
+
 /**
  * 从字符串创建 bitmap（字符串格式："010101"）
  */
@@ -186,7 +784,7 @@ BHS* bitmap_create_from_string(const char* s) {
     if (!s) return NULL;
     
     uint64_t len = strlen(s);
-    BHS* bm = bitmap_create_with_size(len);
+    BHS* bm = bitmap_create_dense(len);
     if (!bm) return NULL;
     
     // 设置位
@@ -211,18 +809,9 @@ BHS* bitmap_create_copy(const BHS* other) {
     // 复制基本信息
     memcpy(bm, other, sizeof(BHS));
     
-    // 处理数据复制
+    // large_data 按写时复制共享，修改前由 get_bitmap_data_mut 复制
     if (other->is_large) {
-        uint64_t byte_num = other->capacity;
-        bm->data.large_data = (char*)malloc(byte_num);
-        if (!bm->data.large_data) {
-            #ifdef bitmap_debug
-            perror("BITMAP memory init failed!");
-            #endif
-            free(bm);
-            return NULL;
-        }
-        memcpy(bm->data.large_data, other->data.large_data, byte_num);
+        bignum_payload_share(bm->data.large_data);
     }
     // small_data 已经在 memcpy 时复制了
     
@@ -235,7 +824,7 @@ BHS* bitmap_create_copy(const BHS* other) {
 BHS* bitmap_create_from_data(char* s, uint64_t len, uint8_t zerochar) {
     if (!s) return NULL;
     
-    BHS* bm = bitmap_create_with_size(len);
+    BHS* bm = bitmap_create_dense(len);
     if (!bm) return NULL;
     
     uint8_t* data = get_bitmap_data(bm);
@@ -255,7 +844,7 @@ void free_bitmap(BHS* bm) {
     if (!bm) return;
     
     if (check_if_bitmap(bm) && bm->is_large && bm->data.large_data) {
-        free(bm->data.large_data);
+        bignum_payload_release(bm->data.large_data);
     }
     free(bm);
 }
@@ -275,11 +864,12 @@ int bitmap_assign_string(BHS* bm, char* s) {
     
     // 释放旧数据
     if (bm->is_large && bm->data.large_data) {
-        free(bm->data.large_data);
+        bignum_payload_release(bm->data.large_data);
         bm->data.large_data = NULL;
     }
     
     // 分配新数据
+    bm->type_data.bm.encoding = BITMAP_ENC_DENSE;
     if (byte_num <= BIGNUM_SMALL_SIZE) {
         bm->is_large = 0;
         bm->capacity = BIGNUM_SMALL_SIZE;
@@ -287,13 +877,14 @@ int bitmap_assign_string(BHS* bm, char* s) {
     } else {
         bm->is_large = 1;
         bm->capacity = byte_num;
-        bm->data.large_data = (char*)calloc(byte_num, 1);
+        bm->data.large_data = bignum_payload_alloc(byte_num);
         if (!bm->data.large_data) {
             #ifdef bitmap_debug
             perror("BITMAP memory init failed!");
             #endif
             return merr;
         }
+        memset(bm->data.large_data, 0, byte_num);
     }
     
     bm->length = len;
@@ -317,33 +908,26 @@ int bitmap_assign_bitmap(BHS* bm, const BHS* other) {
     if (bm == other) return 0; // 自赋值保护
     
     uint64_t bit_num = other->length;
-    uint64_t byte_num = (bit_num + 7) / 8;
     
     // 释放旧数据
     if (bm->is_large && bm->data.large_data) {
-        free(bm->data.large_data);
+        bignum_payload_release(bm->data.large_data);
         bm->data.large_data = NULL;
     }
     
-    // 分配新数据
-    if (byte_num <= BIGNUM_SMALL_SIZE) {
+    // large_data 共享（写时复制），small_data 直接复制
+    if (!other->is_large) {
         bm->is_large = 0;
         bm->capacity = BIGNUM_SMALL_SIZE;
         memcpy(bm->data.small_data, other->data.small_data, BIGNUM_SMALL_SIZE);
     } else {
         bm->is_large = 1;
-        bm->capacity = byte_num;
-        bm->data.large_data = (char*)malloc(byte_num);
-        if (!bm->data.large_data) {
-            #ifdef bitmap_debug
-            perror("BITMAP memory allocation failed!");
-            #endif
-            return merr;
-        }
-        memcpy(bm->data.large_data, other->data.large_data, byte_num);
+        bm->capacity = other->capacity;
+        bm->data.large_data = bignum_payload_share(other->data.large_data);
     }
     
     bm->type = BIGNUM_TYPE_BITMAP;
+    bm->type_data = other->type_data;  // 编码方式随数据一起复制
     bm->length = bit_num;
     
     return 0;
@@ -365,10 +949,25 @@ int bitmap_append(BHS* bm, BHS* other) {
     uint64_t new_size = bm_size + other_size;
     uint64_t new_byte_num = (new_size + 7) / 8;
     
+    // 有压缩编码参与时按 bm | (other << bm_size) 合并
+    if (BITMAP_IS_ROARING(bm) || BITMAP_IS_ROARING(other)) {
+        BHS* shifted = bitmap_bitshl(other, bm_size);
+        BHS* merged = shifted ? bitmap_bitor(bm, shifted) : NULL;
+        free_bitmap(shifted);
+        if (!merged) return merr;
+        
+        if (bm->is_large && bm->data.large_data) {
+            bignum_payload_release(bm->data.large_data);
+        }
+        memcpy(bm, merged, sizeof(BHS));
+        free(merged);
+        return 0;
+    }
+    
     // 创建临时数据存储旧数据
     char* temp_data;
     int temp_is_large = bm->is_large;
-    uint64_t old_byte_num = (bm_size + 7) / 8;
+    size_t temp_capacity = bm->capacity;
     
     if (bm->is_large) {
         temp_data = bm->data.large_data;
@@ -386,37 +985,36 @@ int bitmap_append(BHS* bm, BHS* other) {
     } else {
         bm->is_large = 1;
         bm->capacity = new_byte_num;
-        bm->data.large_data = (char*)calloc(new_byte_num, 1);
+        bm->data.large_data = bignum_payload_alloc(new_byte_num);
         if (!bm->data.large_data) {
             #ifdef bitmap_debug
             perror("BITMAP memory init failed!");
             #endif
-            if (!temp_is_large) free(temp_data);
+            // 恢复原数据（small_data 未被改动）
+            bm->is_large = temp_is_large;
+            bm->capacity = temp_capacity;
+            if (temp_is_large) {
+                bm->data.large_data = temp_data;
+            } else {
+                free(temp_data);
+            }
             return merr;
         }
+        memset(bm->data.large_data, 0, new_byte_num);
     }
     
     bm->length = new_size;
     
-    // 复制数据
-    uint64_t dest_buffer_size = (new_size + 7) / 8;
-    uint64_t bm_buffer_size = (bm_size + 7) / 8;
-    uint64_t other_buffer_size = (other_size + 7) / 8;
-    
+    // 复制数据：旧数据字节对齐直接拷贝，other 接在第 bm_size 位之后
     uint8_t* new_data = get_bitmap_data(bm);
     uint8_t* other_data = get_bitmap_data(other);
     
-    bitcpy(new_data, 0, 
-           (uint8_t*)temp_data, 0, 
-           bm_size, dest_buffer_size, bm_buffer_size);
+    bitcpy(new_data, 0, (uint8_t*)temp_data, 0, bm_size);
+    bitcpy(new_data + bm_size / 8, bm_size % 8, other_data, 0, other_size);
     
-    bitcpy(new_data, bm_size, 
-           other_data, 0, 
-           other_size, dest_buffer_size, other_buffer_size);
-    
-    // 清理临时数据
+    // 清理临时数据（原 large_data 可能仍被其他 BHS 共享，只释放引用）
     if (temp_is_large) {
-        free(temp_data);
+        bignum_payload_release(temp_data);
     } else {
         free(temp_data);
     }
@@ -434,6 +1032,7 @@ int bitmap_append(BHS* bm, BHS* other) {
 int bitmap_get(const BHS* bm, uint64_t offset) {
     if (!check_if_bitmap(bm)) return merr;
     if (offset >= bm->length) return merr;
+    if (BITMAP_IS_ROARING(bm)) return roaring_get(bm, offset);
     
     uint8_t* data = get_bitmap_data(bm);
     return (data[offset / 8] >> (offset % 8)) & 1;
@@ -445,16 +1044,25 @@ int bitmap_get(const BHS* bm, uint64_t offset) {
 int bitmap_set(BHS* bm, uint64_t offset, uint8_t value) {
     if (!check_if_bitmap(bm)) return merr;
     
-    if (offset >= bm->length && bitmap_rexpand(bm, offset + 1) == merr) {
+    if (offset >= bm->length && bitmap_grow(bm, offset + 1, value ? 1 : 0) == merr) {
         return merr;
     }
+    if (BITMAP_IS_ROARING(bm)) {
+        if (roaring_set(bm, offset, value) != 0) return merr;
+        return bitmap_settle(bm);
+    }
     
-    uint8_t* data = get_bitmap_data(bm);
+    uint8_t* data = get_bitmap_data_unique(bm);
+    if (!data) return merr;
+    int old = (data[offset / 8] >> (offset % 8)) & 1;
     if (value) {
         data[offset / 8] |= 1 << (offset % 8);
     } else {
         data[offset / 8] &= ~(1 << (offset % 8));
     }
+    
+    rank_dir* dir = old != (value != 0) ? bitmap_rank_dir(bm, 0) : NULL;
+    if (dir) rank_dir_adjust(dir, offset, value ? 1 : -1);
     return 0;
 }
 
@@ -465,11 +1073,16 @@ int bitmap_set_range(BHS* bm, uint64_t offset, uint64_t len, uint8_t value) {
     if (!check_if_bitmap(bm)) return merr;
     if (!len) return 0;
     
-    if (offset + len > bm->length && bitmap_rexpand(bm, offset + len) == merr) {
+    if (offset + len > bm->length && bitmap_grow(bm, offset + len, value ? len : 0) == merr) {
         return merr;
     }
+    if (BITMAP_IS_ROARING(bm)) {
+        if (roaring_set_range(bm, offset, len, value) != 0) return merr;
+        return bitmap_settle(bm);
+    }
     
-    uint8_t* data = get_bitmap_data(bm);
+    uint8_t* data = get_bitmap_data_unique(bm);
+    if (!data) return merr;
     uint64_t s_byte = offset / 8;
     uint64_t e_bit = offset + len - 1;
     uint64_t e_byte = e_bit / 8;
@@ -480,6 +1093,7 @@ int bitmap_set_range(BHS* bm, uint64_t offset, uint64_t len, uint8_t value) {
         // 同一字节处理
         uint8_t mask = ((1 << (e_bit_in_byte + 1)) - 1) & ~((1 << s_bit) - 1);
         data[s_byte] = value ? (data[s_byte] | mask) : (data[s_byte] & ~mask);
+        bitmap_rank_dir_touch(bm, offset, e_bit);
         return 0;
     }
     
@@ -497,6 +1111,7 @@ int bitmap_set_range(BHS* bm, uint64_t offset, uint64_t len, uint8_t value) {
     uint8_t mask_tail = (1 << (e_bit_in_byte + 1)) - 1;
     data[e_byte] = value ? (data[e_byte] | mask_tail) : (data[e_byte] & ~mask_tail);
     
+    bitmap_rank_dir_touch(bm, offset, e_bit);
     return 0;
 }
 
@@ -507,11 +1122,22 @@ int bitmap_set_from_stream(BHS* bm, uint64_t offset, uint64_t len,
                           const char* data_stream, char zero_value) {
     if (!check_if_bitmap(bm) || !data_stream || !len) return merr;
     
-    if (offset + len > bm->length && bitmap_rexpand(bm, offset + len) == merr) {
-        return merr;
+    if (offset + len > bm->length) {
+        uint64_t ones = 0;
+        for (uint64_t i = 0; i < len; i++) {
+            ones += data_stream[i] != zero_value;
+        }
+        if (bitmap_grow(bm, offset + len, ones) == merr) return merr;
+    }
+    if (BITMAP_IS_ROARING(bm)) {
+        for (uint64_t i = 0; i < len; i++) {
+            if (roaring_set(bm, offset + i, data_stream[i] != zero_value) != 0) return merr;
+        }
+        return bitmap_settle(bm);
     }
     
-    uint8_t* data = get_bitmap_data(bm);
+    uint8_t* data = get_bitmap_data_unique(bm);
+    if (!data) return merr;
     for (uint64_t i = 0; i < len; i++, offset++) {
         if (data_stream[i] == zero_value) {
             data[offset / 8] &= ~(1 << (offset % 8));
@@ -519,6 +1145,7 @@ int bitmap_set_from_stream(BHS* bm, uint64_t offset, uint64_t len,
             data[offset / 8] |= 1 << (offset % 8);
         }
     }
+    bitmap_rank_dir_touch(bm, offset - len, offset - 1);
     return 0;
 }
 
@@ -542,117 +1169,172 @@ uint64_t bitmap_count(const BHS* bm, uint64_t st_offset, uint64_t ed_offset) {
     if (st_offset > ed_offset || ed_offset >= bm->length || st_offset >= bm->length) {
         return merr;
     }
+    if (BITMAP_IS_ROARING(bm)) return roaring_count(bm, st_offset, ed_offset);
     
-    uint8_t* data = get_bitmap_data(bm);
-    uint64_t sum = 0;
-    for (; st_offset <= ed_offset; st_offset++) {
-        if (data[st_offset / 8] & (1 << (st_offset % 8))) sum++;
+    const uint8_t* data = get_bitmap_data(bm);
+    
+    // 有目录时两次 rank 相减；没有目录时范围超过一半才值得建立
+    rank_dir* dir = bitmap_rank_dir(bm, ed_offset - st_offset >= bm->length / 2);
+    if (dir) return rank_dir_rank(dir, data, ed_offset + 1) - rank_dir_rank(dir, data, st_offset);
+    
+    uint64_t byte_num = (bm->length + 7) / 8;
+    uint64_t first_word = st_offset / 64;
+    uint64_t last_word = ed_offset / 64;
+    uint64_t head_mask = ~0ULL << (st_offset % 64);
+    uint64_t tail_mask = ~0ULL >> (63 - ed_offset % 64);
+    
+    // 范围在同一个字内
+    if (first_word == last_word) {
+        return popcount64_swar(bitmap_load_word(data, byte_num, first_word) & head_mask & tail_mask);
     }
+    
+    // 首尾两个字按掩码截取，中间的完整字交给批量内核
+    uint64_t sum = popcount64_swar(bitmap_load_word(data, byte_num, first_word) & head_mask);
+    sum += popcount_words(data + (first_word + 1) * 8, last_word - first_word - 1);
+    sum += popcount64_swar(bitmap_load_word(data, byte_num, last_word) & tail_mask);
     return sum;
 }
 
 /**
  * 查找指定值的位
+ * 按 64 位字扫描，找 0 时把字取反后同样找 1，非空字用 ctz 直接定位
  */
 int64_t bitmap_find(const BHS* bm, uint8_t value, uint64_t start, uint64_t end) {
     if (!check_if_bitmap(bm)) return merr;
     if (start > end || end >= bm->length) {
         return merr;
     }
+    if (BITMAP_IS_ROARING(bm)) return roaring_find(bm, value, start, end);
     
-    uint8_t* data = get_bitmap_data(bm);
-    const uint64_t* p64 = (const uint64_t*)data;
-    uint64_t pos = start;
-    
-    // 1. 处理起始的未对齐部分和单块内的查找
-    uint64_t first_word_idx = pos / 64;
-    uint64_t end_word_idx = end / 64;
-    
-    uint64_t chunk = p64[first_word_idx];
-    
-    // 创建掩码，屏蔽掉 pos 之前的所有位
-    uint64_t start_mask = ~0ULL << (pos % 64);
-    
-    // 如果搜索范围在同一个64位块内
-    if (first_word_idx == end_word_idx) {
-        // 创建掩码，屏蔽掉 end 之后的所有位
-        uint64_t end_mask = ~0ULL >> (63 - (end % 64));
-        uint64_t mask = start_mask & end_mask;
-        chunk &= mask;
-    } else {
-        chunk &= start_mask;
+    const uint8_t* data = get_bitmap_data(bm);
+    uint64_t byte_num = (bm->length + 7) / 8;
+    uint64_t first_word = start / 64;
+    uint64_t last_word = end / 64;
+    uint64_t flip = value ? 0 : ~0ULL;
+    uint64_t head_mask = ~0ULL << (start % 64);
+    uint64_t tail_mask = ~0ULL >> (63 - end % 64);
+    
+    // 首字（可能同时是尾字）
+    uint64_t w = (bitmap_load_word(data, byte_num, first_word) ^ flip) & head_mask;
+    if (first_word == last_word) w &= tail_mask;
+    if (w) return (int64_t)(first_word * 64 + __builtin_ctzll(w));
+    if (first_word == last_word) return merr;
+    
+    // 中间的完整字都在数据区之内
+    for (uint64_t i = first_word + 1; i < last_word; i++) {
+        memcpy(&w, data + i * 8, 8);
+        w ^= flip;
+        if (w) return (int64_t)(i * 64 + __builtin_ctzll(w));
     }
     
-    if (value) { // 查找 1
-        if (chunk != 0) {
-            for (int i = pos % 64; i < 64; ++i) {
-                if ((chunk >> i) & 1) {
-                    if (first_word_idx * 64 + i <= end) {
-                        return first_word_idx * 64 + i;
-                    }
-                }
-            }
-        }
-    } else { // 查找 0
-        uint64_t search_chunk = ~chunk & start_mask;
-        if (first_word_idx == end_word_idx) {
-            uint64_t end_mask = ~0ULL >> (63 - (end % 64));
-            search_chunk &= end_mask;
-        }
-        if (search_chunk != 0) {
-            for (int i = pos % 64; i < 64; ++i) {
-                if ((search_chunk >> i) & 1) {
-                    if (first_word_idx * 64 + i <= end) {
-                        return first_word_idx * 64 + i;
-                    }
-                }
+    // 尾字：最后一个字可能不满 8 字节
+    w = (bitmap_load_word(data, byte_num, last_word) ^ flip) & tail_mask;
+    if (w) return (int64_t)(last_word * 64 + __builtin_ctzll(w));
+    return merr;
+}
+
+/**
+ * 从 *cursor 开始按升序取出 [*cursor, end] 中为 1 的位置，最多 cap 个写入 out
+ * *cursor 更新为下一批的起点，取完时为 end + 1，可以反复调用直到返回 0
+ * @return 写入的个数, -1 参数错误
+ */
+int64_t bitmap_extract_set(const BHS* bm, uint64_t* cursor, uint64_t end, uint64_t* out, uint64_t cap) {
+    if (!check_if_bitmap(bm) || !cursor || (!out && cap)) return merr;
+    if (bm->length == 0 || *cursor > end) return 0;
+    if (end >= bm->length) end = bm->length - 1;
+    if (*cursor > end) return 0;
+    if (BITMAP_IS_ROARING(bm)) return (int64_t)roaring_extract(bm, cursor, end, out, cap);
+    
+    const uint8_t* data = get_bitmap_data(bm);
+    uint64_t byte_num = (bm->length + 7) / 8;
+    uint64_t last_word = end / 64;
+    uint64_t n = 0;
+    
+    for (uint64_t i = *cursor / 64; i <= last_word; i++) {
+        uint64_t w = bitmap_load_word(data, byte_num, i);
+        if (i == *cursor / 64) w &= ~0ULL << (*cursor % 64);
+        if (i == last_word) w &= ~0ULL >> (63 - end % 64);
+        
+        // 每次取出最低位的 1
+        while (w) {
+            uint64_t pos = i * 64 + __builtin_ctzll(w);
+            if (n == cap) {
+                *cursor = pos;
+                return (int64_t)n;
             }
+            out[n++] = pos;
+            w &= w - 1;
         }
     }
-    
-    if (first_word_idx == end_word_idx) {
-        return merr;
-    }
-    
-    // 2. 处理中间的全量64位块
-    for (uint64_t i = first_word_idx + 1; i < end_word_idx; ++i) {
-        chunk = p64[i];
-        if (value) { // 查找 1
-            if (chunk != 0) {
-                for (int j = 0; j < 64; ++j) {
-                    if ((chunk >> j) & 1) return i * 64 + j;
-                }
-            }
-        } else { // 查找 0
-            if (chunk != ~0ULL) {
-                for (int j = 0; j < 64; ++j) {
-                    if (!((chunk >> j) & 1)) return i * 64 + j;
-                }
-            }
+    *cursor = end + 1;
+    return (int64_t)n;
+}
+
+/**
+ * 按升序对 [start, end] 中每个为 1 的位调用 fn(pos, ctx)，fn 返回非 0 时停止
+ * 内部按 BITMAP_ITER_BATCH 个位置一批取出
+ * @return 0 遍历完成, 1 被 fn 中止, -1 参数错误
+ */
+int bitmap_foreach_set(const BHS* bm, uint64_t start, uint64_t end, bitmap_visit_fn fn, void* ctx) {
+    if (!check_if_bitmap(bm) || !fn) return merr;
+    
+    uint64_t batch[BITMAP_ITER_BATCH];
+    uint64_t cursor = start;
+    int64_t n;
+    while ((n = bitmap_extract_set(bm, &cursor, end, batch, BITMAP_ITER_BATCH)) > 0) {
+        for (int64_t i = 0; i < n; i++) {
+            if (fn(batch[i], ctx)) return 1;
         }
     }
+    return n < 0 ? merr : 0;
+}
+
+/**
+ * 统计 [0, offset) 中 1 的个数（offset 可以等于位数）
+ * 较大的平铺位图第一次调用时建立 rank/select 目录，之后为 O(1)
+ */
+uint64_t bitmap_rank(const BHS* bm, uint64_t offset) {
+    if (!check_if_bitmap(bm) || offset > bm->length) return merr;
+    if (offset == 0) return 0;
+    if (BITMAP_IS_ROARING(bm)) return roaring_count(bm, 0, offset - 1);
+    
+    const uint8_t* data = get_bitmap_data(bm);
+    rank_dir* dir = bitmap_rank_dir(bm, 1);
+    if (dir) return rank_dir_rank(dir, data, offset);
+    return bitmap_count_span(data, (bm->length + 7) / 8, 0, offset);
+}
+
+/**
+ * 第 k 个（从 0 开始）1 的位置，不存在时返回 -1
+ * 较大的平铺位图第一次调用时建立 rank/select 目录，之后为 O(log n)
+ */
+int64_t bitmap_select(const BHS* bm, uint64_t k) {
+    if (!check_if_bitmap(bm)) return merr;
     
-    // 3. 处理结尾的未对齐部分
-    chunk = p64[end_word_idx];
-    uint64_t end_mask = ~0ULL >> (63 - (end % 64));
-    
-    if (value) {
-        chunk &= end_mask;
-        if (chunk != 0) {
-            for (int i = 0; i <= (end % 64); ++i) {
-                if ((chunk >> i) & 1) return end_word_idx * 64 + i;
-            }
-        }
+    int64_t pos;
+    if (BITMAP_IS_ROARING(bm)) {
+        pos = roaring_select(bm, k);
     } else {
-        chunk = ~chunk & end_mask;
-        if (chunk != 0) {
-            for (int i = 0; i <= (end % 64); ++i) {
-                if ((chunk >> i) & 1) return end_word_idx * 64 + i;
+        const uint8_t* data = get_bitmap_data(bm);
+        uint64_t byte_num = (bm->length + 7) / 8;
+        rank_dir* dir = bitmap_rank_dir(bm, 1);
+        if (dir) {
+            pos = rank_dir_select(dir, data, k);
+        } else {
+            pos = merr;
+            for (uint64_t i = 0; i < (byte_num + 7) / 8; i++) {
+                uint64_t w = bitmap_load_word(data, byte_num, i);
+                uint64_t n = popcount64_swar(w);
+                if (k < n) {
+                    pos = (int64_t)(i * 64 + bitmap_word_select(w, (uint32_t)k));
+                    break;
+                }
+                k -= n;
             }
         }
     }
-    
-    return merr; // 如果没有找到，则返回merr
+    // 长度之外的残留位不算
+    return pos >= 0 && (uint64_t)pos < bm->length ? pos : merr;
 }
 
 // ============================================================================
@@ -664,6 +1346,7 @@ int64_t bitmap_find(const BHS* bm, uint8_t value, uint64_t start, uint64_t end)
  */
 int bitmap_iserr(BHS* bm) {
     if (!check_if_bitmap(bm)) return merr;
+    if (BITMAP_IS_ROARING(bm)) return roaring_check(bm);
     
     uint64_t byte_num = (bm->length + 7) / 8;
     
@@ -672,7 +1355,8 @@ int bitmap_iserr(BHS* bm) {
         if (!bm->data.large_data) return merr;
         if (bm->capacity < byte_num) {
             // 尝试修正容量
-            char* new_data = (char*)realloc(bm->data.large_data, byte_num);
+            if (bignum_make_unique(bm) != BIGNUM_SUCCESS) return merr;
+            char* new_data = bignum_payload_realloc(bm->data.large_data, byte_num);
             if (!new_data) return merr;
             bm->data.large_data = new_data;
             bm->capacity = byte_num;
@@ -697,7 +1381,8 @@ void bitmap_print(const BHS* bm) {
     
     uint8_t* data = get_bitmap_data(bm);
     for (uint64_t i = 0; i < bm->length; i++) {
-        printf("%d", (data[i / 8] >> (i % 8)) & 1);
+        if (BITMAP_IS_ROARING(bm)) printf("%d", roaring_get(bm, i));
+        else printf("%d", (data[i / 8] >> (i % 8)) & 1);
     }
     printf("\n");
 }
@@ -707,29 +1392,47 @@ void bitmap_print(const BHS* bm) {
 // ============================================================================
 
 /**
- * 按位与
+ * 二元运算的平铺实现：result_len 由调用者按运算决定
+ * 公共前缀走字级内核；或、异或的结果比短操作数长的部分直接取长操作数
  */
-BHS* bitmap_bitand(const BHS* a, const BHS* b) {
-    if (!check_if_bitmap(a) || !check_if_bitmap(b)) return NULL;
-    
-    /* 结果长度取较小值 */
-    uint64_t result_len = (a->length < b->length) ? a->length : b->length;
-    
-    BHS* result = bitmap_create_with_size(result_len);
+static BHS* bitmap_binary_dense(const BHS* a, const BHS* b, int op, uint64_t result_len) {
+    BHS* result = bitmap_create_dense(result_len);
     if (!result) return NULL;
     
     uint8_t* a_data = get_bitmap_data(a);
     uint8_t* b_data = get_bitmap_data(b);
     uint8_t* result_data = get_bitmap_data(result);
     
-    uint64_t byte_num = (result_len + 7) / 8;
-    for (uint64_t i = 0; i < byte_num; i++) {
-        result_data[i] = a_data[i] & b_data[i];
+    uint64_t a_bytes = (a->length + 7) / 8;
+    uint64_t b_bytes = (b->length + 7) / 8;
+    uint64_t common = a_bytes < b_bytes ? a_bytes : b_bytes;
+    uint64_t result_bytes = (result_len + 7) / 8;
+    if (common > result_bytes) common = result_bytes;
+    
+    bitwise_bytes(result_data, a_data, b_data, common, op);
+    if (result_bytes > common) {
+        const uint8_t* longer = a_bytes > b_bytes ? a_data : b_data;
+        memcpy(result_data + common, longer + common, result_bytes - common);
     }
     
     return result;
 }
 
+/**
+ * 按位与
+ */
+BHS* bitmap_bitand(const BHS* a, const BHS* b) {
+    if (!check_if_bitmap(a) || !check_if_bitmap(b)) return NULL;
+    
+    /* 结果长度取较小值 */
+    uint64_t result_len = (a->length < b->length) ? a->length : b->length;
+    if (BITMAP_IS_ROARING(a) || BITMAP_IS_ROARING(b)) {
+        return bitmap_settled(roaring_binary(a, b, ROARING_OP_AND, result_len));
+    }
+    
+    return bitmap_binary_dense(a, b, BITWISE_AND, result_len);
+}
+
 /**
  * 按位或
  */
@@ -738,25 +1441,11 @@ BHS* bitmap_bitor(const BHS* a, const BHS* b) {
     
     /* 结果长度取较大值 */
     uint64_t result_len = (a->length > b->length) ? a->length : b->length;
-    
-    BHS* result = bitmap_create_with_size(result_len);
-    if (!result) return NULL;
-    
-    uint8_t* a_data = get_bitmap_data(a);
-    uint8_t* b_data = get_bitmap_data(b);
-    uint8_t* result_data = get_bitmap_data(result);
-    
-    uint64_t a_bytes = (a->length + 7) / 8;
-    uint64_t b_bytes = (b->length + 7) / 8;
-    uint64_t result_bytes = (result_len + 7) / 8;
-    
-    for (uint64_t i = 0; i < result_bytes; i++) {
-        uint8_t a_byte = (i < a_bytes) ? a_data[i] : 0;
-        uint8_t b_byte = (i < b_bytes) ? b_data[i] : 0;
-        result_data[i] = a_byte | b_byte;
+    if (BITMAP_IS_ROARING(a) || BITMAP_IS_ROARING(b)) {
+        return bitmap_settled(roaring_binary(a, b, ROARING_OP_OR, result_len));
     }
     
-    return result;
+    return bitmap_binary_dense(a, b, BITWISE_OR, result_len);
 }
 
 /**
@@ -767,25 +1456,22 @@ BHS* bitmap_bitxor(const BHS* a, const BHS* b) {
     
     /* 结果长度取较大值 */
     uint64_t result_len = (a->length > b->length) ? a->length : b->length;
-    
-    BHS* result = bitmap_create_with_size(result_len);
-    if (!result) return NULL;
-    
-    uint8_t* a_data = get_bitmap_data(a);
-    uint8_t* b_data = get_bitmap_data(b);
-    uint8_t* result_data = get_bitmap_data(result);
-    
-    uint64_t a_bytes = (a->length + 7) / 8;
-    uint64_t b_bytes = (b->length + 7) / 8;
-    uint64_t result_bytes = (result_len + 7) / 8;
-    
-    for (uint64_t i = 0; i < result_bytes; i++) {
-        uint8_t a_byte = (i < a_bytes) ? a_data[i] : 0;
-        uint8_t b_byte = (i < b_bytes) ? b_data[i] : 0;
-        result_data[i] = a_byte ^ b_byte;
+    if (BITMAP_IS_ROARING(a) || BITMAP_IS_ROARING(b)) {
+        return bitmap_settled(roaring_binary(a, b, ROARING_OP_XOR, result_len));
     }
     
-    return result;
+    return bitmap_binary_dense(a, b, BITWISE_XOR, result_len);
+}
+
+/**
+ * 平铺数据原地取反，并清除超出 length 的位
+ */
+static void bitmap_not_dense(uint8_t* data, uint64_t bit_num) {
+    uint64_t byte_num = (bit_num + 7) / 8;
+    bitwise_bytes(data, data, NULL, byte_num, BITWISE_NOT);
+    if (bit_num % 8 != 0) {
+        data[byte_num - 1] &= (uint8_t)((1 << (bit_num % 8)) - 1);
+    }
 }
 
 /**
@@ -793,26 +1479,53 @@ BHS* bitmap_bitxor(const BHS* a, const BHS* b) {
  */
 BHS* bitmap_bitnot(const BHS* a) {
     if (!check_if_bitmap(a)) return NULL;
+    if (BITMAP_IS_ROARING(a)) return bitmap_settled(roaring_not(a));
     
     BHS* result = bitmap_create_copy(a);
     if (!result) return NULL;
     
-    uint8_t* result_data = get_bitmap_data(result);
-    uint64_t byte_num = (a->length + 7) / 8;
-    
-    for (uint64_t i = 0; i < byte_num; i++) {
-        result_data[i] = ~result_data[i];
-    }
-    
-    /* 清除超出length的位 */
-    if (a->length % 8 != 0) {
-        uint8_t mask = (1 << (a->length % 8)) - 1;
-        result_data[byte_num - 1] &= mask;
+    // 拷贝与 a 共享数据区，写之前先复制
+    uint8_t* result_data = get_bitmap_data_mut(result);
+    if (!result_data) {
+        free_bitmap(result);
+        return NULL;
     }
+    bitmap_not_dense(result_data, a->length);
     
     return result;
 }
 
+/**
+ * 平铺数据原地整体移向高位：位 i 移到 i + shift，低 shift 位清零
+ * 从高字向低字处理，每个输出字只读取不高于自身的两个源字，因此不会读到已改写的数据
+ * @param data 数据区，已扩到移位后的 byte_num 字节，新增部分为 0
+ * @param byte_num 移位后的字节数
+ */
+static void bitmap_dense_shift_up(uint8_t* data, uint64_t byte_num, uint64_t shift) {
+    uint64_t q = shift / 64;
+    uint32_t r = shift % 64;
+    uint64_t words = (byte_num + 7) / 8;
+    
+    for (uint64_t i = words; i-- > 0;) {
+        uint64_t w = 0;
+        if (i >= q) {
+            // 只有最高字可能不满 8 字节，其余按整字读写
+            uint64_t hi;
+            if (i - q + 1 == words) hi = bitmap_load_word(data, byte_num, i - q);
+            else memcpy(&hi, data + (i - q) * 8, 8);
+            w = hi << r;
+            if (r && i > q) {
+                uint64_t lo;
+                memcpy(&lo, data + (i - q - 1) * 8, 8);
+                w |= lo >> (64 - r);
+            }
+        }
+        
+        if (i + 1 == words) memcpy(data + i * 8, &w, byte_num - i * 8);
+        else memcpy(data + i * 8, &w, 8);
+    }
+}
+
 /**
  * 左移
  */
@@ -824,19 +1537,22 @@ BHS* bitmap_bitshl(const BHS* a, uint64_t shift) {
     if (shift > SIZE_MAX - 1 - a->length) return NULL;
     
     uint64_t result_len = a->length + shift;
-    BHS* result = bitmap_create_with_size(result_len);
+    
+    // 移位后很长但很稀疏时直接生成压缩编码，避免按位数分配
+    if (BITMAP_IS_ROARING(a) ||
+        ((result_len + 7) / 8 > BITMAP_ROARING_MIN_BYTES && a->length &&
+         bitmap_count(a, 0, a->length - 1) * BITMAP_SPARSE_RATIO < result_len)) {
+        return bitmap_settled(roaring_shift(a, shift, 1));
+    }
+    
+    BHS* result = bitmap_create_dense(result_len);
     if (!result) return NULL;
     
     uint8_t* a_data = get_bitmap_data(a);
     uint8_t* result_data = get_bitmap_data(result);
     
-    /* 复制并左移 */
-    for (uint64_t i = 0; i < a->length; i++) {
-        if ((a_data[i / 8] >> (i % 8)) & 1) {
-            uint64_t new_pos = i + shift;
-            result_data[new_pos / 8] |= (1 << (new_pos % 8));
-        }
-    }
+    /* 整体拷贝到第 shift 位之后，低位保持为 0 */
+    bitcpy(result_data + shift / 8, shift % 8, a_data, 0, a->length);
     
     return result;
 }
@@ -850,19 +1566,315 @@ BHS* bitmap_bitshr(const BHS* a, uint64_t shift) {
     if (shift == 0) return bitmap_create_copy(a);
     
     uint64_t result_len = a->length - shift;
-    BHS* result = bitmap_create_with_size(result_len);
+    if (BITMAP_IS_ROARING(a)) return bitmap_settled(roaring_shift(a, shift, 0));
+    
+    BHS* result = bitmap_create_dense(result_len);
     if (!result) return NULL;
     
     uint8_t* a_data = get_bitmap_data(a);
     uint8_t* result_data = get_bitmap_data(result);
     
-    /* 复制并右移 */
-    for (uint64_t i = shift; i < a->length; i++) {
-        if ((a_data[i / 8] >> (i % 8)) & 1) {
-            uint64_t new_pos = i - shift;
-            result_data[new_pos / 8] |= (1 << (new_pos % 8));
+    /* 从第 shift 位开始整体拷贝 */
+    bitcpy(result_data, 0, a_data + shift / 8, shift % 8, result_len);
+    
+    return result;
+}
+
+// ============================================================================
+// 原地位运算（dst op= src）
+// ============================================================================
+
+/**
+ * 用运算结果替换 dst 的内容，结果的 BHS 外壳随之释放
+ * @return 0 成功, -1 失败（result 为 NULL 时 dst 保持不变）
+ */
+static int bitmap_take(BHS* dst, BHS* result) {
+    if (!result) return merr;
+    if (dst->is_large && dst->data.large_data) {
+        bignum_payload_release(dst->data.large_data);
+    }
+    memcpy(dst, result, sizeof(BHS));
+    free(result);
+    return 0;
+}
+
+/**
+ * 平铺的原地二元运算
+ * 与：长度取较小值，只需处理较短的一段再截断；
+ * 或、异或：长度取较大值，先把 dst 扩到结果长度，再与 src 的全部字节运算
+ */
+static int bitmap_inplace_dense(BHS* dst, const BHS* src, int op) {
+    uint64_t result_len = op == BITWISE_AND ?
+        (dst->length < src->length ? dst->length : src->length) :
+        (dst->length > src->length ? dst->length : src->length);
+    
+    if (result_len > dst->length && bitmap_rexpand(dst, result_len) != 0) return merr;
+    
+    // 先取 dst 的可写指针：dst 与 src 共享数据区时 dst 会复制一份，src 不受影响
+    uint8_t* dst_data = get_bitmap_data_mut(dst);
+    if (!dst_data) return merr;
+    const uint8_t* src_data = get_bitmap_data(src);
+    
+    uint64_t src_bytes = (src->length + 7) / 8;
+    uint64_t dst_bytes = (result_len + 7) / 8;
+    bitwise_bytes(dst_data, dst_data, src_data, src_bytes < dst_bytes ? src_bytes : dst_bytes, op);
+    
+    if (result_len < dst->length) return bitmap_rexpand(dst, result_len);
+    return 0;
+}
+
+/**
+ * 原地按位与：dst &= src，dst 长度变为两者较小值
+ * 结果与 bitmap_bitand(dst, src) 相同，平铺编码下不分配新位图
+ * @return 0 成功, -1 失败
+ */
+int bitmap_and_inplace(BHS* dst, const BHS* src) {
+    if (!check_if_bitmap(dst) || !check_if_bitmap(src)) return merr;
+    if (dst == src) return 0;
+    if (BITMAP_IS_ROARING(dst) || BITMAP_IS_ROARING(src)) {
+        return bitmap_take(dst, bitmap_bitand(dst, src));
+    }
+    return bitmap_inplace_dense(dst, src, BITWISE_AND);
+}
+
+/**
+ * 原地按位或：dst |= src，dst 长度变为两者较大值
+ * @return 0 成功, -1 失败
+ */
+int bitmap_or_inplace(BHS* dst, const BHS* src) {
+    if (!check_if_bitmap(dst) || !check_if_bitmap(src)) return merr;
+    if (dst == src) return 0;
+    if (BITMAP_IS_ROARING(dst) || BITMAP_IS_ROARING(src)) {
+        return bitmap_take(dst, bitmap_bitor(dst, src));
+    }
+    return bitmap_inplace_dense(dst, src, BITWISE_OR);
+}
+
+/**
+ * 原地按位异或：dst ^= src，dst 长度变为两者较大值
+ * @return 0 成功, -1 失败
+ */
+int bitmap_xor_inplace(BHS* dst, const BHS* src) {
+    if (!check_if_bitmap(dst) || !check_if_bitmap(src)) return merr;
+    if (BITMAP_IS_ROARING(dst) || BITMAP_IS_ROARING(src)) {
+        return bitmap_take(dst, bitmap_bitxor(dst, src));
+    }
+    return bitmap_inplace_dense(dst, src, BITWISE_XOR);
+}
+
+/**
+ * 原地按位非：dst = ~dst，长度不变
+ * @return 0 成功, -1 失败
+ */
+int bitmap_not_inplace(BHS* dst) {
+    if (!check_if_bitmap(dst)) return merr;
+    if (BITMAP_IS_ROARING(dst)) return bitmap_take(dst, bitmap_bitnot(dst));
+    
+    uint8_t* data = get_bitmap_data_mut(dst);
+    if (!data) return merr;
+    bitmap_not_dense(data, dst->length);
+    return 0;
+}
+
+/**
+ * 原地左移：dst <<= shift，长度增加 shift，结果与 bitmap_bitshl 相同
+ * 平铺编码下在原数据区上扩展后按字移动，不分配新位图
+ * @return 0 成功, -1 失败
+ */
+int bitmap_shl_inplace(BHS* dst, uint64_t shift) {
+    if (!check_if_bitmap(dst)) return merr;
+    if (shift == 0) return 0;
+    if (shift > SIZE_MAX - 1 - dst->length) return merr;
+    
+    uint64_t old_len = dst->length;
+    uint64_t new_len = old_len + shift;
+    
+    // 与 bitmap_bitshl 相同：结果很长但很稀疏时转为压缩编码
+    if (BITMAP_IS_ROARING(dst) ||
+        ((new_len + 7) / 8 > BITMAP_ROARING_MIN_BYTES && old_len &&
+         bitmap_count(dst, 0, old_len - 1) * BITMAP_SPARSE_RATIO < new_len)) {
+        return bitmap_take(dst, bitmap_settled(roaring_shift(dst, shift, 1)));
+    }
+    
+    // 末字节中超出长度的位移入有效范围前先清掉
+    uint8_t* data = get_bitmap_data_mut(dst);
+    if (!data) return merr;
+    if (old_len % 8) data[old_len / 8] &= (uint8_t)((1u << (old_len % 8)) - 1);
+    
+    if (bitmap_rexpand(dst, new_len) != 0) return merr;
+    data = get_bitmap_data_mut(dst);
+    if (!data) return merr;
+    bitmap_dense_shift_up(data, (new_len + 7) / 8, shift);
+    return 0;
+}
+
+/**
+ * 原地右移：dst >>= shift，长度减少 shift；shift 不小于长度时与 bitmap_bitshr 一样变为 "0"
+ * @return 0 成功, -1 失败
+ */
+int bitmap_shr_inplace(BHS* dst, uint64_t shift) {
+    if (!check_if_bitmap(dst)) return merr;
+    if (shift >= dst->length) return bitmap_take(dst, bitmap_create_from_string("0"));
+    if (shift == 0) return 0;
+    if (BITMAP_IS_ROARING(dst)) {
+        return bitmap_take(dst, bitmap_settled(roaring_shift(dst, shift, 0)));
+    }
+    
+    uint64_t new_len = dst->length - shift;
+    uint8_t* data = get_bitmap_data_mut(dst);
+    if (!data) return merr;
+    
+    // 目标在源之前，bitcpy 由低到高拷贝可以原地进行
+    bitcpy(data, 0, data + shift / 8, shift % 8, new_len);
+    if (new_len % 8) data[new_len / 8] &= (uint8_t)((1u << (new_len % 8)) - 1);
+    return bitmap_rexpand(dst, new_len);
+}
+
+// ============================================================================
+// 多路聚合
+// ============================================================================
+
+/**
+ * 检查参数并换算成“至少 k 个为 1”的形式
+ * 与：k = n，结果长度取最小值；或、阈值：结果长度取最大值
+ * @return 0 成功, -1 失败
+ */
+static int bitmap_aggregate_prepare(const BHS* const* bms, size_t n, int op, size_t k,
+                                    size_t* need, uint64_t* result_len, int* all_dense) {
+    if (!bms || n == 0) return merr;
+    
+    *all_dense = 1;
+    *result_len = bms[0] ? bms[0]->length : 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!check_if_bitmap(bms[i])) return merr;
+        if (BITMAP_IS_ROARING(bms[i])) *all_dense = 0;
+        if (op == BITMAP_AGG_AND ? bms[i]->length < *result_len : bms[i]->length > *result_len) {
+            *result_len = bms[i]->length;
         }
     }
     
-    return result;
+    if (op == BITMAP_AGG_AND) *need = n;
+    else if (op == BITMAP_AGG_OR) *need = 1;
+    else if (op == BITMAP_AGG_THRESHOLD && k >= 1 && k <= n) *need = k;
+    else return merr;
+    return 0;
+}
+
+/* 全 0 检查 */
+static int bitmap_bytes_zero(const uint8_t* p, uint64_t n) {
+    uint64_t any = 0;
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        any |= w;
+    }
+    for (; i < n; i++) {
+        any |= p[i];
+    }
+    return any == 0;
+}
+
+/**
+ * 全部为平铺编码时的与、或：按 BITMAP_AGG_BLOCK 字节分块，
+ * 每块先放入第一个输入，再依次与其余输入按字运算，块留在缓存中直到处理完所有输入。
+ * out 非 NULL 时直接在结果数据区上运算，否则使用一块临时缓冲；card 非 NULL 时统计 1 的个数
+ * @return 0 成功, -1 失败
+ */
+static int bitmap_aggregate_dense(const BHS* const* bms, size_t n, int op, uint64_t result_len,
+                                  uint8_t* out, uint64_t* card) {
+    uint64_t result_bytes = (result_len + 7) / 8;
+    uint8_t* scratch = NULL;
+    if (!out) {
+        scratch = (uint8_t*)malloc(BITMAP_AGG_BLOCK);
+        if (!scratch) return merr;
+    }
+    
+    uint64_t total = 0;
+    for (uint64_t off = 0; off < result_bytes; off += BITMAP_AGG_BLOCK) {
+        uint64_t len = result_bytes - off < BITMAP_AGG_BLOCK ? result_bytes - off : BITMAP_AGG_BLOCK;
+        uint8_t* acc = out ? out + off : scratch;
+        
+        // 较短的输入只覆盖本块的一部分或完全不覆盖，未覆盖部分按 0 处理
+        if (op == BITMAP_AGG_AND) {
+            uint64_t covered = len;
+            for (size_t i = 0; i < n && covered; i++) {
+                uint64_t bytes = (bms[i]->length + 7) / 8;
+                uint64_t part = bytes <= off ? 0 : (bytes - off < covered ? bytes - off : covered);
+                if (i == 0) memcpy(acc, get_bitmap_data(bms[i]) + off, part);
+                else bitwise_bytes(acc, acc, get_bitmap_data(bms[i]) + off, part, BITWISE_AND);
+                covered = part;
+                if ((i & 7) == 7 && bitmap_bytes_zero(acc, covered)) covered = 0;
+            }
+            memset(acc + covered, 0, len - covered);
+        } else {
+            memset(acc, 0, len);
+            for (size_t i = 0; i < n; i++) {
+                uint64_t bytes = (bms[i]->length + 7) / 8;
+                if (bytes <= off) continue;
+                uint64_t part = bytes - off < len ? bytes - off : len;
+                bitwise_bytes(acc, acc, get_bitmap_data(bms[i]) + off, part, BITWISE_OR);
+            }
+        }
+        
+        if (card) {
+            uint64_t words = len / 8;
+            total += popcount_words(acc, words);
+            for (uint64_t j = words * 8; j < len; j++) {
+                total += (uint64_t)__builtin_popcount(acc[j]);
+            }
+        }
+    }
+    
+    free(scratch);
+    if (card) *card = total;
+    return 0;
+}
+
+/**
+ * 多路聚合：一趟逐块合并 n 个位图，不产生中间结果
+ * @param op BITMAP_AGG_AND / BITMAP_AGG_OR / BITMAP_AGG_THRESHOLD
+ * @param k 阈值模式下至少需要多少个输入为 1（1 ~ n），其他模式忽略
+ * @return 新位图，失败返回 NULL。输入全为平铺编码时结果也是平铺，否则按密度选择
+ */
+BHS* bitmap_aggregate(const BHS* const* bms, size_t n, int op, size_t k) {
+    size_t need;
+    uint64_t result_len;
+    int all_dense;
+    if (bitmap_aggregate_prepare(bms, n, op, k, &need, &result_len, &all_dense) != 0) return NULL;
+    
+    if (all_dense) {
+        BHS* result = bitmap_create_dense(result_len);
+        if (!result) return NULL;
+        int ret = op == BITMAP_AGG_THRESHOLD && need != 1 && need != n ?
+            roaring_aggregate(bms, n, need, result_len, get_bitmap_data(result), NULL, NULL) :
+            bitmap_aggregate_dense(bms, n, need == n ? BITMAP_AGG_AND : BITMAP_AGG_OR, result_len,
+                                   get_bitmap_data(result), NULL);
+        if (ret != 0) {
+            free_bitmap(result);
+            return NULL;
+        }
+        return result;
+    }
+    
+    BHS* result = NULL;
+    if (roaring_aggregate(bms, n, need, result_len, NULL, &result, NULL) != 0) return NULL;
+    return bitmap_settled(result);
+}
+
+/**
+ * 多路聚合只求结果中 1 的个数，不生成结果位图
+ * @param count 输出个数
+ * @return 0 成功, -1 失败
+ */
+int bitmap_aggregate_count(const BHS* const* bms, size_t n, int op, size_t k, uint64_t* count) {
+    size_t need;
+    uint64_t result_len;
+    int all_dense;
+    if (!count) return merr;
+    if (bitmap_aggregate_prepare(bms, n, op, k, &need, &result_len, &all_dense) != 0) return merr;
+    if (all_dense && (need == 1 || need == n)) {
+        return bitmap_aggregate_dense(bms, n, need == n ? BITMAP_AGG_AND : BITMAP_AGG_OR, result_len, NULL, count);
+    }
+    return roaring_aggregate(bms, n, need, result_len, NULL, NULL, count);
 }
@@ -16,6 +16,7 @@ Email:hj18914255909@outlook.com
 #include "bitcpy.h"
 
 #include "bignum.h"  /* 提供 BHS 类型定义 */ 
+#include "roaring.h"
 
 
 #define bitmap_debug
@@ -34,7 +35,22 @@ BHS 结构用于表示 BITMAP 类型：
 - 使用 BHS.capacity 表示分配的字节数
 - 小于等于 BIGNUM_SMALL_SIZE (32) 字节时使用 small_data
 - 大于 BIGNUM_SMALL_SIZE 时使用 large_data
+
+编码方式（type_data.bm.encoding）：
+- BITMAP_ENC_DENSE：上述平铺存储
+- BITMAP_ENC_ROARING：按 2^16 位分块的压缩容器，见 roaring.h
+平铺数据超过 BITMAP_ROARING_MIN_BYTES 且 1 的比例低于 1/BITMAP_SPARSE_RATIO 时
+自动转为压缩编码；压缩后反而更大时转回平铺。对外接口与编码无关。
+*/
+#define BITMAP_ROARING_MIN_BYTES (64 * 1024)
+#define BITMAP_SPARSE_RATIO      32
+
+/*
+平铺数据达到 BITMAP_RANK_MIN_BYTES 后，第一次 rank/select（或覆盖一半以上的 count）
+会建立 rank/select 目录：每 512 位一个块内计数、每 2^16 位一个累计计数，约占数据的 0.4%。
+目录挂在共享数据区上，set/set_range 时增量更新，其他写操作后丢弃，下次查询时重建。
 */
+#define BITMAP_RANK_MIN_BYTES    (64 * 1024)
 
 // 类型检查函数
 int check_if_bitmap(const BHS* bm);
@@ -62,6 +78,14 @@ int bitmap_set_from_stream(BHS* bm, uint64_t offset, uint64_t len, const char* d
 uint64_t bitmap_size(const BHS* bm);
 uint64_t bitmap_count(const BHS* bm, uint64_t st_offset, uint64_t ed_offset);
 int64_t bitmap_find(const BHS* bm, uint8_t value, uint64_t start, uint64_t end);
+uint64_t bitmap_rank(const BHS* bm, uint64_t offset);   // [0, offset) 中 1 的个数
+int64_t bitmap_select(const BHS* bm, uint64_t k);       // 第 k 个（从 0 开始）1 的位置，不存在时返回 -1
+
+// 遍历为 1 的位（升序）
+#define BITMAP_ITER_BATCH 256   /* bitmap_foreach_set 每批取出的位置数 */
+typedef int (*bitmap_visit_fn)(uint64_t pos, void* ctx);   /* 返回非 0 时停止遍历 */
+int64_t bitmap_extract_set(const BHS* bm, uint64_t* cursor, uint64_t end, uint64_t* out, uint64_t cap);
+int bitmap_foreach_set(const BHS* bm, uint64_t start, uint64_t end, bitmap_visit_fn fn, void* ctx);
 
 // 状态和调试
 int bitmap_iserr(BHS* bm);
@@ -75,5 +99,26 @@ BHS* bitmap_bitnot(const BHS* a);
 BHS* bitmap_bitshl(const BHS* a, uint64_t shift);
 BHS* bitmap_bitshr(const BHS* a, uint64_t shift);
 
+// 原地位运算（dst op= src，平铺编码下不分配新位图；长度规则同上）
+int bitmap_and_inplace(BHS* dst, const BHS* src);
+int bitmap_or_inplace(BHS* dst, const BHS* src);
+int bitmap_xor_inplace(BHS* dst, const BHS* src);
+int bitmap_not_inplace(BHS* dst);
+int bitmap_shl_inplace(BHS* dst, uint64_t shift);
+int bitmap_shr_inplace(BHS* dst, uint64_t shift);
+
+// 字级内核（按 CPU 特性选择实现，供 roaring.c 等内部模块使用）
+void bitmap_words_op(uint8_t* dst, const uint8_t* a, const uint8_t* b, uint64_t byte_num, int op);
+uint64_t bitmap_words_popcount(const uint8_t* p, uint64_t n);
+uint32_t bitmap_word_select(uint64_t w, uint32_t r);
+
+// 多路聚合（一趟逐块合并，不产生中间结果）
+#define BITMAP_AGG_AND       0   /* 全部为 1，长度取最小值 */
+#define BITMAP_AGG_OR        1   /* 任一为 1，长度取最大值 */
+#define BITMAP_AGG_THRESHOLD 2   /* 至少 k 个为 1，长度取最大值 */
+#define BITMAP_AGG_BLOCK     (64 * 1024)  /* 平铺输入逐块合并时的块大小（字节），使累加块常驻 L2 */
+BHS* bitmap_aggregate(const BHS* const* bms, size_t n, int op, size_t k);
+int bitmap_aggregate_count(const BHS* const* bms, size_t n, int op, size_t k, uint64_t* count);
+
 #endif
 
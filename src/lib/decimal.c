@@ -0,0 +1,367 @@
+#include "decimal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//10^0 ~ 10^19（10^19 超出 int64_t，但在 uint64_t 范围内）
+static const uint64_t pow10_u64[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+//内部统一用最宽的整数计算
+#if defined(__SIZEOF_INT128__)
+typedef dec128_t dec_int_t;
+typedef unsigned __int128 dec_uint_t;
+#define DEC_INT_MAX ((dec_int_t)(~(dec_uint_t)0 >> 1))
+#else
+typedef int64_t dec_int_t;
+typedef uint64_t dec_uint_t;
+#define DEC_INT_MAX INT64_MAX
+#endif
+#define DEC_INT_MIN (-DEC_INT_MAX - 1)
+
+//10^p，p <= 38
+static dec_uint_t dec_pow10(int p){
+    if(p <= 19) return pow10_u64[p];
+    return (dec_uint_t)pow10_u64[p / 2] * pow10_u64[p - p / 2];
+}
+
+static dec_int_t dec_null_value(int precision){
+    return precision <= DECIMAL_INT64_PRECISION ? (dec_int_t)DECIMAL_NULL64 : DEC_INT_MIN;
+}
+
+//读写格子（数据区只保证按 malloc 对齐，用 memcpy 避免未对齐访问）
+static dec_int_t dec_load(const void* cell, int precision){
+    if(precision <= DECIMAL_INT64_PRECISION){
+        int64_t v;
+        memcpy(&v, cell, sizeof(v));
+        return v;
+    }
+    dec_int_t v;
+    memcpy(&v, cell, sizeof(v));
+    return v;
+}
+
+static void dec_store(void* cell, int precision, dec_int_t value){
+    if(precision <= DECIMAL_INT64_PRECISION){
+        int64_t v = (int64_t)value;
+        memcpy(cell, &v, sizeof(v));
+        return;
+    }
+    memcpy(cell, &value, sizeof(value));
+}
+
+//|value| < 10^p
+static int dec_in_range(dec_int_t value, int precision){
+    dec_uint_t mag = value < 0 ? (dec_uint_t)0 - (dec_uint_t)value : (dec_uint_t)value;
+    return mag < dec_pow10(precision);
+}
+
+size_t decimal_width(int precision){
+    if(precision < 1 || precision > DECIMAL_MAX_PRECISION) return 0;
+    return precision <= DECIMAL_INT64_PRECISION ? sizeof(int64_t) : sizeof(dec_int_t);
+}
+
+int decimal_check_spec(int precision, int scale){
+    if(precision < 1 || precision > DECIMAL_MAX_PRECISION) return -1;
+    if(scale < 0 || scale > precision) return -1;
+    return 0;
+}
+
+int decimal_parse_spec(const char* type_name, int* precision, int* scale){
+    if(type_name == NULL || precision == NULL || scale == NULL) return -1;
+    
+    static const char prefix[] = "decimal";
+    size_t i = 0;
+    for(; i < sizeof(prefix) - 1; i++){
+        char c = type_name[i];
+        if(c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if(c != prefix[i]) return -1;
+    }
+    if(type_name[i++] != '(') return -1;
+    
+    int p = 0, s = 0, digits = 0;
+    while(type_name[i] >= '0' && type_name[i] <= '9' && digits < 3){
+        p = p * 10 + (type_name[i++] - '0');
+        digits++;
+    }
+    if(digits == 0) return -1;
+    if(type_name[i] == ','){
+        i++;
+        digits = 0;
+        while(type_name[i] >= '0' && type_name[i] <= '9' && digits < 3){
+            s = s * 10 + (type_name[i++] - '0');
+            digits++;
+        }
+        if(digits == 0) return -1;
+    }
+    if(type_name[i] != ')' || type_name[i + 1] != '\0') return -1;
+    if(decimal_check_spec(p, s) != 0) return -1;
+    
+    *precision = p;
+    *scale = s;
+    return 0;
+}
+
+int decimal_is_null(const void* cell, int precision){
+    return dec_load(cell, precision) == dec_null_value(precision);
+}
+
+void decimal_set_null(void* cell, int precision){
+    dec_store(cell, precision, dec_null_value(precision));
+}
+
+int decimal_from_bhs(const BHS* num, int precision, int scale, void* cell){
+    if(cell == NULL || decimal_check_spec(precision, scale) != 0) return -1;
+    if(num == NULL){
+        decimal_set_null(cell, precision);
+        return 0;
+    }
+    if(!bignum_is_number(num)) return -1;
+    
+    //按 scale 位截断格式化；整数部分超过 p 位时缓冲区不够，同样视为超出精度
+    char buf[DECIMAL_MAX_PRECISION * 2 + 8];
+    if(bignum_to_string(num, buf, sizeof(buf), scale) != BIGNUM_SUCCESS) return -1;
+    
+    const char* c = buf;
+    int negative = 0;
+    if(*c == '-'){
+        negative = 1;
+        c++;
+    }
+    
+    dec_uint_t mag = 0;
+    int significant = 0;//有效数字位数（不含整数部分前导零）
+    int frac = -1;//已读的小数位数，-1 表示还没遇到小数点
+    for(; *c != '\0'; c++){
+        if(*c == '.'){
+            frac = 0;
+            continue;
+        }
+        if(*c < '0' || *c > '9') return -1;
+        if(mag != 0 || *c != '0') significant++;
+        if(significant > precision) return -1;
+        mag = mag * 10 + (dec_uint_t)(*c - '0');
+        if(frac >= 0) frac++;
+    }
+    //补齐到 scale 位小数
+    for(int k = frac < 0 ? 0 : frac; k < scale; k++){
+        if(mag != 0) significant++;
+        if(significant > precision) return -1;
+        mag *= 10;
+    }
+    
+    dec_int_t value = (dec_int_t)mag;
+    dec_store(cell, precision, negative ? -value : value);
+    return 0;
+}
+
+//整数 value * 10^-scale 转为新分配的 BHS
+static BHS* dec_int_to_bhs(dec_int_t value, int scale){
+    char buf[64];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    *--p = '\0';
+    
+    dec_uint_t mag = value < 0 ? (dec_uint_t)0 - (dec_uint_t)value : (dec_uint_t)value;
+    int digits = 0;
+    do{
+        if(digits == scale && scale > 0) *--p = '.';
+        *--p = (char)('0' + (int)(mag % 10));
+        mag /= 10;
+        digits++;
+    }while(mag != 0 || digits <= scale);
+    if(value < 0) *--p = '-';
+    
+    return bignum_from_string(p);
+}
+
+BHS* decimal_to_bhs(const void* cell, int precision, int scale){
+    if(cell == NULL || decimal_check_spec(precision, scale) != 0) return NULL;
+    dec_int_t value = dec_load(cell, precision);
+    if(value == dec_null_value(precision)) return NULL;
+    return dec_int_to_bhs(value, scale);
+}
+
+int decimal_add(const void* a, const void* b, void* out, int precision){
+    if(a == NULL || b == NULL || out == NULL || decimal_width(precision) == 0) return -1;
+    dec_int_t x = dec_load(a, precision), y = dec_load(b, precision);
+    dec_int_t null_value = dec_null_value(precision);
+    if(x == null_value || y == null_value){
+        dec_store(out, precision, null_value);
+        return 0;
+    }
+    
+    dec_int_t r;
+    if(__builtin_add_overflow(x, y, &r) || !dec_in_range(r, precision)) return -1;
+    dec_store(out, precision, r);
+    return 0;
+}
+
+int decimal_sub(const void* a, const void* b, void* out, int precision){
+    if(a == NULL || b == NULL || out == NULL || decimal_width(precision) == 0) return -1;
+    dec_int_t x = dec_load(a, precision), y = dec_load(b, precision);
+    dec_int_t null_value = dec_null_value(precision);
+    if(x == null_value || y == null_value){
+        dec_store(out, precision, null_value);
+        return 0;
+    }
+    
+    dec_int_t r;
+    if(__builtin_sub_overflow(x, y, &r) || !dec_in_range(r, precision)) return -1;
+    dec_store(out, precision, r);
+    return 0;
+}
+
+#if defined(__SIZEOF_INT128__)
+//|x| * |y| / 10^scale（向零截断），x、y < 10^38，乘积最多 256 位
+static int dec_mul_wide(dec_uint_t x, dec_uint_t y, int scale, dec_uint_t* out){
+    uint64_t a[2] = { (uint64_t)x, (uint64_t)(x >> 64) };
+    uint64_t b[2] = { (uint64_t)y, (uint64_t)(y >> 64) };
+    uint64_t w[4] = { 0, 0, 0, 0 };
+    
+    for(int i = 0; i < 2; i++){
+        uint64_t carry = 0;
+        for(int j = 0; j < 2; j++){
+            dec_uint_t cur = (dec_uint_t)a[i] * b[j] + w[i + j] + carry;
+            w[i + j] = (uint64_t)cur;
+            carry = (uint64_t)(cur >> 64);
+        }
+        w[i + 2] = carry;
+    }
+    
+    //每次最多除以 10^19
+    while(scale > 0){
+        int step = scale > 19 ? 19 : scale;
+        uint64_t d = pow10_u64[step];
+        dec_uint_t rem = 0;
+        for(int i = 3; i >= 0; i--){
+            dec_uint_t cur = (rem << 64) | w[i];
+            w[i] = (uint64_t)(cur / d);
+            rem = cur % d;
+        }
+        scale -= step;
+    }
+    
+    if(w[3] != 0 || w[2] != 0) return -1;
+    *out = ((dec_uint_t)w[1] << 64) | w[0];
+    return 0;
+}
+#endif
+
+int decimal_mul(const void* a, const void* b, void* out, int precision, int scale){
+    if(a == NULL || b == NULL || out == NULL || decimal_check_spec(precision, scale) != 0) return -1;
+    dec_int_t x = dec_load(a, precision), y = dec_load(b, precision);
+    dec_int_t null_value = dec_null_value(precision);
+    if(x == null_value || y == null_value){
+        dec_store(out, precision, null_value);
+        return 0;
+    }
+
+#if defined(__SIZEOF_INT128__)
+    int negative = (x < 0) != (y < 0);
+    dec_uint_t mx = x < 0 ? (dec_uint_t)0 - (dec_uint_t)x : (dec_uint_t)x;
+    dec_uint_t my = y < 0 ? (dec_uint_t)0 - (dec_uint_t)y : (dec_uint_t)y;
+    dec_uint_t mag;
+    if(precision <= DECIMAL_INT64_PRECISION){
+        //两个 int64 的乘积小于 10^36，int128 放得下
+        mag = mx * my / pow10_u64[scale];
+    }else if(dec_mul_wide(mx, my, scale, &mag) != 0){
+        return -1;
+    }
+    if(mag >= dec_pow10(precision)) return -1;
+    dec_int_t r = (dec_int_t)mag;
+    dec_store(out, precision, negative ? -r : r);
+    return 0;
+#else
+    //没有 int128 时借助 BHS 计算精确乘积
+    BHS* bx = dec_int_to_bhs(x, scale);
+    BHS* by = dec_int_to_bhs(y, scale);
+    BHS* prod = (bx != NULL && by != NULL) ? bignum_mul(bx, by) : NULL;
+    int ret = -1;
+    if(prod != NULL){
+        int64_t r;
+        if(decimal_from_bhs(prod, precision, scale, &r) == 0){
+            dec_store(out, precision, r);
+            ret = 0;
+        }
+    }
+    if(bx != NULL) bignum_destroy(bx);
+    if(by != NULL) bignum_destroy(by);
+    if(prod != NULL) bignum_destroy(prod);
+    return ret;
+#endif
+}
+
+int decimal_cmp(const void* a, const void* b, int precision){
+    dec_int_t x = dec_load(a, precision), y = dec_load(b, precision);
+    return (x > y) - (x < y);//空值是最小的整数，自然排在最前
+}
+
+//把部分和并入 BHS 累加器
+static int dec_flush(BHS** total, dec_int_t acc, int scale){
+    BHS* part = dec_int_to_bhs(acc, scale);
+    if(part == NULL) return -1;
+    if(*total == NULL){
+        *total = part;
+        return 0;
+    }
+    BHS* sum = bignum_add(*total, part);
+    bignum_destroy(part);
+    if(sum == NULL) return -1;
+    bignum_destroy(*total);
+    *total = sum;
+    return 0;
+}
+
+BHS* decimal_sum(const void* cells, size_t count, int precision, int scale){
+    if(decimal_check_spec(precision, scale) != 0 || (cells == NULL && count > 0)) return NULL;
+    
+    BHS* total = NULL;
+    dec_int_t acc = 0;
+    
+    if(precision <= DECIMAL_INT64_PRECISION){
+        const int64_t* v = (const int64_t*)cells;
+#if defined(__SIZEOF_INT128__)
+        //|v| < 10^18，int128 累加 10^20 行也不会溢出
+        for(size_t i = 0; i < count; i++){
+            if(v[i] != DECIMAL_NULL64) acc += v[i];
+        }
+#else
+        for(size_t i = 0; i < count; i++){
+            if(v[i] == DECIMAL_NULL64) continue;
+            int64_t next;
+            if(__builtin_add_overflow(acc, v[i], &next)){
+                //acc + v 溢出：先把 acc 并入 BHS，再从 v 重新开始
+                if(dec_flush(&total, acc, scale) != 0) goto fail;
+                next = v[i];
+            }
+            acc = next;
+        }
+#endif
+    }else{
+        const char* c = (const char*)cells;
+        dec_int_t null_value = dec_null_value(precision);
+        for(size_t i = 0; i < count; i++, c += sizeof(dec_int_t)){
+            dec_int_t v = dec_load(c, precision);
+            if(v == null_value) continue;
+            dec_int_t next;
+            if(__builtin_add_overflow(acc, v, &next)){
+                if(dec_flush(&total, acc, scale) != 0) goto fail;
+                next = v;
+            }
+            acc = next;
+        }
+    }
+    
+    if(dec_flush(&total, acc, scale) != 0) goto fail;
+    return total;
+
+fail:
+    if(total != NULL) bignum_destroy(total);
+    return NULL;
+}
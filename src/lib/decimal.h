@@ -0,0 +1,59 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bignum.h"  /* 提供 BHS 类型定义 */
+
+/*
+DECIMAL(p,s)：定长定点小数
+数值 = value * 10^-s，value 为有符号整数，|value| < 10^p
+- p <= 18 时每格 8 字节（int64_t）
+- p <= 38 时每格 16 字节（__int128）
+格子连续存放在表的数据区里，加减乘比较都直接在整数上完成，
+只有进出 API 时才与 BHS 互相转换
+*/
+
+#if defined(__SIZEOF_INT128__)
+typedef __int128 dec128_t;
+#define DECIMAL_MAX_PRECISION 38
+#else
+#define DECIMAL_MAX_PRECISION 18
+#endif
+
+#define DECIMAL_INT64_PRECISION 18//int64_t 能容纳的最大精度
+
+//空值标记：取各宽度下的最小值，不在合法取值范围内
+#define DECIMAL_NULL64 INT64_MIN
+
+//单格占用的字节数，精度非法返回0
+size_t decimal_width(int precision);
+//检查 DECIMAL(p,s) 是否合法：1<=p<=DECIMAL_MAX_PRECISION，0<=s<=p
+int decimal_check_spec(int precision, int scale);
+//解析类型名 "decimal(p,s)" 或 "decimal(p)"，成功返回0
+int decimal_parse_spec(const char* type_name, int* precision, int* scale);
+
+//空值
+int decimal_is_null(const void* cell, int precision);
+void decimal_set_null(void* cell, int precision);
+
+//与 BHS 互转
+//num 为 NULL 时写入空值；多余的小数位截断；整数部分超出精度或不是数字返回-1
+int decimal_from_bhs(const BHS* num, int precision, int scale, void* cell);
+//返回新分配的 BHS，空值返回 NULL
+BHS* decimal_to_bhs(const void* cell, int precision, int scale);
+
+//算术（a、b、out 同为 DECIMAL(p,s)，out 可与 a 或 b 相同）
+//任一操作数为空值时结果为空值；结果超出精度返回-1，out 不变
+int decimal_add(const void* a, const void* b, void* out, int precision);
+int decimal_sub(const void* a, const void* b, void* out, int precision);
+int decimal_mul(const void* a, const void* b, void* out, int precision, int scale);
+//比较：返回 -1/0/1，空值小于任何数
+int decimal_cmp(const void* a, const void* b, int precision);
+
+//聚合：对 count 个连续的格子求和（跳过空值），返回新分配的 BHS
+//结果不受 p 限制，溢出 int128 时转为 BHS 累加
+BHS* decimal_sum(const void* cells, size_t count, int precision, int scale);
+
+#endif // DECIMAL_H
@@ -0,0 +1,546 @@
+#include "filter.h"
+#include "hll.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FILTER_X86_DISPATCH 1  /* 运行时按 CPUID 选择 AVX2 块内核 */
+#endif
+/*
+#版权所有 (c) Mhuixs-team 2024
+#许可证协议:
+#任何人或组织在未经版权所有者同意的情况下禁止使用、修改、分发此作品
+start from 2024.11
+Email:hj18914255909@outlook.com
+*/
+#define merr -1
+
+#define FILTER_PREFETCH   8              /* 批量接口提前预取的元素数 */
+#define FILTER_MAX_BLOCKS (1ULL << 32)   /* 块号由哈希高 32 位映射，块数（桶数）不超过 2^32 */
+
+/*
+数据区头部，块（桶）数组紧随其后并按缓存行对齐。
+写时复制得到的新数据区对齐位置可能不同，取可写数据区时按需搬移（见 filter_data_mut）
+*/
+typedef struct {
+    uint64_t offset;    /* 数据区起点到块（桶）数组的字节数 */
+    uint64_t nblocks;   /* 布隆：块数；布谷鸟：桶数（2 的幂） */
+    uint64_t victim;    /* 布谷鸟：踢出后无处安放的指纹，桶号 << 16 | 指纹，0 表示没有 */
+    uint64_t reserved;
+} filter_header;
+
+/* 每个 64 位字取一位时用的乘数（与 Parquet 分块布隆过滤器相同） */
+static const uint32_t filter_salt[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+// ============================================================================
+// 类型检查函数
+// ============================================================================
+
+/**
+ * 检查 BHS 是否为 FILTER 类型
+ * @param f BHS 指针
+ * @return 1 表示是 FILTER 类型, 0 表示不是
+ */
+int check_if_filter(const BHS* f) {
+    if (!f) return 0;
+    return (f->type == BIGNUM_TYPE_FILTER && f->is_large && f->data.large_data);
+}
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+static inline filter_header* filter_hdr(const BHS* f) {
+    return (filter_header*)f->data.large_data;
+}
+
+static inline uint8_t* filter_array(const BHS* f) {
+    return (uint8_t*)f->data.large_data + filter_hdr(f)->offset;
+}
+
+/* 数组占用的字节数 */
+static inline uint64_t filter_array_bytes(const BHS* f) {
+    uint64_t unit = FILTER_IS_CUCKOO(f) ? FILTER_BUCKET_SLOTS * sizeof(uint16_t) : FILTER_BLOCK_BYTES;
+    return filter_hdr(f)->nblocks * unit;
+}
+
+/* data 对应的数组偏移：跳过头部后对齐到缓存行 */
+static inline uint64_t filter_align_offset(const char* data) {
+    uintptr_t start = (uintptr_t)data + sizeof(filter_header);
+    return sizeof(filter_header) + (FILTER_BLOCK_BYTES - start % FILTER_BLOCK_BYTES) % FILTER_BLOCK_BYTES;
+}
+
+/**
+ * 获取可写的块（桶）数组，被其他 BHS 共享时先复制一份（写时复制）
+ * 复制出的数据区对齐位置不同时把数组搬到新的对齐位置
+ */
+static uint8_t* filter_data_mut(BHS* f) {
+    if (bignum_make_unique(f) != BIGNUM_SUCCESS) return NULL;
+    
+    filter_header* hdr = filter_hdr(f);
+    uint64_t offset = filter_align_offset(f->data.large_data);
+    if (offset != hdr->offset) {
+        memmove(f->data.large_data + offset, f->data.large_data + hdr->offset, filter_array_bytes(f));
+        hdr->offset = offset;
+    }
+    return filter_array(f);
+}
+
+/**
+ * 创建空过滤器，数组多留一个缓存行用于对齐
+ */
+static BHS* filter_create(int encoding, uint64_t nblocks, uint64_t unit) {
+    if (nblocks == 0 || nblocks > FILTER_MAX_BLOCKS) return NULL;
+    if (nblocks > (SIZE_MAX - sizeof(filter_header) - FILTER_BLOCK_BYTES) / unit) return NULL;
+    
+    size_t size = sizeof(filter_header) + FILTER_BLOCK_BYTES + nblocks * unit;
+    BHS* f = (BHS*)malloc(sizeof(BHS));
+    if (!f) return NULL;
+    
+    memset(f, 0, sizeof(BHS));
+    f->data.large_data = bignum_payload_alloc(size);
+    if (!f->data.large_data) {
+        free(f);
+        return NULL;
+    }
+    memset(f->data.large_data, 0, size);
+    f->type = BIGNUM_TYPE_FILTER;
+    f->is_large = 1;
+    f->capacity = size;
+    f->length = 0;
+    f->type_data.filter.encoding = encoding;
+    
+    filter_header* hdr = filter_hdr(f);
+    hdr->offset = filter_align_offset(f->data.large_data);
+    hdr->nblocks = nblocks;
+    return f;
+}
+
+// ============================================================================
+// 分块布隆过滤器
+// ============================================================================
+
+/* 哈希高 32 位按乘法映射到块号，避免取模 */
+static inline uint64_t bloom_block_index(uint64_t hash, uint64_t nblocks) {
+    return ((hash >> 32) * nblocks) >> 32;
+}
+
+static void bloom_add_scalar(uint8_t* arr, uint64_t nblocks, const uint64_t* hashes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH < n) {
+            __builtin_prefetch(arr + bloom_block_index(hashes[i + FILTER_PREFETCH], nblocks) * FILTER_BLOCK_BYTES, 1);
+        }
+        uint64_t* w = (uint64_t*)(arr + bloom_block_index(hashes[i], nblocks) * FILTER_BLOCK_BYTES);
+        uint32_t h = (uint32_t)hashes[i];
+        for (int j = 0; j < 8; j++) {
+            w[j] |= 1ULL << ((h * filter_salt[j]) >> 26);
+        }
+    }
+}
+
+static int64_t bloom_test_scalar(const uint8_t* arr, uint64_t nblocks, const uint64_t* hashes, size_t n, uint8_t* out) {
+    int64_t hits = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH < n) {
+            __builtin_prefetch(arr + bloom_block_index(hashes[i + FILTER_PREFETCH], nblocks) * FILTER_BLOCK_BYTES, 0);
+        }
+        const uint64_t* w = (const uint64_t*)(arr + bloom_block_index(hashes[i], nblocks) * FILTER_BLOCK_BYTES);
+        uint32_t h = (uint32_t)hashes[i];
+        int hit = 1;
+        for (int j = 0; j < 8 && hit; j++) {
+            hit = (w[j] >> ((h * filter_salt[j]) >> 26)) & 1;
+        }
+        if (out) out[i] = (uint8_t)hit;
+        hits += hit;
+    }
+    return hits;
+}
+
+#ifdef FILTER_X86_DISPATCH
+/*
+ * AVX2 内核：8 个乘数一次算出 8 个位号，扩成两个 4×64 位掩码，
+ * 整块（两个 256 位向量）一次置位或比较
+ */
+__attribute__((target("avx2")))
+static inline void bloom_masks_avx2(uint32_t h, __m256i* lo, __m256i* hi) {
+    const __m256i salt = _mm256_loadu_si256((const __m256i*)filter_salt);
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i s = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)h), salt), 26);
+    *lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(s)));
+    *hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(s, 1)));
+}
+
+__attribute__((target("avx2")))
+static void bloom_add_avx2(uint8_t* arr, uint64_t nblocks, const uint64_t* hashes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH < n) {
+            __builtin_prefetch(arr + bloom_block_index(hashes[i + FILTER_PREFETCH], nblocks) * FILTER_BLOCK_BYTES, 1);
+        }
+        __m256i* b = (__m256i*)(arr + bloom_block_index(hashes[i], nblocks) * FILTER_BLOCK_BYTES);
+        __m256i lo, hi;
+        bloom_masks_avx2((uint32_t)hashes[i], &lo, &hi);
+        _mm256_store_si256(b, _mm256_or_si256(_mm256_load_si256(b), lo));
+        _mm256_store_si256(b + 1, _mm256_or_si256(_mm256_load_si256(b + 1), hi));
+    }
+}
+
+__attribute__((target("avx2")))
+static int64_t bloom_test_avx2(const uint8_t* arr, uint64_t nblocks, const uint64_t* hashes, size_t n, uint8_t* out) {
+    int64_t hits = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH < n) {
+            __builtin_prefetch(arr + bloom_block_index(hashes[i + FILTER_PREFETCH], nblocks) * FILTER_BLOCK_BYTES, 0);
+        }
+        const __m256i* b = (const __m256i*)(arr + bloom_block_index(hashes[i], nblocks) * FILTER_BLOCK_BYTES);
+        __m256i lo, hi;
+        bloom_masks_avx2((uint32_t)hashes[i], &lo, &hi);
+        int hit = _mm256_testc_si256(_mm256_load_si256(b), lo) & _mm256_testc_si256(_mm256_load_si256(b + 1), hi);
+        if (out) out[i] = (uint8_t)hit;
+        hits += hit;
+    }
+    return hits;
+}
+#endif
+
+typedef void (*bloom_add_fn)(uint8_t* arr, uint64_t nblocks, const uint64_t* hashes, size_t n);
+typedef int64_t (*bloom_test_fn)(const uint8_t* arr, uint64_t nblocks, const uint64_t* hashes, size_t n, uint8_t* out);
+
+typedef struct {
+    bloom_add_fn add;
+    bloom_test_fn test;
+} bloom_kernels;
+
+static const bloom_kernels bloom_kernels_scalar = {bloom_add_scalar, bloom_test_scalar};
+#ifdef FILTER_X86_DISPATCH
+static const bloom_kernels bloom_kernels_avx2 = {bloom_add_avx2, bloom_test_avx2};
+#endif
+
+/**
+ * 按 CPU 特性选择内核
+ * 首次调用时选定一张内核表，用原子读写发布指针，其他线程看到的总是完整的表
+ */
+static const bloom_kernels* bloom_kernel(void) {
+    static const bloom_kernels* k = NULL;
+    const bloom_kernels* sel = __atomic_load_n(&k, __ATOMIC_ACQUIRE);
+    if (!sel) {
+        sel = &bloom_kernels_scalar;
+#ifdef FILTER_X86_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) sel = &bloom_kernels_avx2;
+#endif
+        __atomic_store_n(&k, sel, __ATOMIC_RELEASE);
+    }
+    return sel;
+}
+
+/**
+ * 创建分块布隆过滤器
+ * 位数按标准公式 n·ln(1/p)/ln²2 估算，再多留 1/4 抵消分块造成的负载不均
+ * @param expected 预计元素数
+ * @param fpp 目标假阳性率，(0, 1)
+ */
+BHS* filter_create_bloom(uint64_t expected, double fpp) {
+    if (!(fpp > 0.0 && fpp < 1.0)) return NULL;
+    if (expected == 0) expected = 1;
+    
+    double bits = (double)expected * -log(fpp) / (0.6931471805599453 * 0.6931471805599453) * 1.25;
+    double blocks = ceil(bits / (FILTER_BLOCK_BYTES * 8));
+    if (blocks > (double)FILTER_MAX_BLOCKS) return NULL;
+    return filter_create(FILTER_ENC_BLOOM, (uint64_t)blocks, FILTER_BLOCK_BYTES);
+}
+
+// ============================================================================
+// 布谷鸟过滤器
+// ============================================================================
+
+#define CUCKOO_LANES 0x0001000100010001ULL   /* 4 个 16 位通道各取最低位 */
+
+/* 指纹取哈希最高 16 位，0 表示空槽，所以 0 换成 1 */
+static inline uint16_t cuckoo_fp(uint64_t hash) {
+    uint16_t fp = (uint16_t)(hash >> 48);
+    return fp ? fp : 1;
+}
+
+/* 另一个候选桶：只依赖当前桶号和指纹，两个方向互逆 */
+static inline uint64_t cuckoo_alt(uint64_t i, uint16_t fp, uint64_t mask) {
+    return (i ^ ((uint64_t)fp * 0x5bd1e995ULL)) & mask;
+}
+
+static inline uint16_t* cuckoo_bucket(uint8_t* arr, uint64_t i) {
+    return (uint16_t*)(arr + i * FILTER_BUCKET_SLOTS * sizeof(uint16_t));
+}
+
+/* 桶内是否有该指纹：整桶读成 64 位，异或后找为 0 的 16 位通道 */
+static inline int cuckoo_bucket_has(const uint8_t* arr, uint64_t i, uint16_t fp) {
+    uint64_t x;
+    memcpy(&x, arr + i * FILTER_BUCKET_SLOTS * sizeof(uint16_t), sizeof(x));
+    x ^= fp * CUCKOO_LANES;
+    return ((x - CUCKOO_LANES) & ~x & (CUCKOO_LANES << 15)) != 0;
+}
+
+static inline int cuckoo_bucket_put(uint16_t* b, uint16_t fp) {
+    for (int s = 0; s < FILTER_BUCKET_SLOTS; s++) {
+        if (b[s] == 0) {
+            b[s] = fp;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static inline int cuckoo_bucket_del(uint16_t* b, uint16_t fp) {
+    for (int s = 0; s < FILTER_BUCKET_SLOTS; s++) {
+        if (b[s] == fp) {
+            b[s] = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int cuckoo_test(const BHS* f, uint64_t hash) {
+    const filter_header* hdr = filter_hdr(f);
+    const uint8_t* arr = filter_array(f);
+    uint64_t mask = hdr->nblocks - 1;
+    uint16_t fp = cuckoo_fp(hash);
+    uint64_t i1 = hash & mask;
+    uint64_t i2 = cuckoo_alt(i1, fp, mask);
+    
+    if (cuckoo_bucket_has(arr, i1, fp) || cuckoo_bucket_has(arr, i2, fp)) return 1;
+    if (hdr->victim && (uint16_t)hdr->victim == fp) {
+        uint64_t vi = hdr->victim >> 16;
+        return vi == i1 || vi == i2;
+    }
+    return 0;
+}
+
+/**
+ * 插入指纹：两个候选桶都满时随机踢出一个指纹换到它的另一个桶，
+ * 踢满 FILTER_MAX_KICKS 次仍无处安放时把最后的指纹存为 victim，之后的插入都会失败
+ */
+static int cuckoo_add(BHS* f, uint64_t hash) {
+    if (filter_hdr(f)->victim) return merr;
+    
+    uint8_t* arr = filter_data_mut(f);
+    if (!arr) return merr;
+    
+    filter_header* hdr = filter_hdr(f);
+    uint64_t mask = hdr->nblocks - 1;
+    uint16_t fp = cuckoo_fp(hash);
+    uint64_t i = hash & mask;
+    
+    f->length++;
+    if (cuckoo_bucket_put(cuckoo_bucket(arr, i), fp)) return 0;
+    i = cuckoo_alt(i, fp, mask);
+    if (cuckoo_bucket_put(cuckoo_bucket(arr, i), fp)) return 0;
+    
+    uint64_t r = hash;
+    for (int k = 0; k < FILTER_MAX_KICKS; k++) {
+        r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint16_t* b = cuckoo_bucket(arr, i);
+        int s = (int)(r >> 62);
+        uint16_t out = b[s];
+        b[s] = fp;
+        fp = out;
+        i = cuckoo_alt(i, fp, mask);
+        if (cuckoo_bucket_put(cuckoo_bucket(arr, i), fp)) return 0;
+    }
+    hdr->victim = (i << 16) | fp;
+    return 0;
+}
+
+static int cuckoo_remove(BHS* f, uint64_t hash) {
+    if (!cuckoo_test(f, hash)) return merr;
+    
+    uint8_t* arr = filter_data_mut(f);
+    if (!arr) return merr;
+    
+    filter_header* hdr = filter_hdr(f);
+    uint64_t mask = hdr->nblocks - 1;
+    uint16_t fp = cuckoo_fp(hash);
+    uint64_t i1 = hash & mask;
+    uint64_t i2 = cuckoo_alt(i1, fp, mask);
+    
+    if (!cuckoo_bucket_del(cuckoo_bucket(arr, i1), fp) && !cuckoo_bucket_del(cuckoo_bucket(arr, i2), fp)) {
+        /* 只可能在 victim 中 */
+        hdr->victim = 0;
+        f->length--;
+        return 0;
+    }
+    f->length--;
+    
+    /* 腾出了位置，victim 放得回去时解除"已满" */
+    if (hdr->victim) {
+        uint64_t vi = hdr->victim >> 16;
+        uint16_t vfp = (uint16_t)hdr->victim;
+        if (cuckoo_bucket_put(cuckoo_bucket(arr, vi), vfp) ||
+            cuckoo_bucket_put(cuckoo_bucket(arr, cuckoo_alt(vi, vfp, mask)), vfp)) {
+            hdr->victim = 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 创建布谷鸟过滤器
+ * 桶数取 2 的幂，使预计元素数时装载率不超过 95%
+ * @param expected 预计元素数
+ */
+BHS* filter_create_cuckoo(uint64_t expected) {
+    if (expected == 0) expected = 1;
+    if (expected > FILTER_MAX_BLOCKS * FILTER_BUCKET_SLOTS / 2) return NULL;
+    
+    uint64_t need = (uint64_t)ceil((double)expected / (FILTER_BUCKET_SLOTS * 0.95));
+    uint64_t buckets = 1;
+    while (buckets < need) buckets <<= 1;
+    return filter_create(FILTER_ENC_CUCKOO, buckets, FILTER_BUCKET_SLOTS * sizeof(uint16_t));
+}
+
+// ============================================================================
+// 公共接口
+// ============================================================================
+
+/**
+ * 释放过滤器
+ */
+void free_filter(BHS* f) {
+    if (!f) return;
+    
+    if (check_if_filter(f)) {
+        bignum_payload_release(f->data.large_data);
+    }
+    free(f);
+}
+
+/**
+ * 两个过滤器是否相同：编码、元素数、块（桶）数、布谷鸟的踢出指纹和数组内容
+ * 数组在数据区中的对齐偏移可能不同，按各自的偏移比较
+ */
+int filter_equal(const BHS* a, const BHS* b) {
+    if (!check_if_filter(a) || !check_if_filter(b)) return 0;
+    if (a->data.large_data == b->data.large_data) return 1;
+    if (a->type_data.filter.encoding != b->type_data.filter.encoding || a->length != b->length) return 0;
+    
+    const filter_header* ha = filter_hdr(a);
+    const filter_header* hb = filter_hdr(b);
+    if (ha->nblocks != hb->nblocks || ha->victim != hb->victim) return 0;
+    return memcmp(filter_array(a), filter_array(b), filter_array_bytes(a)) == 0;
+}
+
+int filter_add_hash(BHS* f, uint64_t hash) {
+    return filter_add_hashes(f, &hash, 1) == 1 ? 0 : merr;
+}
+
+int filter_test_hash(const BHS* f, uint64_t hash) {
+    if (!check_if_filter(f)) return merr;
+    if (FILTER_IS_CUCKOO(f)) return cuckoo_test(f, hash);
+    return (int)bloom_kernel()->test(filter_array(f), filter_hdr(f)->nblocks, &hash, 1, NULL);
+}
+
+int filter_remove_hash(BHS* f, uint64_t hash) {
+    if (!check_if_filter(f) || !FILTER_IS_CUCKOO(f)) return merr;
+    return cuckoo_remove(f, hash);
+}
+
+int filter_add(BHS* f, const void* data, size_t len) {
+    if (!data && len) return merr;
+    return filter_add_hash(f, hll_hash(data, len));
+}
+
+int filter_test(const BHS* f, const void* data, size_t len) {
+    if (!data && len) return merr;
+    return filter_test_hash(f, hll_hash(data, len));
+}
+
+int filter_remove(BHS* f, const void* data, size_t len) {
+    if (!data && len) return merr;
+    return filter_remove_hash(f, hll_hash(data, len));
+}
+
+/**
+ * 批量加入哈希值
+ * 布谷鸟过滤器装满后剩余的元素不再加入
+ * @return 成功加入的个数，参数错误或内存不足返回 -1
+ */
+int64_t filter_add_hashes(BHS* f, const uint64_t* hashes, size_t n) {
+    if (!check_if_filter(f) || (!hashes && n)) return merr;
+    if (n == 0) return 0;
+    
+    if (FILTER_IS_CUCKOO(f)) {
+        int64_t added = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (cuckoo_add(f, hashes[i]) != 0) break;
+            added++;
+        }
+        return added;
+    }
+    
+    uint8_t* arr = filter_data_mut(f);
+    if (!arr) return merr;
+    bloom_kernel()->add(arr, filter_hdr(f)->nblocks, hashes, n);
+    f->length += n;
+    return (int64_t)n;
+}
+
+/**
+ * 批量查询哈希值
+ * @param out 为 NULL 时只统计个数
+ * @return 可能存在的个数，参数错误返回 -1
+ */
+int64_t filter_test_hashes(const BHS* f, const uint64_t* hashes, size_t n, uint8_t* out) {
+    if (!check_if_filter(f) || (!hashes && n)) return merr;
+    
+    if (FILTER_IS_CUCKOO(f)) {
+        int64_t hits = 0;
+        for (size_t i = 0; i < n; i++) {
+            int hit = cuckoo_test(f, hashes[i]);
+            if (out) out[i] = (uint8_t)hit;
+            hits += hit;
+        }
+        return hits;
+    }
+    return bloom_kernel()->test(filter_array(f), filter_hdr(f)->nblocks, hashes, n, out);
+}
+
+/**
+ * 批量加入元素，每 FILTER_BATCH 个先算完哈希再一起写入，便于预取
+ */
+int64_t filter_add_bulk(BHS* f, const void* const* items, const size_t* lens, size_t n) {
+    if (!check_if_filter(f) || (n && (!items || !lens))) return merr;
+    
+    uint64_t hashes[FILTER_BATCH];
+    int64_t added = 0;
+    for (size_t i = 0; i < n; i += FILTER_BATCH) {
+        size_t m = n - i < FILTER_BATCH ? n - i : FILTER_BATCH;
+        for (size_t j = 0; j < m; j++) hashes[j] = hll_hash(items[i + j], lens[i + j]);
+        
+        int64_t r = filter_add_hashes(f, hashes, m);
+        if (r < 0) return merr;
+        added += r;
+        if ((size_t)r < m) break;
+    }
+    return added;
+}
+
+/**
+ * 批量查询元素
+ */
+int64_t filter_test_bulk(const BHS* f, const void* const* items, const size_t* lens, size_t n, uint8_t* out) {
+    if (!check_if_filter(f) || (n && (!items || !lens))) return merr;
+    
+    uint64_t hashes[FILTER_BATCH];
+    int64_t hits = 0;
+    for (size_t i = 0; i < n; i += FILTER_BATCH) {
+        size_t m = n - i < FILTER_BATCH ? n - i : FILTER_BATCH;
+        for (size_t j = 0; j < m; j++) hashes[j] = hll_hash(items[i + j], lens[i + j]);
+        
+        int64_t r = filter_test_hashes(f, hashes, m, out ? out + i : NULL);
+        if (r < 0) return merr;
+        hits += r;
+    }
+    return hits;
+}
@@ -0,0 +1,70 @@
+#ifndef FILTER_H
+#define FILTER_H
+/*
+#版权所有 (c) Mhuixs-team 2024
+#许可证协议:
+#任何人或组织在未经版权所有者同意的情况下禁止使用、修改、分发此作品
+start from 2024.11
+Email:hj18914255909@outlook.com
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "bignum.h"  /* 提供 BHS 类型定义 */
+
+/*
+FILTER（成员过滤器）使用 BHS 结构，用于在查大结构之前先排除一定不存在的元素：
+- type = BIGNUM_TYPE_FILTER
+- 数据总在 data.large_data 中（is_large = 1），复制时共享数据区，写时复制
+- capacity = 分配的字节数
+- length = 已加入的元素个数（布隆过滤器按加入次数计，布谷鸟过滤器为实际保存的指纹数）
+
+编码方式（type_data.filter.encoding）：
+- FILTER_ENC_BLOOM ：分块布隆过滤器。每个元素只落在一个 64 字节（一条缓存行）的块内，
+  在块的 8 个 64 位字中各置 1 位，查询只访问一条缓存行。没有假阴性，不支持删除
+- FILTER_ENC_CUCKOO：布谷鸟过滤器。每桶 4 个 16 位指纹，支持删除，
+  假阳性率约 8 / 2^16。装满后 filter_add 返回 -1，已加入的元素不受影响
+
+布隆过滤器只能删除整个对象；同一元素重复加入布谷鸟过滤器会占用多个槽位，删除时逐个删除。
+元素按 hll_hash() 哈希，调用者也可以直接传入 64 位哈希值（*_hash 系列接口）。
+
+过滤器同样只在值层面可用（bloom/cuckoo 等内置函数）。HOOK_login 接受 OBJ_TYPE_FILTER 的对象，
+但 VM 中 HOOK 创建与 STATIC 注册尚未接通，NAQL 还不能把过滤器注册为具名键。
+*/
+#define FILTER_ENC_BLOOM   0
+#define FILTER_ENC_CUCKOO  1
+
+#define FILTER_BLOCK_BYTES   64    /* 布隆过滤器块大小，等于缓存行 */
+#define FILTER_BUCKET_SLOTS  4     /* 布谷鸟过滤器每桶指纹数 */
+#define FILTER_MAX_KICKS     500   /* 布谷鸟插入时最多踢出的次数 */
+#define FILTER_BATCH         256   /* 批量接口每批计算的哈希数 */
+
+#define FILTER_IS_CUCKOO(f) ((f)->type_data.filter.encoding == FILTER_ENC_CUCKOO)
+
+// 类型检查函数
+int check_if_filter(const BHS* f);
+
+// 构造和析构函数
+BHS* filter_create_bloom(uint64_t expected, double fpp);   // 预计元素数和目标假阳性率
+BHS* filter_create_cuckoo(uint64_t expected);
+void free_filter(BHS* f);
+
+// 编码、元素数和块（桶）数组是否全部相同，相同返回 1
+int filter_equal(const BHS* a, const BHS* b);
+
+// 单个元素：add 成功返回 0；test 可能存在返回 1，一定不存在返回 0；失败返回 -1
+int filter_add(BHS* f, const void* data, size_t len);
+int filter_test(const BHS* f, const void* data, size_t len);
+int filter_remove(BHS* f, const void* data, size_t len);   // 仅布谷鸟过滤器，不存在时返回 -1
+int filter_add_hash(BHS* f, uint64_t hash);
+int filter_test_hash(const BHS* f, uint64_t hash);
+int filter_remove_hash(BHS* f, uint64_t hash);
+
+// 批量接口：add 返回成功加入的个数；test 把结果写入 out[i]（可为 NULL），返回可能存在的个数；失败返回 -1
+int64_t filter_add_hashes(BHS* f, const uint64_t* hashes, size_t n);
+int64_t filter_test_hashes(const BHS* f, const uint64_t* hashes, size_t n, uint8_t* out);
+int64_t filter_add_bulk(BHS* f, const void* const* items, const size_t* lens, size_t n);
+int64_t filter_test_bulk(const BHS* f, const void* const* items, const size_t* lens, size_t n, uint8_t* out);
+
+#endif
@@ -1,5 +1,5 @@
 #include "getid.h"
-#include <pthread.h>
+#include <stdlib.h>
 
 /*
 #版权所有 (c) HuJi 2024
@@ -11,18 +11,135 @@ Email:hj18914255909@outlook.com
 
 #define merr -1
 
-/* 全局位图 */
-static BITMAP sid_bitmap;
-static BITMAP uid_bitmap;
-static BITMAP gid_bitmap;
+/*
+ID 池：两层位图，全部用原子操作，不加锁
+- words：每位一个 ID，1 表示已占用
+- full ：每位对应 words 中的一个字，1 表示该字已满，分配时整字跳过
+分配时从上次成功的字开始，按 full 找到未满的字，再在字内用 CAS 占用最低的空位；
+字被占满时置位 full，随后复查一次该字，避免与并发释放交错后留下错误的"已满"标记。
+full 只是提示：漏标"已满"只会多看一个字，不会分配出错。
+*/
+typedef struct {
+    uint64_t *words;
+    uint64_t *full;
+    uint32_t nwords;
+    uint32_t hint;      /* 下次开始查找的字下标 */
+} idpool;
 
-/* 互斥锁 */
-static pthread_mutex_t sid_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t uid_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t gid_mutex = PTHREAD_MUTEX_INITIALIZER;
+static idpool sid_pool;
+static idpool uid_pool;
+static idpool gid_pool;
 
 static int if_init = 0;
 
+/* ==================== ID 池 ==================== */
+
+static int idpool_create(idpool *p, uint32_t bits) {
+    p->nwords = bits / 64;
+    p->words = calloc(p->nwords, sizeof(uint64_t));
+    p->full = calloc((p->nwords + 63) / 64, sizeof(uint64_t));
+    p->hint = 0;
+    if (!p->words || !p->full) {
+        free(p->words);
+        free(p->full);
+        p->words = p->full = NULL;
+        return merr;
+    }
+    return 0;
+}
+
+static void idpool_destroy(idpool *p) {
+    free(p->words);
+    free(p->full);
+    p->words = p->full = NULL;
+    p->nwords = 0;
+}
+
+/* 第 lo 到 hi 位（含）为 1 的掩码，0 <= lo <= hi <= 63 */
+static inline uint64_t idpool_mask(uint32_t lo, uint32_t hi) {
+    return (~0ULL >> (63 - hi)) & (~0ULL << lo);
+}
+
+/* 字 w 被占满后置位 full，再复查：期间若有释放，撤销标记 */
+static void idpool_mark_full(idpool *p, uint32_t w) {
+    uint64_t bit = 1ULL << (w % 64);
+    __atomic_fetch_or(&p->full[w / 64], bit, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&p->words[w], __ATOMIC_SEQ_CST) != ~0ULL) {
+        __atomic_fetch_and(&p->full[w / 64], ~bit, __ATOMIC_SEQ_CST);
+    }
+}
+
+/* 在字 w 中占用 allow 范围内最低的空位，失败返回 -1 */
+static int64_t idpool_take_word(idpool *p, uint32_t w, uint64_t allow) {
+    uint64_t v = __atomic_load_n(&p->words[w], __ATOMIC_RELAXED);
+    while (~v & allow) {
+        uint64_t bit = ~v & allow;
+        bit &= -bit;
+        if (__atomic_compare_exchange_n(&p->words[w], &v, v | bit, 1,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            if ((v | bit) == ~0ULL) idpool_mark_full(p, w);
+            return (int64_t)w * 64 + __builtin_ctzll(bit);
+        }
+    }
+    return -1;
+}
+
+/* 在字 [ws, we] 中查找，ID 限定在 [start, end] */
+static int64_t idpool_scan(idpool *p, uint32_t ws, uint32_t we, uint32_t start, uint32_t end) {
+    for (uint32_t s = ws / 64; s <= we / 64; s++) {
+        uint32_t lo = s * 64 < ws ? ws - s * 64 : 0;
+        uint32_t hi = s * 64 + 63 > we ? we - s * 64 : 63;
+        uint64_t cand = ~__atomic_load_n(&p->full[s], __ATOMIC_SEQ_CST) & idpool_mask(lo, hi);
+        
+        while (cand) {
+            uint32_t w = s * 64 + __builtin_ctzll(cand);
+            cand &= cand - 1;
+            
+            uint64_t allow = ~0ULL;
+            if (w == start / 64) allow &= ~0ULL << (start % 64);
+            if (w == end / 64) allow &= ~0ULL >> (63 - end % 64);
+            
+            int64_t id = idpool_take_word(p, w, allow);
+            if (id >= 0) {
+                /* 提示没变时不写，避免多线程反复争抢同一缓存行 */
+                if (__atomic_load_n(&p->hint, __ATOMIC_RELAXED) != w) {
+                    __atomic_store_n(&p->hint, w, __ATOMIC_RELAXED);
+                }
+                return id;
+            }
+        }
+    }
+    return -1;
+}
+
+/* 分配 [start, end] 中的一个空闲 ID，从上次成功的位置开始环绕查找 */
+static int64_t idpool_alloc(idpool *p, uint32_t start, uint32_t end) {
+    uint32_t ws = start / 64, we = end / 64;
+    uint32_t h = __atomic_load_n(&p->hint, __ATOMIC_RELAXED);
+    if (h < ws || h > we) h = ws;
+    
+    int64_t id = idpool_scan(p, h, we, start, end);
+    if (id < 0 && h > ws) id = idpool_scan(p, ws, h - 1, start, end);
+    return id;
+}
+
+/* 释放 ID，ID 本来就空闲时返回 merr */
+static int idpool_free(idpool *p, uint32_t id) {
+    uint32_t w = id / 64;
+    uint64_t bit = 1ULL << (id % 64);
+    uint64_t old = __atomic_fetch_and(&p->words[w], ~bit, __ATOMIC_SEQ_CST);
+    if (!(old & bit)) return merr;
+    if (old == ~0ULL) {
+        __atomic_fetch_and(&p->full[w / 64], ~(1ULL << (w % 64)), __ATOMIC_SEQ_CST);
+    }
+    return 0;
+}
+
+/* 标记 ID 为已占用（初始化时保留） */
+static void idpool_reserve(idpool *p, uint32_t id) {
+    __atomic_fetch_or(&p->words[id / 64], 1ULL << (id % 64), __ATOMIC_SEQ_CST);
+}
+
 /* ==================== 初始化和清理 ==================== */
 
 int idalloc_init(void) {
@@ -30,17 +147,18 @@ int idalloc_init(void) {
         return 0; /* 已经初始化 */
     }
     
-    sid_bitmap = *bitmap_create_with_size(65536);
-    uid_bitmap = *bitmap_create_with_size(65536);
-    gid_bitmap = *bitmap_create_with_size(65536);
-    
-    if (bitmap_iserr(&sid_bitmap) || bitmap_iserr(&uid_bitmap) || bitmap_iserr(&gid_bitmap)) {
-        free_bitmap(&sid_bitmap);
-        free_bitmap(&uid_bitmap);
-        free_bitmap(&gid_bitmap);
+    if (idpool_create(&sid_pool, SID_MAX) != 0 ||
+        idpool_create(&uid_pool, UID_MAX) != 0 ||
+        idpool_create(&gid_pool, GID_MAX) != 0) {
+        idpool_destroy(&sid_pool);
+        idpool_destroy(&uid_pool);
+        idpool_destroy(&gid_pool);
         return init_failed;
     }
     
+    /* SID 0 表示"没有会话"，不分配 */
+    idpool_reserve(&sid_pool, 0);
+    
     if_init = 1;
     return 0;
 }
@@ -51,37 +169,27 @@ int idalloc_close(void) {
     }
     
     if_init = 0;
-    free_bitmap(&sid_bitmap);
-    free_bitmap(&uid_bitmap);
-    free_bitmap(&gid_bitmap);
+    idpool_destroy(&sid_pool);
+    idpool_destroy(&uid_pool);
+    idpool_destroy(&gid_pool);
     return 0;
 }
 
 /* ==================== 会话ID分配 ==================== */
 
 SID get_sid(void) {
-    pthread_mutex_lock(&sid_mutex);
-    
-    int64_t idx = bitmap_find(&sid_bitmap, 0, 0, 65535);
-    if (idx == merr) {
-        pthread_mutex_unlock(&sid_mutex);
-        return merr;
-    }
+    if (!if_init) return merr;
     
-    bitmap_set(&sid_bitmap, (uint32_t)idx, 1);
-    pthread_mutex_unlock(&sid_mutex);
-    return (SID)idx;
+    int64_t idx = idpool_alloc(&sid_pool, 1, SID_MAX - 1);
+    return idx < 0 ? merr : (SID)idx;
 }
 
 SID del_sid(SID sid) {
-    if (sid < 0 || sid > 65535) {
+    if (!if_init || sid <= 0 || sid >= SID_MAX) {
         return merr;
     }
     
-    pthread_mutex_lock(&sid_mutex);
-    bitmap_set(&sid_bitmap, (uint32_t)sid, 0);
-    pthread_mutex_unlock(&sid_mutex);
-    return 0;
+    return idpool_free(&sid_pool, (uint32_t)sid);
 }
 
 /* ==================== 用户ID分配 ==================== */
@@ -92,21 +200,13 @@ UID get_uid(UID_t type) {
     switch (type) {
         case ROOT_UID:    start = 0; end = 0; break;
         case SYSTEM_UID:  start = 1; end = 99; break;
-        case COMMON_UID:  start = 100; end = 65535; break;
+        case COMMON_UID:  start = 100; end = UID_MAX - 1; break;
         default: return merr;
     }
+    if (!if_init) return merr;
     
-    pthread_mutex_lock(&uid_mutex);
-    
-    int64_t idx = bitmap_find(&uid_bitmap, 0, start, end);
-    if (idx == merr) {
-        pthread_mutex_unlock(&uid_mutex);
-        return merr;
-    }
-    
-    bitmap_set(&uid_bitmap, (uint32_t)idx, 1);
-    pthread_mutex_unlock(&uid_mutex);
-    return (UID)idx;
+    int64_t idx = idpool_alloc(&uid_pool, start, end);
+    return idx < 0 ? merr : (UID)idx;
 }
 
 UID del_uid(UID_t type, UID uid) {
@@ -115,18 +215,15 @@ UID del_uid(UID_t type, UID uid) {
     switch (type) {
         case ROOT_UID:    start = 0; end = 0; break;
         case SYSTEM_UID:  start = 1; end = 99; break;
-        case COMMON_UID:  start = 100; end = 65535; break;
+        case COMMON_UID:  start = 100; end = UID_MAX - 1; break;
         default: return merr;
     }
     
-    if (uid < (int)start || uid > (int)end) {
+    if (!if_init || uid < (int)start || uid > (int)end) {
         return merr;
     }
     
-    pthread_mutex_lock(&uid_mutex);
-    bitmap_set(&uid_bitmap, (uint32_t)uid, 0);
-    pthread_mutex_unlock(&uid_mutex);
-    return 0;
+    return idpool_free(&uid_pool, (uint32_t)uid);
 }
 
 /* ==================== 组ID分配 ==================== */
@@ -136,21 +233,13 @@ GID get_gid(GID_t type) {
     
     switch (type) {
         case SYSTEM_GID:  start = 0; end = 0; break;
-        case COMMON_GID:  start = 1; end = 65535; break;
+        case COMMON_GID:  start = 1; end = GID_MAX - 1; break;
         default: return merr;
     }
+    if (!if_init) return merr;
     
-    pthread_mutex_lock(&gid_mutex);
-    
-    int64_t idx = bitmap_find(&gid_bitmap, 0, start, end);
-    if (idx == merr) {
-        pthread_mutex_unlock(&gid_mutex);
-        return merr;
-    }
-    
-    bitmap_set(&gid_bitmap, (uint32_t)idx, 1);
-    pthread_mutex_unlock(&gid_mutex);
-    return (GID)idx;
+    int64_t idx = idpool_alloc(&gid_pool, start, end);
+    return idx < 0 ? merr : (GID)idx;
 }
 
 GID del_gid(GID_t type, GID gid) {
@@ -158,16 +247,13 @@ GID del_gid(GID_t type, GID gid) {
     
     switch (type) {
         case SYSTEM_GID:  start = 0; end = 0; break;
-        case COMMON_GID:  start = 1; end = 65535; break;
+        case COMMON_GID:  start = 1; end = GID_MAX - 1; break;
         default: return merr;
     }
     
-    if (gid < start || gid > end) {
+    if (!if_init || gid < start || gid > end) {
         return merr;
     }
     
-    pthread_mutex_lock(&gid_mutex);
-    bitmap_set(&gid_bitmap, (uint32_t)gid, 0);
-    pthread_mutex_unlock(&gid_mutex);
-    return 0;
+    return idpool_free(&gid_pool, (uint32_t)gid);
 }
@@ -1,7 +1,7 @@
 #ifndef GETID_H
 #define GETID_H
 
-#include "bitmap.h"
+#include <stdint.h>
 #include "merr.h"
 
 #ifdef __cplusplus
@@ -18,10 +18,11 @@ Email:hj18914255909@outlook.com
 
 /*
 ===================================
-ID分配器模块 线程安全：所有公有方法均加锁
+ID分配器模块 线程安全：所有公有方法均无锁（原子操作），可在多个线程中并发调用
 ===================================
 
-会话SID:0-65535,类似linux的PID
+会话SID:1-(SID_MAX-1),类似linux的PID
+    0表示没有会话,不分配
 
 用户UID:0-65535,类似linux
     0为root用户ID            ROOT_UID
@@ -37,6 +38,10 @@ ID分配器模块 线程安全：所有公有方法均加锁
 
 typedef int SID, UID, GID;
 
+#define SID_MAX (1 << 20)   /* 会话ID个数，并发会话数上限 */
+#define UID_MAX 65536       /* 用户ID个数（65536 留作临时用户标识） */
+#define GID_MAX 65536       /* 组ID个数（65536 留作临时用户组标识） */
+
 typedef enum {
     ROOT_UID,     /* root用户ID */
     SYSTEM_UID,   /* 系统用户ID */
@@ -0,0 +1,555 @@
+#include "hll.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HLL_X86_DISPATCH 1  /* 运行时按 CPUID 选择 AVX2 合并内核 */
+#endif
+/*
+#版权所有 (c) Mhuixs-team 2024
+#许可证协议:
+#任何人或组织在未经版权所有者同意的情况下禁止使用、修改、分发此作品
+start from 2024.11
+Email:hj18914255909@outlook.com
+*/
+#define merr -1
+
+#define HLL_Q                  (64 - HLL_P)        /* 参与求秩的哈希位数，秩最大为 HLL_Q + 1 */
+#define HLL_ALPHA_INF          0.721347520444481703680  /* 1 / (2 ln 2) */
+#define HLL_SPARSE_INIT_BYTES  64                  /* 新建时稀疏数据区的大小 */
+
+// ============================================================================
+// 类型检查函数
+// ============================================================================
+
+/**
+ * 检查 BHS 是否为 HLL 类型
+ * @param h BHS 指针
+ * @return 1 表示是 HLL 类型, 0 表示不是
+ */
+int check_if_hll(const BHS* h) {
+    if (!h) return 0;
+    return (h->type == BIGNUM_TYPE_HLL && h->is_large && h->data.large_data);
+}
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+static inline const uint8_t* hll_data(const BHS* h) {
+    return (const uint8_t*)h->data.large_data;
+}
+
+static inline const uint32_t* hll_entries(const BHS* h) {
+    return (const uint32_t*)h->data.large_data;
+}
+
+/**
+ * 获取可写的数据区，被其他 BHS 共享时先复制一份（写时复制）
+ */
+static inline uint8_t* hll_data_mut(BHS* h) {
+    if (bignum_make_unique(h) != BIGNUM_SUCCESS) return NULL;
+    return (uint8_t*)h->data.large_data;
+}
+
+/**
+ * 读取平铺编码的第 i 个寄存器
+ * 寄存器跨字节时才读下一个字节，不会读出数据区
+ */
+static inline uint8_t hll_dense_get(const uint8_t* d, uint32_t i) {
+    uint32_t bit = i * HLL_REGISTER_BITS;
+    uint32_t b = bit >> 3, s = bit & 7;
+    unsigned v = d[b] >> s;
+    if (s > 8 - HLL_REGISTER_BITS) v |= (unsigned)d[b + 1] << (8 - s);
+    return (uint8_t)(v & 63);
+}
+
+static inline void hll_dense_set(uint8_t* d, uint32_t i, uint8_t v) {
+    uint32_t bit = i * HLL_REGISTER_BITS;
+    uint32_t b = bit >> 3, s = bit & 7;
+    d[b] = (uint8_t)((d[b] & ~(63u << s)) | ((unsigned)v << s));
+    if (s > 8 - HLL_REGISTER_BITS) {
+        d[b + 1] = (uint8_t)((d[b + 1] & ~(63u >> (8 - s))) | ((unsigned)v >> (8 - s)));
+    }
+}
+
+/* 平铺编码每 3 字节恰好 4 个寄存器 */
+static inline uint32_t hll_load24(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+/**
+ * 在稀疏条目中二分查找寄存器 idx
+ * @return 找到时返回条目下标；否则返回 -(插入位置) - 1
+ */
+static int64_t hll_sparse_find(const uint32_t* e, uint64_t n, uint32_t idx) {
+    uint64_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        uint32_t k = e[mid] >> 8;
+        if (k == idx) return (int64_t)mid;
+        if (k < idx) lo = mid + 1;
+        else hi = mid;
+    }
+    return -(int64_t)lo - 1;
+}
+
+/**
+ * 稀疏编码转为平铺编码
+ * 新数据区由自己独占，旧数据区只释放一个引用，不需要先复制
+ */
+static int hll_to_dense(BHS* h) {
+    char* dense = bignum_payload_alloc(HLL_DENSE_BYTES);
+    if (!dense) return merr;
+    memset(dense, 0, HLL_DENSE_BYTES);
+    
+    const uint32_t* e = hll_entries(h);
+    for (uint64_t i = 0; i < h->length; i++) {
+        hll_dense_set((uint8_t*)dense, e[i] >> 8, (uint8_t)(e[i] & 0xFF));
+    }
+    
+    bignum_payload_release(h->data.large_data);
+    h->data.large_data = dense;
+    h->capacity = HLL_DENSE_BYTES;
+    h->length = HLL_REGISTERS;
+    h->type_data.hll.encoding = HLL_ENC_DENSE;
+    return 0;
+}
+
+// ============================================================================
+// 寄存器数组（合并与估计的中间形式，每个寄存器一个字节）
+// ============================================================================
+
+/* regs[i] = max(regs[i], 平铺寄存器 i)，从第 from 个寄存器（4 的倍数）开始 */
+static void hll_dense_max_scalar(uint8_t* regs, const uint8_t* d, uint32_t from) {
+    const uint8_t* p = d + from / 4 * 3;
+    for (uint32_t i = from; i < HLL_REGISTERS; i += 4, p += 3) {
+        uint32_t x = hll_load24(p);
+        for (int j = 0; j < 4; j++, x >>= HLL_REGISTER_BITS) {
+            uint8_t r = (uint8_t)(x & 63);
+            if (r > regs[i + j]) regs[i + j] = r;
+        }
+    }
+}
+
+static void hll_dense_max_generic(uint8_t* regs, const uint8_t* d) {
+    hll_dense_max_scalar(regs, d, 0);
+}
+
+#ifdef HLL_X86_DISPATCH
+/*
+ * AVX2 内核：每次解开 32 个寄存器（24 字节）
+ * 两个 128 位通道分别从 p 和 p + 12 读入，pshufb 把每 3 字节放进一个 32 位元素，
+ * 再用移位和掩码把 4 个 6 位寄存器摊到 4 个字节上，与 regs 逐字节取最大值。
+ * 每次读 p 到 p + 27，最后一组不够读时交给标量尾部
+ */
+__attribute__((target("avx2")))
+static void hll_dense_max_avx2(uint8_t* regs, const uint8_t* d) {
+    const __m256i shuf = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i m0 = _mm256_set1_epi32(0x3F);
+    const __m256i m1 = _mm256_set1_epi32(0x3F00);
+    const __m256i m2 = _mm256_set1_epi32(0x3F0000);
+    const __m256i m3 = _mm256_set1_epi32(0x3F000000);
+    
+    uint32_t i = 0;
+    for (; i / 4 * 3 + 28 <= HLL_DENSE_BYTES; i += 32) {
+        const uint8_t* p = d + i / 4 * 3;
+        __m256i raw = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                              _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+        __m256i x = _mm256_shuffle_epi8(raw, shuf);
+        __m256i r = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(x, m0), _mm256_and_si256(_mm256_slli_epi32(x, 2), m1)),
+            _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(x, 4), m2), _mm256_and_si256(_mm256_slli_epi32(x, 6), m3)));
+        __m256i cur = _mm256_loadu_si256((const __m256i*)(regs + i));
+        _mm256_storeu_si256((__m256i*)(regs + i), _mm256_max_epu8(cur, r));
+    }
+    hll_dense_max_scalar(regs, d, i);
+}
+#endif
+
+typedef void (*hll_dense_max_fn)(uint8_t* regs, const uint8_t* d);
+
+/* 按 CPU 特性选择内核 */
+static hll_dense_max_fn hll_dense_max_select(void) {
+#ifdef HLL_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return hll_dense_max_avx2;
+#endif
+    return hll_dense_max_generic;
+}
+
+/**
+ * 把 h 的寄存器按最大值并入 regs
+ * 首次调用时选定内核，之后直接走函数指针（多线程下重复选择结果相同，无害）
+ */
+static void hll_max_into(uint8_t* regs, const BHS* h) {
+    if (HLL_IS_DENSE(h)) {
+        static hll_dense_max_fn kernel = NULL;
+        if (!kernel) kernel = hll_dense_max_select();
+        kernel(regs, hll_data(h));
+        return;
+    }
+    
+    const uint32_t* e = hll_entries(h);
+    for (uint64_t i = 0; i < h->length; i++) {
+        uint32_t idx = e[i] >> 8;
+        uint8_t r = (uint8_t)(e[i] & 0xFF);
+        if (r > regs[idx]) regs[idx] = r;
+    }
+}
+
+/**
+ * 用寄存器数组重写 h 的数据区
+ * 非 0 寄存器不多且 allow_sparse 时写成稀疏编码，否则写成平铺编码
+ */
+static int hll_store_regs(BHS* h, const uint8_t* regs, int allow_sparse) {
+    uint64_t nz = 0;
+    for (uint32_t i = 0; i < HLL_REGISTERS; i++) nz += regs[i] != 0;
+    
+    int sparse = allow_sparse && nz * sizeof(uint32_t) <= HLL_SPARSE_MAX_BYTES;
+    size_t size = sparse ? (nz > 0 ? nz * sizeof(uint32_t) : HLL_SPARSE_INIT_BYTES) : HLL_DENSE_BYTES;
+    char* data = bignum_payload_alloc(size);
+    if (!data) return merr;
+    
+    if (sparse) {
+        uint32_t* e = (uint32_t*)data;
+        uint64_t n = 0;
+        for (uint32_t i = 0; i < HLL_REGISTERS; i++) {
+            if (regs[i]) e[n++] = (i << 8) | regs[i];
+        }
+    } else {
+        uint8_t* p = (uint8_t*)data;
+        for (uint32_t i = 0; i < HLL_REGISTERS; i += 4, p += 3) {
+            uint32_t x = (uint32_t)regs[i] | ((uint32_t)regs[i + 1] << 6) |
+                         ((uint32_t)regs[i + 2] << 12) | ((uint32_t)regs[i + 3] << 18);
+            p[0] = (uint8_t)x;
+            p[1] = (uint8_t)(x >> 8);
+            p[2] = (uint8_t)(x >> 16);
+        }
+    }
+    
+    bignum_payload_release(h->data.large_data);
+    h->data.large_data = data;
+    h->capacity = size;
+    h->length = sparse ? nz : HLL_REGISTERS;
+    h->type_data.hll.encoding = sparse ? HLL_ENC_SPARSE : HLL_ENC_DENSE;
+    return 0;
+}
+
+// ============================================================================
+// 基数估计
+// ============================================================================
+
+/* Ertl 估计中的 σ(x) = x + Σ x^(2^k) 2^(k-1) */
+static double hll_sigma(double x) {
+    if (x == 1.0) return INFINITY;
+    double y = 1.0, z = x, zp;
+    do {
+        x *= x;
+        zp = z;
+        z += x * y;
+        y += y;
+    } while (zp != z);
+    return z;
+}
+
+/* Ertl 估计中的 τ(x) = (1 - x - Σ (1 - x^(2^-k))^2 2^-k) / 3 */
+static double hll_tau(double x) {
+    if (x == 0.0 || x == 1.0) return 0.0;
+    double y = 1.0, z = 1.0 - x, zp;
+    do {
+        x = sqrt(x);
+        zp = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (zp != z);
+    return z / 3.0;
+}
+
+/**
+ * 由寄存器直方图估计基数（Ertl 2017 改进估计）
+ * 小基数和大基数都不需要偏差修正表或线性计数切换
+ * @param c c[k] 为值等于 k 的寄存器个数，k = 0 .. HLL_Q + 1
+ */
+static uint64_t hll_estimate(const uint32_t* c) {
+    double m = HLL_REGISTERS;
+    double z = m * hll_tau((m - c[HLL_Q + 1]) / m);
+    for (int k = HLL_Q; k >= 1; k--) {
+        z += c[k];
+        z *= 0.5;
+    }
+    z += m * hll_sigma(c[0] / m);
+    return (uint64_t)llround(HLL_ALPHA_INF * m * m / z);
+}
+
+static uint64_t hll_estimate_regs(const uint8_t* regs) {
+    uint32_t c[64] = {0};
+    for (uint32_t i = 0; i < HLL_REGISTERS; i++) c[regs[i] & 63]++;
+    return hll_estimate(c);
+}
+
+// ============================================================================
+// 构造和析构函数
+// ============================================================================
+
+/**
+ * 创建空的 HLL（稀疏编码）
+ */
+BHS* hll_create(void) {
+    BHS* h = (BHS*)malloc(sizeof(BHS));
+    if (!h) return NULL;
+    
+    memset(h, 0, sizeof(BHS));
+    h->data.large_data = bignum_payload_alloc(HLL_SPARSE_INIT_BYTES);
+    if (!h->data.large_data) {
+        free(h);
+        return NULL;
+    }
+    h->type = BIGNUM_TYPE_HLL;
+    h->is_large = 1;
+    h->capacity = HLL_SPARSE_INIT_BYTES;
+    h->length = 0;
+    h->type_data.hll.encoding = HLL_ENC_SPARSE;
+    
+    return h;
+}
+
+/**
+ * 释放 HLL
+ */
+void free_hll(BHS* h) {
+    if (!h) return;
+    
+    if (check_if_hll(h)) {
+        bignum_payload_release(h->data.large_data);
+    }
+    free(h);
+}
+
+// ============================================================================
+// 添加元素
+// ============================================================================
+
+/**
+ * 64 位 MurmurHash2（MurmurHash64A），按小端读入
+ */
+uint64_t hll_hash(const void* data, size_t len) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t h = 0xadc83b19ULL ^ (len * m);
+    
+    size_t nblocks = len / 8;
+    for (size_t i = 0; i < nblocks; i++, p += 8) {
+        uint64_t k = 0;
+        for (int j = 7; j >= 0; j--) k = (k << 8) | p[j];
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    
+    switch (len & 7) {
+        case 7: h ^= (uint64_t)p[6] << 48; /* fall through */
+        case 6: h ^= (uint64_t)p[5] << 40; /* fall through */
+        case 5: h ^= (uint64_t)p[4] << 32; /* fall through */
+        case 4: h ^= (uint64_t)p[3] << 24; /* fall through */
+        case 3: h ^= (uint64_t)p[2] << 16; /* fall through */
+        case 2: h ^= (uint64_t)p[1] << 8;  /* fall through */
+        case 1: h ^= (uint64_t)p[0];
+                h *= m;
+    }
+    
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+/**
+ * 按哈希值更新寄存器
+ * @return 1 寄存器变大, 0 没有变化, -1 失败
+ */
+int hll_add_hash(BHS* h, uint64_t hash) {
+    if (!check_if_hll(h)) return merr;
+    
+    uint32_t idx = (uint32_t)(hash & (HLL_REGISTERS - 1));
+    /* 补一个哨兵位，保证秩不超过 HLL_Q + 1 */
+    uint64_t rest = (hash >> HLL_P) | (1ULL << HLL_Q);
+    uint8_t rank = (uint8_t)(__builtin_ctzll(rest) + 1);
+    
+    if (HLL_IS_DENSE(h)) {
+        if (hll_dense_get(hll_data(h), idx) >= rank) return 0;
+        uint8_t* d = hll_data_mut(h);
+        if (!d) return merr;
+        hll_dense_set(d, idx, rank);
+        return 1;
+    }
+    
+    int64_t pos = hll_sparse_find(hll_entries(h), h->length, idx);
+    if (pos >= 0 && (hll_entries(h)[pos] & 0xFF) >= rank) return 0;
+    
+    if (pos < 0 && (h->length + 1) * sizeof(uint32_t) > HLL_SPARSE_MAX_BYTES) {
+        if (hll_to_dense(h) != 0) return merr;
+        hll_dense_set((uint8_t*)h->data.large_data, idx, rank);
+        return 1;
+    }
+    
+    uint32_t* e = (uint32_t*)hll_data_mut(h);
+    if (!e) return merr;
+    uint32_t entry = (idx << 8) | rank;
+    if (pos >= 0) {
+        e[pos] = entry;
+        return 1;
+    }
+    
+    /* 插入新条目，容量按倍数增长 */
+    uint64_t at = (uint64_t)(-pos - 1);
+    if ((h->length + 1) * sizeof(uint32_t) > h->capacity) {
+        size_t cap = h->capacity * 2;
+        if (cap > HLL_SPARSE_MAX_BYTES) cap = HLL_SPARSE_MAX_BYTES;
+        char* data = bignum_payload_realloc(h->data.large_data, cap);
+        if (!data) return merr;
+        h->data.large_data = data;
+        h->capacity = cap;
+        e = (uint32_t*)data;
+    }
+    memmove(e + at + 1, e + at, (h->length - at) * sizeof(uint32_t));
+    e[at] = entry;
+    h->length++;
+    return 1;
+}
+
+/**
+ * 添加一个元素（PFADD）
+ */
+int hll_add(BHS* h, const void* data, size_t len) {
+    if (!data && len) return merr;
+    return hll_add_hash(h, hll_hash(data, len));
+}
+
+// ============================================================================
+// 基数查询
+// ============================================================================
+
+/**
+ * 估计 HLL 的基数（PFCOUNT）
+ * @return 估计值，h 不是 HLL 时返回 0
+ */
+uint64_t hll_count(const BHS* h) {
+    if (!check_if_hll(h)) return 0;
+    
+    uint32_t c[64] = {0};
+    if (HLL_IS_DENSE(h)) {
+        const uint8_t* p = hll_data(h);
+        for (uint32_t i = 0; i < HLL_REGISTERS; i += 4, p += 3) {
+            uint32_t x = hll_load24(p);
+            c[x & 63]++;
+            c[(x >> 6) & 63]++;
+            c[(x >> 12) & 63]++;
+            c[(x >> 18) & 63]++;
+        }
+    } else {
+        const uint32_t* e = hll_entries(h);
+        c[0] = (uint32_t)(HLL_REGISTERS - h->length);
+        for (uint64_t i = 0; i < h->length; i++) c[e[i] & 63]++;
+    }
+    return hll_estimate(c);
+}
+
+/**
+ * 两个 HLL 的寄存器是否全部相同
+ * 编码相同时直接比较数据区，不同时逐个比较稀疏条目与平铺寄存器
+ */
+int hll_equal(const BHS* a, const BHS* b) {
+    if (!check_if_hll(a) || !check_if_hll(b)) return 0;
+    if (a->data.large_data == b->data.large_data) return 1;
+    if (HLL_IS_DENSE(a) && HLL_IS_DENSE(b)) return memcmp(hll_data(a), hll_data(b), HLL_DENSE_BYTES) == 0;
+    if (!HLL_IS_DENSE(a) && !HLL_IS_DENSE(b)) {
+        return a->length == b->length && memcmp(hll_entries(a), hll_entries(b), a->length * sizeof(uint32_t)) == 0;
+    }
+    
+    if (!HLL_IS_DENSE(a)) {
+        const BHS* t = a;
+        a = b;
+        b = t;
+    }
+    const uint8_t* d = hll_data(a);
+    const uint32_t* e = hll_entries(b);
+    uint64_t k = 0;
+    for (uint32_t i = 0; i < HLL_REGISTERS; i++) {
+        uint8_t r = 0;
+        if (k < b->length && e[k] >> 8 == i) r = (uint8_t)(e[k++] & 0xFF);
+        if (hll_dense_get(d, i) != r) return 0;
+    }
+    return 1;
+}
+
+/**
+ * 估计多个 HLL 并集的基数（PFCOUNT k1 k2 ...），不生成合并结果
+ * @return 0 成功, -1 参数不是 HLL 或内存不足
+ */
+int hll_count_union(const BHS* const* hs, size_t n, uint64_t* count) {
+    if (!hs || n == 0 || !count) return merr;
+    for (size_t i = 0; i < n; i++) {
+        if (!check_if_hll(hs[i])) return merr;
+    }
+    
+    if (n == 1) {
+        *count = hll_count(hs[0]);
+        return 0;
+    }
+    
+    uint8_t* regs = (uint8_t*)calloc(HLL_REGISTERS, 1);
+    if (!regs) return merr;
+    for (size_t i = 0; i < n; i++) hll_max_into(regs, hs[i]);
+    *count = hll_estimate_regs(regs);
+    free(regs);
+    return 0;
+}
+
+// ============================================================================
+// 合并
+// ============================================================================
+
+/**
+ * dst 并入 src 的寄存器，dst 已是平铺编码时保持平铺
+ */
+int hll_merge_inplace(BHS* dst, const BHS* src) {
+    if (!check_if_hll(dst) || !check_if_hll(src)) return merr;
+    if (dst->data.large_data == src->data.large_data) return 0;
+    
+    uint8_t* regs = (uint8_t*)calloc(HLL_REGISTERS, 1);
+    if (!regs) return merr;
+    hll_max_into(regs, dst);
+    hll_max_into(regs, src);
+    int ret = hll_store_regs(dst, regs, !HLL_IS_DENSE(dst));
+    free(regs);
+    return ret;
+}
+
+/**
+ * 合并多个 HLL（PFMERGE），一趟按寄存器取最大值
+ * @return 新的 HLL，失败返回 NULL
+ */
+BHS* hll_merge(const BHS* const* hs, size_t n) {
+    if (!hs || n == 0) return NULL;
+    for (size_t i = 0; i < n; i++) {
+        if (!check_if_hll(hs[i])) return NULL;
+    }
+    
+    uint8_t* regs = (uint8_t*)calloc(HLL_REGISTERS, 1);
+    if (!regs) return NULL;
+    for (size_t i = 0; i < n; i++) hll_max_into(regs, hs[i]);
+    
+    BHS* h = hll_create();
+    if (h && hll_store_regs(h, regs, 1) != 0) {
+        free_hll(h);
+        h = NULL;
+    }
+    free(regs);
+    return h;
+}
@@ -0,0 +1,69 @@
+#ifndef HLL_H
+#define HLL_H
+/*
+#版权所有 (c) Mhuixs-team 2024
+#许可证协议:
+#任何人或组织在未经版权所有者同意的情况下禁止使用、修改、分发此作品
+start from 2024.11
+Email:hj18914255909@outlook.com
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "bignum.h"  /* 提供 BHS 类型定义 */
+
+/*
+HLL（HyperLogLog 基数估计）使用 BHS 结构：
+- type = BIGNUM_TYPE_HLL
+- 数据总在 data.large_data 中（is_large = 1），复制时共享数据区，写时复制
+- capacity = 分配的字节数
+- length = 稀疏编码下的条目数；平铺编码下为寄存器数 HLL_REGISTERS
+
+元素经 64 位哈希后，低 HLL_P 位选寄存器，其余位中第一个 1 的位置（从 1 起）为秩，
+寄存器保存见过的最大秩。标准误差约 1.04 / sqrt(2^HLL_P) = 0.81%。
+
+编码方式（type_data.hll.encoding）：
+- HLL_ENC_SPARSE：按寄存器下标升序的 uint32 条目，条目 = 下标 << 8 | 秩，只存非 0 寄存器
+- HLL_ENC_DENSE ：2^HLL_P 个 6 位寄存器紧密排列（小端，寄存器 i 占第 6i 到 6i+5 位），12 KB
+稀疏数据超过 HLL_SPARSE_MAX_BYTES 时转为平铺，之后不再转回。
+
+目前 HLL 只作为值使用：Logex 变量、pfadd/pfcount/pfmerge 等内置函数的参数和结果。
+C 层可以用 HOOK_login 挂到钩子上（OBJ_TYPE_HLL），但 VM 的 HOOK 创建和 STATIC 注册
+还是 TODO，NAQL 里还不能按名字创建或取出 HLL 键。
+*/
+#define HLL_P                 14
+#define HLL_REGISTERS         (1 << HLL_P)
+#define HLL_REGISTER_BITS     6
+#define HLL_DENSE_BYTES       (HLL_REGISTERS * HLL_REGISTER_BITS / 8)
+#define HLL_SPARSE_MAX_BYTES  3072
+
+#define HLL_ENC_SPARSE 0
+#define HLL_ENC_DENSE  1
+
+#define HLL_IS_DENSE(h) ((h)->type_data.hll.encoding == HLL_ENC_DENSE)
+
+// 类型检查函数
+int check_if_hll(const BHS* h);
+
+// 构造和析构函数
+BHS* hll_create(void);
+void free_hll(BHS* h);
+
+// 添加元素（PFADD），有寄存器变大时返回 1，否则返回 0，失败返回 -1
+uint64_t hll_hash(const void* data, size_t len);
+int hll_add(BHS* h, const void* data, size_t len);
+int hll_add_hash(BHS* h, uint64_t hash);
+
+// 寄存器是否全部相同（与编码无关），相同返回 1
+int hll_equal(const BHS* a, const BHS* b);
+
+// 基数估计（PFCOUNT），多个时估计并集的基数
+uint64_t hll_count(const BHS* h);
+int hll_count_union(const BHS* const* hs, size_t n, uint64_t* count);
+
+// 合并（PFMERGE）
+int hll_merge_inplace(BHS* dst, const BHS* src);
+BHS* hll_merge(const BHS* const* hs, size_t n);
+
+#endif
@@ -75,6 +75,8 @@ typedef enum {
     OBJ_TYPE_KVALOT = BIGNUM_TYPE_KVALOT,
     OBJ_TYPE_HOOK = BIGNUM_TYPE_HOOK,
     OBJ_TYPE_KEY = BIGNUM_TYPE_KEY,
+    OBJ_TYPE_HLL = BIGNUM_TYPE_HLL,
+    OBJ_TYPE_FILTER = BIGNUM_TYPE_FILTER,
 } obj_type;
 
 /* HOOK 函数声明 */
@@ -1,8 +1,26 @@
 #include "list.h"
+#include <pthread.h>
 #define merr -1
 
+#define INDEX_NONE ((size_t)-1)
+
+// 块目录：slots[lo, hi) 依次为各块，tree 为槽位上的树状数组（下标从 1 起）
+typedef struct ListIndex {
+    Block** slots;
+    size_t* tree;
+    size_t cap; // 槽位数（2 的幂），两端留有空槽供首尾新块使用
+    size_t lo, hi;
+} ListIndex;
+
 // Block 内部辅助函数
-static void locate(const LIST* lst, size_t pos, Block** blk, size_t* offset);
+static Block* block_alloc(uint32_t cap);
+static void block_free(const LIST* lst, Block* blk);
+static int block_own(const LIST* lst, Block* blk);
+static int resize_block(Block* blk, uint32_t cap);
+static int make_room(Block* blk);
+static void shrink_block(Block* blk);
+static void locate(const LIST* lst, size_t pos, Block** blk, size_t* offset, size_t* slot);
+static void index_rebuild(LIST* lst);
 static void center_block(Block* blk);
 static void split_block(LIST* lst, Block* blk);
 static void merge_block(LIST* lst, Block* blk);
@@ -10,22 +28,299 @@ static size_t block_left_space(const Block* blk);
 static size_t block_right_space(const Block* blk);
 static int block_is_centered(const Block* blk);
 
+// 本线程回收的满容量块数据，以 slots[0] 串成单链表，最多 LIST_FREELIST_MAX 个
+static __thread BlockBuf* buf_pool = NULL;
+static __thread size_t buf_pool_len = 0;
+
+// 块数据实现
+static BlockBuf* buf_alloc(uint32_t cap) {
+    BlockBuf* buf;
+    if (cap == UINTDEQUE_BLOCK_SIZE && buf_pool) {
+        buf = buf_pool;
+        buf_pool = (BlockBuf*)buf->slots[0];
+        buf_pool_len--;
+    } else {
+        buf = (BlockBuf*)malloc(sizeof(BlockBuf) + cap * sizeof(Obj));
+        if (!buf) return NULL;
+    }
+    buf->refcount = 1;
+    buf->cap = cap;
+    return buf;
+}
+
+static void buf_free(BlockBuf* buf) {
+    if (buf->cap == UINTDEQUE_BLOCK_SIZE && buf_pool_len < LIST_FREELIST_MAX) {
+        buf->slots[0] = (Obj)buf_pool;
+        buf_pool = buf;
+        buf_pool_len++;
+        return;
+    }
+    free(buf);
+}
+
+// 销毁块数据中 [start, start + size) 的元素并释放块数据
+static void buf_destroy(const LIST* lst, BlockBuf* buf, uint32_t start, uint32_t size) {
+    if (lst->destroy) {
+        for (uint32_t i = 0; i < size; i++) lst->destroy(buf->slots[start + i]);
+    }
+    buf_free(buf);
+}
+
+// 块节点指向新的块数据
+static void block_attach(Block* blk, BlockBuf* buf) {
+    blk->buf = buf;
+    blk->data = buf->slots;
+    blk->cap = buf->cap;
+}
+
 // Block 函数实现
+static Block* block_alloc(uint32_t cap) {
+    Block* blk = (Block*)malloc(sizeof(Block));
+    if (!blk) return NULL;
+    BlockBuf* buf = buf_alloc(cap);
+    if (!buf) {
+        free(blk);
+        return NULL;
+    }
+    block_attach(blk, buf);
+    blk->prev = NULL;
+    blk->next = NULL;
+    blk->size = 0;
+    blk->start = cap / 2;
+    return blk;
+}
+
+// 释放块节点和它对块数据的引用，最后一个引用时销毁其中的元素
+// 元素已经移走的块应先把 size 置 0
+static void block_free(const LIST* lst, Block* blk) {
+    if (__atomic_sub_fetch(&blk->buf->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        buf_destroy(lst, blk->buf, blk->start, blk->size);
+    }
+    free(blk);
+}
+
+// 块数据被共享时复制一份归本列表独有，修改块之前调用；失败返回 merr，块不变
+static int block_own(const LIST* lst, Block* blk) {
+    BlockBuf* old = blk->buf;
+    if (__atomic_load_n(&old->refcount, __ATOMIC_ACQUIRE) == 1) return 0;
+    BlockBuf* buf = buf_alloc(old->cap);
+    if (!buf) return merr;
+    for (uint32_t i = 0; i < blk->size; i++) {
+        Obj value = old->slots[blk->start + i];
+        if (lst->clone) {
+            value = lst->clone(value);
+            if (!value) {
+                buf_destroy(lst, buf, blk->start, i);
+                return merr;
+            }
+        }
+        buf->slots[blk->start + i] = value;
+    }
+    block_attach(blk, buf);
+    // 其他持有者同时也复制走了，原数据不再有人引用
+    if (__atomic_sub_fetch(&old->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        buf_destroy(lst, old, blk->start, blk->size);
+    }
+    return 0;
+}
+
 static size_t block_left_space(const Block* blk) {
     return blk->start;
 }
 
 static size_t block_right_space(const Block* blk) {
-    return UINTDEQUE_BLOCK_SIZE - (blk->start + blk->size);
+    return blk->cap - (blk->start + blk->size);
 }
 
 static int block_is_centered(const Block* blk) {
-    return blk->start >= UINTDEQUE_BLOCK_SIZE / 4 && 
-           (blk->start + blk->size) <= UINTDEQUE_BLOCK_SIZE * 3 / 4;
+    return blk->start >= blk->cap / 4 && 
+           (blk->start + blk->size) <= blk->cap * 3 / 4;
+}
+
+// 把独有的块数据换成容量为 cap 的新块数据，元素居中；失败返回 merr，块不变
+static int resize_block(Block* blk, uint32_t cap) {
+    BlockBuf* buf = buf_alloc(cap);
+    if (!buf) return merr;
+    uint32_t start = (cap - blk->size) / 2;
+    memcpy(&buf->slots[start], &blk->data[blk->start], blk->size * sizeof(Obj));
+    buf_free(blk->buf);
+    block_attach(blk, buf);
+    blk->start = start;
+    return 0;
+}
+
+// 只有一块的列表在两端没有空间时：元素不到一半则居中，否则容量翻倍
+static int make_room(Block* blk) {
+    if (blk->size * 2 <= blk->cap) {
+        center_block(blk);
+        return 0;
+    }
+    uint32_t cap = blk->cap * 2 < UINTDEQUE_BLOCK_SIZE ? blk->cap * 2 : UINTDEQUE_BLOCK_SIZE;
+    return resize_block(blk, cap);
+}
+
+// 只剩一块且元素不到容量的 1/8 时缩小到 1/4，与翻倍之间留有余量，避免反复伸缩
+static void shrink_block(Block* blk) {
+    if (blk->prev || blk->next || blk->cap <= LIST_BLOCK_MIN || blk->size * 8 > blk->cap) return;
+    uint32_t cap = blk->cap / 4 > LIST_BLOCK_MIN ? blk->cap / 4 : LIST_BLOCK_MIN;
+    resize_block(blk, cap);
+}
+
+// 块目录实现
+static void index_free(LIST* lst) {
+    if (!lst->index) return;
+    free(lst->index->slots);
+    free(lst->index->tree);
+    free(lst->index);
+    lst->index = NULL;
+}
+
+// 槽位 slot 的值加 delta（delta 按补码传入，可为负）
+static void index_add(ListIndex* ix, size_t slot, size_t delta) {
+    for (size_t i = slot + 1; i <= ix->cap; i += i & (~i + 1)) ix->tree[i] += delta;
+}
+
+// 找到第 pos 个元素（不计首块）所在槽位，pos 改为块内偏移
+static size_t index_search(const ListIndex* ix, size_t* pos) {
+    size_t i = 0, rem = *pos;
+    for (size_t step = ix->cap; step; step >>= 1) {
+        if (i + step <= ix->cap && ix->tree[i + step] <= rem) {
+            i += step;
+            rem -= ix->tree[i];
+        }
+    }
+    *pos = rem;
+    return i;
+}
+
+// 按当前块链表重建目录，块数不够或分配失败时不建目录
+static void index_rebuild(LIST* lst) {
+    if (lst->nblocks < LIST_INDEX_MIN_BLOCKS) {
+        index_free(lst);
+        return;
+    }
+    size_t cap = 1;
+    while (cap < lst->nblocks * 2) cap <<= 1;
+    ListIndex* ix = lst->index;
+    // 两端各留至少 nblocks / 2 个空槽，首尾新建块时摊还 O(1)
+    if (!ix || ix->cap < cap || ix->cap > cap * 4) {
+        index_free(lst);
+        ix = (ListIndex*)calloc(1, sizeof(ListIndex));
+        if (!ix) return;
+        ix->slots = (Block**)malloc(cap * sizeof(Block*));
+        ix->tree = (size_t*)malloc((cap + 1) * sizeof(size_t));
+        if (!ix->slots || !ix->tree) {
+            free(ix->slots);
+            free(ix->tree);
+            free(ix);
+            return;
+        }
+        ix->cap = cap;
+        lst->index = ix;
+    }
+    ix->lo = (ix->cap - lst->nblocks) / 2;
+    ix->hi = ix->lo;
+    memset(ix->tree, 0, (ix->cap + 1) * sizeof(size_t));
+    for (Block* blk = lst->head_block; blk; blk = blk->next) {
+        ix->slots[ix->hi] = blk;
+        // 首尾块记 0
+        if (blk != lst->head_block && blk != lst->tail_block) ix->tree[ix->hi + 1] = blk->size;
+        ix->hi++;
+    }
+    // 线性建树
+    for (size_t i = 1; i <= ix->cap; i++) {
+        size_t j = i + (i & (~i + 1));
+        if (j <= ix->cap) ix->tree[j] += ix->tree[i];
+    }
+}
+
+// 中间块的元素数变化后更新目录（首尾块和没有目录时 slot 为 INDEX_NONE）
+static void index_resize(LIST* lst, size_t slot, size_t delta) {
+    if (lst->index && slot != INDEX_NONE) index_add(lst->index, slot, delta);
+}
+
+// 新块已接到链表头部：原首块变为中间块
+static void index_push_front(LIST* lst) {
+    ListIndex* ix = lst->index;
+    if (!ix || ix->lo == 0) {
+        index_rebuild(lst);
+        return;
+    }
+    Block* old = ix->slots[ix->lo];
+    index_add(ix, ix->lo, old->size);
+    ix->slots[--ix->lo] = lst->head_block;
+}
+
+// 新块已接到链表尾部：原尾块变为中间块
+static void index_push_back(LIST* lst) {
+    ListIndex* ix = lst->index;
+    if (!ix || ix->hi == ix->cap) {
+        index_rebuild(lst);
+        return;
+    }
+    Block* old = ix->slots[ix->hi - 1];
+    index_add(ix, ix->hi - 1, old->size);
+    ix->slots[ix->hi++] = lst->tail_block;
+}
+
+// 首块已释放：第二块成为首块，在目录中记 0
+static void index_pop_front(LIST* lst) {
+    ListIndex* ix = lst->index;
+    if (!ix) return;
+    if (lst->nblocks < LIST_INDEX_MIN_BLOCKS) {
+        index_free(lst);
+        return;
+    }
+    ix->lo++;
+    index_add(ix, ix->lo, ~(size_t)lst->head_block->size + 1);
+}
+
+// 尾块已释放：倒数第二块成为尾块，在目录中记 0
+static void index_pop_back(LIST* lst) {
+    ListIndex* ix = lst->index;
+    if (!ix) return;
+    if (lst->nblocks < LIST_INDEX_MIN_BLOCKS) {
+        index_free(lst);
+        return;
+    }
+    ix->hi--;
+    index_add(ix, ix->hi - 1, ~(size_t)lst->tail_block->size + 1);
 }
 
 // LIST 内部辅助函数实现
-static void locate(const LIST* lst, size_t pos, Block** blk, size_t* offset) {
+// 定位第 pos 个元素；slot 为所在中间块的目录槽位，首尾块或没有目录时为 INDEX_NONE
+static void locate(const LIST* lst, size_t pos, Block** blk, size_t* offset, size_t* slot) {
+    if (slot) *slot = INDEX_NONE;
+    const ListIndex* ix = lst->index;
+    if (ix) {
+        Block* head = lst->head_block;
+        Block* tail = lst->tail_block;
+        size_t inner = lst->num - head->size - tail->size;
+        if (pos < head->size) {
+            *blk = head;
+        } else if (pos - head->size >= inner) {
+            *blk = tail;
+            pos -= head->size + inner;
+        } else {
+            pos -= head->size;
+            size_t i = index_search(ix, &pos);
+            *blk = ix->slots[i];
+            if (slot) *slot = i;
+        }
+        *offset = pos;
+        return;
+    }
+    // 没有目录时从较近的一端逐块查找
+    if (pos >= lst->num / 2 && lst->tail_block) {
+        size_t rest = lst->num - pos;
+        *blk = lst->tail_block;
+        while ((*blk)->prev && rest > (*blk)->size) {
+            rest -= (*blk)->size;
+            *blk = (*blk)->prev;
+        }
+        *offset = (*blk)->size - rest;
+        return;
+    }
     *blk = lst->head_block;
     while (*blk && pos >= (*blk)->size) {
         pos -= (*blk)->size;
@@ -35,20 +330,19 @@ static void locate(const LIST* lst, size_t pos, Block** blk, size_t* offset) {
 }
 
 static void center_block(Block* blk) {
-    size_t new_start = (UINTDEQUE_BLOCK_SIZE - blk->size) / 2;
-    if (block_is_centered(blk) || new_start + blk->size > UINTDEQUE_BLOCK_SIZE) return;
+    size_t new_start = (blk->cap - blk->size) / 2;
+    if (block_is_centered(blk) || new_start + blk->size > blk->cap) return;
     memmove(&blk->data[new_start], &blk->data[blk->start], blk->size * sizeof(Obj));
     blk->start = new_start;
 }
 
 static void split_block(LIST* lst, Block* blk) {
-    if (blk->size < UINTDEQUE_BLOCK_SIZE) return;
+    if (blk->size < blk->cap) return;
     size_t mid = blk->size / 2;
-    Block* new_blk = (Block*)calloc(1, sizeof(Block));
+    Block* new_blk = block_alloc(blk->cap);
     if (!new_blk) return;
     new_blk->size = blk->size - mid;
-    new_blk->start = (UINTDEQUE_BLOCK_SIZE - new_blk->size) / 2;
-    if (new_blk->start + new_blk->size > UINTDEQUE_BLOCK_SIZE) new_blk->start = 0;
+    new_blk->start = (new_blk->cap - new_blk->size) / 2;
     memcpy(&new_blk->data[new_blk->start], &blk->data[blk->start + mid], new_blk->size * sizeof(Obj));
     new_blk->prev = blk;
     new_blk->next = blk->next;
@@ -56,14 +350,17 @@ static void split_block(LIST* lst, Block* blk) {
     blk->next = new_blk;
     if (lst->tail_block == blk) lst->tail_block = new_blk;
     blk->size = mid;
+    lst->nblocks++;
     center_block(blk);
     center_block(new_blk);
+    index_rebuild(lst);
 }
 
 static void merge_block(LIST* lst, Block* blk) {
     if (!blk->next) return;
     Block* nxt = blk->next;
-    if (blk->size + nxt->size > UINTDEQUE_BLOCK_SIZE) return;
+    if (blk->size + nxt->size > blk->cap) return;
+    if (block_own(lst, blk) != 0 || block_own(lst, nxt) != 0) return;
     memmove(&blk->data[0], &blk->data[blk->start], blk->size * sizeof(Obj));
     memcpy(&blk->data[blk->size], &nxt->data[nxt->start], nxt->size * sizeof(Obj));
     blk->start = 0;
@@ -72,7 +369,15 @@ static void merge_block(LIST* lst, Block* blk) {
     if (nxt->next) nxt->next->prev = blk;
     if (lst->tail_block == nxt) lst->tail_block = blk;
     center_block(blk);
-    free(nxt);
+    nxt->size = 0; // 元素已移入 blk
+    block_free(lst, nxt);
+    lst->nblocks--;
+    index_rebuild(lst);
+}
+
+// 逻辑位置换算为块链表中的物理位置
+static size_t phys_pos(const LIST* lst, size_t pos) {
+    return lst->reversed ? lst->num - 1 - pos : pos;
 }
 
 // LIST 公共函数实现
@@ -82,6 +387,10 @@ LIST* list_create(void) {
     lst->head_block = NULL;
     lst->tail_block = NULL;
     lst->num = 0;
+    lst->refcount = 1;
+    lst->nblocks = 0;
+    lst->index = NULL;
+    lst->reversed = 0;
     return lst;
 }
 
@@ -90,27 +399,46 @@ LIST* list_copy(const LIST* other) {
     LIST* lst = list_create();
     if (!lst) return NULL;
     
+    lst->clone = other->clone;
+    lst->destroy = other->destroy;
+    lst->reversed = other->reversed;
+    // 只复制节点，块数据共享
     Block* cur = other->head_block;
     while (cur) {
-        Block* blk = (Block*)calloc(1, sizeof(Block));
+        Block* blk = (Block*)malloc(sizeof(Block));
         if (!blk) {
             free_list(lst);
             return NULL;
         }
-        blk->size = cur->size;
-        blk->start = cur->start;
-        memcpy(&blk->data[0], &cur->data[0], sizeof(Obj) * UINTDEQUE_BLOCK_SIZE);
-        blk->prev = lst->tail_block;
+        *blk = *cur;
+        __atomic_add_fetch(&cur->buf->refcount, 1, __ATOMIC_RELAXED);
         blk->next = NULL;
+        blk->prev = lst->tail_block;
         if (lst->tail_block) lst->tail_block->next = blk;
         else lst->head_block = blk;
         lst->tail_block = blk;
+        lst->nblocks++;
         cur = cur->next;
     }
     lst->num = other->num;
+    index_rebuild(lst);
     return lst;
 }
 
+void list_set_elem_ops(LIST* lst, list_clone_fn clone, list_free_fn destroy) {
+    if (!lst) return;
+    lst->clone = clone;
+    lst->destroy = destroy;
+}
+
+int list_unshare(LIST* lst) {
+    if (!lst) return merr;
+    for (Block* blk = lst->head_block; blk; blk = blk->next) {
+        if (block_own(lst, blk) != 0) return merr;
+    }
+    return 0;
+}
+
 void free_list(LIST* lst) {
     if (!lst) return;
     list_clear(lst);
@@ -122,32 +450,39 @@ void list_clear(LIST* lst) {
     Block* cur = lst->head_block;
     while (cur) {
         Block* nxt = cur->next;
-        free(cur);
+        block_free(lst, cur);
         cur = nxt;
     }
     lst->head_block = NULL;
     lst->tail_block = NULL;
     lst->num = 0;
+    lst->nblocks = 0;
+    lst->reversed = 0;
+    index_free(lst);
 }
 
 size_t list_size(const LIST* lst) {
     return lst ? lst->num : 0;
 }
 
-int list_lpush(LIST* lst, Obj value) {
+static int push_front(LIST* lst, Obj value) {
     if (!lst) return merr;
+    // 只有一个未满容量的块时先在块内腾出空间
+    if (lst->head_block && block_left_space(lst->head_block) == 0 && lst->head_block->cap < UINTDEQUE_BLOCK_SIZE) {
+        if (block_own(lst, lst->head_block) != 0 || make_room(lst->head_block) != 0) return merr;
+    }
     // 如果没有头块或头块左边没有空间，创建新块
     if (!lst->head_block || block_left_space(lst->head_block) == 0) {
-        Block* blk = (Block*)calloc(1, sizeof(Block));
+        Block* blk = block_alloc(lst->head_block ? UINTDEQUE_BLOCK_SIZE : LIST_BLOCK_MIN);
         if (!blk) return merr;
-        blk->size = 0;
-        blk->start = UINTDEQUE_BLOCK_SIZE / 2;
-        blk->prev = NULL;
         blk->next = lst->head_block;
         if (lst->head_block) lst->head_block->prev = blk;
         lst->head_block = blk;
         if (!lst->tail_block) lst->tail_block = blk;
+        lst->nblocks++;
+        index_push_front(lst);
     }
+    if (block_own(lst, lst->head_block) != 0) return merr;
     // 如果左边还是没空间，尝试居中或分裂
     if (block_left_space(lst->head_block) == 0) {
         center_block(lst->head_block);
@@ -164,20 +499,24 @@ int list_lpush(LIST* lst, Obj value) {
     return 0;
 }
 
-int list_rpush(LIST* lst, Obj value) {
+static int push_back(LIST* lst, Obj value) {
     if (!lst) return merr;
+    // 只有一个未满容量的块时先在块内腾出空间
+    if (lst->tail_block && block_right_space(lst->tail_block) == 0 && lst->tail_block->cap < UINTDEQUE_BLOCK_SIZE) {
+        if (block_own(lst, lst->tail_block) != 0 || make_room(lst->tail_block) != 0) return merr;
+    }
     // 如果没有尾块或尾块右边没有空间，创建新块
     if (!lst->tail_block || block_right_space(lst->tail_block) == 0) {
-        Block* blk = (Block*)calloc(1, sizeof(Block));
+        Block* blk = block_alloc(lst->tail_block ? UINTDEQUE_BLOCK_SIZE : LIST_BLOCK_MIN);
         if (!blk) return merr;
-        blk->size = 0;
-        blk->start = UINTDEQUE_BLOCK_SIZE / 2;
-        blk->next = NULL;
         blk->prev = lst->tail_block;
         if (lst->tail_block) lst->tail_block->next = blk;
         lst->tail_block = blk;
         if (!lst->head_block) lst->head_block = blk;
+        lst->nblocks++;
+        index_push_back(lst);
     }
+    if (block_own(lst, lst->tail_block) != 0) return merr;
     // 如果右边还是没空间，尝试居中或分裂
     if (block_right_space(lst->tail_block) == 0) {
         center_block(lst->tail_block);
@@ -193,8 +532,9 @@ int list_rpush(LIST* lst, Obj value) {
     return 0;
 }
 
-Obj list_lpop(LIST* lst) {
+static Obj pop_front(LIST* lst) {
     if (!lst || !lst->num) return (Obj)(intptr_t)merr;
+    if (block_own(lst, lst->head_block) != 0) return (Obj)(intptr_t)merr;
     Obj ret = lst->head_block->data[lst->head_block->start];
     lst->head_block->start++;
     lst->head_block->size--;
@@ -204,15 +544,20 @@ Obj list_lpop(LIST* lst) {
         lst->head_block = lst->head_block->next;
         if (lst->head_block) lst->head_block->prev = NULL;
         else lst->tail_block = NULL;
-        free(old);
+        block_free(lst, old);
+        lst->nblocks--;
+        index_pop_front(lst);
     } else if (lst->head_block->size < MIN_BLOCK_SIZE && lst->head_block->next) {
         merge_block(lst, lst->head_block);
+    } else {
+        shrink_block(lst->head_block);
     }
     return ret;
 }
 
-Obj list_rpop(LIST* lst) {
+static Obj pop_back(LIST* lst) {
     if (!lst || !lst->num) return (Obj)(intptr_t)merr;
+    if (block_own(lst, lst->tail_block) != 0) return (Obj)(intptr_t)merr;
     Obj ret = lst->tail_block->data[lst->tail_block->start + lst->tail_block->size - 1];
     lst->tail_block->size--;
     lst->num--;
@@ -221,26 +566,36 @@ Obj list_rpop(LIST* lst) {
         lst->tail_block = lst->tail_block->prev;
         if (lst->tail_block) lst->tail_block->next = NULL;
         else lst->head_block = NULL;
-        free(old);
+        block_free(lst, old);
+        lst->nblocks--;
+        index_pop_back(lst);
     } else if (lst->tail_block->size < MIN_BLOCK_SIZE && lst->tail_block->prev) {
         merge_block(lst, lst->tail_block->prev);
+    } else {
+        shrink_block(lst->tail_block);
     }
     return ret;
 }
 
 int list_insert(LIST* lst, size_t pos, Obj value) {
     if (!lst || pos > lst->num) return merr;
-    if (pos == 0) return list_lpush(lst, value);
-    if (pos == lst->num) return list_rpush(lst, value);
+    // 反转时新元素的物理位置为 num - pos
+    if (lst->reversed) pos = lst->num - pos;
+    if (pos == 0) return push_front(lst, value);
+    if (pos == lst->num) return push_back(lst, value);
     Block* blk;
-    size_t offset;
-    locate(lst, pos, &blk, &offset);
-    if (!blk) return merr;
-    if (blk->size == UINTDEQUE_BLOCK_SIZE || block_left_space(blk) == 0 || block_right_space(blk) == 0) {
+    size_t offset, slot;
+    locate(lst, pos, &blk, &offset, &slot);
+    if (!blk || block_own(lst, blk) != 0) return merr;
+    if (blk->size == blk->cap || block_left_space(blk) == 0 || block_right_space(blk) == 0) {
         center_block(blk);
-        if (blk->size == UINTDEQUE_BLOCK_SIZE || block_left_space(blk) == 0 || block_right_space(blk) == 0) {
+        if (blk->cap < UINTDEQUE_BLOCK_SIZE && (blk->size == blk->cap || block_left_space(blk) == 0 || block_right_space(blk) == 0)) {
+            // 未满容量的块（只有一块时）先翻倍
+            if (make_room(blk) != 0) return merr;
+        }
+        if (blk->size == blk->cap || block_left_space(blk) == 0 || block_right_space(blk) == 0) {
             split_block(lst, blk);
-            locate(lst, pos, &blk, &offset);
+            locate(lst, pos, &blk, &offset, &slot);
             if (!blk) return merr;
         }
     }
@@ -258,15 +613,17 @@ int list_insert(LIST* lst, size_t pos, Obj value) {
     }
     blk->size++;
     lst->num++;
+    index_resize(lst, slot, 1);
     return 0;
 }
 
 int list_rm_index(LIST* lst, size_t pos) {
     if (!lst || pos >= lst->num) return merr;
     Block* blk;
-    size_t offset;
-    locate(lst, pos, &blk, &offset);
-    if (!blk) return merr;
+    size_t offset, slot;
+    locate(lst, phys_pos(lst, pos), &blk, &offset, &slot);
+    if (!blk || block_own(lst, blk) != 0) return merr;
+    if (lst->destroy) lst->destroy(blk->data[blk->start + offset]);
     if (offset < blk->size / 2) {
         memmove(&blk->data[blk->start + 1], &blk->data[blk->start], offset * sizeof(Obj));
         blk->start++;
@@ -275,23 +632,48 @@ int list_rm_index(LIST* lst, size_t pos) {
     }
     blk->size--;
     lst->num--;
+    index_resize(lst, slot, (size_t)-1);
     if (blk->size == 0) {
         if (blk->prev) blk->prev->next = blk->next;
         if (blk->next) blk->next->prev = blk->prev;
         if (lst->head_block == blk) lst->head_block = blk->next;
         if (lst->tail_block == blk) lst->tail_block = blk->prev;
-        free(blk);
+        block_free(lst, blk);
+        lst->nblocks--;
+        index_rebuild(lst);
     } else if (blk->size < MIN_BLOCK_SIZE && blk->next) {
         merge_block(lst, blk);
+    } else {
+        shrink_block(blk);
     }
     return 0;
 }
 
+int list_lpush(LIST* lst, Obj value) {
+    if (!lst) return merr;
+    return lst->reversed ? push_back(lst, value) : push_front(lst, value);
+}
+
+int list_rpush(LIST* lst, Obj value) {
+    if (!lst) return merr;
+    return lst->reversed ? push_front(lst, value) : push_back(lst, value);
+}
+
+Obj list_lpop(LIST* lst) {
+    if (!lst) return (Obj)(intptr_t)merr;
+    return lst->reversed ? pop_back(lst) : pop_front(lst);
+}
+
+Obj list_rpop(LIST* lst) {
+    if (!lst) return (Obj)(intptr_t)merr;
+    return lst->reversed ? pop_front(lst) : pop_back(lst);
+}
+
 Obj list_get_index(const LIST* lst, size_t pos) {
     if (!lst || pos >= lst->num) return (Obj)(intptr_t)merr;
     Block* blk;
     size_t offset;
-    locate(lst, pos, &blk, &offset);
+    locate(lst, phys_pos(lst, pos), &blk, &offset, NULL);
     if (!blk) return (Obj)(intptr_t)merr;
     return blk->data[blk->start + offset];
 }
@@ -300,8 +682,9 @@ int list_set_index(LIST* lst, size_t pos, Obj value) {
     if (!lst || pos >= lst->num) return merr;
     Block* blk;
     size_t offset;
-    locate(lst, pos, &blk, &offset);
-    if (!blk) return merr;
+    locate(lst, phys_pos(lst, pos), &blk, &offset, NULL);
+    if (!blk || block_own(lst, blk) != 0) return merr;
+    if (lst->destroy) lst->destroy(blk->data[blk->start + offset]);
     blk->data[blk->start + offset] = value;
     return 0;
 }
@@ -313,12 +696,257 @@ int list_swap(LIST* lst, size_t idx1, size_t idx2) {
     size_t offset1;
     Block* blk2;
     size_t offset2;
-    locate(lst, idx1, &blk1, &offset1);
-    locate(lst, idx2, &blk2, &offset2);
+    locate(lst, phys_pos(lst, idx1), &blk1, &offset1, NULL);
+    locate(lst, phys_pos(lst, idx2), &blk2, &offset2, NULL);
     if (!blk1 || !blk2) return merr;
+    if (block_own(lst, blk1) != 0 || block_own(lst, blk2) != 0) return merr;
     Obj temp = blk1->data[blk1->start + offset1];
     blk1->data[blk1->start + offset1] = blk2->data[blk2->start + offset2];
     blk2->data[blk2->start + offset2] = temp;
     return 0;
 }
 
+// 排序、去重和反转
+void list_reverse(LIST* lst) {
+    if (lst) lst->reversed = !lst->reversed;
+}
+
+// 按逻辑顺序取出全部元素，调用前块应已独有
+static Obj* list_gather(const LIST* lst) {
+    Obj* arr = (Obj*)malloc((lst->num ? lst->num : 1) * sizeof(Obj));
+    if (!arr) return NULL;
+    ListIter it;
+    Obj* span;
+    size_t k = 0, n;
+    list_iter_range(lst, 0, lst->num, &it);
+    while ((n = list_iter_next(&it, &span)) > 0) {
+        if (it.reversed) {
+            for (size_t i = 0; i < n; i++) arr[k + i] = span[n - 1 - i];
+        } else {
+            memcpy(&arr[k], span, n * sizeof(Obj));
+        }
+        k += n;
+    }
+    return arr;
+}
+
+// 把 arr 的前 n 个元素按块链表顺序写回，各块大小不变，多出的块释放；之后不再反转
+static void list_scatter(LIST* lst, const Obj* arr, size_t n) {
+    size_t k = 0;
+    Block* blk = lst->head_block;
+    while (blk && k < n) {
+        if (blk->size > n - k) blk->size = n - k;
+        memcpy(&blk->data[blk->start], &arr[k], blk->size * sizeof(Obj));
+        k += blk->size;
+        blk = blk->next;
+    }
+    if (blk) {
+        lst->tail_block = blk->prev;
+        if (blk->prev) blk->prev->next = NULL;
+        else lst->head_block = NULL;
+        while (blk) {
+            Block* nxt = blk->next;
+            blk->size = 0; // 元素已移走
+            block_free(lst, blk);
+            lst->nblocks--;
+            blk = nxt;
+        }
+    }
+    lst->num = n;
+    lst->reversed = 0;
+    index_rebuild(lst);
+}
+
+typedef struct {
+    list_cmp_fn cmp;
+    int desc;
+    Obj* a;      // 待排序数组
+    Obj* tmp;    // 同样大小的辅助区
+    size_t lo, mid, hi;
+} SortTask;
+
+// b 严格排在 a 之前
+static int sort_before(const SortTask* t, Obj b, Obj a) {
+    int c = t->cmp(b, a);
+    return t->desc ? c > 0 : c < 0;
+}
+
+// 合并 src 中相邻的有序段 [lo, mid) 和 [mid, hi) 到 dst，相等时取左段，保证稳定
+static void sort_merge(const SortTask* t, const Obj* src, Obj* dst, size_t lo, size_t mid, size_t hi) {
+    size_t i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) dst[k++] = sort_before(t, src[j], src[i]) ? src[j++] : src[i++];
+    memcpy(&dst[k], &src[i], (mid - i) * sizeof(Obj));
+    k += mid - i;
+    memcpy(&dst[k], &src[j], (hi - j) * sizeof(Obj));
+}
+
+// 把 src[lo, hi) 排好序放到 dst[lo, hi)，两者开始时内容相同；短段用插入排序
+// 自顶向下递归，子问题先在缓存内排好，比逐轮扫过整个数组的自底向上归并快
+static void sort_split(const SortTask* t, Obj* src, Obj* dst, size_t lo, size_t hi) {
+    if (hi - lo <= LIST_SORT_RUN) {
+        for (size_t i = lo + 1; i < hi; i++) {
+            Obj v = dst[i];
+            size_t j = i;
+            while (j > lo && sort_before(t, v, dst[j - 1])) {
+                dst[j] = dst[j - 1];
+                j--;
+            }
+            dst[j] = v;
+        }
+        return;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    sort_split(t, dst, src, lo, mid);
+    sort_split(t, dst, src, mid, hi);
+    sort_merge(t, src, dst, lo, mid, hi);
+}
+
+// 对 a[lo, hi) 归并排序，tmp 为同样大小的辅助区
+static void sort_range(const SortTask* t) {
+    memcpy(&t->tmp[t->lo], &t->a[t->lo], (t->hi - t->lo) * sizeof(Obj));
+    sort_split(t, t->tmp, t->a, t->lo, t->hi);
+}
+
+static void* sort_range_worker(void* arg) {
+    sort_range((const SortTask*)arg);
+    return NULL;
+}
+
+static void* sort_merge_worker(void* arg) {
+    const SortTask* t = (const SortTask*)arg;
+    sort_merge(t, t->a, t->tmp, t->lo, t->mid, t->hi);
+    memcpy(&t->a[t->lo], &t->tmp[t->lo], (t->hi - t->lo) * sizeof(Obj));
+    return NULL;
+}
+
+// 在 n 个任务上并行执行 fn：除第一个外各开一个线程，创建失败时在当前线程执行
+static void sort_run(void* (*fn)(void*), SortTask* tasks, size_t n) {
+    pthread_t tids[LIST_SORT_MAX_THREADS];
+    int started[LIST_SORT_MAX_THREADS];
+    for (size_t i = 1; i < n; i++) {
+        started[i] = pthread_create(&tids[i], NULL, fn, &tasks[i]) == 0;
+        if (!started[i]) fn(&tasks[i]);
+    }
+    fn(&tasks[0]);
+    for (size_t i = 1; i < n; i++) {
+        if (started[i]) pthread_join(tids[i], NULL);
+    }
+}
+
+int list_sort(LIST* lst, list_cmp_fn cmp, int desc, int nthreads) {
+    if (!lst || !cmp) return merr;
+    if (lst->num < 2) {
+        lst->reversed = 0;
+        return 0;
+    }
+    if (list_unshare(lst) != 0) return merr;
+    size_t n = lst->num;
+    Obj* a = list_gather(lst);
+    Obj* tmp = (Obj*)malloc(n * sizeof(Obj));
+    if (!a || !tmp) {
+        free(a);
+        free(tmp);
+        return merr;
+    }
+    // 每个线程至少分到 LIST_SORT_PAR_MIN 个元素
+    size_t nt = nthreads > 1 ? (size_t)nthreads : 1;
+    if (nt > LIST_SORT_MAX_THREADS) nt = LIST_SORT_MAX_THREADS;
+    if (nt > n / LIST_SORT_PAR_MIN) nt = n / LIST_SORT_PAR_MIN ? n / LIST_SORT_PAR_MIN : 1;
+    SortTask tasks[LIST_SORT_MAX_THREADS];
+    size_t bound[LIST_SORT_MAX_THREADS + 1];
+    for (size_t i = 0; i <= nt; i++) bound[i] = n * i / nt;
+    for (size_t i = 0; i < nt; i++) {
+        tasks[i] = (SortTask){cmp, desc, a, tmp, bound[i], bound[i], bound[i + 1]};
+    }
+    sort_run(sort_range_worker, tasks, nt);
+    // 相邻有序段两两合并，每轮段数减半
+    while (nt > 1) {
+        size_t m = 0;
+        for (size_t i = 0; i + 1 < nt; i += 2) {
+            tasks[m++] = (SortTask){cmp, desc, a, tmp, bound[i], bound[i + 1], bound[i + 2]};
+        }
+        sort_run(sort_merge_worker, tasks, m);
+        for (size_t i = 0; i < m; i++) bound[i] = bound[2 * i];
+        if (nt % 2) bound[m++] = bound[nt - 1];
+        bound[m] = n;
+        nt = m;
+    }
+    list_scatter(lst, a, n);
+    free(a);
+    free(tmp);
+    return 0;
+}
+
+int list_unique(LIST* lst, list_hash_fn hash, list_eq_fn eq) {
+    if (!lst || !hash || !eq) return merr;
+    if (lst->num < 2) return 0;
+    if (list_unshare(lst) != 0) return merr;
+    size_t n = lst->num;
+    size_t cap = 16;
+    while (cap < n * 2) cap <<= 1;
+    Obj* a = list_gather(lst);
+    uint64_t* hs = (uint64_t*)malloc(n * sizeof(uint64_t));
+    size_t* table = (size_t*)malloc(cap * sizeof(size_t));
+    if (!a || !hs || !table) {
+        free(a);
+        free(hs);
+        free(table);
+        return merr;
+    }
+    memset(table, 0xff, cap * sizeof(size_t));
+    // 开放寻址表中存保留元素的下标，保留的元素原地前移
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t h = hash(a[i]);
+        size_t p = (size_t)h & (cap - 1);
+        while (table[p] != INDEX_NONE && !(hs[table[p]] == h && eq(a[table[p]], a[i]))) p = (p + 1) & (cap - 1);
+        if (table[p] != INDEX_NONE) {
+            if (lst->destroy) lst->destroy(a[i]);
+            continue;
+        }
+        table[p] = m;
+        hs[m] = h;
+        a[m++] = a[i];
+    }
+    list_scatter(lst, a, m);
+    free(a);
+    free(hs);
+    free(table);
+    return 0;
+}
+
+// 范围迭代器
+int list_iter_range(const LIST* lst, size_t start, size_t end, ListIter* it) {
+    if (!it) return merr;
+    it->blk = NULL;
+    it->offset = 0;
+    it->remain = 0;
+    it->reversed = 0;
+    if (!lst) return merr;
+    if (end > lst->num) end = lst->num;
+    if (start >= end) return 0;
+    it->reversed = lst->reversed;
+    it->remain = end - start;
+    // 反转时从逻辑起点对应的物理位置向块链表头部方向走
+    locate(lst, phys_pos(lst, start), &it->blk, &it->offset, NULL);
+    return it->blk ? 0 : merr;
+}
+
+size_t list_iter_next(ListIter* it, Obj** span) {
+    if (!it || !it->remain || !it->blk) return 0;
+    Block* blk = it->blk;
+    size_t n;
+    if (it->reversed) {
+        n = it->offset + 1 < it->remain ? it->offset + 1 : it->remain;
+        *span = &blk->data[blk->start + it->offset + 1 - n];
+        it->blk = blk->prev;
+        it->offset = it->blk ? it->blk->size - 1 : 0;
+    } else {
+        n = blk->size - it->offset < it->remain ? blk->size - it->offset : it->remain;
+        *span = &blk->data[blk->start + it->offset];
+        it->blk = blk->next;
+        it->offset = 0;
+    }
+    it->remain -= n;
+    return n;
+}
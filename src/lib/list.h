@@ -18,24 +18,80 @@ Email:hj18914255909@outlook.com
 /* 内部使用 Obj 作为 void* 别名，减少代码改动 */
 #define UINTDEQUE_BLOCK_SIZE 4096 // 每块最大元素数
 #define MIN_BLOCK_SIZE 512 // 块合并的最小阈值
+#define LIST_BLOCK_MIN 8 // 新列表首块的容量，只有一块时按 2 倍增长到 UINTDEQUE_BLOCK_SIZE
+#define LIST_FREELIST_MAX 16 // 每个线程缓存的回收满容量块数
+#define LIST_SORT_RUN 32 // 排序时先插入排序的段长
+#define LIST_SORT_PAR_MIN 65536 // 并行排序时每个线程至少分到的元素数
+#define LIST_SORT_MAX_THREADS 64 // 排序线程数上限
+#define LIST_INDEX_MIN_BLOCKS 8 // 块数达到该值时建立块目录，按位置定位为 O(log n)
 
 
+/*
+块容量可变：列表只有一块时从 LIST_BLOCK_MIN 起按需翻倍（元素少时也会缩小），
+满 UINTDEQUE_BLOCK_SIZE 后才在两端新建块，因此多块列表中的块都是满容量的。
+短列表只占几十到几百字节，而不是整块的 32 KB。
+
+块分为链表节点（Block，每个列表各自一份）和块数据（BlockBuf，可被多个列表共享）。
+list_copy 只新建节点并增加块数据的引用计数，为 O(块数)；任一方修改某块
+（push/pop/insert/rm/set/swap 以及居中、分裂、合并）之前先复制该块的数据（写时复制），
+复制时用列表的 clone 复制元素。共享的块数据在各列表中的 start/size 总是相同，
+因为改变它们之前都要先复制。块数据的最后一个引用释放时用 destroy 销毁其中的元素。
+*/
+typedef struct BlockBuf {
+    uint32_t refcount; // 共享该数据的块数
+    uint32_t cap;      // 容量（元素数）
+    Obj slots[];
+} BlockBuf;
+
 typedef struct Block {
-    Obj data[UINTDEQUE_BLOCK_SIZE];
     struct Block *prev, *next;
     uint32_t size;  // 当前块内元素数
     uint32_t start; // 块内数据起始下标（data[start]为第一个元素）
+    uint32_t cap;   // 块容量（元素数），等于 buf->cap
+    Obj* data;      // 指向 buf->slots
+    BlockBuf* buf;
 } Block;
 
-typedef struct {
+/*
+元素的复制和销毁函数：clone 失败返回 NULL。
+设置后列表拥有其中的元素：list_rm_index、list_set_index 和释放列表时销毁被移除、替换的元素，
+lpop/rpop 把元素交给调用者，list_get_index 返回的元素只在下次修改列表前有效。
+都为 NULL（默认）时列表不管理元素，写时复制只复制指针，也不销毁元素。
+*/
+typedef Obj (*list_clone_fn)(Obj value);
+typedef void (*list_free_fn)(Obj value);
+
+// 排序比较（a 在前返回负数，相等返回 0）、去重用的哈希和相等判断
+typedef int (*list_cmp_fn)(Obj a, Obj b);
+typedef uint64_t (*list_hash_fn)(Obj value);
+typedef int (*list_eq_fn)(Obj a, Obj b);
+
+/*
+块目录（ListIndex）：按顺序存放各块指针，并用树状数组维护中间各块的元素数，
+按位置定位时先比较首尾块，再在树状数组上二分，为 O(log 块数)。
+首尾块在树状数组中记 0，两端 push/pop 只改首尾块的 size，不需要更新目录。
+在两端新建或释放块时增量更新，分裂、合并或中间块释放时整体重建。
+目录只是加速结构，分配失败时退回逐块查找。
+*/
+struct ListIndex;
+
+typedef struct LIST { // 带标签，与 bignum.h 中的前向声明 struct LIST 是同一类型
     Block* head_block;
     Block* tail_block;
     size_t num; // 总元素数
+    size_t refcount; // 引用计数（BHS 写时复制共享），list_create/list_copy 置为 1
+    size_t nblocks; // 块数
+    struct ListIndex* index; // 块目录，块数少于 LIST_INDEX_MIN_BLOCKS 时为 NULL
+    list_clone_fn clone; // 元素复制函数，list_copy 时继承
+    list_free_fn destroy; // 元素销毁函数，list_copy 时继承
+    int reversed; // 逻辑顺序与块链表顺序相反（list_reverse），第 pos 个元素在物理位置 num - 1 - pos
 } LIST;
 
 // LIST 函数（对外接口使用 BHS*）
 LIST* list_create(void);
-LIST* list_copy(const LIST* other);
+LIST* list_copy(const LIST* other); // 与 other 共享块数据，写时复制
+void list_set_elem_ops(LIST* lst, list_clone_fn clone, list_free_fn destroy);
+int list_unshare(LIST* lst); // 立即复制所有共享的块数据
 void free_list(LIST* lst);
 void list_clear(LIST* lst);
 size_t list_size(const LIST* lst);
@@ -49,5 +105,33 @@ Obj list_get_index(const LIST* lst, size_t pos);
 int list_set_index(LIST* lst, size_t pos, Obj value);
 int list_swap(LIST* lst, size_t idx1, size_t idx2);
 
+/*
+SORT / UNIQUE / REVERSE：
+- list_reverse 只翻转方向标记，O(1)，之后的按位置操作和两端操作都按反转后的顺序
+- list_sort 稳定归并排序：取出全部元素后分成 nthreads 段并行排序，再两两并行合并，
+  写回原有的块；desc 非 0 时降序
+- list_unique 按哈希去重，保留每个值第一次出现的位置，重复的元素用 destroy 销毁
+排序和去重先复制共享的块，之后方向标记清零。
+*/
+void list_reverse(LIST* lst);
+int list_sort(LIST* lst, list_cmp_fn cmp, int desc, int nthreads);
+int list_unique(LIST* lst, list_hash_fn hash, list_eq_fn eq);
+
+/*
+范围迭代器：按逻辑顺序遍历第 start 到 end - 1 个元素，每次给出一个块内的连续一段，不复制。
+span 指向该段中地址最低的元素；reversed 非 0（列表已反转）时段内逻辑顺序为
+span[n - 1], span[n - 2], ..., span[0]，各段之间仍按逻辑顺序给出。
+迭代期间不能修改列表。
+*/
+typedef struct {
+    Block* blk;     // 下一段所在的块
+    size_t offset;  // 下一段在块内的起点（反转时为终点）
+    size_t remain;  // 剩余元素数
+    int reversed;
+} ListIter;
+
+int list_iter_range(const LIST* lst, size_t start, size_t end, ListIter* it); // end 超过长度时截断
+size_t list_iter_next(ListIter* it, Obj** span); // 返回本段元素数，遍历完返回 0
+
 #endif
 
@@ -222,7 +222,7 @@ static inline BHS* bhs_from_mstr(mstring str){
     } else {
         bhs->is_large = 1;
         bhs->capacity = len;
-        bhs->data.large_data = (char*)malloc(len);
+        bhs->data.large_data = bignum_payload_alloc(len);
         if(!bhs->data.large_data){
             free(bhs);
             return NULL;
@@ -0,0 +1,1590 @@
+#include "roaring.h"
+#include "bitmap.h"  /* 字级运算与计数内核 */
+
+#include <stdlib.h>
+#include <string.h>
+/*
+#版权所有 (c) Mhuixs-team 2024
+#许可证协议:
+#任何人或组织在未经版权所有者同意的情况下禁止使用、修改、分发此作品
+start from 2024.11
+Email:hj18914255909@outlook.com
+*/
+#define merr -1
+
+#define CHUNK_BYTES (ROARING_CHUNK_WORDS * 8)   /* 一个块平铺时的字节数 */
+
+/* 一个编码好的容器（数据另存） */
+typedef struct {
+    uint16_t type;
+    uint32_t bytes;
+    uint32_t card;
+} rcont;
+
+// ============================================================================
+// 内部辅助函数
+// ============================================================================
+
+static inline roaring_header* r_header(const BHS* bm) {
+    return (roaring_header*)bm->data.large_data;
+}
+
+static inline roaring_entry* r_entries(const roaring_header* h) {
+    return (roaring_entry*)((uint8_t*)h + sizeof(roaring_header));
+}
+
+/* 数据区紧跟在目录之后，目录扩容时整体后移 */
+static inline uint8_t* r_data(const roaring_header* h) {
+    return (uint8_t*)h + sizeof(roaring_header) + h->entry_cap * sizeof(roaring_entry);
+}
+
+static inline uint8_t* r_cdata(const roaring_header* h, const roaring_entry* e) {
+    return r_data(h) + e->offset;
+}
+
+static inline uint32_t round8(uint32_t n) {
+    return (n + 7) & ~7u;
+}
+
+/* 平铺数据按 64 位字读写时的字节序转换（位 i 对应字内第 i % 64 位） */
+static inline uint64_t word_from_le(uint64_t w) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(w);
+#else
+    return w;
+#endif
+}
+
+/**
+ * 二分查找 key 所在的容器
+ * @return 1 找到（*idx 为下标），0 未找到（*idx 为插入位置）
+ */
+static int r_find(const roaring_header* h, uint64_t key, uint64_t* idx) {
+    const roaring_entry* e = r_entries(h);
+    uint64_t lo = 0, hi = h->count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (e[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    *idx = lo;
+    return lo < h->count && e[lo].key == key;
+}
+
+/* 升序 uint16 数组中第一个 >= v 的下标（v 可以是 65536） */
+static uint32_t array_lower_bound(const uint16_t* a, uint32_t n, uint32_t v) {
+    uint32_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (a[mid] < v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// ============================================================================
+// 块内位图（1024 个 uint64）
+// ============================================================================
+
+static uint32_t bs_card(const uint64_t* w) {
+    return (uint32_t)bitmap_words_popcount((const uint8_t*)w, ROARING_CHUNK_WORDS);
+}
+
+/* 连续 1 段的个数：每个前一位为 0 的 1 是一段的起点 */
+static uint32_t bs_runs(const uint64_t* w) {
+    uint32_t runs = 0;
+    uint64_t carry = 0;
+    for (int i = 0; i < ROARING_CHUNK_WORDS; i++) {
+        uint64_t starts = w[i] & ~((w[i] << 1) | carry);
+        runs += (uint32_t)__builtin_popcountll(starts);
+        carry = w[i] >> 63;
+    }
+    return runs;
+}
+
+/* 把 [lo, hi] 闭区间置为 value */
+static void bs_fill(uint64_t* w, uint32_t lo, uint32_t hi, int value) {
+    uint32_t wl = lo >> 6, wh = hi >> 6;
+    uint64_t ml = ~0ULL << (lo & 63);
+    uint64_t mh = ~0ULL >> (63 - (hi & 63));
+    
+    if (wl == wh) {
+        uint64_t m = ml & mh;
+        w[wl] = value ? (w[wl] | m) : (w[wl] & ~m);
+        return;
+    }
+    w[wl] = value ? (w[wl] | ml) : (w[wl] & ~ml);
+    for (uint32_t i = wl + 1; i < wh; i++) {
+        w[i] = value ? ~0ULL : 0;
+    }
+    w[wh] = value ? (w[wh] | mh) : (w[wh] & ~mh);
+}
+
+/* 从 from 开始第一个值为 value 的位置，没有时返回 65536 */
+static uint32_t bs_next(const uint64_t* w, uint32_t from, int value) {
+    if (from >= ROARING_CHUNK_BITS) return ROARING_CHUNK_BITS;
+    
+    uint32_t i = from >> 6;
+    uint64_t x = (value ? w[i] : ~w[i]) & (~0ULL << (from & 63));
+    while (!x) {
+        if (++i >= ROARING_CHUNK_WORDS) return ROARING_CHUNK_BITS;
+        x = value ? w[i] : ~w[i];
+    }
+    return (i << 6) + (uint32_t)__builtin_ctzll(x);
+}
+
+/* 取出所有为 1 的位置（升序），返回个数 */
+static uint32_t bs_extract(const uint64_t* w, uint16_t* out) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < ROARING_CHUNK_WORDS; i++) {
+        uint64_t x = w[i];
+        while (x) {
+            out[n++] = (uint16_t)((i << 6) + (uint32_t)__builtin_ctzll(x));
+            x &= x - 1;
+        }
+    }
+    return n;
+}
+
+// ============================================================================
+// 容器编解码
+// ============================================================================
+
+/* 按字节数选择最省空间的容器：ARRAY 2*card，RUN 4*runs，BITSET 8192；相同时优先前者 */
+static uint16_t choose_type(uint32_t card, uint32_t runs) {
+    uint16_t type = ROARING_BITSET;
+    uint32_t bytes = CHUNK_BYTES;
+    
+    if (runs * 4 < bytes) {
+        type = ROARING_RUN;
+        bytes = runs * 4;
+    }
+    if (card <= ROARING_ARRAY_MAX && card * 2 <= bytes) {
+        type = ROARING_ARRAY;
+    }
+    return type;
+}
+
+/**
+ * 把块内位图编码成最省空间的容器
+ * @param card w 中 1 的个数（必须大于 0）
+ * @param out 输出缓冲区，至少 8192 字节且 8 字节对齐
+ */
+static void encode_bitset(const uint64_t* w, uint32_t card, void* out, rcont* c) {
+    c->card = card;
+    c->type = choose_type(card, bs_runs(w));
+    
+    if (c->type == ROARING_ARRAY) {
+        c->bytes = bs_extract(w, (uint16_t*)out) * 2;
+    } else if (c->type == ROARING_RUN) {
+        uint16_t* r = (uint16_t*)out;
+        uint32_t n = 0;
+        uint32_t p = bs_next(w, 0, 1);
+        while (p < ROARING_CHUNK_BITS) {
+            uint32_t q = bs_next(w, p, 0);
+            r[2 * n] = (uint16_t)p;
+            r[2 * n + 1] = (uint16_t)(q - 1 - p);
+            n++;
+            p = bs_next(w, q, 1);
+        }
+        c->bytes = n * 4;
+    } else {
+        memcpy(out, w, CHUNK_BYTES);
+        c->bytes = CHUNK_BYTES;
+    }
+}
+
+/**
+ * 把升序的块内位置列表编码成最省空间的容器
+ * @param n 元素个数（1 ~ 65536）
+ */
+static void encode_values(const uint16_t* v, uint32_t n, void* out, rcont* c) {
+    uint32_t runs = 1;
+    for (uint32_t i = 1; i < n; i++) {
+        if (v[i] != (uint16_t)(v[i - 1] + 1)) runs++;
+    }
+    
+    c->card = n;
+    c->type = choose_type(n, runs);
+    
+    if (c->type == ROARING_ARRAY) {
+        memcpy(out, v, (size_t)n * 2);
+        c->bytes = n * 2;
+    } else if (c->type == ROARING_RUN) {
+        uint16_t* r = (uint16_t*)out;
+        uint32_t k = 0;
+        uint32_t i = 0;
+        while (i < n) {
+            uint32_t j = i;
+            while (j + 1 < n && v[j + 1] == (uint16_t)(v[j] + 1)) j++;
+            r[2 * k] = v[i];
+            r[2 * k + 1] = (uint16_t)(j - i);
+            k++;
+            i = j + 1;
+        }
+        c->bytes = k * 4;
+    } else {
+        uint64_t* w = (uint64_t*)out;
+        memset(w, 0, CHUNK_BYTES);
+        for (uint32_t i = 0; i < n; i++) {
+            w[v[i] >> 6] |= 1ULL << (v[i] & 63);
+        }
+        c->bytes = CHUNK_BYTES;
+    }
+}
+
+/* 容器解码成块内位图 */
+static void container_to_bitset(const roaring_entry* e, const uint8_t* d, uint64_t* w) {
+    if (e->type == ROARING_BITSET) {
+        memcpy(w, d, CHUNK_BYTES);
+        return;
+    }
+    
+    memset(w, 0, CHUNK_BYTES);
+    if (e->type == ROARING_ARRAY) {
+        const uint16_t* a = (const uint16_t*)d;
+        for (uint32_t i = 0; i < e->card; i++) {
+            w[a[i] >> 6] |= 1ULL << (a[i] & 63);
+        }
+    } else {
+        const uint16_t* r = (const uint16_t*)d;
+        uint32_t runs = e->bytes / 4;
+        for (uint32_t i = 0; i < runs; i++) {
+            bs_fill(w, r[2 * i], (uint32_t)r[2 * i] + r[2 * i + 1], 1);
+        }
+    }
+}
+
+/* 容器解码成升序位置列表，返回个数；w 为临时缓冲区 */
+static uint32_t container_to_values(const roaring_entry* e, const uint8_t* d, uint16_t* out, uint64_t* w) {
+    if (e->type == ROARING_ARRAY) {
+        memcpy(out, d, (size_t)e->card * 2);
+        return e->card;
+    }
+    if (e->type == ROARING_RUN) {
+        const uint16_t* r = (const uint16_t*)d;
+        uint32_t runs = e->bytes / 4;
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < runs; i++) {
+            uint32_t end = (uint32_t)r[2 * i] + r[2 * i + 1];
+            for (uint32_t v = r[2 * i]; v <= end; v++) {
+                out[n++] = (uint16_t)v;
+            }
+        }
+        return n;
+    }
+    memcpy(w, d, CHUNK_BYTES);
+    return bs_extract(w, out);
+}
+
+/* 统计容器在块内 [lo, hi] 中 1 的个数 */
+static uint32_t container_count(const roaring_entry* e, const uint8_t* d, uint32_t lo, uint32_t hi) {
+    if (e->type == ROARING_ARRAY) {
+        const uint16_t* a = (const uint16_t*)d;
+        return array_lower_bound(a, e->card, hi + 1) - array_lower_bound(a, e->card, lo);
+    }
+    
+    if (e->type == ROARING_RUN) {
+        const uint16_t* r = (const uint16_t*)d;
+        uint32_t runs = e->bytes / 4;
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < runs; i++) {
+            uint32_t s = r[2 * i];
+            uint32_t t = s + r[2 * i + 1];
+            if (s > hi) break;
+            if (t < lo) continue;
+            sum += (t < hi ? t : hi) - (s > lo ? s : lo) + 1;
+        }
+        return sum;
+    }
+    
+    const uint64_t* w = (const uint64_t*)d;
+    uint32_t wl = lo >> 6, wh = hi >> 6;
+    uint64_t ml = ~0ULL << (lo & 63);
+    uint64_t mh = ~0ULL >> (63 - (hi & 63));
+    if (wl == wh) return (uint32_t)__builtin_popcountll(w[wl] & ml & mh);
+    
+    uint32_t sum = (uint32_t)__builtin_popcountll(w[wl] & ml);
+    for (uint32_t i = wl + 1; i < wh; i++) {
+        sum += (uint32_t)__builtin_popcountll(w[i]);
+    }
+    return sum + (uint32_t)__builtin_popcountll(w[wh] & mh);
+}
+
+/* 容器中第 r 个（从 0 开始，r < card）1 的块内位置 */
+static uint32_t container_select(const roaring_entry* e, const uint8_t* d, uint32_t r) {
+    if (e->type == ROARING_ARRAY) return ((const uint16_t*)d)[r];
+    
+    if (e->type == ROARING_RUN) {
+        const uint16_t* runs = (const uint16_t*)d;
+        for (uint32_t i = 0; ; i++) {
+            uint32_t len = (uint32_t)runs[2 * i + 1] + 1;
+            if (r < len) return runs[2 * i] + r;
+            r -= len;
+        }
+    }
+    
+    const uint64_t* w = (const uint64_t*)d;
+    for (uint32_t i = 0; ; i++) {
+        uint32_t c = (uint32_t)__builtin_popcountll(w[i]);
+        if (r < c) return i * 64 + bitmap_word_select(w[i], r);
+        r -= c;
+    }
+}
+
+/* 块内 [lo, hi] 中第一个值为 value 的位置，没有时返回 -1 */
+static int32_t container_find(const roaring_entry* e, const uint8_t* d, uint32_t lo, uint32_t hi, int value) {
+    uint32_t c;
+    
+    if (e->type == ROARING_ARRAY) {
+        const uint16_t* a = (const uint16_t*)d;
+        uint32_t i = array_lower_bound(a, e->card, lo);
+        if (value) {
+            c = i < e->card ? a[i] : ROARING_CHUNK_BITS;
+        } else {
+            c = lo;
+            while (i < e->card && a[i] == c) {
+                c++;
+                i++;
+            }
+        }
+    } else if (e->type == ROARING_RUN) {
+        // 段是极大的，段尾的下一位必为 0
+        const uint16_t* r = (const uint16_t*)d;
+        uint32_t runs = e->bytes / 4;
+        uint32_t i = 0;
+        while (i < runs && (uint32_t)r[2 * i] + r[2 * i + 1] < lo) i++;
+        if (value) {
+            c = i < runs ? (r[2 * i] > lo ? r[2 * i] : lo) : ROARING_CHUNK_BITS;
+        } else {
+            c = (i < runs && r[2 * i] <= lo) ? (uint32_t)r[2 * i] + r[2 * i + 1] + 1 : lo;
+        }
+    } else {
+        c = bs_next((const uint64_t*)d, lo, value);
+    }
+    return c <= hi ? (int32_t)c : -1;
+}
+
+// ============================================================================
+// 构建器：按 key 升序追加容器，最后生成一整块数据
+// ============================================================================
+
+typedef struct {
+    roaring_entry* entries;
+    uint64_t count;
+    uint64_t cap;
+    uint8_t* data;
+    uint64_t used;
+    uint64_t data_cap;
+    int failed;
+} rbuild;
+
+static void rb_init(rbuild* b) {
+    memset(b, 0, sizeof(rbuild));
+}
+
+static void rb_free(rbuild* b) {
+    free(b->entries);
+    free(b->data);
+    rb_init(b);
+}
+
+static void rb_push(rbuild* b, uint64_t key, const rcont* c, const void* src) {
+    if (b->failed) return;
+    
+    if (b->count == b->cap) {
+        uint64_t cap = b->cap ? b->cap * 2 : 16;
+        roaring_entry* entries = (roaring_entry*)realloc(b->entries, cap * sizeof(roaring_entry));
+        if (!entries) {
+            b->failed = 1;
+            return;
+        }
+        b->entries = entries;
+        b->cap = cap;
+    }
+    
+    uint32_t cap = round8(c->bytes);
+    if (b->used + cap > b->data_cap) {
+        uint64_t data_cap = b->data_cap ? b->data_cap * 2 : 4096;
+        if (data_cap < b->used + cap) data_cap = b->used + cap;
+        uint8_t* data = (uint8_t*)realloc(b->data, data_cap);
+        if (!data) {
+            b->failed = 1;
+            return;
+        }
+        b->data = data;
+        b->data_cap = data_cap;
+    }
+    
+    roaring_entry* e = &b->entries[b->count++];
+    e->key = key;
+    e->offset = b->used;
+    e->bytes = c->bytes;
+    e->cap = cap;
+    e->card = c->card;
+    e->type = c->type;
+    e->reserved = 0;
+    memcpy(b->data + b->used, src, c->bytes);
+    memset(b->data + b->used + c->bytes, 0, cap - c->bytes);
+    b->used += cap;
+}
+
+/* 原样复制一个已有容器 */
+static void rb_push_entry(rbuild* b, uint64_t key, const roaring_entry* e, const uint8_t* d) {
+    rcont c = { e->type, e->bytes, e->card };
+    rb_push(b, key, &c, d);
+}
+
+/* 生成数据块并释放构建器，失败返回 NULL */
+static char* rb_payload(rbuild* b, size_t* size) {
+    if (b->failed) {
+        rb_free(b);
+        return NULL;
+    }
+    
+    size_t total = sizeof(roaring_header) + b->count * sizeof(roaring_entry) + b->used;
+    char* p = bignum_payload_alloc(total);
+    if (!p) {
+        rb_free(b);
+        return NULL;
+    }
+    
+    roaring_header* h = (roaring_header*)p;
+    h->count = b->count;
+    h->entry_cap = b->count;
+    h->data_used = b->used;
+    h->garbage = 0;
+    if (b->count) memcpy(r_entries(h), b->entries, b->count * sizeof(roaring_entry));
+    if (b->used) memcpy(r_data(h), b->data, b->used);
+    
+    rb_free(b);
+    *size = total;
+    return p;
+}
+
+/* 用构建结果替换 bm 的数据（旧数据可能仍被共享，只释放引用） */
+static int rb_adopt(BHS* bm, rbuild* b) {
+    size_t size;
+    char* p = rb_payload(b, &size);
+    if (!p) return merr;
+    
+    if (bm->is_large && bm->data.large_data) {
+        bignum_payload_release(bm->data.large_data);
+    }
+    bm->data.large_data = p;
+    bm->is_large = 1;
+    bm->capacity = size;
+    bm->type_data.bm.encoding = BITMAP_ENC_ROARING;
+    return 0;
+}
+
+/* 用构建结果创建新的压缩位图 */
+static BHS* rb_finish(rbuild* b, uint64_t length) {
+    BHS* bm = (BHS*)malloc(sizeof(BHS));
+    if (!bm) {
+        rb_free(b);
+        return NULL;
+    }
+    
+    memset(bm, 0, sizeof(BHS));
+    bm->type = BIGNUM_TYPE_BITMAP;
+    bm->length = length;
+    if (rb_adopt(bm, b) != 0) {
+        free(bm);
+        return NULL;
+    }
+    return bm;
+}
+
+// ============================================================================
+// 原地修改：目录与数据区的空间管理
+// ============================================================================
+
+/* 把仍在使用的容器紧凑地排到数据区开头 */
+static void r_compact(roaring_header* h) {
+    uint64_t live = h->data_used - h->garbage;
+    uint8_t* tmp = (uint8_t*)malloc(live ? live : 1);
+    if (!tmp) return;  // 整理失败不影响正确性，只是多占空间
+    
+    roaring_entry* e = r_entries(h);
+    uint8_t* data = r_data(h);
+    uint64_t off = 0;
+    for (uint64_t i = 0; i < h->count; i++) {
+        memcpy(tmp + off, data + e[i].offset, e[i].cap);
+        e[i].offset = off;
+        off += e[i].cap;
+    }
+    memcpy(data, tmp, off);
+    h->data_used = off;
+    h->garbage = 0;
+    free(tmp);
+}
+
+/**
+ * 保证目录还能再放 extra_entries 个条目、数据区末尾还有 extra_bytes 字节
+ * 调用前 bm 必须已独占数据；可能移动整块数据和容器偏移
+ */
+static int r_reserve(BHS* bm, uint64_t extra_entries, uint64_t extra_bytes) {
+    roaring_header* h = r_header(bm);
+    uint64_t entry_cap = h->entry_cap;
+    if (h->count + extra_entries > entry_cap) {
+        entry_cap = entry_cap ? entry_cap * 2 : 4;
+        if (entry_cap < h->count + extra_entries) entry_cap = h->count + extra_entries;
+    }
+    
+    if (h->garbage > 0 && h->garbage * 2 > h->data_used) {
+        r_compact(h);
+    }
+    
+    size_t need = sizeof(roaring_header) + entry_cap * sizeof(roaring_entry) + h->data_used + extra_bytes;
+    if (need > bm->capacity) {
+        size_t size = bm->capacity + bm->capacity / 2;
+        if (size < need) size = need;
+        char* p = bignum_payload_realloc(bm->data.large_data, size);
+        if (!p) return merr;
+        bm->data.large_data = p;
+        bm->capacity = size;
+        h = r_header(bm);
+    }
+    
+    if (entry_cap != h->entry_cap) {
+        uint8_t* data = r_data(h);
+        memmove(data + (entry_cap - h->entry_cap) * sizeof(roaring_entry), data, h->data_used);
+        h->entry_cap = entry_cap;
+    }
+    return 0;
+}
+
+/* 在 idx 处插入新容器 */
+static int r_insert(BHS* bm, uint64_t idx, uint64_t key, const rcont* c, const void* src, uint32_t cap) {
+    if (r_reserve(bm, 1, cap) != 0) return merr;
+    
+    roaring_header* h = r_header(bm);
+    roaring_entry* entries = r_entries(h);
+    memmove(&entries[idx + 1], &entries[idx], (h->count - idx) * sizeof(roaring_entry));
+    
+    roaring_entry* e = &entries[idx];
+    e->key = key;
+    e->offset = h->data_used;
+    e->bytes = c->bytes;
+    e->cap = cap;
+    e->card = c->card;
+    e->type = c->type;
+    e->reserved = 0;
+    h->data_used += cap;
+    h->count++;
+    memcpy(r_cdata(h, e), src, c->bytes);
+    return 0;
+}
+
+static void r_remove(BHS* bm, uint64_t idx) {
+    roaring_header* h = r_header(bm);
+    roaring_entry* entries = r_entries(h);
+    h->garbage += entries[idx].cap;
+    memmove(&entries[idx], &entries[idx + 1], (h->count - idx - 1) * sizeof(roaring_entry));
+    h->count--;
+}
+
+/* 把容器搬到数据区末尾并预留 cap 字节，旧位置记为垃圾 */
+static int r_relocate(BHS* bm, uint64_t idx, uint32_t cap) {
+    if (r_reserve(bm, 0, cap) != 0) return merr;
+    
+    roaring_header* h = r_header(bm);
+    roaring_entry* e = &r_entries(h)[idx];
+    uint8_t* data = r_data(h);
+    memcpy(data + h->data_used, data + e->offset, e->bytes);
+    h->garbage += e->cap;
+    e->offset = h->data_used;
+    e->cap = cap;
+    h->data_used += cap;
+    return 0;
+}
+
+/* 用新编码覆盖第 idx 个容器 */
+static int r_replace(BHS* bm, uint64_t idx, const rcont* c, const void* src) {
+    roaring_entry* e = &r_entries(r_header(bm))[idx];
+    if (c->bytes > e->cap && r_relocate(bm, idx, round8(c->bytes)) != 0) return merr;
+    
+    roaring_header* h = r_header(bm);
+    e = &r_entries(h)[idx];
+    memcpy(r_cdata(h, e), src, c->bytes);
+    e->bytes = c->bytes;
+    e->card = c->card;
+    e->type = c->type;
+    return 0;
+}
+
+/**
+ * 把块 key 内的 [lo, hi] 置为 value，并按最优编码写回
+ * 调用前 bm 必须已独占数据
+ */
+static int r_update_chunk(BHS* bm, uint64_t key, uint32_t lo, uint32_t hi, int value) {
+    uint64_t idx;
+    int found = r_find(r_header(bm), key, &idx);
+    if (!found && !value) return 0;
+    
+    uint64_t w[ROARING_CHUNK_WORDS];
+    uint64_t buf[ROARING_CHUNK_WORDS];
+    rcont c;
+    
+    if (found) {
+        roaring_header* h = r_header(bm);
+        roaring_entry* e = &r_entries(h)[idx];
+        container_to_bitset(e, r_cdata(h, e), w);
+    } else {
+        memset(w, 0, CHUNK_BYTES);
+    }
+    bs_fill(w, lo, hi, value);
+    
+    uint32_t card = bs_card(w);
+    if (card == 0) {
+        if (found) r_remove(bm, idx);
+        return 0;
+    }
+    encode_bitset(w, card, buf, &c);
+    if (!found) return r_insert(bm, idx, key, &c, buf, round8(c.bytes));
+    return r_replace(bm, idx, &c, buf);
+}
+
+// ============================================================================
+// 平铺数据的读写
+// ============================================================================
+
+static inline const uint8_t* dense_data(const BHS* bm) {
+    return (const uint8_t*)(bm->is_large ? bm->data.large_data : bm->data.small_data);
+}
+
+/* 读取平铺位图的第 key 块，超出 length 的位视为 0 */
+static void dense_copy_chunk(const BHS* bm, uint64_t key, uint64_t* w) {
+    uint64_t bytes = (bm->length + 7) / 8;
+    uint64_t off = key * CHUNK_BYTES;
+    uint64_t n = bytes - off < CHUNK_BYTES ? bytes - off : CHUNK_BYTES;
+    
+    if (n < CHUNK_BYTES) memset(w, 0, CHUNK_BYTES);
+    memcpy(w, dense_data(bm) + off, n);
+    for (uint64_t i = 0; i < (n + 7) / 8; i++) {
+        w[i] = word_from_le(w[i]);
+    }
+    if (key == (bm->length - 1) >> 16 && ((bm->length - 1) & 0xFFFF) < 0xFFFF) {
+        bs_fill(w, (uint32_t)((bm->length - 1) & 0xFFFF) + 1, ROARING_CHUNK_BITS - 1, 0);
+    }
+}
+
+/* 同上，并返回 1 的个数 */
+static uint32_t dense_load_chunk(const BHS* bm, uint64_t key, uint64_t* w) {
+    dense_copy_chunk(bm, key, w);
+    return bs_card(w);
+}
+
+/* 把块内位图写入平铺数据区的第 key 块，只写 bytes 之内的部分 */
+static void dense_store_chunk(uint8_t* d, uint64_t bytes, uint64_t key, const uint64_t* w) {
+    uint64_t off = key * CHUNK_BYTES;
+    uint64_t n = bytes - off < CHUNK_BYTES ? bytes - off : CHUNK_BYTES;
+    for (uint64_t j = 0; j * 8 < n; j++) {
+        uint64_t x = word_from_le(w[j]);
+        memcpy(d + off + j * 8, &x, n - j * 8 < 8 ? n - j * 8 : 8);
+    }
+}
+
+/* 平铺数据中把 [from, to] 闭区间置 1 */
+static void dense_fill(uint8_t* d, uint64_t from, uint64_t to) {
+    while (from <= to && (from & 7)) {
+        d[from >> 3] |= (uint8_t)(1 << (from & 7));
+        from++;
+    }
+    if (from + 8 <= to + 1) {
+        uint64_t n = (to + 1 - from) >> 3;
+        memset(d + (from >> 3), 0xFF, n);
+        from += n * 8;
+    }
+    while (from <= to) {
+        d[from >> 3] |= (uint8_t)(1 << (from & 7));
+        from++;
+    }
+}
+
+// ============================================================================
+// 运算的数据源：统一按块读取压缩或平铺位图
+// ============================================================================
+
+typedef struct {
+    const BHS* bm;
+    const roaring_header* h;   // 压缩编码时有效，否则为 NULL
+    uint64_t nkeys;            // 平铺编码的块数
+    uint64_t pos;              // 压缩：条目下标；平铺：块号
+} rsource;
+
+static void src_init(rsource* s, const BHS* bm) {
+    s->bm = bm;
+    s->pos = 0;
+    s->h = BITMAP_IS_ROARING(bm) ? r_header(bm) : NULL;
+    s->nkeys = s->h ? 0 : (bm->length + ROARING_CHUNK_BITS - 1) >> 16;
+}
+
+/* 当前块号，读完时返回 UINT64_MAX */
+static uint64_t src_key(const rsource* s) {
+    if (s->h) return s->pos < s->h->count ? r_entries(s->h)[s->pos].key : UINT64_MAX;
+    return s->pos < s->nkeys ? s->pos : UINT64_MAX;
+}
+
+/* 当前容器，平铺数据源返回 NULL */
+static const roaring_entry* src_entry(const rsource* s) {
+    return s->h ? &r_entries(s->h)[s->pos] : NULL;
+}
+
+/* 当前块解码成块内位图，返回 1 的个数 */
+static uint32_t src_load(const rsource* s, uint64_t* w) {
+    if (!s->h) return dense_load_chunk(s->bm, s->pos, w);
+    
+    const roaring_entry* e = src_entry(s);
+    container_to_bitset(e, r_cdata(s->h, e), w);
+    return e->card;
+}
+
+/* 当前块解码成块内位图，不统计个数 */
+static void src_words(const rsource* s, uint64_t* w) {
+    if (!s->h) {
+        dense_copy_chunk(s->bm, s->pos, w);
+        return;
+    }
+    
+    const roaring_entry* e = src_entry(s);
+    container_to_bitset(e, r_cdata(s->h, e), w);
+}
+
+/* 当前块解码成升序位置列表 */
+static uint32_t src_values(const rsource* s, uint16_t* out, uint64_t* w) {
+    if (!s->h) {
+        dense_load_chunk(s->bm, s->pos, w);
+        return bs_extract(w, out);
+    }
+    
+    const roaring_entry* e = src_entry(s);
+    return container_to_values(e, r_cdata(s->h, e), out, w);
+}
+
+/* 运算用的临时空间，放在堆上避免占用过多栈 */
+typedef struct {
+    uint64_t wa[ROARING_CHUNK_WORDS];
+    uint64_t wb[ROARING_CHUNK_WORDS];
+    uint64_t out[ROARING_CHUNK_WORDS];
+    uint16_t vals[ROARING_CHUNK_BITS];
+    uint16_t pend[ROARING_CHUNK_BITS];
+    uint32_t pend_n;
+    uint64_t pend_key;
+} rscratch;
+
+// ============================================================================
+// 编码转换
+// ============================================================================
+
+int roaring_init(BHS* bm) {
+    char* p = bignum_payload_alloc(sizeof(roaring_header));
+    if (!p) return merr;
+    
+    memset(p, 0, sizeof(roaring_header));
+    bm->data.large_data = p;
+    bm->is_large = 1;
+    bm->capacity = sizeof(roaring_header);
+    bm->type_data.bm.encoding = BITMAP_ENC_ROARING;
+    return 0;
+}
+
+int roaring_from_dense(BHS* bm) {
+    rscratch* s = (rscratch*)malloc(sizeof(rscratch));
+    if (!s) return merr;
+    
+    rbuild b;
+    rb_init(&b);
+    uint64_t nkeys = (bm->length + ROARING_CHUNK_BITS - 1) >> 16;
+    for (uint64_t k = 0; k < nkeys && !b.failed; k++) {
+        uint32_t card = dense_load_chunk(bm, k, s->wa);
+        if (card) {
+            rcont c;
+            encode_bitset(s->wa, card, s->out, &c);
+            rb_push(&b, k, &c, s->out);
+        }
+    }
+    free(s);
+    return rb_adopt(bm, &b);
+}
+
+int roaring_to_dense(BHS* bm) {
+    uint64_t bytes = (bm->length + 7) / 8;
+    char* old = bm->data.large_data;
+    const roaring_header* h = (const roaring_header*)old;
+    char small[BIGNUM_SMALL_SIZE];
+    char* payload = NULL;
+    uint8_t* dst = (uint8_t*)small;
+    
+    if (bytes > BIGNUM_SMALL_SIZE) {
+        payload = bignum_payload_alloc(bytes);
+        if (!payload) return merr;
+        dst = (uint8_t*)payload;
+        memset(dst, 0, bytes);
+    } else {
+        memset(dst, 0, BIGNUM_SMALL_SIZE);
+    }
+    
+    const roaring_entry* e = r_entries(h);
+    for (uint64_t i = 0; i < h->count; i++) {
+        const uint8_t* d = r_cdata(h, &e[i]);
+        uint64_t base = e[i].key << 16;
+        if (e[i].type == ROARING_ARRAY) {
+            const uint16_t* a = (const uint16_t*)d;
+            for (uint32_t j = 0; j < e[i].card; j++) {
+                uint64_t pos = base + a[j];
+                dst[pos >> 3] |= (uint8_t)(1 << (pos & 7));
+            }
+        } else if (e[i].type == ROARING_RUN) {
+            const uint16_t* r = (const uint16_t*)d;
+            for (uint32_t j = 0; j < e[i].bytes / 4; j++) {
+                dense_fill(dst, base + r[2 * j], base + r[2 * j] + r[2 * j + 1]);
+            }
+        } else {
+            const uint64_t* w = (const uint64_t*)d;
+            uint64_t off = base >> 3;
+            uint64_t n = bytes - off < CHUNK_BYTES ? bytes - off : CHUNK_BYTES;
+            for (uint64_t j = 0; j * 8 < n; j++) {
+                uint64_t x = word_from_le(w[j]);
+                memcpy(dst + off + j * 8, &x, n - j * 8 < 8 ? n - j * 8 : 8);
+            }
+        }
+    }
+    
+    bignum_payload_release(old);
+    if (payload) {
+        bm->data.large_data = payload;
+        bm->is_large = 1;
+        bm->capacity = bytes;
+    } else {
+        memcpy(bm->data.small_data, small, BIGNUM_SMALL_SIZE);
+        bm->is_large = 0;
+        bm->capacity = BIGNUM_SMALL_SIZE;
+    }
+    bm->type_data.bm.encoding = BITMAP_ENC_DENSE;
+    return 0;
+}
+
+size_t roaring_size_bytes(const BHS* bm) {
+    const roaring_header* h = r_header(bm);
+    return sizeof(roaring_header) + h->count * sizeof(roaring_entry) + h->data_used - h->garbage;
+}
+
+// ============================================================================
+// 查询与修改
+// ============================================================================
+
+int roaring_get(const BHS* bm, uint64_t pos) {
+    const roaring_header* h = r_header(bm);
+    uint64_t idx;
+    if (!r_find(h, pos >> 16, &idx)) return 0;
+    
+    const roaring_entry* e = &r_entries(h)[idx];
+    const uint8_t* d = r_cdata(h, e);
+    uint32_t low = (uint32_t)(pos & 0xFFFF);
+    
+    if (e->type == ROARING_ARRAY) {
+        const uint16_t* a = (const uint16_t*)d;
+        uint32_t i = array_lower_bound(a, e->card, low);
+        return i < e->card && a[i] == low;
+    }
+    if (e->type == ROARING_BITSET) {
+        return (int)((((const uint64_t*)d)[low >> 6] >> (low & 63)) & 1);
+    }
+    
+    // RUN：找最后一个起点 <= low 的段
+    const uint16_t* r = (const uint16_t*)d;
+    uint32_t lo = 0, hi = e->bytes / 4;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (r[2 * mid] <= low) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo > 0 && low <= (uint32_t)r[2 * (lo - 1)] + r[2 * (lo - 1) + 1];
+}
+
+int roaring_set(BHS* bm, uint64_t pos, int value) {
+    if (bignum_make_unique(bm) != BIGNUM_SUCCESS) return merr;
+    
+    uint64_t key = pos >> 16;
+    uint16_t low = (uint16_t)(pos & 0xFFFF);
+    roaring_header* h = r_header(bm);
+    uint64_t idx;
+    
+    if (!r_find(h, key, &idx)) {
+        if (!value) return 0;
+        rcont c = { ROARING_ARRAY, 2, 1 };
+        return r_insert(bm, idx, key, &c, &low, 8);
+    }
+    
+    roaring_entry* e = &r_entries(h)[idx];
+    uint8_t* d = r_cdata(h, e);
+    
+    // 常见情况原地修改，其余情况（RUN、ARRAY 满、BITSET 变稀疏）整块重编码
+    if (e->type == ROARING_BITSET) {
+        uint64_t* w = (uint64_t*)d;
+        uint64_t bit = 1ULL << (low & 63);
+        int cur = (w[low >> 6] & bit) != 0;
+        if (cur == !!value) return 0;
+        if (value) {
+            w[low >> 6] |= bit;
+            e->card++;
+            return 0;
+        }
+        if (e->card - 1 > ROARING_ARRAY_MAX) {
+            w[low >> 6] &= ~bit;
+            e->card--;
+            return 0;
+        }
+    } else if (e->type == ROARING_ARRAY) {
+        uint16_t* a = (uint16_t*)d;
+        uint32_t n = e->card;
+        uint32_t i = array_lower_bound(a, n, low);
+        int cur = i < n && a[i] == low;
+        if (cur == !!value) return 0;
+        if (!value) {
+            if (n == 1) {
+                r_remove(bm, idx);
+                return 0;
+            }
+            memmove(a + i, a + i + 1, (size_t)(n - i - 1) * 2);
+            e->card--;
+            e->bytes -= 2;
+            return 0;
+        }
+        if (n < ROARING_ARRAY_MAX) {
+            if (e->bytes + 2 > e->cap) {
+                uint32_t cap = e->cap * 2 < ROARING_ARRAY_MAX * 2 ? e->cap * 2 : ROARING_ARRAY_MAX * 2;
+                if (r_relocate(bm, idx, cap) != 0) return merr;
+                h = r_header(bm);
+                e = &r_entries(h)[idx];
+                a = (uint16_t*)r_cdata(h, e);
+            }
+            memmove(a + i + 1, a + i, (size_t)(n - i) * 2);
+            a[i] = low;
+            e->card++;
+            e->bytes += 2;
+            return 0;
+        }
+    }
+    return r_update_chunk(bm, key, low, low, value);
+}
+
+int roaring_set_range(BHS* bm, uint64_t start, uint64_t len, int value) {
+    if (!len) return 0;
+    if (bignum_make_unique(bm) != BIGNUM_SUCCESS) return merr;
+    
+    uint64_t end = start + len - 1;
+    uint64_t k0 = start >> 16, k1 = end >> 16;
+    uint32_t lo0 = (uint32_t)(start & 0xFFFF), hi1 = (uint32_t)(end & 0xFFFF);
+    
+    // 只涉及一两个块时原地修改
+    if (k1 - k0 < 2) {
+        for (uint64_t k = k0; k <= k1; k++) {
+            if (r_update_chunk(bm, k, k == k0 ? lo0 : 0, k == k1 ? hi1 : 0xFFFF, value) != 0) return merr;
+        }
+        return 0;
+    }
+    
+    // 跨越多个块时重建：区间外的容器原样复制，区间内的块整块写入或清除
+    static const uint16_t full_run[2] = { 0, 0xFFFF };
+    const rcont full = { ROARING_RUN, 4, ROARING_CHUNK_BITS };
+    const roaring_header* h = r_header(bm);
+    const roaring_entry* e = r_entries(h);
+    uint64_t w[ROARING_CHUNK_WORDS];
+    uint64_t buf[ROARING_CHUNK_WORDS];
+    rbuild b;
+    rb_init(&b);
+    
+    uint64_t i = 0;
+    while (i < h->count && e[i].key < k0) {
+        rb_push_entry(&b, e[i].key, &e[i], r_cdata(h, &e[i]));
+        i++;
+    }
+    
+    // 置 1 时逐块生成；清零时只需处理区间内已有的块
+    uint64_t k = k0;
+    while (!b.failed && (value ? k <= k1 : (i < h->count && e[i].key <= k1))) {
+        if (!value) k = e[i].key;
+        const roaring_entry* cur = (i < h->count && e[i].key == k) ? &e[i++] : NULL;
+        uint32_t lo = k == k0 ? lo0 : 0;
+        uint32_t hi = k == k1 ? hi1 : 0xFFFF;
+        
+        if (lo == 0 && hi == 0xFFFF) {
+            if (value) rb_push(&b, k, &full, full_run);
+        } else {
+            if (cur) container_to_bitset(cur, r_cdata(h, cur), w);
+            else memset(w, 0, CHUNK_BYTES);
+            bs_fill(w, lo, hi, value);
+            
+            uint32_t card = bs_card(w);
+            if (card) {
+                rcont c;
+                encode_bitset(w, card, buf, &c);
+                rb_push(&b, k, &c, buf);
+            }
+        }
+        k++;
+    }
+    
+    for (; i < h->count; i++) {
+        rb_push_entry(&b, e[i].key, &e[i], r_cdata(h, &e[i]));
+    }
+    return rb_adopt(bm, &b);
+}
+
+int roaring_truncate(BHS* bm, uint64_t bits) {
+    if (bignum_make_unique(bm) != BIGNUM_SUCCESS) return merr;
+    
+    roaring_header* h = r_header(bm);
+    if (bits == 0) {
+        h->count = 0;
+        h->data_used = 0;
+        h->garbage = 0;
+        return 0;
+    }
+    
+    uint64_t last_key = (bits - 1) >> 16;
+    uint32_t last_low = (uint32_t)((bits - 1) & 0xFFFF);
+    uint64_t idx;
+    int found = r_find(h, last_key, &idx);
+    uint64_t keep = found ? idx + 1 : idx;
+    
+    roaring_entry* e = r_entries(h);
+    for (uint64_t i = keep; i < h->count; i++) {
+        h->garbage += e[i].cap;
+    }
+    h->count = keep;
+    
+    if (found && last_low < 0xFFFF) {
+        return r_update_chunk(bm, last_key, last_low + 1, 0xFFFF, 0);
+    }
+    return 0;
+}
+
+uint64_t roaring_count(const BHS* bm, uint64_t st, uint64_t ed) {
+    const roaring_header* h = r_header(bm);
+    const roaring_entry* e = r_entries(h);
+    uint64_t k0 = st >> 16, k1 = ed >> 16;
+    uint64_t sum = 0;
+    uint64_t i;
+    
+    r_find(h, k0, &i);
+    for (; i < h->count && e[i].key <= k1; i++) {
+        uint32_t lo = e[i].key == k0 ? (uint32_t)(st & 0xFFFF) : 0;
+        uint32_t hi = e[i].key == k1 ? (uint32_t)(ed & 0xFFFF) : 0xFFFF;
+        if (lo == 0 && hi == 0xFFFF) sum += e[i].card;
+        else sum += container_count(&e[i], r_cdata(h, &e[i]), lo, hi);
+    }
+    return sum;
+}
+
+int64_t roaring_find(const BHS* bm, int value, uint64_t start, uint64_t end) {
+    const roaring_header* h = r_header(bm);
+    const roaring_entry* e = r_entries(h);
+    uint64_t k0 = start >> 16, k1 = end >> 16;
+    uint64_t i;
+    
+    r_find(h, k0, &i);
+    if (value) {
+        for (; i < h->count && e[i].key <= k1; i++) {
+            uint32_t lo = e[i].key == k0 ? (uint32_t)(start & 0xFFFF) : 0;
+            uint32_t hi = e[i].key == k1 ? (uint32_t)(end & 0xFFFF) : 0xFFFF;
+            int32_t r = container_find(&e[i], r_cdata(h, &e[i]), lo, hi, 1);
+            if (r >= 0) return (int64_t)((e[i].key << 16) | (uint64_t)r);
+        }
+        return merr;
+    }
+    
+    // 找 0：不存在的块全为 0
+    uint64_t p = start;
+    for (;;) {
+        uint64_t k = p >> 16;
+        if (i >= h->count || e[i].key != k) return (int64_t)p;
+        
+        uint32_t hi = k == k1 ? (uint32_t)(end & 0xFFFF) : 0xFFFF;
+        int32_t r = container_find(&e[i], r_cdata(h, &e[i]), (uint32_t)(p & 0xFFFF), hi, 0);
+        if (r >= 0) return (int64_t)((k << 16) | (uint64_t)r);
+        if (k == k1) return merr;
+        p = (k + 1) << 16;
+        i++;
+    }
+}
+
+int64_t roaring_select(const BHS* bm, uint64_t k) {
+    const roaring_header* h = r_header(bm);
+    const roaring_entry* e = r_entries(h);
+    
+    for (uint64_t i = 0; i < h->count; i++) {
+        if (k < e[i].card) {
+            return (int64_t)((e[i].key << 16) | container_select(&e[i], r_cdata(h, &e[i]), (uint32_t)k));
+        }
+        k -= e[i].card;
+    }
+    return merr;
+}
+
+/* 写满 cap 个时记下下一个位置并返回 */
+#define EXTRACT_EMIT(pos) do {                              \
+    if (n == cap) { *cursor = (pos); return n; }            \
+    out[n++] = (pos);                                       \
+} while (0)
+
+uint64_t roaring_extract(const BHS* bm, uint64_t* cursor, uint64_t end, uint64_t* out, uint64_t cap) {
+    const roaring_header* h = r_header(bm);
+    const roaring_entry* e = r_entries(h);
+    uint64_t k0 = *cursor >> 16, k1 = end >> 16;
+    uint64_t n = 0;
+    uint64_t i;
+    
+    r_find(h, k0, &i);
+    for (; i < h->count && e[i].key <= k1; i++) {
+        uint64_t base = e[i].key << 16;
+        uint32_t lo = e[i].key == k0 ? (uint32_t)(*cursor & 0xFFFF) : 0;
+        uint32_t hi = e[i].key == k1 ? (uint32_t)(end & 0xFFFF) : 0xFFFF;
+        const uint8_t* d = r_cdata(h, &e[i]);
+        
+        if (e[i].type == ROARING_ARRAY) {
+            const uint16_t* a = (const uint16_t*)d;
+            for (uint32_t j = array_lower_bound(a, e[i].card, lo); j < e[i].card && a[j] <= hi; j++) {
+                EXTRACT_EMIT(base | a[j]);
+            }
+        } else if (e[i].type == ROARING_RUN) {
+            const uint16_t* r = (const uint16_t*)d;
+            uint32_t runs = e[i].bytes / 4;
+            for (uint32_t j = 0; j < runs && r[2 * j] <= hi; j++) {
+                uint32_t s = r[2 * j] > lo ? r[2 * j] : lo;
+                uint32_t t = (uint32_t)r[2 * j] + r[2 * j + 1];
+                if (t > hi) t = hi;
+                for (uint32_t v = s; v <= t; v++) {
+                    EXTRACT_EMIT(base | v);
+                }
+            }
+        } else {
+            const uint64_t* w = (const uint64_t*)d;
+            for (uint32_t j = lo >> 6; j <= hi >> 6; j++) {
+                uint64_t x = w[j];
+                if (j == lo >> 6) x &= ~0ULL << (lo & 63);
+                if (j == hi >> 6) x &= ~0ULL >> (63 - (hi & 63));
+                while (x) {
+                    EXTRACT_EMIT(base | ((uint64_t)j << 6) | (uint64_t)__builtin_ctzll(x));
+                    x &= x - 1;
+                }
+            }
+        }
+    }
+    
+    *cursor = end + 1;
+    return n;
+}
+
+#undef EXTRACT_EMIT
+
+int roaring_check(const BHS* bm) {
+    if (!bm->is_large || !bm->data.large_data) return merr;
+    if (bm->capacity < sizeof(roaring_header)) return merr;
+    
+    const roaring_header* h = r_header(bm);
+    if (h->count > h->entry_cap || h->garbage > h->data_used) return merr;
+    if (sizeof(roaring_header) + h->entry_cap * sizeof(roaring_entry) + h->data_used > bm->capacity) return merr;
+    if (h->count && (bm->length == 0 || r_entries(h)[h->count - 1].key > (bm->length - 1) >> 16)) return merr;
+    
+    const roaring_entry* e = r_entries(h);
+    for (uint64_t i = 0; i < h->count; i++) {
+        if (i > 0 && e[i].key <= e[i - 1].key) return merr;
+        if (e[i].offset + e[i].cap > h->data_used || e[i].bytes > e[i].cap) return merr;
+        if (e[i].card == 0 || e[i].card > ROARING_CHUNK_BITS) return merr;
+        if (e[i].type == ROARING_ARRAY && e[i].bytes != e[i].card * 2) return merr;
+        if (e[i].type == ROARING_BITSET && e[i].bytes != CHUNK_BYTES) return merr;
+        if (e[i].type == ROARING_RUN && (e[i].bytes == 0 || e[i].bytes % 4)) return merr;
+        if (e[i].type < ROARING_ARRAY || e[i].type > ROARING_RUN) return merr;
+    }
+    return 0;
+}
+
+// ============================================================================
+// 整体运算
+// ============================================================================
+
+/* 两个 ARRAY 容器按 op 归并，结果最多 8192 个元素 */
+static uint32_t array_merge(int op, const uint16_t* a, uint32_t na, const uint16_t* b, uint32_t nb, uint16_t* out) {
+    uint32_t i = 0, j = 0, n = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            if (op != ROARING_OP_AND) out[n++] = a[i];
+            i++;
+        } else if (a[i] > b[j]) {
+            if (op != ROARING_OP_AND) out[n++] = b[j];
+            j++;
+        } else {
+            if (op != ROARING_OP_XOR) out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    if (op != ROARING_OP_AND) {
+        while (i < na) out[n++] = a[i++];
+        while (j < nb) out[n++] = b[j++];
+    }
+    return n;
+}
+
+BHS* roaring_binary(const BHS* a, const BHS* b, int op, uint64_t result_len) {
+    rscratch* s = (rscratch*)malloc(sizeof(rscratch));
+    if (!s) return NULL;
+    
+    rsource sa, sb;
+    src_init(&sa, a);
+    src_init(&sb, b);
+    rbuild rb;
+    rb_init(&rb);
+    
+    uint64_t last_key = result_len ? (result_len - 1) >> 16 : 0;
+    uint32_t last_low = (uint32_t)((result_len - 1) & 0xFFFF);
+    
+    while (result_len && !rb.failed) {
+        uint64_t ka = src_key(&sa), kb = src_key(&sb);
+        uint64_t k = ka < kb ? ka : kb;
+        if (k == UINT64_MAX || k > last_key) break;
+        
+        int has_a = ka == k, has_b = kb == k;
+        const roaring_entry* ea = has_a ? src_entry(&sa) : NULL;
+        const roaring_entry* eb = has_b ? src_entry(&sb) : NULL;
+        int masked = k == last_key && last_low < 0xFFFF;
+        rcont c;
+        
+        if (op == ROARING_OP_AND && !(has_a && has_b)) {
+            // 交集只在两边都有的块上产生结果
+        } else if (has_a != has_b) {
+            // OR / XOR 只有一边时结果就是该容器
+            const rsource* one = has_a ? &sa : &sb;
+            const roaring_entry* e = has_a ? ea : eb;
+            if (e && !masked) {
+                rb_push_entry(&rb, k, e, r_cdata(one->h, e));
+            } else {
+                src_load(one, s->wa);
+                if (masked) bs_fill(s->wa, last_low + 1, 0xFFFF, 0);
+                uint32_t card = bs_card(s->wa);
+                if (card) {
+                    encode_bitset(s->wa, card, s->out, &c);
+                    rb_push(&rb, k, &c, s->out);
+                }
+            }
+        } else if (ea && eb && ea->type == ROARING_ARRAY && eb->type == ROARING_ARRAY) {
+            uint32_t n = array_merge(op, (const uint16_t*)r_cdata(sa.h, ea), ea->card,
+                                     (const uint16_t*)r_cdata(sb.h, eb), eb->card, s->vals);
+            if (masked) n = array_lower_bound(s->vals, n, last_low + 1);
+            if (n) {
+                encode_values(s->vals, n, s->out, &c);
+                rb_push(&rb, k, &c, s->out);
+            }
+        } else {
+            src_load(&sa, s->wa);
+            src_load(&sb, s->wb);
+            for (int i = 0; i < ROARING_CHUNK_WORDS; i++) {
+                if (op == ROARING_OP_AND) s->wa[i] &= s->wb[i];
+                else if (op == ROARING_OP_OR) s->wa[i] |= s->wb[i];
+                else s->wa[i] ^= s->wb[i];
+            }
+            if (masked) bs_fill(s->wa, last_low + 1, 0xFFFF, 0);
+            uint32_t card = bs_card(s->wa);
+            if (card) {
+                encode_bitset(s->wa, card, s->out, &c);
+                rb_push(&rb, k, &c, s->out);
+            }
+        }
+        
+        if (has_a) sa.pos++;
+        if (has_b) sb.pos++;
+    }
+    
+    free(s);
+    return rb_finish(&rb, result_len);
+}
+
+BHS* roaring_not(const BHS* a) {
+    rscratch* s = (rscratch*)malloc(sizeof(rscratch));
+    if (!s) return NULL;
+    
+    static const uint16_t full_run[2] = { 0, 0xFFFF };
+    const rcont full = { ROARING_RUN, 4, ROARING_CHUNK_BITS };
+    uint64_t len = a->length;
+    uint64_t last_key = len ? (len - 1) >> 16 : 0;
+    uint32_t last_low = (uint32_t)((len - 1) & 0xFFFF);
+    rsource src;
+    src_init(&src, a);
+    rbuild rb;
+    rb_init(&rb);
+    
+    for (uint64_t k = 0; len && k <= last_key && !rb.failed; k++) {
+        uint32_t hi = k == last_key ? last_low : 0xFFFF;
+        if (src_key(&src) == k) {
+            src_load(&src, s->wa);
+            for (int i = 0; i < ROARING_CHUNK_WORDS; i++) {
+                s->wa[i] = ~s->wa[i];
+            }
+            src.pos++;
+        } else if (hi == 0xFFFF) {
+            rb_push(&rb, k, &full, full_run);
+            continue;
+        } else {
+            memset(s->wa, 0xFF, CHUNK_BYTES);
+        }
+        if (hi < 0xFFFF) bs_fill(s->wa, hi + 1, 0xFFFF, 0);
+        
+        uint32_t card = bs_card(s->wa);
+        if (card) {
+            rcont c;
+            encode_bitset(s->wa, card, s->out, &c);
+            rb_push(&rb, k, &c, s->out);
+        }
+    }
+    
+    free(s);
+    return rb_finish(&rb, len);
+}
+
+/* 把 n 个已平移的位置追加到块 key，块号变化时先输出之前积累的块 */
+static void shift_emit(rbuild* b, rscratch* s, uint64_t key, const uint16_t* v, uint32_t n, uint16_t delta) {
+    if (!n) return;
+    
+    if (s->pend_n && s->pend_key != key) {
+        rcont c;
+        encode_values(s->pend, s->pend_n, s->out, &c);
+        rb_push(b, s->pend_key, &c, s->out);
+        s->pend_n = 0;
+    }
+    s->pend_key = key;
+    for (uint32_t i = 0; i < n; i++) {
+        s->pend[s->pend_n++] = (uint16_t)(v[i] + delta);
+    }
+}
+
+BHS* roaring_shift(const BHS* a, uint64_t shift, int left) {
+    rscratch* s = (rscratch*)malloc(sizeof(rscratch));
+    if (!s) return NULL;
+    
+    uint64_t result_len = left ? a->length + shift : a->length - shift;
+    uint64_t q = shift >> 16;
+    uint32_t r = (uint32_t)(shift & 0xFFFF);
+    rsource src;
+    src_init(&src, a);
+    rbuild rb;
+    rb_init(&rb);
+    s->pend_n = 0;
+    
+    for (uint64_t k; (k = src_key(&src)) != UINT64_MAX && !rb.failed; src.pos++) {
+        if (!left && k < q) continue;
+        
+        if (r == 0) {
+            // 整块平移只改块号
+            uint64_t t = left ? k + q : k - q;
+            const roaring_entry* e = src_entry(&src);
+            if (e) {
+                rb_push_entry(&rb, t, e, r_cdata(src.h, e));
+            } else {
+                uint32_t card = src_load(&src, s->wa);
+                if (card) {
+                    rcont c;
+                    encode_bitset(s->wa, card, s->out, &c);
+                    rb_push(&rb, t, &c, s->out);
+                }
+            }
+            continue;
+        }
+        
+        // 每块拆成两段分别落到相邻的两个目标块，块内位置加减 r 后按 65536 取模
+        uint32_t n = src_values(&src, s->vals, s->wa);
+        if (left) {
+            uint32_t split = array_lower_bound(s->vals, n, ROARING_CHUNK_BITS - r);
+            shift_emit(&rb, s, k + q, s->vals, split, (uint16_t)r);
+            shift_emit(&rb, s, k + q + 1, s->vals + split, n - split, (uint16_t)r);
+        } else {
+            uint32_t split = array_lower_bound(s->vals, n, r);
+            if (k >= q + 1) shift_emit(&rb, s, k - q - 1, s->vals, split, (uint16_t)(ROARING_CHUNK_BITS - r));
+            shift_emit(&rb, s, k - q, s->vals + split, n - split, (uint16_t)(ROARING_CHUNK_BITS - r));
+        }
+    }
+    
+    if (s->pend_n) {
+        rcont c;
+        encode_values(s->pend, s->pend_n, s->out, &c);
+        rb_push(&rb, s->pend_key, &c, s->out);
+    }
+    free(s);
+    return rb_finish(&rb, result_len);
+}
+
+// ============================================================================
+// 多路聚合
+// ============================================================================
+
+/*
+ * 按位切片的计数器：planes[j * 1024 + i] 是第 i 个字各位置计数值的第 j 位。
+ * 加一个块内位图就是逐层做半加：新进位 = 本层 & 进位，本层 ^= 进位。
+ * 已加入 added 个输入时计数不超过 added，进位最多传到第 floor(log2(added)) 层。
+ * 每层都是整块的字级运算，走 bitmap_words_op 的向量内核；carry 需要两块临时空间
+ */
+static void slice_add(uint64_t* planes, int nplanes, uint64_t added, const uint64_t* w, uint64_t* carry) {
+    int top = 63 - __builtin_clzll(added);
+    const uint8_t* c = (const uint8_t*)w;
+    uint8_t* next = (uint8_t*)carry;
+    
+    for (int j = 0; j <= top && j < nplanes; j++) {
+        uint8_t* p = (uint8_t*)&planes[(size_t)j * ROARING_CHUNK_WORDS];
+        if (j < top) bitmap_words_op(next, p, c, CHUNK_BYTES, ROARING_OP_AND);
+        bitmap_words_op(p, p, c, CHUNK_BYTES, ROARING_OP_XOR);
+        
+        // 两块临时空间轮流存放进位
+        c = next;
+        next = next == (uint8_t*)carry ? (uint8_t*)(carry + ROARING_CHUNK_WORDS) : (uint8_t*)carry;
+    }
+}
+
+/* 计数 >= k 的位置置 1：从高位到低位逐位比较（k 必须小于 2^nplanes） */
+static void slice_ge(const uint64_t* planes, int nplanes, uint64_t k, uint64_t* out) {
+    for (int i = 0; i < ROARING_CHUNK_WORDS; i++) {
+        uint64_t gt = 0, eq = ~0ULL;
+        for (int j = nplanes - 1; j >= 0; j--) {
+            uint64_t p = planes[(size_t)j * ROARING_CHUNK_WORDS + i];
+            if ((k >> j) & 1) {
+                eq &= p;
+            } else {
+                gt |= eq & p;
+                eq &= ~p;
+            }
+        }
+        out[i] = gt | eq;
+    }
+}
+
+/*
+ * acc = acc op 当前块（op 为 ROARING_OP_AND / ROARING_OP_OR）
+ * 平铺数据源的完整块在小端机器上直接从数据区读取，省去一次解码；其他情况先解码到 tmp
+ */
+static void src_fold(const rsource* s, uint64_t* acc, int op, uint64_t* tmp) {
+    const uint8_t* d = (const uint8_t*)tmp;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+    if (!s->h && (s->pos + 1) * (uint64_t)ROARING_CHUNK_BITS <= s->bm->length) {
+        d = dense_data(s->bm) + s->pos * CHUNK_BYTES;
+    } else
+#endif
+    src_words(s, tmp);
+    bitmap_words_op((uint8_t*)acc, (const uint8_t*)acc, d, CHUNK_BYTES, op);
+}
+
+/* 块内位图是否全 0 */
+static int bs_empty(const uint64_t* w) {
+    uint64_t any = 0;
+    for (int i = 0; i < ROARING_CHUNK_WORDS; i++) any |= w[i];
+    return any == 0;
+}
+
+int roaring_aggregate(const BHS* const* in, size_t n, size_t k, uint64_t result_len,
+                      uint8_t* dense_out, BHS** roaring_out, uint64_t* card) {
+    if (!in || n == 0 || k == 0 || k > n) return merr;
+    
+    int nplanes = 64 - __builtin_clzll((uint64_t)n);
+    rscratch* s = (rscratch*)malloc(sizeof(rscratch));
+    rsource* src = (rsource*)malloc(n * sizeof(rsource));
+    size_t* hit = (size_t*)malloc(n * sizeof(size_t));
+    uint64_t* planes = NULL;
+    if (k > 1 && k < n) planes = (uint64_t*)malloc((size_t)(nplanes + 2) * CHUNK_BYTES);  // 末尾两块放进位
+    if (!s || !src || !hit || (k > 1 && k < n && !planes)) {
+        free(s);
+        free(src);
+        free(hit);
+        free(planes);
+        return merr;
+    }
+    
+    for (size_t i = 0; i < n; i++) {
+        src_init(&src[i], in[i]);
+    }
+    rbuild rb;
+    rb_init(&rb);
+    
+    uint64_t total = 0;
+    uint64_t dense_bytes = (result_len + 7) / 8;
+    uint64_t last_key = result_len ? (result_len - 1) >> 16 : 0;
+    uint32_t last_low = (uint32_t)((result_len - 1) & 0xFFFF);
+    
+    while (result_len && !rb.failed) {
+        // 取所有输入中最小的块号，少于 k 个输入有这一块时整块结果为 0，直接跳过
+        uint64_t key = UINT64_MAX;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t ki = src_key(&src[i]);
+            if (ki < key) key = ki;
+        }
+        if (key == UINT64_MAX || key > last_key) break;
+        
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (src_key(&src[i]) == key) hit[m++] = i;
+        }
+        
+        int masked = key == last_key && last_low < 0xFFFF;
+        const roaring_entry* only = m == 1 ? src_entry(&src[hit[0]]) : NULL;
+        if (m < k) {
+            // 跳过
+        } else if (only && !masked && !dense_out) {
+            // k == 1 且只有一个压缩输入有这一块：结果就是该容器，原样复制
+            total += only->card;
+            if (roaring_out) rb_push_entry(&rb, key, only, r_cdata(src[hit[0]].h, only));
+        } else {
+            if (k == 1 || k == m) {
+                // 只需判断“任一”或“全部”，逐字或、与即可
+                // 交集每折叠几个输入检查一次，整块已为 0 时不再读其余输入
+                int op = k == 1 ? ROARING_OP_OR : ROARING_OP_AND;
+                src_words(&src[hit[0]], s->wa);
+                for (size_t t = 1; t < m; t++) {
+                    src_fold(&src[hit[t]], s->wa, op, s->wb);
+                    if (op == ROARING_OP_AND && (t & 3) == 0 && bs_empty(s->wa)) break;
+                }
+            } else {
+                memset(planes, 0, (size_t)nplanes * CHUNK_BYTES);
+                uint64_t* carry = planes + (size_t)nplanes * ROARING_CHUNK_WORDS;
+                for (size_t t = 0; t < m; t++) {
+                    src_words(&src[hit[t]], s->wb);
+                    slice_add(planes, nplanes, t + 1, s->wb, carry);
+                }
+                slice_ge(planes, nplanes, k, s->wa);
+            }
+            if (masked) bs_fill(s->wa, last_low + 1, 0xFFFF, 0);
+            
+            uint32_t c = bs_card(s->wa);
+            if (c) {
+                total += c;
+                if (dense_out) dense_store_chunk(dense_out, dense_bytes, key, s->wa);
+                if (roaring_out) {
+                    rcont rc;
+                    encode_bitset(s->wa, c, s->out, &rc);
+                    rb_push(&rb, key, &rc, s->out);
+                }
+            }
+        }
+        
+        for (size_t t = 0; t < m; t++) {
+            src[hit[t]].pos++;
+        }
+    }
+    
+    free(s);
+    free(src);
+    free(hit);
+    free(planes);
+    
+    if (rb.failed) {
+        rb_free(&rb);
+        return merr;
+    }
+    if (roaring_out) {
+        *roaring_out = rb_finish(&rb, result_len);
+        if (!*roaring_out) return merr;
+    } else {
+        rb_free(&rb);
+    }
+    if (card) *card = total;
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef ROARING_H
+#define ROARING_H
+/*
+#版权所有 (c) Mhuixs-team 2024
+#许可证协议:
+#任何人或组织在未经版权所有者同意的情况下禁止使用、修改、分发此作品
+start from 2024.11
+Email:hj18914255909@outlook.com
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bignum.h"  /* 提供 BHS 类型定义 */
+
+/*
+BITMAP 的压缩编码（Roaring）
+位偏移按 2^16 位分块，块号 key = offset >> 16，块内按 1 的分布选择容器：
+- ARRAY：升序 uint16 数组，1 的个数 <= 4096 时使用
+- BITSET：1024 个 uint64，固定 8KB
+- RUN：(起点, 长度-1) 的 uint16 对，适合连续段
+全 0 的块不存储。每次整块重写时按字节数最小的原则自动选择容器类型。
+
+整个结构放在一块 large_data 里，沿用 BHS 的写时复制：
+  [roaring_header][roaring_entry x entry_cap][容器数据区]
+单点修改时容器放不下就搬到数据区末尾，旧位置记为垃圾，垃圾过半时整理。
+BHS.length 仍是位数，BHS.capacity 是整块的字节数，is_large 恒为 1。
+*/
+
+/* BHS.type_data.bm.encoding 的取值 */
+#define BITMAP_ENC_DENSE   0   /* 平铺字节数组，位 i 在第 i/8 字节的第 i%8 位 */
+#define BITMAP_ENC_ROARING 1   /* 分块压缩容器 */
+#define BITMAP_IS_ROARING(obj) ((obj)->type_data.bm.encoding == BITMAP_ENC_ROARING)
+
+#define ROARING_CHUNK_BITS  65536
+#define ROARING_CHUNK_WORDS 1024
+#define ROARING_ARRAY_MAX   4096   /* ARRAY 容器最多容纳的元素数 */
+
+/* 容器类型 */
+#define ROARING_ARRAY  1
+#define ROARING_BITSET 2
+#define ROARING_RUN    3
+
+typedef struct {
+    uint64_t count;       // 容器个数
+    uint64_t entry_cap;   // 目录容量（数据区紧跟在目录之后）
+    uint64_t data_used;   // 数据区已用字节数（含垃圾）
+    uint64_t garbage;     // 数据区中已废弃的字节数
+} roaring_header;
+
+typedef struct {
+    uint64_t key;         // 块号
+    uint64_t offset;      // 容器在数据区中的字节偏移（8 字节对齐）
+    uint32_t bytes;       // 容器数据字节数
+    uint32_t cap;         // 为容器预留的字节数
+    uint32_t card;        // 容器内 1 的个数（1 ~ 65536）
+    uint16_t type;        // ROARING_ARRAY / ROARING_BITSET / ROARING_RUN
+    uint16_t reserved;
+} roaring_entry;
+
+// 编码转换（不改变 length）
+int roaring_init(BHS* bm);                  // 变为空的压缩位图，调用者负责先释放原数据
+int roaring_from_dense(BHS* bm);            // 平铺 -> 压缩
+int roaring_to_dense(BHS* bm);              // 压缩 -> 平铺
+size_t roaring_size_bytes(const BHS* bm);   // 目录与容器预留空间的总字节数（不含垃圾）
+
+// 查询与修改（bm 必须是压缩编码；位置由调用者保证在 length 之内）
+int roaring_get(const BHS* bm, uint64_t pos);
+int roaring_set(BHS* bm, uint64_t pos, int value);
+int roaring_set_range(BHS* bm, uint64_t start, uint64_t len, int value);
+int roaring_truncate(BHS* bm, uint64_t bits);   // 清除 >= bits 的位
+uint64_t roaring_count(const BHS* bm, uint64_t st, uint64_t ed);
+int64_t roaring_find(const BHS* bm, int value, uint64_t start, uint64_t end);
+int64_t roaring_select(const BHS* bm, uint64_t k);   // 第 k 个（从 0 开始）1 的位置，不存在时返回 -1
+uint64_t roaring_extract(const BHS* bm, uint64_t* cursor, uint64_t end, uint64_t* out, uint64_t cap);   // 同 bitmap_extract_set
+int roaring_check(const BHS* bm);
+
+// 整体运算：a、b 可以是任意编码，返回新的压缩位图（length 已设置）
+#define ROARING_OP_AND 0
+#define ROARING_OP_OR  1
+#define ROARING_OP_XOR 2
+BHS* roaring_binary(const BHS* a, const BHS* b, int op, uint64_t result_len);
+BHS* roaring_not(const BHS* a);
+BHS* roaring_shift(const BHS* a, uint64_t shift, int left);   // 右移时 shift 必须小于 a->length
+
+/*
+ * 多路聚合：n 个任意编码的输入逐块（64K 位）合并，结果中某位为 1 当且仅当至少 k 个输入该位为 1
+ * （k == n 即交集，k == 1 即并集）。少于 k 个输入含有的块整块跳过，不解码。
+ * dense_out 非 NULL 时写入调用者提供的已清零平铺区（(result_len + 7) / 8 字节）；
+ * roaring_out 非 NULL 时生成压缩结果；card 非 NULL 时返回结果中 1 的个数。三者可任意组合
+ * @return 0 成功, -1 失败
+ */
+int roaring_aggregate(const BHS* const* in, size_t n, size_t k, uint64_t result_len,
+                      uint8_t* dense_out, BHS** roaring_out, uint64_t* card);
+
+#endif
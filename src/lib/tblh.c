@@ -1,10 +1,46 @@
 #include "tblh.h"
 
+//每个格子的字节数：DECIMAL 字段按精度定长，其余字段存 Obj
+static size_t field_unit(int type){
+    if(FIELD_IS_DECIMAL(type)) return decimal_width(FIELD_DEC_PRECISION(type));
+    return sizeof(Obj);
+}
+
+//物理行对应的格子地址
+static void* field_cell(FIELD* field, size_t physical_line){
+    return (char*)field->data + field_unit(field->type) * physical_line;
+}
+
+//校验字段类型，DECIMAL 的 p、s 必须合法
+static int check_type(int type){
+    if(!FIELD_IS_DECIMAL(type)) return 0;
+    return decimal_check_spec(FIELD_DEC_PRECISION(type), FIELD_DEC_SCALE(type));
+}
+
+//把 value 写入 DECIMAL 格子，成功后释放 value（所有权转移）
+static int store_decimal(FIELD* field, size_t physical_line, Obj value){
+    int p = FIELD_DEC_PRECISION(field->type), s = FIELD_DEC_SCALE(field->type);
+    if(decimal_from_bhs(value, p, s, field_cell(field, physical_line)) != 0){
+        return -1;
+    }
+    if(value != NULL) bignum_destroy(value);
+    return 0;
+}
+
+//检查 value 能否写入 DECIMAL 字段，不修改表
+static int check_decimal(FIELD* field, Obj value){
+    unsigned char cell[16];//最宽的格子是 int128
+    return decimal_from_bhs(value, FIELD_DEC_PRECISION(field->type), FIELD_DEC_SCALE(field->type), cell);
+}
+
 TABLE* create_table(int* types, mstring* field_names, size_t field_num, mstring table_name){
     //先验证参数是否合法
     if(types==NULL || field_names==NULL || field_num==0 || table_name==NULL){
         return NULL;
     }
+    for(size_t i=0; i<field_num; i++){
+        if(check_type(types[i]) != 0) return NULL;
+    }
     
     //申请表结构内存
     TABLE* table = (TABLE*)malloc(sizeof(TABLE));
@@ -53,7 +89,7 @@ TABLE* create_table(int* types, mstring* field_names, size_t field_num, mstring
         table->field[i].column_index = i;
         
         //分配内存
-        void* ptr = malloc(sizeof(Obj) * INCREASE_LINES_NUM);
+        void* ptr = malloc(field_unit(types[i]) * INCREASE_LINES_NUM);
         if(ptr == NULL){
             //如果分配失败，释放之前已分配的内存
             for(size_t j=0; j<i; j++){
@@ -112,7 +148,7 @@ int add_record(TABLE* table, Obj* values, size_t num){
         //对每个字段进行扩容
         for(size_t i=0; i<table->field_num; i++){            
             //union所有成员共享地址，realloc使用任意一个即可
-            void* temp = realloc(table->field[i].data, sizeof(Obj) * new_capacity);
+            void* temp = realloc(table->field[i].data, field_unit(table->field[i].type) * new_capacity);
             if(temp == NULL){
                 //扩容失败，但原数据仍然有效
                 return -1;
@@ -125,8 +161,19 @@ int add_record(TABLE* table, Obj* values, size_t num){
     
     //插入数据到当前行
     size_t current_line = table->line_num;
+    //先写 DECIMAL 字段：当前行还未计入 line_num，转换失败时表不变
     for(size_t i=0; i<table->field_num; i++){
-        if(i < num){
+        if(!FIELD_IS_DECIMAL(table->field[i].type)) continue;
+        int p = FIELD_DEC_PRECISION(table->field[i].type), s = FIELD_DEC_SCALE(table->field[i].type);
+        if(decimal_from_bhs(i < num ? values[i] : NULL, p, s, field_cell(&table->field[i], current_line)) != 0){
+            return -1;
+        }
+    }
+    for(size_t i=0; i<table->field_num; i++){
+        if(FIELD_IS_DECIMAL(table->field[i].type)){
+            //已转换为定点数，释放传入的 BHS（所有权转移）
+            if(i < num && values[i] != NULL) bignum_destroy(values[i]);
+        }else if(i < num){
             //使用用户提供的值
             table->field[i].data[current_line] = values[i];
         }else{
@@ -150,14 +197,15 @@ int rm_record(TABLE* table, size_t logic_index){
         return -1;
     }   
     //获取要删除的物理行号和最后一个物理行号进行替换
+    //物理行始终保持 0..line_num-1 连续，新行和按列扫描都依赖这一点
     size_t physical_to_delete = table->logic_index[logic_index];
-    size_t last_physical = table->logic_index[table->line_num - 1];
+    size_t last_physical = table->line_num - 1;
     
     //如果删除的不是最后一行，用最后一行的数据覆盖被删除行
     if(physical_to_delete != last_physical){
         //复制数据
         for(size_t i=0; i<table->field_num; i++){
-            table->field[i].data[physical_to_delete] = table->field[i].data[last_physical];
+            memcpy(field_cell(&table->field[i], physical_to_delete), field_cell(&table->field[i], last_physical), field_unit(table->field[i].type));
         }
         //更新原本指向last_physical的逻辑行，让它指向physical_to_delete
         size_t logic_of_last = table->memory_index[last_physical];
@@ -212,7 +260,7 @@ int rm_field(TABLE* table, size_t field_index){
 
 
 int add_field(TABLE* table, int type, mstring field_name){
-    if(table == NULL || field_name == NULL){
+    if(table == NULL || field_name == NULL || check_type(type) != 0){
         return -1;//参数验证
     }
     //扩展字段数组
@@ -230,7 +278,7 @@ int add_field(TABLE* table, int type, mstring field_name){
     table->field[new_index].column_index = new_index;
     
     //为新字段分配数据区内存
-    void* ptr = malloc(sizeof(Obj) * table->capacity);
+    void* ptr = malloc(field_unit(type) * table->capacity);
     if(ptr == NULL){
         //分配失败，恢复field_num（field数组已扩展但可以不用）
         return -1;
@@ -240,7 +288,11 @@ int add_field(TABLE* table, int type, mstring field_name){
     //初始化新字段的所有行为NULL
     for(size_t i=0; i<table->line_num; i++){
         size_t physical_line = table->logic_index[i];
-        table->field[new_index].data[physical_line] = NULL;
+        if(FIELD_IS_DECIMAL(type)){
+            decimal_set_null(field_cell(&table->field[new_index], physical_line), FIELD_DEC_PRECISION(type));
+        }else{
+            table->field[new_index].data[physical_line] = NULL;
+        }
     }
     //更新字段数
     table->field_num = new_field_num;
@@ -281,14 +333,25 @@ Obj get_value(TABLE* table, size_t idx_x, size_t idx_y){
     if(table == NULL || idx_x >= table->line_num || idx_y >= table->field_num){
         return NULL;
     }
-    return table->field[idx_y].data[table->logic_index[idx_x]];
+    FIELD* field = &table->field[idx_y];
+    size_t physical_line = table->logic_index[idx_x];
+    if(FIELD_IS_DECIMAL(field->type)){
+        //定点数没有现成的 BHS，返回新分配的副本
+        return decimal_to_bhs(field_cell(field, physical_line), FIELD_DEC_PRECISION(field->type), FIELD_DEC_SCALE(field->type));
+    }
+    return field->data[physical_line];
 }
 
 int set_value(TABLE* table, size_t idx_x, size_t idx_y, Obj content){
     if(table == NULL || idx_x >= table->line_num || idx_y >= table->field_num){
         return -1;
     }
-    table->field[idx_y].data[table->logic_index[idx_x]] = content;
+    FIELD* field = &table->field[idx_y];
+    size_t physical_line = table->logic_index[idx_x];
+    if(FIELD_IS_DECIMAL(field->type)){
+        return store_decimal(field, physical_line, content);
+    }
+    field->data[physical_line] = content;
     return 0;
 }
 
@@ -354,7 +417,7 @@ void clear_table(TABLE* table){
         }
         //缩减每个字段的数据区
         for(size_t i=0; i<table->field_num; i++){
-            void* temp = realloc(table->field[i].data, sizeof(Obj) * INCREASE_LINES_NUM);
+            void* temp = realloc(table->field[i].data, field_unit(table->field[i].type) * INCREASE_LINES_NUM);
             if(temp != NULL){
                 table->field[i].data = (Obj*)temp;
             }
@@ -365,7 +428,11 @@ void clear_table(TABLE* table){
     //初始化所有数据为NULL
     for(size_t i=0; i<table->field_num; i++){
         for(size_t j=0; j<table->capacity; j++){
-            table->field[i].data[j] = NULL;
+            if(FIELD_IS_DECIMAL(table->field[i].type)){
+                decimal_set_null(field_cell(&table->field[i], j), FIELD_DEC_PRECISION(table->field[i].type));
+            }else{
+                table->field[i].data[j] = NULL;
+            }
         }
     }
     table->line_num = 0;
@@ -391,10 +458,20 @@ int update_record(TABLE* table, size_t logic_index, Obj* values, size_t num){
         return -1;
     }
     size_t physical_line = table->logic_index[logic_index];
+    //先确认 DECIMAL 值都能写入，避免更新到一半失败
+    for(size_t i=0; i<num; i++){
+        if(FIELD_IS_DECIMAL(table->field[i].type) && check_decimal(&table->field[i], values[i]) != 0){
+            return -1;
+        }
+    }
     for(size_t i=0; i<table->field_num; i++){
         if(i < num){
             //使用用户提供的值（所有权转移）
-            table->field[i].data[physical_line] = values[i];
+            if(FIELD_IS_DECIMAL(table->field[i].type)){
+                store_decimal(&table->field[i], physical_line, values[i]);
+            }else{
+                table->field[i].data[physical_line] = values[i];
+            }
         }
     }
     return 0;//成功
@@ -410,7 +487,33 @@ Obj* get_record(TABLE* table, size_t logic_index){
     }
     size_t physical_line = table->logic_index[logic_index];
     for(size_t i=0; i<table->field_num; i++){
-        record[i] = table->field[i].data[physical_line];
+        FIELD* field = &table->field[i];
+        if(FIELD_IS_DECIMAL(field->type)){
+            record[i] = decimal_to_bhs(field_cell(field, physical_line), FIELD_DEC_PRECISION(field->type), FIELD_DEC_SCALE(field->type));
+        }else{
+            record[i] = field->data[physical_line];
+        }
     }
     return record;
 }
+
+Obj sum_field(TABLE* table, size_t field_index){
+    if(table == NULL || field_index >= table->field_num){
+        return NULL;
+    }
+    FIELD* field = &table->field[field_index];
+    if(FIELD_IS_DECIMAL(field->type)){
+        //物理行 0..line_num-1 连续，直接扫整块定长格子
+        return decimal_sum(field->data, table->line_num, FIELD_DEC_PRECISION(field->type), FIELD_DEC_SCALE(field->type));
+    }
+    //普通字段逐个 BHS 相加，跳过空值和非数字
+    BHS* total = bignum_from_string("0");
+    for(size_t i=0; i<table->line_num && total != NULL; i++){
+        Obj value = field->data[i];
+        if(value == NULL || !bignum_is_number(value)) continue;
+        BHS* next = bignum_add(total, value);
+        bignum_destroy(total);
+        total = next;
+    }
+    return total;
+}
@@ -7,6 +7,8 @@
 #include <string.h>
 
 #include "bignum.h"  /* 提供 BHS/Obj 类型定义 */
+#include "decimal.h"
+#include "mstring.h"
 
 /*
 tblh的思路
@@ -23,9 +25,17 @@ tblh只负责管理数据关系，不关心数据的具体类型、内容
 #define INCREASE_LINES_NUM 100//每次增加的行数
 #define FIELD_NOT_FOUND SIZE_MAX//字段未找到的错误码
 
+//DECIMAL(p,s) 字段：type 的第16位为标记，8~15位为精度p，0~7位为小数位数s
+//这类字段的数据区不存 Obj，而是按 decimal_width(p) 定长存放定点整数
+#define FIELD_TYPE_DECIMAL 0x10000
+#define FIELD_DECIMAL(p, s) (FIELD_TYPE_DECIMAL | ((p) << 8) | (s))
+#define FIELD_IS_DECIMAL(t) (((t) & FIELD_TYPE_DECIMAL) != 0)
+#define FIELD_DEC_PRECISION(t) (((t) >> 8) & 0xff)
+#define FIELD_DEC_SCALE(t) ((t) & 0xff)
+
 typedef struct {
     size_t column_index;//字段在表中的索引(从0开始)
-    Obj* data;//数据区
+    Obj* data;//数据区（DECIMAL 字段为定长格子，见 FIELD_TYPE_DECIMAL）
     mstring name;//字段名
     int type;//字段类型(由外部设置、定义)
 }FIELD;
@@ -41,6 +51,8 @@ typedef struct {
 }TABLE;
 
 //函数声明（对外接口使用 BHS*）
+//DECIMAL 字段：写入时把 BHS 转成定点数并释放传入的 BHS，值超出精度时返回-1且表不变；
+//get_value/get_record 读出时返回新分配的 BHS，由调用者释放
 TABLE* create_table(int* types, mstring* field_names, size_t field_num, mstring table_name);
 int add_record(TABLE* table, Obj* values, size_t num);
 int rm_record(TABLE* table, size_t logic_index);
@@ -57,5 +69,6 @@ size_t get_record_count(TABLE* table);
 size_t get_field_count(TABLE* table);
 int update_record(TABLE* table, size_t logic_index, Obj* values, size_t num);
 Obj* get_record(TABLE* table, size_t logic_index);
+Obj sum_field(TABLE* table, size_t field_index);//对一列求和（跳过空值），返回新分配的 BHS
 
 #endif // TBLH_H
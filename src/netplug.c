@@ -380,6 +380,12 @@ static void on_connection(uv_stream_t* server, int status) {
         }
 
         session->session_id = get_sid();
+        if (session->session_id < 0) {
+            fprintf(stderr, "Warning: No free session ID, rejecting connection\n");
+            session->session_id = 0;
+            uv_close((uv_handle_t*)&session->tcp_handle, on_close);
+            return;
+        }
         session->user_id = 65536; // 默认未认证用户ID
         session->state = SESS_ALIVE;
         session->last_activity = uv_now(g_netplug->loop);
@@ -620,6 +626,10 @@ static void free_session(session_t* session) {
         return;
     }
 
+    // 归还会话ID
+    if (session->session_id > 0) {
+        del_sid(session->session_id);
+    }
     reset_session(session);
     session->state = SESS_IDLE;
 
@@ -7,10 +7,14 @@
  * 包含函数：
  *   - 三角函数：sin, cos, tan, asin, acos, atan, atan2
  *   - 指数对数：exp, ln, log, log10, log2
- *   - 幂和根：sqrt, cbrt
+ *   - 幂和根：pow, sqrt, cbrt
  *   - 取整：floor, ceil, round, trunc
  *   - 其他：abs, sign, max, min
  * 
+ * sin, cos, tan, exp, ln, log, log10, log2, sqrt 使用 bignum 的任意精度实现，
+ * 结果精确到 precision 位小数；末尾多传一个非 0 参数（如 sin(x, 1)、log(x, b, 1)）
+ * 则改走 double 快速路径，只有约 15 位有效数字。其余函数使用 double 计算。
+ * 
  * 包含常量：
  *   - pi, π: 圆周率
  *   - e: 自然常数
@@ -24,40 +28,7 @@
 #include <string.h>
 #include <stdio.h>
 
-/* 辅助函数：将BigNum转换为double */
-static double bignum_to_double(const BHS *num) {
-    if (num == NULL) return 0.0;
-    
-    char *digits = BIGNUM_DIGITS(num);
-    
-    /* BHS 存储格式：digits 从低位到高位存储
-     * decimal_pos 表示小数位数
-     * 例如：1.5707 存储为 digits=[7,0,7,5,1], decimal_pos=4
-     *      - digits[0]=7 是小数部分最低位（0.0007）
-     *      - digits[3]=5 是小数部分最高位（0.5）
-     *      - digits[4]=1 是整数部分个位（1）
-     *      整数 123 存储为 digits=[3,2,1], decimal_pos=0
-     *      - digits[0]=3 是个位
-     *      - digits[1]=2 是十位
-     *      - digits[2]=1 是百位
-     */
-    
-    double result = 0.0;
-    
-    /* 从高位到低位处理，这样更符合直觉 */
-    for (int i = num->length - 1; i >= 0; i--) {
-        result = result * 10.0 + digits[i];
-    }
-    
-    /* 调整小数点位置 */
-    if (num->type_data.num.decimal_pos > 0) {
-        for (int i = 0; i < num->type_data.num.decimal_pos; i++) {
-            result /= 10.0;
-        }
-    }
-    
-    return num->type_data.num.is_negative ? -result : result;
-}
+/* BigNum 转 double 使用 bignum.h 中的 bignum_to_double() */
 
 /* 辅助函数：将double转换为BigNum（栈分配版本，用于临时计算） */
 static int double_to_bignum(double value, BHS *num, int precision) {
@@ -73,24 +44,72 @@ static int double_to_bignum(double value, BHS *num, int precision) {
     return ret;
 }
 
+/* 第 n 个参数（可选）非 0 时使用 double 快速路径 */
+static int use_fast_mode(const BHS *args, int arg_count, int n) {
+    return arg_count > n && bignum_to_double(&args[n]) != 0.0;
+}
+
+/* 辅助函数：把 bignum_* 返回的新 BHS 复制到 result 并释放 */
+static int take_bignum(BHS *value, BHS *result) {
+    if (value == NULL) return -1;
+    
+    int ret = bignum_copy(value, result);
+    bignum_destroy(value);
+    return ret;
+}
+
+/* 辅助函数：result = ln(x) / denom，denom 由调用方新分配，这里负责释放 */
+static int ln_ratio(const BHS *x, BHS *denom, BHS *result, int precision) {
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    
+    BHS *num = bignum_ln(x, precision + 10);
+    if (num == NULL || denom == NULL) {
+        if (num != NULL) bignum_destroy(num);
+        if (denom != NULL) bignum_destroy(denom);
+        return -1;
+    }
+    
+    BHS *value = bignum_div(num, denom, precision);
+    bignum_destroy(num);
+    bignum_destroy(denom);
+    return take_bignum(value, result);
+}
+
 /* =========================== 三角函数 =========================== */
 
 static int math_sin(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    return double_to_bignum(sin(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        return double_to_bignum(sin(x), result, precision);
+    }
+    return take_bignum(bignum_sin(&args[0], precision), result);
 }
 
 static int math_cos(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    return double_to_bignum(cos(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        return double_to_bignum(cos(x), result, precision);
+    }
+    return take_bignum(bignum_cos(&args[0], precision), result);
 }
 
 static int math_tan(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    return double_to_bignum(tan(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        return double_to_bignum(tan(x), result, precision);
+    }
+    
+    /* tan = sin / cos，多算 10 位抵消除法的误差放大 */
+    if (precision < 0) precision = BIGNUM_DEFAULT_PRECISION;
+    BHS *s = bignum_sin(&args[0], precision + 10);
+    BHS *c = bignum_cos(&args[0], precision + 10);
+    BHS *value = (s != NULL && c != NULL) ? bignum_div(s, c, precision) : NULL;
+    if (s != NULL) bignum_destroy(s);
+    if (c != NULL) bignum_destroy(c);
+    return take_bignum(value, result);
 }
 
 static int math_asin(const BHS *args, int arg_count, BHS *result, int precision) {
@@ -123,54 +142,92 @@ static int math_atan2(const BHS *args, int arg_count, BHS *result, int precision
 /* =========================== 指数对数函数 =========================== */
 
 static int math_exp(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    return double_to_bignum(exp(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        return double_to_bignum(exp(x), result, precision);
+    }
+    return take_bignum(bignum_exp(&args[0], precision), result);
 }
 
 static int math_ln(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    if (x <= 0.0) return -1;
-    return double_to_bignum(log(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        if (x <= 0.0) return -1;
+        return double_to_bignum(log(x), result, precision);
+    }
+    return take_bignum(bignum_ln(&args[0], precision), result);
+}
+
+/* 常用对数的分母 ln10 */
+static BHS* ln10(int precision) {
+    BHS ten;
+    bignum_from_int64_legacy(10, &ten);
+    return bignum_ln(&ten, precision);
 }
 
 static int math_log(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count < 1 || arg_count > 2) return -1;
-    
-    double x = bignum_to_double(&args[0]);
-    if (x <= 0.0) return -1;
+    if (arg_count < 1 || arg_count > 3) return -1;
     
-    if (arg_count == 1) {
-        return double_to_bignum(log10(x), result, precision);
-    } else {
+    if (use_fast_mode(args, arg_count, 2)) {
+        double x = bignum_to_double(&args[0]);
         double base = bignum_to_double(&args[1]);
-        if (base <= 0.0 || base == 1.0) return -1;
+        if (x <= 0.0 || base <= 0.0 || base == 1.0) return -1;
         return double_to_bignum(log(x) / log(base), result, precision);
     }
+    
+    /* base 为 1 时 ln(base) 为 0，除法返回 NULL */
+    int denom_precision = (precision < 0 ? BIGNUM_DEFAULT_PRECISION : precision) + 10;
+    if (arg_count == 1) {
+        return ln_ratio(&args[0], ln10(denom_precision), result, precision);
+    }
+    return ln_ratio(&args[0], bignum_ln(&args[1], denom_precision), result, precision);
 }
 
 static int math_log10(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    if (x <= 0.0) return -1;
-    return double_to_bignum(log10(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        if (x <= 0.0) return -1;
+        return double_to_bignum(log10(x), result, precision);
+    }
+    
+    int denom_precision = (precision < 0 ? BIGNUM_DEFAULT_PRECISION : precision) + 10;
+    return ln_ratio(&args[0], ln10(denom_precision), result, precision);
 }
 
 static int math_log2(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    if (x <= 0.0) return -1;
-    return double_to_bignum(log2(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        if (x <= 0.0) return -1;
+        return double_to_bignum(log2(x), result, precision);
+    }
+    
+    int denom_precision = (precision < 0 ? BIGNUM_DEFAULT_PRECISION : precision) + 10;
+    return ln_ratio(&args[0], bignum_ln2(denom_precision), result, precision);
 }
 
 /* =========================== 幂和根函数 =========================== */
 
+/* pow(x, y) 与 ^ 运算相同；pow(x, y, m) 为模幂，不展开完整的幂 */
+static int math_pow(const BHS *args, int arg_count, BHS *result, int precision) {
+    if (arg_count < 2 || arg_count > 3) return -1;
+    if (arg_count == 3) {
+        return take_bignum(bignum_powmod(&args[0], &args[1], &args[2]), result);
+    }
+    return take_bignum(bignum_pow(&args[0], &args[1], precision), result);
+}
+
 static int math_sqrt(const BHS *args, int arg_count, BHS *result, int precision) {
-    if (arg_count != 1) return -1;
-    double x = bignum_to_double(&args[0]);
-    if (x < 0.0) return -1;
-    return double_to_bignum(sqrt(x), result, precision);
+    if (arg_count < 1 || arg_count > 2) return -1;
+    if (use_fast_mode(args, arg_count, 1)) {
+        double x = bignum_to_double(&args[0]);
+        if (x < 0.0) return -1;
+        return double_to_bignum(sqrt(x), result, precision);
+    }
+    return take_bignum(bignum_sqrt(&args[0], precision), result);
 }
 
 static int math_cbrt(const BHS *args, int arg_count, BHS *result, int precision) {
@@ -217,31 +274,11 @@ static int math_abs(const BHS *args, int arg_count, BHS *result, int precision)
 static int math_sign(const BHS *args, int arg_count, BHS *result, int precision) {
     if (arg_count != 1) return -1;
     
-    bignum_init(result);
-    
-    char *arg_digits = BIGNUM_DIGITS(&args[0]);
-    char *result_digits = BIGNUM_DIGITS(result);
-    
-    int is_zero = 1;
-    for (int i = 0; i < args[0].length; i++) {
-        if (arg_digits[i] != 0) {
-            is_zero = 0;
-            break;
-        }
-    }
+    BHS zero;
+    bignum_init(&zero);
+    int cmp = bignum_compare(&args[0], &zero);
     
-    if (is_zero) {
-        result_digits[0] = 0;
-    } else if (args[0].type_data.num.is_negative) {
-        result_digits[0] = 1;
-        result->type_data.num.is_negative = 1;
-    } else {
-        result_digits[0] = 1;
-    }
-    
-    result->length = 1;
-    result->type_data.num.decimal_pos = 0;
-    return 0;
+    return bignum_from_int64_legacy(cmp, result);
 }
 
 static int math_max(const BHS *args, int arg_count, BHS *result, int precision) {
@@ -286,23 +323,24 @@ int package_register(FunctionRegistry *registry) {
     int count = 0;
     
     /* 三角函数 */
-    count += (function_register(registry, "sin", math_sin, 1, 1, "正弦函数 sin(x)") == 0);
-    count += (function_register(registry, "cos", math_cos, 1, 1, "余弦函数 cos(x)") == 0);
-    count += (function_register(registry, "tan", math_tan, 1, 1, "正切函数 tan(x)") == 0);
+    count += (function_register(registry, "sin", math_sin, 1, 2, "正弦函数 sin(x[,fast])") == 0);
+    count += (function_register(registry, "cos", math_cos, 1, 2, "余弦函数 cos(x[,fast])") == 0);
+    count += (function_register(registry, "tan", math_tan, 1, 2, "正切函数 tan(x[,fast])") == 0);
     count += (function_register(registry, "asin", math_asin, 1, 1, "反正弦函数 asin(x)") == 0);
     count += (function_register(registry, "acos", math_acos, 1, 1, "反余弦函数 acos(x)") == 0);
     count += (function_register(registry, "atan", math_atan, 1, 1, "反正切函数 atan(x)") == 0);
     count += (function_register(registry, "atan2", math_atan2, 2, 2, "两参数反正切 atan2(y,x)") == 0);
     
     /* 指数对数函数 */
-    count += (function_register(registry, "exp", math_exp, 1, 1, "自然指数函数 e^x") == 0);
-    count += (function_register(registry, "ln", math_ln, 1, 1, "自然对数 ln(x)") == 0);
-    count += (function_register(registry, "log", math_log, 1, 2, "对数 log(x) 或 log(x,base)") == 0);
-    count += (function_register(registry, "log10", math_log10, 1, 1, "常用对数 log10(x)") == 0);
-    count += (function_register(registry, "log2", math_log2, 1, 1, "二进制对数 log2(x)") == 0);
+    count += (function_register(registry, "exp", math_exp, 1, 2, "自然指数函数 e^x，exp(x[,fast])") == 0);
+    count += (function_register(registry, "ln", math_ln, 1, 2, "自然对数 ln(x[,fast])") == 0);
+    count += (function_register(registry, "log", math_log, 1, 3, "对数 log(x) 或 log(x,base[,fast])") == 0);
+    count += (function_register(registry, "log10", math_log10, 1, 2, "常用对数 log10(x[,fast])") == 0);
+    count += (function_register(registry, "log2", math_log2, 1, 2, "二进制对数 log2(x[,fast])") == 0);
     
     /* 幂和根 */
-    count += (function_register(registry, "sqrt", math_sqrt, 1, 1, "平方根 √x") == 0);
+    count += (function_register(registry, "pow", math_pow, 2, 3, "幂 pow(x,y) 或模幂 pow(x,y,m)") == 0);
+    count += (function_register(registry, "sqrt", math_sqrt, 1, 2, "平方根 √x，sqrt(x[,fast])") == 0);
     count += (function_register(registry, "cbrt", math_cbrt, 1, 1, "立方根 ∛x") == 0);
     
     /* 取整函数 */
@@ -324,27 +362,35 @@ int package_register_constants(void *ctx) {
     if (ctx == NULL) return -1;
     
     Context *context = (Context *)ctx;
-    BHS value;
+    BHS *value;
     
     /* π (pi) */
-    bignum_init(&value);
-    double_to_bignum(3.141592653589793238462643383279502884197, &value, BIGNUM_DEFAULT_PRECISION);
-    context_set(context, "π", &value);
-    context_set(context, "pi", &value);
-    bignum_free(&value);  /* 清理临时数据 */
+    value = bignum_pi(BIGNUM_DEFAULT_PRECISION);
+    if (value == NULL) return -1;
+    context_set(context, "π", value);
+    context_set(context, "pi", value);
+    bignum_destroy(value);
     
     /* e (自然常数) */
-    bignum_init(&value);
-    double_to_bignum(2.718281828459045235360287471352662497757, &value, BIGNUM_DEFAULT_PRECISION);
-    context_set(context, "e", &value);
-    bignum_free(&value);
-    
-    /* φ (黄金比例) */
-    bignum_init(&value);
-    double_to_bignum(1.618033988749894848204586834365638117720, &value, BIGNUM_DEFAULT_PRECISION);
-    context_set(context, "φ", &value);
-    context_set(context, "phi", &value);
-    bignum_free(&value);
+    value = bignum_e(BIGNUM_DEFAULT_PRECISION);
+    if (value == NULL) return -1;
+    context_set(context, "e", value);
+    bignum_destroy(value);
+    
+    /* φ (黄金比例) = (1 + √5) / 2 */
+    BHS five, two, one;
+    bignum_from_int64_legacy(5, &five);
+    bignum_from_int64_legacy(2, &two);
+    bignum_from_int64_legacy(1, &one);
+    BHS *root = bignum_sqrt(&five, BIGNUM_DEFAULT_PRECISION + 1);
+    BHS *sum = root != NULL ? bignum_add(root, &one) : NULL;
+    value = sum != NULL ? bignum_div(sum, &two, BIGNUM_DEFAULT_PRECISION) : NULL;
+    if (root != NULL) bignum_destroy(root);
+    if (sum != NULL) bignum_destroy(sum);
+    if (value == NULL) return -1;
+    context_set(context, "φ", value);
+    context_set(context, "phi", value);
+    bignum_destroy(value);
     
     return 0;
 }
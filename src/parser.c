@@ -1,5 +1,6 @@
 #include "parser.h"
 #include "lexer.h"
+#include "lib/decimal.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -695,9 +696,47 @@ ASTNode* parser_parse_hook(Parser *parser) {
     return node;
 }
 
+/* 解析 decimal 之后的 (p[,s])，返回 "decimal(p,s)" */
+static char* parser_parse_decimal_spec(Parser *parser) {
+    if (!parser_expect(parser, TOK_LPAREN)) {
+        return NULL;
+    }
+    
+    int precision = 0, scale = 0;
+    if (lexer_current_type(parser->lexer) != TOK_NUMBER) {
+        parser_set_error(parser, "Expected DECIMAL precision");
+        return NULL;
+    }
+    precision = atoi(lexer_current_value(parser->lexer));
+    lexer_next(parser->lexer);
+    
+    if (lexer_current_type(parser->lexer) == TOK_COMMA) {
+        lexer_next(parser->lexer);
+        if (lexer_current_type(parser->lexer) != TOK_NUMBER) {
+            parser_set_error(parser, "Expected DECIMAL scale");
+            return NULL;
+        }
+        scale = atoi(lexer_current_value(parser->lexer));
+        lexer_next(parser->lexer);
+    }
+    
+    if (!parser_expect(parser, TOK_RPAREN)) {
+        return NULL;
+    }
+    if (decimal_check_spec(precision, scale) != 0) {
+        parser_set_error(parser, "Invalid DECIMAL precision or scale");
+        return NULL;
+    }
+    
+    char buf[32];
+    snprintf(buf, sizeof(buf), "decimal(%d,%d)", precision, scale);
+    return parser_strdup(buf);
+}
+
 /* 解析 FIELD 语句 */
 ASTNode* parser_parse_field(Parser *parser) {
     /* FIELD ADD id i4 PKEY; */
+    /* FIELD ADD price decimal(10,2); */
     /* FIELD DEL 0; */
     /* FIELD SWAP 0 1; */
     
@@ -719,8 +758,19 @@ ASTNode* parser_parse_field(Parser *parser) {
         lexer_next(parser->lexer);
         
         /* 数据类型 */
-        char *data_type = parser_strdup(lexer_current_value(parser->lexer));
-        lexer_next(parser->lexer);
+        char *data_type = NULL;
+        if (lexer_current_type(parser->lexer) == TOK_DECIMAL) {
+            /* decimal(p,s) / decimal(p)，规范化为 "decimal(p,s)" */
+            lexer_next(parser->lexer);
+            data_type = parser_parse_decimal_spec(parser);
+            if (!data_type) {
+                free(field_name);
+                return NULL;
+            }
+        } else {
+            data_type = parser_strdup(lexer_current_value(parser->lexer));
+            lexer_next(parser->lexer);
+        }
         
         /* 约束（可选） */
         char *constraint = NULL;
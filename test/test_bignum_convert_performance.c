@@ -0,0 +1,169 @@
+/*
+ * BHS 十进制解析/格式化性能测试
+ *
+ * 对比逐字符的旧实现与 bignum_from_string_legacy / bignum_to_string
+ * （SIMD 校验、8 位一组的 SWAR 解析与 SSE2 格式化）在 10、100、10000 位输入上的耗时，
+ * 并校验两者结果一致。
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -DLOGEX_BUILD -I../src -I../src/lib test_bignum_convert_performance.c \
+ *       ../src/lib/bignum.c ../src/lib/list.c ../src/lib/bitmap.c ../src/lib/roaring.c ../src/lib/hll.c ../src/lib/bitcpy.c -lm -pthread
+ * 加 -mavx2 可启用 AVX2 校验路径
+ */
+#include "../src/lib/bignum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+/* 性能测试工具 */
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ========== 旧实现（逐字符） ========== */
+
+static const bignum_limb_t pow10_table[BIGNUM_LIMB_DIGITS] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u
+};
+
+/* 逐字符解析为 limb 数组，返回 limb 个数，失败返回 0 */
+static size_t old_parse(const char *str, bignum_limb_t *limbs, int *scale) {
+    int len = strlen(str);
+    int pos = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+
+    int decimal_point = -1;
+    for (int i = pos; i < len; i++) {
+        if (str[i] == '.') {
+            decimal_point = i;
+            break;
+        }
+    }
+    *scale = decimal_point >= 0 ? len - decimal_point - 1 : 0;
+
+    size_t idx = 0;
+    int k = 0;
+    bignum_limb_t limb = 0;
+    for (int i = len - 1; i >= pos; i--) {
+        if (i == decimal_point) continue;
+        if (!isdigit((unsigned char)str[i])) return 0;
+        limb += (bignum_limb_t)(str[i] - '0') * pow10_table[k];
+        if (++k == BIGNUM_LIMB_DIGITS) {
+            limbs[idx++] = limb;
+            limb = 0;
+            k = 0;
+        }
+    }
+    if (k > 0) limbs[idx++] = limb;
+    return idx;
+}
+
+/* 逐位取模展开 limb 数组（高位在前，无前导零） */
+static size_t old_format(const bignum_limb_t *limbs, size_t n, char *out) {
+    size_t pos = 0;
+    char tmp[BIGNUM_LIMB_DIGITS];
+    bignum_limb_t top = limbs[n - 1];
+    int t = 0;
+    do {
+        tmp[t++] = (char)('0' + top % 10);
+        top /= 10;
+    } while (top > 0);
+    while (t > 0) out[pos++] = tmp[--t];
+
+    for (size_t i = n - 1; i-- > 0;) {
+        bignum_limb_t v = limbs[i];
+        for (int j = BIGNUM_LIMB_DIGITS - 1; j >= 0; j--) {
+            out[pos + j] = (char)('0' + v % 10);
+            v /= 10;
+        }
+        pos += BIGNUM_LIMB_DIGITS;
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+/* ========== 测试 ========== */
+
+static void test_digits(int digits, int iterations) {
+    printf("\n=== %d 位整数 (%d 次) ===\n", digits, iterations);
+
+    char *input = (char *)malloc(digits + 1);
+    char *output = (char *)malloc(digits + 16);
+    bignum_limb_t *limbs = (bignum_limb_t *)malloc((digits / BIGNUM_LIMB_DIGITS + 2) * sizeof(bignum_limb_t));
+
+    srand(digits);
+    input[0] = (char)('1' + rand() % 9);
+    for (int i = 1; i < digits; i++) input[i] = (char)('0' + rand() % 10);
+    input[digits] = '\0';
+
+    /* 校验新旧实现结果一致 */
+    int scale = 0;
+    size_t n = old_parse(input, limbs, &scale);
+    BHS num;
+    if (bignum_from_string_legacy(input, &num) != BIGNUM_SUCCESS || num.length != n ||
+        memcmp(BIGNUM_LIMBS(&num), limbs, n * sizeof(bignum_limb_t)) != 0) {
+        printf("❌ 解析结果不一致\n");
+        exit(1);
+    }
+    if (bignum_to_string(&num, output, digits + 16, 0) != BIGNUM_SUCCESS || strcmp(output, input) != 0) {
+        printf("❌ 格式化结果不一致\n");
+        exit(1);
+    }
+
+    volatile size_t sink = 0;
+    double start = now_sec();
+    for (int it = 0; it < iterations; it++) {
+        sink += old_parse(input, limbs, &scale);
+    }
+    double old_parse_time = now_sec() - start;
+
+    start = now_sec();
+    for (int it = 0; it < iterations; it++) {
+        BHS tmp;
+        bignum_from_string_legacy(input, &tmp);
+        sink += tmp.length;
+        bignum_free(&tmp);
+    }
+    double new_parse_time = now_sec() - start;
+
+    start = now_sec();
+    for (int it = 0; it < iterations; it++) {
+        sink += old_format(limbs, n, output);
+    }
+    double old_format_time = now_sec() - start;
+
+    start = now_sec();
+    for (int it = 0; it < iterations; it++) {
+        bignum_to_string(&num, output, digits + 16, 0);
+        sink += (size_t)output[0];
+    }
+    double new_format_time = now_sec() - start;
+
+    printf("解析:   旧 %8.1f ns  新 %8.1f ns  (%.2fx)\n",
+           old_parse_time / iterations * 1e9, new_parse_time / iterations * 1e9,
+           old_parse_time / new_parse_time);
+    printf("格式化: 旧 %8.1f ns  新 %8.1f ns  (%.2fx)\n",
+           old_format_time / iterations * 1e9, new_format_time / iterations * 1e9,
+           old_format_time / new_format_time);
+
+    bignum_free(&num);
+    free(limbs);
+    free(output);
+    free(input);
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("  BHS 十进制解析/格式化性能测试\n");
+    printf("===========================================\n");
+
+    test_digits(10, 2000000);
+    test_digits(100, 500000);
+    test_digits(10000, 5000);
+
+    printf("\n===========================================\n");
+    return 0;
+}
@@ -0,0 +1,476 @@
+/*
+ * BHS 微基准测试
+ *
+ * 覆盖 create/destroy、from_string/to_string、add/sub/mul/div/mod/pow、compare
+ * （操作数 1、10、100、1000、10000 位）以及各 BHS 类型的 bignum_copy，
+ * 报告每次操作的耗时（ns/op）与内存分配次数（allocs/op）。
+ * 数字最多 BIGNUM_MAX_DIGITS 位，因此 mul 用两个 digits/2 位的操作数、pow 用 digits/3 位的底数求立方，
+ * 使结果约为 digits 位；div/mod 的除数为 digits/2 位。
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -DLOGEX_BUILD -I../src -I../src/lib test_bignum_performance.c \
+ *       ../src/lib/bignum.c ../src/lib/list.c ../src/lib/bitmap.c ../src/lib/roaring.c ../src/lib/hll.c ../src/lib/bitcpy.c -lm -pthread
+ *
+ * 用法：
+ *   ./a.out                          人类可读的表格
+ *   ./a.out --csv                    机器可读输出：name,digits,ns_per_op,allocs_per_op
+ *   ./a.out --save FILE              把结果写成基线文件（同 --csv 格式）
+ *   ./a.out --baseline FILE          与基线比较，耗时超出容差或分配次数增加即判为退化，退出码 1
+ *                                    （耗时先按 reference 项折算机器快慢）
+ *   ./a.out --tolerance PCT          耗时容差百分比，默认 40
+ *   ./a.out --runs N                 整套测试跑 N 遍，每项取中位数（N <= 16）
+ *   ./a.out --quick                  缩短每项的测量时间（用于冒烟测试）
+ *
+ * 基线见 bignum_perf_baseline.csv（--runs 5 生成）。耗时与机器相关，换机器后请先用 --save 重新生成；
+ * 分配次数与机器无关，可以直接比较。
+ * 分配计数依赖 glibc 的 __libc_malloc，其他平台上 allocs/op 显示为 -
+ */
+#include "../src/lib/bignum.h"
+#include "../src/lib/list.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ========== 分配计数 ========== */
+
+#if defined(__GLIBC__)
+#define BENCH_COUNT_ALLOCS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static size_t alloc_count = 0;
+
+/* 覆盖 malloc 系列，统计程序中的全部分配 */
+void *malloc(size_t size) {
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+#else
+#define BENCH_COUNT_ALLOCS 0
+static size_t alloc_count = 0;
+#endif
+
+/* ========== 计时与结果 ========== */
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define MAX_RESULTS 128
+#define MAX_RUNS 16
+
+typedef struct {
+    char name[32];
+    int digits;             /* 操作数位数，与位数无关的项为 0 */
+    double ns_per_op;       /* 各次运行的中位数 */
+    double allocs_per_op;
+    double samples[MAX_RUNS];
+    int sample_count;
+} bench_result_t;
+
+static bench_result_t results[MAX_RESULTS];
+static int result_count = 0;
+static double target_time = 0.25;  /* 每项正式测量的总秒数 */
+
+/* 操作数 */
+typedef struct {
+    BHS *a;         /* digits 位 */
+    BHS *b;         /* digits 位，与 a 不同 */
+    BHS *d;         /* 除数，约 digits/2 位 */
+    BHS *h1, *h2;   /* 乘数，约 digits/2 位 */
+    BHS *base;      /* 底数，约 digits/3 位 */
+    BHS *e;         /* 指数 3 */
+    const BHS *src; /* bignum_copy 的源 */
+    char *str;      /* a 的十进制串 */
+    char *buf;      /* to_string 的输出缓冲区 */
+    size_t buf_len;
+} bench_ctx_t;
+
+typedef void (*bench_fn)(bench_ctx_t *ctx);
+
+/* 防止结果被优化掉 */
+static volatile size_t sink = 0;
+
+static void consume(BHS *r) {
+    if (r == NULL) {
+        fprintf(stderr, "operation failed\n");
+        exit(2);
+    }
+    sink += r->length;
+    bignum_destroy(r);
+}
+
+static double median(const double *values, int n) {
+    double sorted[MAX_RUNS];
+    memcpy(sorted, values, n * sizeof(double));
+    for (int i = 1; i < n; i++) {
+        double v = sorted[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+/* 单轮计时，返回耗时（秒），*allocs 为本轮的分配次数 */
+static double time_round(bench_fn fn, bench_ctx_t *ctx, long iterations, size_t *allocs) {
+    size_t before = alloc_count;
+    double start = now_sec();
+    for (long i = 0; i < iterations; i++) fn(ctx);
+    double elapsed = now_sec() - start;
+    *allocs = alloc_count - before;
+    return elapsed;
+}
+
+#define BENCH_ROUNDS 5
+
+/*
+ * 先放大迭代次数直到单轮不少于 target_time / BENCH_ROUNDS（同时起预热作用），
+ * 再按该次数跑 BENCH_ROUNDS 轮取最快的一轮，压低调度和频率波动带来的噪声
+ */
+static void run_bench(const char *name, int digits, bench_fn fn, bench_ctx_t *ctx) {
+    double round_time = target_time / BENCH_ROUNDS;
+    long iterations = 1;
+    size_t allocs = 0;
+    for (;;) {
+        double elapsed = time_round(fn, ctx, iterations, &allocs);
+        if (elapsed >= round_time || iterations >= (1L << 30)) break;
+        /* 按已测耗时估算，最多一次放大 16 倍 */
+        long next = elapsed > 0 ? (long)(iterations * (round_time * 1.2 / elapsed)) : iterations * 16;
+        if (next > iterations * 16) next = iterations * 16;
+        if (next <= iterations) next = iterations * 2;
+        iterations = next;
+    }
+
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double elapsed = time_round(fn, ctx, iterations, &allocs);
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+
+    /* 多次运行整套测试时，同一项的样本累积到同一条结果里 */
+    bench_result_t *r = NULL;
+    for (int i = 0; i < result_count; i++) {
+        if (results[i].digits == digits && strcmp(results[i].name, name) == 0) r = &results[i];
+    }
+    if (r == NULL) {
+        if (result_count >= MAX_RESULTS) return;
+        r = &results[result_count++];
+        snprintf(r->name, sizeof(r->name), "%s", name);
+        r->digits = digits;
+        r->sample_count = 0;
+    }
+    if (r->sample_count < MAX_RUNS) r->samples[r->sample_count++] = best / iterations * 1e9;
+    r->ns_per_op = median(r->samples, r->sample_count);
+    r->allocs_per_op = BENCH_COUNT_ALLOCS ? (double)allocs / iterations : -1;
+}
+
+/* ========== 各项操作 ========== */
+
+/* 与 BHS 无关的纯计算负载，用来衡量机器当前的速度 */
+static void op_reference(bench_ctx_t *ctx) {
+    (void)ctx;
+    uint64_t x = sink;
+    for (int i = 0; i < 256; i++) x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    sink = (size_t)x;
+}
+
+static void op_create_destroy(bench_ctx_t *ctx) {
+    (void)ctx;
+    BHS *r = bignum_create();
+    sink += r != NULL;
+    bignum_destroy(r);
+}
+
+static void op_from_string(bench_ctx_t *ctx) { consume(bignum_from_string(ctx->str)); }
+
+static void op_to_string(bench_ctx_t *ctx) {
+    bignum_to_string(ctx->a, ctx->buf, ctx->buf_len, 0);
+    sink += (size_t)ctx->buf[0];
+}
+
+static void op_add(bench_ctx_t *ctx) { consume(bignum_add(ctx->a, ctx->b)); }
+static void op_sub(bench_ctx_t *ctx) { consume(bignum_sub(ctx->a, ctx->b)); }
+static void op_mul(bench_ctx_t *ctx) { consume(bignum_mul(ctx->h1, ctx->h2)); }
+static void op_div(bench_ctx_t *ctx) { consume(bignum_div(ctx->a, ctx->d, 10)); }
+static void op_mod(bench_ctx_t *ctx) { consume(bignum_mod(ctx->a, ctx->d)); }
+static void op_pow(bench_ctx_t *ctx) { consume(bignum_pow(ctx->base, ctx->e, 0)); }
+static void op_compare(bench_ctx_t *ctx) { sink += (size_t)bignum_compare(ctx->a, ctx->b); }
+
+static void op_copy(bench_ctx_t *ctx) {
+    BHS dst;
+    bignum_init(&dst);
+    if (bignum_copy(ctx->src, &dst) != BIGNUM_SUCCESS) {
+        fprintf(stderr, "bignum_copy failed\n");
+        exit(2);
+    }
+    sink += dst.length;
+    bignum_free(&dst);
+}
+
+/* ========== 测试数据 ========== */
+
+/* 首位非零的随机十进制串 */
+static char *random_digits(int digits) {
+    char *s = (char *)malloc(digits + 1);
+    s[0] = (char)('1' + rand() % 9);
+    for (int i = 1; i < digits; i++) s[i] = (char)('0' + rand() % 10);
+    s[digits] = '\0';
+    return s;
+}
+
+static BHS *random_number(int digits) {
+    char *s = random_digits(digits);
+    BHS *r = bignum_from_string(s);
+    free(s);
+    return r;
+}
+
+static void bench_digits(int digits) {
+    char name[32];
+    bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    srand(digits);
+    ctx.str = random_digits(digits);
+    ctx.a = bignum_from_string(ctx.str);
+    ctx.b = random_number(digits);
+    ctx.d = random_number(digits > 1 ? digits / 2 : 1);
+    ctx.h1 = random_number(digits > 1 ? digits / 2 : 1);
+    ctx.h2 = random_number(digits > 1 ? digits / 2 : 1);
+    ctx.base = random_number(digits > 3 ? digits / 3 : 1);
+    ctx.e = bignum_from_string("3");
+    ctx.buf_len = (size_t)digits + 16;
+    ctx.buf = (char *)malloc(ctx.buf_len);
+
+    static const struct {
+        const char *name;
+        bench_fn fn;
+    } ops[] = {
+        {"from_string", op_from_string},
+        {"to_string", op_to_string},
+        {"add", op_add},
+        {"sub", op_sub},
+        {"mul", op_mul},
+        {"div", op_div},
+        {"mod", op_mod},
+        {"pow", op_pow},
+        {"compare", op_compare},
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        snprintf(name, sizeof(name), "%s", ops[i].name);
+        run_bench(name, digits, ops[i].fn, &ctx);
+    }
+
+    free(ctx.buf);
+    free(ctx.str);
+    bignum_destroy(ctx.a);
+    bignum_destroy(ctx.b);
+    bignum_destroy(ctx.d);
+    bignum_destroy(ctx.h1);
+    bignum_destroy(ctx.h2);
+    bignum_destroy(ctx.base);
+    bignum_destroy(ctx.e);
+}
+
+static void bench_copy(void) {
+    bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    srand(1);
+
+    BHS *imm = bignum_from_string("123456789");
+    BHS *number = random_number(1000);
+    char *raw = random_digits(1000);
+    BHS *string = bignum_from_raw_string(raw);
+    BHS *bitmap = bignum_number_to_bitmap(imm);
+    BHS *list = bignum_create_list();
+    LIST *items = (LIST *)bignum_get_list_mutable(list);
+    for (int i = 0; i < 100; i++) list_rpush(items, bignum_from_int64(i));
+
+    const struct {
+        const char *name;
+        const BHS *src;
+    } srcs[] = {
+        {"copy_imm", imm},
+        {"copy_number", number},
+        {"copy_string", string},
+        {"copy_bitmap", bitmap},
+        {"copy_list", list},
+    };
+    for (size_t i = 0; i < sizeof(srcs) / sizeof(srcs[0]); i++) {
+        if (srcs[i].src == NULL) {
+            fprintf(stderr, "%s: failed to build source\n", srcs[i].name);
+            exit(2);
+        }
+        ctx.src = srcs[i].src;
+        run_bench(srcs[i].name, 0, op_copy, &ctx);
+    }
+
+    free(raw);
+    bignum_destroy(imm);
+    bignum_destroy(number);
+    bignum_destroy(string);
+    bignum_destroy(bitmap);
+    bignum_destroy(list);
+}
+
+/* ========== 输出与基线比较 ========== */
+
+static void print_table(void) {
+    printf("%-14s %7s %14s %12s\n", "benchmark", "digits", "ns/op", "allocs/op");
+    for (int i = 0; i < result_count; i++) {
+        const bench_result_t *r = &results[i];
+        if (r->allocs_per_op < 0) {
+            printf("%-14s %7d %14.1f %12s\n", r->name, r->digits, r->ns_per_op, "-");
+        } else {
+            printf("%-14s %7d %14.1f %12.2f\n", r->name, r->digits, r->ns_per_op, r->allocs_per_op);
+        }
+    }
+}
+
+static void write_csv(FILE *out) {
+    fprintf(out, "name,digits,ns_per_op,allocs_per_op\n");
+    for (int i = 0; i < result_count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "%s,%d,%.1f,%.2f\n", r->name, r->digits, r->ns_per_op, r->allocs_per_op);
+    }
+}
+
+/*
+ * 与基线逐项比较，返回退化项数；基线里没有的项只提示不计入
+ * 两边都有 reference 项时，先按其耗时之比折算当前结果，抵消机器整体快慢的差异
+ */
+static int compare_baseline(const char *path, double tolerance) {
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        fprintf(stderr, "cannot open baseline %s\n", path);
+        return -1;
+    }
+
+    int regressions = 0;
+    int matched[MAX_RESULTS] = {0};
+    char line[256];
+    double scale = 1;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        double ns;
+        if (sscanf(line, "reference,0,%lf", &ns) == 1 && ns > 0 && results[0].ns_per_op > 0) {
+            scale = results[0].ns_per_op / ns;
+        }
+    }
+    rewind(in);
+    printf("\nmachine speed factor (reference now / baseline): %.2f\n", scale);
+    printf("%-14s %7s %12s %12s %8s %10s %10s\n", "benchmark", "digits", "base ns", "now ns", "delta", "base alloc", "now alloc");
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char name[32];
+        int digits;
+        double ns, allocs;
+        if (line[0] == '#' || sscanf(line, "%31[^,],%d,%lf,%lf", name, &digits, &ns, &allocs) != 4) continue;
+
+        for (int i = 0; i < result_count; i++) {
+            const bench_result_t *r = &results[i];
+            if (r->digits != digits || strcmp(r->name, name) != 0) continue;
+            matched[i] = 1;
+
+            double now_ns = r->ns_per_op / scale;
+            double delta = ns > 0 ? (now_ns - ns) / ns * 100 : 0;
+            int slow = delta > tolerance;
+            /* 分配次数是确定的，只要变多就算退化（留一点舍入余量） */
+            int more_allocs = allocs >= 0 && r->allocs_per_op >= 0 && r->allocs_per_op > allocs + 0.01;
+            printf("%-14s %7d %12.1f %12.1f %+7.1f%% %10.2f %10.2f%s\n", name, digits, ns, now_ns, delta,
+                   allocs, r->allocs_per_op, slow || more_allocs ? "  <-- REGRESSION" : "");
+            regressions += slow || more_allocs;
+            break;
+        }
+    }
+    fclose(in);
+
+    for (int i = 0; i < result_count; i++) {
+        if (!matched[i]) printf("%-14s %7d  (not in baseline)\n", results[i].name, results[i].digits);
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    int csv = 0;
+    const char *save_path = NULL;
+    const char *baseline_path = NULL;
+    double tolerance = 40;
+    int runs = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = 1;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            target_time = 0.025;
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+            if (runs < 1) runs = 1;
+            if (runs > MAX_RUNS) runs = MAX_RUNS;
+        } else {
+            fprintf(stderr, "usage: %s [--csv] [--quick] [--save FILE] [--baseline FILE] [--tolerance PCT] [--runs N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static const int sizes[] = {1, 10, 100, 1000, 10000};
+    for (int run = 0; run < runs; run++) {
+        run_bench("reference", 0, op_reference, NULL);
+        run_bench("create_destroy", 0, op_create_destroy, NULL);
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) bench_digits(sizes[i]);
+        bench_copy();
+    }
+
+    if (csv) {
+        write_csv(stdout);
+    } else {
+        print_table();
+    }
+
+    if (save_path != NULL) {
+        FILE *out = fopen(save_path, "w");
+        if (out == NULL) {
+            fprintf(stderr, "cannot write %s\n", save_path);
+            return 2;
+        }
+        write_csv(out);
+        fclose(out);
+    }
+
+    if (baseline_path != NULL) {
+        int regressions = compare_baseline(baseline_path, tolerance);
+        if (regressions < 0) return 2;
+        printf("\n%d regression(s) against %s (tolerance %.0f%%)\n", regressions, baseline_path, tolerance);
+        return regressions > 0;
+    }
+    return 0;
+}
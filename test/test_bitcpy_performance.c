@@ -0,0 +1,311 @@
+/*
+ * bitcpy 与位图移位/追加的性能测试
+ *
+ * 对比改为 64 位字拼接之前的逐字节实现（下面的 bitcpy_prev，保持原样）与当前 bitcpy：
+ *   1. 正确性：随机位偏移与长度，与逐位拷贝的结果比较，源缓冲区按需分配，可配合 -fsanitize=address 检查越界读
+ *   2. 吞吐量：不同 (dest_bit, src_bit) 组合拷贝 BENCH_BYTES 字节，与 memcpy 对照
+ *   3. 位图移位：原先的逐位循环、bitmap_bitshl/bitshr（分配新位图）、bitmap_shl/shr_inplace
+ *   4. bitmap_append：被追加位图长度不是 8 的倍数，另一半整体错位拷贝
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -DLOGEX_BUILD -I../src -I../src/lib test_bitcpy_performance.c \
+ *       ../src/lib/bitmap.c ../src/lib/roaring.c ../src/lib/hll.c ../src/lib/bignum.c ../src/lib/list.c ../src/lib/bitcpy.c -lm -pthread
+ *
+ * 用法：
+ *   ./a.out            完整测试
+ *   ./a.out --quick    缩小数据量（用于冒烟测试）
+ * 正确性检查失败时退出码为 1
+ */
+#include "../src/lib/bitmap.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t bench_bytes = 32u << 20;   /* 吞吐量测试的拷贝字节数 */
+static uint64_t bench_bits = 64u << 20;    /* 移位与追加测试的位图位数 */
+static int bench_rounds = 20;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ========== 改动前的 bitcpy（逐字节拼接，非对齐时每 8 字节读 9 字节） ========== */
+
+static void bitcpy_prev(uint8_t* dest, uint8_t dest_bit, const uint8_t* src, uint8_t src_bit, uint64_t len) {
+    if (len == 0) return;
+    if ((src_bit | dest_bit) == 0 && (len & 7) == 0) {
+        memcpy(dest, src, len >> 3);
+        return;
+    }
+    static const uint8_t mask_low[8] = {0x00, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F};
+    static const uint8_t mask_high[8]= {0xFF, 0xFE, 0xFC, 0xF8, 0xF0, 0xE0, 0xC0, 0x80};
+    uint64_t remaining = len;
+
+    if (dest_bit != 0) {
+        uint8_t align_bits = 8 - dest_bit;
+        if (align_bits > remaining) align_bits = (uint8_t)remaining;
+
+        uint16_t src_data = src[0];
+        if (src_bit + align_bits > 8) {
+            src_data |= (uint16_t)src[1] << 8;
+        }
+        src_data >>= src_bit;
+        src_data &= mask_low[align_bits];
+
+        uint8_t write_mask = mask_low[align_bits] << dest_bit;
+        dest[0] = (dest[0] & ~write_mask) |
+                  ((uint8_t)src_data << dest_bit);
+
+        remaining -= align_bits;
+        if (remaining == 0) return;
+
+        dest++;
+        uint8_t src_advance = src_bit + align_bits;
+        src += src_advance >> 3;
+        src_bit = src_advance & 7;
+    }
+
+    while (remaining >= 64) {
+        uint64_t data;
+        if (src_bit == 0) {
+            memcpy(&data, src, 8);
+        } else {
+            if (remaining == 64) break;
+
+            uint64_t part1;
+            memcpy(&part1, src, 8);
+            uint8_t part2 = src[8];
+            data = (part1 >> src_bit) | ((uint64_t)part2 << (64 - src_bit));
+        }
+
+        memcpy(dest, &data, 8);
+
+        dest += 8;
+        src += 8;
+        remaining -= 64;
+    }
+
+    while (remaining >= 8) {
+        uint8_t data;
+        if (src_bit == 0) {
+            data = *src;
+        } else {
+            data = (src[0] >> src_bit) | (src[1] << (8 - src_bit));
+        }
+
+        *dest = data;
+
+        dest++;
+        src++;
+        remaining -= 8;
+    }
+
+    if (remaining > 0) {
+        uint16_t src_data = src[0];
+        if (src_bit + remaining > 8) {
+            src_data |= (uint16_t)src[1] << 8;
+        }
+        src_data >>= src_bit;
+        src_data &= mask_low[remaining];
+
+        dest[0] = (dest[0] & mask_high[remaining]) | (uint8_t)src_data;
+    }
+}
+
+/* ========== 正确性 ========== */
+
+static int get_bit(const uint8_t* p, uint64_t i) {
+    return (p[i >> 3] >> (i & 7)) & 1;
+}
+
+static int check_bitcpy(int iterations) {
+    for (int it = 0; it < iterations; it++) {
+        uint8_t sb = rand() % 8, db = rand() % 8;
+        uint64_t len = it % 4 == 0 ? (uint64_t)(rand() % 200) : (uint64_t)(rand() % 5000);
+        size_t sn = (sb + len + 7) / 8, dn = (db + len + 7) / 8;
+        uint8_t* src = malloc(sn ? sn : 1);
+        uint8_t* dst = malloc(dn ? dn : 1);
+        uint8_t* expect = malloc(dn ? dn : 1);
+        for (size_t i = 0; i < sn; i++) src[i] = (uint8_t)rand();
+        for (size_t i = 0; i < dn; i++) dst[i] = expect[i] = (uint8_t)rand();
+
+        for (uint64_t i = 0; i < len; i++) {
+            uint64_t k = db + i;
+            expect[k >> 3] = (uint8_t)((expect[k >> 3] & ~(1u << (k & 7))) | (get_bit(src, sb + i) << (k & 7)));
+        }
+        bitcpy(dst, db, src, sb, len);
+
+        int ok = memcmp(dst, expect, dn) == 0;
+        free(src);
+        free(dst);
+        free(expect);
+        if (!ok) {
+            printf("bitcpy mismatch: dest_bit=%d src_bit=%d len=%llu\n", db, sb, (unsigned long long)len);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ========== 吞吐量 ========== */
+
+typedef void (*copy_fn)(uint8_t*, uint8_t, const uint8_t*, uint8_t, uint64_t);
+
+static double copy_gbps(copy_fn fn, uint8_t* dst, const uint8_t* src, uint8_t db, uint8_t sb) {
+    uint64_t bits = bench_bytes * 8 - 16;   /* 留出位偏移的余量，长度也不是 8 的倍数 */
+    double best = 1e30;
+    for (int r = 0; r < bench_rounds; r++) {
+        double t = now_sec();
+        fn(dst, db, src, sb, bits);
+        t = now_sec() - t;
+        if (t < best) best = t;
+    }
+    return bench_bytes / best / 1e9;
+}
+
+static void bench_throughput(void) {
+    static const uint8_t cfg[][2] = {{0, 0}, {3, 3}, {3, 0}, {0, 5}, {3, 5}, {7, 1}};
+    uint8_t* src = malloc(bench_bytes);
+    uint8_t* dst = malloc(bench_bytes);
+    for (uint64_t i = 0; i < bench_bytes; i++) src[i] = (uint8_t)(i * 131 + 7);
+    memset(dst, 0, bench_bytes);
+
+    printf("\n=== bitcpy throughput (%llu MB, GB/s) ===\n", (unsigned long long)(bench_bytes >> 20));
+    printf("%-22s %10s %10s %8s\n", "dest_bit/src_bit", "previous", "current", "speedup");
+    for (size_t c = 0; c < sizeof(cfg) / sizeof(cfg[0]); c++) {
+        double prev = copy_gbps(bitcpy_prev, dst, src, cfg[c][0], cfg[c][1]);
+        double cur = copy_gbps(bitcpy, dst, src, cfg[c][0], cfg[c][1]);
+        printf("%10d / %-9d %10.2f %10.2f %7.2fx\n", cfg[c][0], cfg[c][1], prev, cur, cur / prev);
+    }
+
+    double best = 1e30;
+    for (int r = 0; r < bench_rounds; r++) {
+        double t = now_sec();
+        memcpy(dst, src, bench_bytes);
+        t = now_sec() - t;
+        if (t < best) best = t;
+    }
+    printf("%-22s %10s %10.2f\n", "memcpy", "", bench_bytes / best / 1e9);
+
+    free(src);
+    free(dst);
+}
+
+/* ========== 位图移位与追加 ========== */
+
+/* 平铺编码的位图：seed 为 0 时全 0，否则按 seed 生成随机位（相同 seed 内容相同，数据区各自独占） */
+static BHS* dense_bitmap(uint64_t bits, uint32_t seed) {
+    char* stream = malloc(bits);
+    uint32_t x = seed;
+    for (uint64_t i = 0; i < bits; i++) {
+        x = x * 1103515245u + 12345u;
+        stream[i] = seed && (x >> 16) & 1 ? '1' : '0';
+    }
+    BHS* bm = bitmap_create_from_data(stream, bits, '0');
+    free(stream);
+    return bm;
+}
+
+/* 改动前 bitmap_bitshl/bitshr 的逐位循环 */
+static BHS* shift_bitloop(const BHS* a, uint64_t shift, int left) {
+    uint64_t len = left ? a->length + shift : a->length - shift;
+    BHS* r = dense_bitmap(len, 0);
+    const uint8_t* a_data = (const uint8_t*)(a->is_large ? a->data.large_data : a->data.small_data);
+    uint8_t* r_data = (uint8_t*)(r->is_large ? r->data.large_data : r->data.small_data);
+    uint64_t from = left ? 0 : shift;
+    for (uint64_t i = from; i < a->length; i++) {
+        if ((a_data[i / 8] >> (i % 8)) & 1) {
+            uint64_t pos = left ? i + shift : i - shift;
+            r_data[pos / 8] |= (1 << (pos % 8));
+        }
+    }
+    return r;
+}
+
+static int same_bits(const BHS* a, const BHS* b) {
+    if (a->length != b->length) return 0;
+    for (uint64_t i = 0; i < a->length; i += 4099) {
+        if (bitmap_get(a, i) != bitmap_get(b, i)) return 0;
+    }
+    return bitmap_count(a, 0, a->length - 1) == bitmap_count(b, 0, b->length - 1);
+}
+
+static int bench_shift(void) {
+    const uint64_t shift = 12345;   /* 既不是字节也不是字的整数倍 */
+    BHS* a = dense_bitmap(bench_bits, 1);
+    int ok = 1;
+
+    printf("\n=== bitmap shift (%llu Mbit, shift %llu, ms) ===\n",
+           (unsigned long long)(bench_bits >> 20), (unsigned long long)shift);
+    printf("%-8s %12s %12s %12s\n", "", "bit loop", "bitshl/shr", "in-place");
+    for (int left = 1; left >= 0; left--) {
+        double t = now_sec();
+        BHS* r0 = shift_bitloop(a, shift, left);
+        double t_loop = now_sec() - t;
+
+        t = now_sec();
+        BHS* r1 = left ? bitmap_bitshl(a, shift) : bitmap_bitshr(a, shift);
+        double t_alloc = now_sec() - t;
+
+        /* 数据区独占，原地移位时不触发写时复制 */
+        BHS* r2 = dense_bitmap(bench_bits, 1);
+        t = now_sec();
+        int ret = left ? bitmap_shl_inplace(r2, shift) : bitmap_shr_inplace(r2, shift);
+        double t_inplace = now_sec() - t;
+
+        if (!r1 || ret != 0 || !same_bits(r0, r1) || !same_bits(r0, r2)) {
+            printf("shift %s mismatch\n", left ? "left" : "right");
+            ok = 0;
+        }
+        printf("%-8s %12.2f %12.2f %12.2f\n", left ? "left" : "right",
+               t_loop * 1e3, t_alloc * 1e3, t_inplace * 1e3);
+        free_bitmap(r0);
+        free_bitmap(r1);
+        free_bitmap(r2);
+    }
+
+    free_bitmap(a);
+    return ok;
+}
+
+static int bench_append(void) {
+    BHS* a = dense_bitmap(bench_bits + 3, 1);   /* 追加的一半从第 3 位开始错位 */
+    BHS* b = dense_bitmap(bench_bits, 2);
+    uint64_t expect = bitmap_count(a, 0, a->length - 1) + bitmap_count(b, 0, b->length - 1);
+
+    double t = now_sec();
+    int ret = bitmap_append(a, b);
+    t = now_sec() - t;
+
+    int ok = ret == 0 && a->length == 2 * bench_bits + 3 && bitmap_count(a, 0, a->length - 1) == expect;
+    printf("\n=== bitmap_append (%llu Mbit + %llu Mbit) ===\n",
+           (unsigned long long)(bench_bits >> 20), (unsigned long long)(bench_bits >> 20));
+    printf("%.2f ms%s\n", t * 1e3, ok ? "" : "  (mismatch)");
+
+    free_bitmap(a);
+    free_bitmap(b);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+        bench_bytes = 1u << 20;
+        bench_bits = 4u << 20;
+        bench_rounds = 3;
+    }
+    srand(12345);
+
+    printf("=== bitcpy correctness ===\n");
+    int ok = check_bitcpy(bench_rounds * 5000);
+    printf("%s\n", ok ? "ok" : "FAILED");
+
+    bench_throughput();
+    ok &= bench_shift();
+    ok &= bench_append();
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+/*
+ * getid ID 分配器的并发测试
+ *
+ *   1. 多线程反复分配/释放 SID：同一时刻不会有两个线程拿到同一个 ID
+ *   2. 全部释放后，多线程把 SID 池分配到耗尽：恰好拿到 1..SID_MAX-1 各一次，没有 ID 丢失
+ *   3. 普通用户 UID 同样分配到耗尽，再全部释放、重新分配一遍
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -I../src/lib test_getid_concurrency.c ../src/lib/getid.c -pthread
+ * 可加 -fsanitize=thread 检查数据竞争
+ *
+ * 用法：
+ *   ./a.out            完整测试
+ *   ./a.out --quick    缩小循环次数（用于冒烟测试）
+ * 检查失败时退出码为 1
+ */
+#include "../src/lib/getid.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREADS 8
+#define HOLD 256            /* 每个线程同时持有的 ID 个数 */
+
+static int rounds = 2000;
+static uint8_t *owner;      /* owner[id] 非 0 表示该 ID 正被某个线程持有 */
+static int failed = 0;
+
+static void fail(const char *what, long id) {
+    if (!__atomic_exchange_n(&failed, 1, __ATOMIC_SEQ_CST)) {
+        printf("❌ %s: %ld\n", what, id);
+    }
+}
+
+/* 占用 owner 标记，已被占用说明分配出了重复的 ID */
+static void claim(long id) {
+    if (__atomic_exchange_n(&owner[id], 1, __ATOMIC_SEQ_CST)) fail("重复分配", id);
+}
+
+static void unclaim(long id) {
+    if (!__atomic_exchange_n(&owner[id], 0, __ATOMIC_SEQ_CST)) fail("释放了未持有的 ID", id);
+}
+
+/* 阶段 1：持有 HOLD 个 ID，每轮随机释放一部分再补齐 */
+static void *churn_worker(void *arg) {
+    unsigned seed = (unsigned)(uintptr_t)arg * 2654435761u + 1;
+    SID held[HOLD];
+    int n = 0;
+    
+    for (int r = 0; r < rounds && !failed; r++) {
+        while (n < HOLD) {
+            SID sid = get_sid();
+            if (sid <= 0) {
+                fail("get_sid 失败", sid);
+                break;
+            }
+            claim(sid);
+            held[n++] = sid;
+        }
+        
+        int drop = rand_r(&seed) % HOLD + 1;
+        for (int i = 0; i < drop && n > 0; i++) {
+            int k = rand_r(&seed) % n;
+            SID sid = held[k];
+            held[k] = held[--n];
+            unclaim(sid);
+            if (del_sid(sid) != 0) fail("del_sid 失败", sid);
+        }
+    }
+    
+    for (int i = 0; i < n; i++) {
+        unclaim(held[i]);
+        if (del_sid(held[i]) != 0) fail("del_sid 失败", held[i]);
+    }
+    return NULL;
+}
+
+/* 阶段 2：一直分配到池耗尽，记下拿到的个数 */
+static void *drain_worker(void *arg) {
+    long *count = arg;
+    SID sid;
+    while ((sid = get_sid()) > 0) {
+        claim(sid);
+        (*count)++;
+    }
+    return NULL;
+}
+
+static int run_threads(void *(*fn)(void *), long *counts) {
+    pthread_t th[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        void *arg = counts ? (void *)&counts[i] : (void *)(uintptr_t)i;
+        if (pthread_create(&th[i], NULL, fn, arg) != 0) return -1;
+    }
+    for (int i = 0; i < THREADS; i++) pthread_join(th[i], NULL);
+    return 0;
+}
+
+/* 并发耗尽整个 SID 池，检查 1..SID_MAX-1 每个都恰好拿到一次 */
+static int drain_sid(const char *label) {
+    long counts[THREADS] = {0};
+    memset(owner, 0, SID_MAX);
+    if (run_threads(drain_worker, counts) != 0) return -1;
+    
+    long total = 0;
+    for (int i = 0; i < THREADS; i++) total += counts[i];
+    if (failed) return -1;
+    if (total != SID_MAX - 1 || owner[0]) {
+        printf("❌ %s: 分配到 %ld 个 SID (期望 %d)\n", label, total, SID_MAX - 1);
+        return -1;
+    }
+    printf("✅ %s: %d 个线程共分配 %ld 个 SID，无重复、无遗漏\n", label, THREADS, total);
+    return 0;
+}
+
+static int free_all_sid(void) {
+    for (SID sid = 1; sid < SID_MAX; sid++) {
+        if (del_sid(sid) != 0) {
+            printf("❌ del_sid(%d) 失败\n", sid);
+            return -1;
+        }
+    }
+    if (del_sid(1) == 0) {
+        printf("❌ 重复释放 SID 1 未报错\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* 普通用户 UID 范围 [100, UID_MAX-1]：耗尽、全部释放、再耗尽 */
+static int test_uid(void) {
+    for (int pass = 0; pass < 2; pass++) {
+        long total = 0;
+        UID uid;
+        memset(owner, 0, UID_MAX);
+        while ((uid = get_uid(COMMON_UID)) >= 0) {
+            if (uid < 100 || uid >= UID_MAX || owner[uid]) {
+                printf("❌ get_uid 返回越界或重复的 UID: %d\n", uid);
+                return -1;
+            }
+            owner[uid] = 1;
+            total++;
+        }
+        if (total != UID_MAX - 100) {
+            printf("❌ 第 %d 遍分配到 %ld 个 UID (期望 %d)\n", pass + 1, total, UID_MAX - 100);
+            return -1;
+        }
+        for (uid = 100; uid < UID_MAX; uid++) {
+            if (del_uid(COMMON_UID, uid) != 0) {
+                printf("❌ del_uid(%d) 失败\n", uid);
+                return -1;
+            }
+        }
+    }
+    printf("✅ 普通用户 UID 两遍分配到耗尽，均为 %d 个\n", UID_MAX - 100);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) rounds = 200;
+    
+    owner = calloc(SID_MAX, 1);
+    if (!owner || idalloc_init() != 0) {
+        printf("❌ 初始化失败\n");
+        return 1;
+    }
+    
+    int ret = 0;
+    
+    if (run_threads(churn_worker, NULL) != 0 || failed) {
+        ret = -1;
+    } else {
+        printf("✅ %d 个线程各 %d 轮分配/释放，同一 ID 从未被两个线程同时持有\n", THREADS, rounds);
+    }
+    
+    /* 阶段 1 结束时全部 ID 已归还，池应当能被完整分配 */
+    if (ret == 0) ret = drain_sid("反复分配/释放之后耗尽");
+    if (ret == 0) ret = free_all_sid();
+    if (ret == 0) ret = drain_sid("全部释放之后再次耗尽");
+    if (ret == 0) ret = test_uid();
+    
+    idalloc_close();
+    free(owner);
+    
+    printf(ret == 0 ? "全部通过\n" : "存在失败\n");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+/*
+ * LIST 写时复制的测试：修改共享列表的一份，另一份保持不变
+ *
+ *   1. list_copy：两份共享块数据，对其中一份执行 push/pop/set/insert/rm/swap/reverse/sort/unique，
+ *      两份都与各自的参照数组比较；元素由 clone/destroy 管理，结束时不能有泄漏或重复释放
+ *   2. 分别修改两份，并覆盖单块的短列表和多块（含块目录）的长列表
+ *   3. BHS 层：bignum_copy 共享同一个 LIST，bignum_get_list_mutable 之后再修改
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -DLOGEX_BUILD -I../src -I../src/lib test_list_cow.c \
+ *       ../src/lib/list.c ../src/lib/bignum.c ../src/lib/bitmap.c ../src/lib/roaring.c \
+ *       ../src/lib/hll.c ../src/lib/filter.c ../src/lib/bitcpy.c -lm -pthread
+ * 可加 -fsanitize=address 检查重复释放
+ *
+ * 检查失败时退出码为 1
+ */
+#include "../src/lib/list.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    OP_LPUSH, OP_RPUSH, OP_LPOP, OP_RPOP, OP_SET, OP_INSERT, OP_RM,
+    OP_SWAP, OP_REVERSE, OP_SORT, OP_UNIQUE, OP_COUNT
+};
+
+static const char *op_names[OP_COUNT] = {
+    "lpush", "rpush", "lpop", "rpop", "set", "insert", "rm_index",
+    "swap", "reverse", "sort", "unique"
+};
+
+static long live = 0;   /* 未销毁的元素个数 */
+
+/* 元素是装着一个整数的堆对象，clone/destroy 计数，用来检查泄漏和重复释放 */
+static Obj box(long v) {
+    long *p = malloc(sizeof(long));
+    *p = v;
+    __atomic_add_fetch(&live, 1, __ATOMIC_RELAXED);
+    return (Obj)p;
+}
+
+static long unbox(Obj o) {
+    return *(long *)o;
+}
+
+static Obj box_clone(Obj o) {
+    return box(unbox(o));
+}
+
+static void box_free(Obj o) {
+    __atomic_sub_fetch(&live, 1, __ATOMIC_RELAXED);
+    free(o);
+}
+
+static int box_cmp(Obj a, Obj b) {
+    return unbox(a) < unbox(b) ? -1 : unbox(a) > unbox(b);
+}
+
+static uint64_t box_hash(Obj o) {
+    return (uint64_t)unbox(o) * 0x9E3779B97F4A7C15ULL;
+}
+
+static int box_eq(Obj a, Obj b) {
+    return unbox(a) == unbox(b);
+}
+
+typedef struct {
+    long *v;
+    size_t n;
+} Ref;
+
+static LIST *build(size_t n, Ref *ref) {
+    LIST *lst = list_create();
+    list_set_elem_ops(lst, box_clone, box_free);
+    ref->v = malloc(sizeof(long) * (n + 8));
+    ref->n = n;
+    for (size_t i = 0; i < n; i++) {
+        long v = (long)((i * 7919) % (n / 2 + 1));   /* 有重复值，unique 才有事可做 */
+        list_rpush(lst, box(v));
+        ref->v[i] = v;
+    }
+    return lst;
+}
+
+static int same(LIST *lst, const Ref *ref, const char *who, const char *op) {
+    if (list_size(lst) != ref->n) {
+        printf("❌ %s 后%s长度为 %zu (期望 %zu)\n", op, who, list_size(lst), ref->n);
+        return -1;
+    }
+    for (size_t i = 0; i < ref->n; i++) {
+        long got = unbox(list_get_index(lst, i));
+        if (got != ref->v[i]) {
+            printf("❌ %s 后%s第 %zu 个元素为 %ld (期望 %ld)\n", op, who, i, got, ref->v[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* 对列表和参照数组执行同一操作 */
+static int apply(LIST *lst, Ref *ref, int op) {
+    size_t n = ref->n, pos = n / 2;
+    switch (op) {
+        case OP_LPUSH:
+            list_lpush(lst, box(-1));
+            memmove(ref->v + 1, ref->v, n * sizeof(long));
+            ref->v[0] = -1;
+            ref->n++;
+            break;
+        case OP_RPUSH:
+            list_rpush(lst, box(-2));
+            ref->v[ref->n++] = -2;
+            break;
+        case OP_LPOP: {
+            Obj o = list_lpop(lst);
+            if (unbox(o) != ref->v[0]) return -1;
+            box_free(o);
+            memmove(ref->v, ref->v + 1, (n - 1) * sizeof(long));
+            ref->n--;
+            break;
+        }
+        case OP_RPOP: {
+            Obj o = list_rpop(lst);
+            if (unbox(o) != ref->v[n - 1]) return -1;
+            box_free(o);
+            ref->n--;
+            break;
+        }
+        case OP_SET:
+            if (list_set_index(lst, pos, box(-3)) != 0) return -1;
+            ref->v[pos] = -3;
+            break;
+        case OP_INSERT:
+            if (list_insert(lst, pos, box(-4)) != 0) return -1;
+            memmove(ref->v + pos + 1, ref->v + pos, (n - pos) * sizeof(long));
+            ref->v[pos] = -4;
+            ref->n++;
+            break;
+        case OP_RM:
+            if (list_rm_index(lst, pos) != 0) return -1;
+            memmove(ref->v + pos, ref->v + pos + 1, (n - pos - 1) * sizeof(long));
+            ref->n--;
+            break;
+        case OP_SWAP: {
+            if (list_swap(lst, 0, n - 1) != 0) return -1;
+            long t = ref->v[0];
+            ref->v[0] = ref->v[n - 1];
+            ref->v[n - 1] = t;
+            break;
+        }
+        case OP_REVERSE:
+            list_reverse(lst);
+            for (size_t i = 0; i < n / 2; i++) {
+                long t = ref->v[i];
+                ref->v[i] = ref->v[n - 1 - i];
+                ref->v[n - 1 - i] = t;
+            }
+            break;
+        case OP_SORT:
+            if (list_sort(lst, box_cmp, 0, 2) != 0) return -1;
+            qsort(ref->v, n, sizeof(long), cmp_long);
+            break;
+        case OP_UNIQUE: {
+            if (list_unique(lst, box_hash, box_eq) != 0) return -1;
+            size_t m = 0;
+            for (size_t i = 0; i < n; i++) {
+                size_t j = 0;
+                while (j < m && ref->v[j] != ref->v[i]) j++;
+                if (j == m) ref->v[m++] = ref->v[i];
+            }
+            ref->n = m;
+            break;
+        }
+    }
+    return 0;
+}
+
+/* 复制一份后修改 which（0 修改副本，1 修改原列表），两份分别与参照比较 */
+static int test_op(size_t n, int op, int which) {
+    Ref ra, rb;
+    LIST *a = build(n, &ra);
+    LIST *b = list_copy(a);
+    rb.v = malloc(sizeof(long) * (n + 8));
+    rb.n = n;
+    memcpy(rb.v, ra.v, n * sizeof(long));
+    
+    int ret = which ? apply(a, &ra, op) : apply(b, &rb, op);
+    if (ret != 0) printf("❌ %s 执行失败 (n=%zu)\n", op_names[op], n);
+    if (ret == 0) ret = same(a, &ra, "原列表", op_names[op]);
+    if (ret == 0) ret = same(b, &rb, "副本", op_names[op]);
+    
+    /* 再修改另一份，之前的修改不能被带过去 */
+    if (ret == 0) ret = which ? apply(b, &rb, OP_SET) : apply(a, &ra, OP_SET);
+    if (ret == 0) ret = same(a, &ra, "原列表", "再次 set");
+    if (ret == 0) ret = same(b, &rb, "副本", "再次 set");
+    
+    free_list(a);
+    free_list(b);
+    free(ra.v);
+    free(rb.v);
+    
+    if (ret == 0 && live != 0) {
+        printf("❌ %s (n=%zu) 之后还有 %ld 个元素未销毁\n", op_names[op], n, live);
+        ret = -1;
+    }
+    live = 0;
+    return ret;
+}
+
+/* BHS 层：bignum_copy 后两个 BHS 共享同一个 LIST，取可修改指针时才分开 */
+static int test_bhs(void) {
+    BHS *x = bignum_create_list();
+    LIST *xl = bignum_get_list_mutable(x);
+    for (int i = 0; i < UINTDEQUE_BLOCK_SIZE * 3; i++) list_rpush(xl, bignum_from_int64(i));
+    
+    BHS y;
+    bignum_init(&y);
+    int ret = bignum_copy(x, &y);
+    if (ret == 0 && bignum_get_list(&y) != bignum_get_list(x)) {
+        printf("❌ bignum_copy 没有共享 LIST\n");
+        ret = -1;
+    }
+    
+    LIST *yl = ret == 0 ? bignum_get_list_mutable(&y) : NULL;
+    if (ret == 0 && (yl == NULL || yl == bignum_get_list(x))) {
+        printf("❌ bignum_get_list_mutable 没有复制出独占的 LIST\n");
+        ret = -1;
+    }
+    if (ret == 0) {
+        list_set_index(yl, 5, bignum_from_int64(-5));
+        list_insert(yl, UINTDEQUE_BLOCK_SIZE, bignum_from_int64(-6));
+        list_rm_index(yl, 0);
+        bignum_destroy((BHS *)list_rpop(yl));
+        list_rpush(yl, bignum_from_int64(-7));
+    }
+    
+    const LIST *orig = bignum_get_list(x);
+    for (int i = 0; ret == 0 && i < UINTDEQUE_BLOCK_SIZE * 3; i++) {
+        if (bignum_to_double((const BHS *)list_get_index(orig, i)) != i) {
+            printf("❌ 修改副本后原 BHS 的第 %d 个元素改变\n", i);
+            ret = -1;
+        }
+    }
+    if (ret == 0 && (list_size(orig) != UINTDEQUE_BLOCK_SIZE * 3 ||
+                     bignum_to_double((const BHS *)list_get_index(yl, 4)) != -5 ||
+                     bignum_to_double((const BHS *)list_get_index(yl, list_size(yl) - 1)) != -7)) {
+        printf("❌ BHS 副本的修改结果不对\n");
+        ret = -1;
+    }
+    
+    bignum_free(&y);
+    bignum_destroy(x);
+    if (ret == 0) printf("✅ BHS 层: 修改 bignum_copy 出的列表，原列表不变\n");
+    return ret;
+}
+
+int main(void) {
+    size_t sizes[] = {
+        20,                                                 /* 单块 */
+        UINTDEQUE_BLOCK_SIZE * 2 + 100,                     /* 多块，没有块目录 */
+        UINTDEQUE_BLOCK_SIZE * (LIST_INDEX_MIN_BLOCKS + 2)  /* 有块目录 */
+    };
+    int ret = 0;
+    
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && ret == 0; s++) {
+        for (int op = 0; op < OP_COUNT && ret == 0; op++) {
+            ret = test_op(sizes[s], op, 0);
+            if (ret == 0) ret = test_op(sizes[s], op, 1);
+        }
+        if (ret == 0) printf("✅ %zu 个元素: 各种修改只影响被修改的一份\n", sizes[s]);
+    }
+    if (ret == 0) ret = test_bhs();
+    
+    printf(ret == 0 ? "全部通过\n" : "存在失败\n");
+    return ret == 0 ? 0 : 1;
+}
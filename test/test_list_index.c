@@ -0,0 +1,247 @@
+/*
+ * LIST 块目录（ListIndex）的正确性测试
+ *
+ * 用一个普通数组作参照，对同一列表随机执行 push/pop/insert/rm_index/set/reverse，
+ * 每步后随机抽查 list_get_index，定期逐个比较全部元素并用范围迭代器再比较一遍：
+ *   1. 从空列表增长到远超 LIST_INDEX_MIN_BLOCKS 个块（建立目录）
+ *   2. 在大列表上随机插入/删除（中间块分裂、合并，目录重建）
+ *   3. 反转后继续随机操作（目录按反转后的位置定位）
+ *   4. 删到少于 LIST_INDEX_MIN_BLOCKS 个块（目录释放），再长回来
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -DLOGEX_BUILD -I../src -I../src/lib test_list_index.c ../src/lib/list.c -pthread
+ *
+ * 用法：
+ *   ./a.out            完整测试
+ *   ./a.out --quick    缩小操作次数（用于冒烟测试）
+ * 检查失败时退出码为 1
+ */
+#include "../src/lib/list.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BIG (UINTDEQUE_BLOCK_SIZE * LIST_INDEX_MIN_BLOCKS * 3)  /* 增长阶段的目标长度 */
+
+static intptr_t *ref;       /* 参照数组 */
+static size_t ref_len = 0;
+static intptr_t next_value = 1;
+static unsigned seed = 12345;
+static int steps = 40000;
+static size_t max_blocks = 0;
+static int saw_index = 0;
+
+static size_t rnd(size_t n) {
+    return n ? (size_t)rand_r(&seed) % n : 0;
+}
+
+static void ref_insert(size_t pos, intptr_t v) {
+    memmove(ref + pos + 1, ref + pos, (ref_len - pos) * sizeof(intptr_t));
+    ref[pos] = v;
+    ref_len++;
+}
+
+static void ref_remove(size_t pos) {
+    memmove(ref + pos, ref + pos + 1, (ref_len - pos - 1) * sizeof(intptr_t));
+    ref_len--;
+}
+
+static void ref_reverse(void) {
+    for (size_t i = 0, j = ref_len; i + 1 < j; i++, j--) {
+        intptr_t t = ref[i];
+        ref[i] = ref[j - 1];
+        ref[j - 1] = t;
+    }
+}
+
+/* 逐个按位置比较，再用迭代器从随机起点比较到末尾 */
+static int check_all(LIST *lst, const char *stage) {
+    if (list_size(lst) != ref_len) {
+        printf("❌ %s: 长度 %zu (期望 %zu)\n", stage, list_size(lst), ref_len);
+        return -1;
+    }
+    for (size_t i = 0; i < ref_len; i++) {
+        if ((intptr_t)list_get_index(lst, i) != ref[i]) {
+            printf("❌ %s: 第 %zu 个元素为 %ld (期望 %ld)\n", stage, i,
+                   (long)(intptr_t)list_get_index(lst, i), (long)ref[i]);
+            return -1;
+        }
+    }
+    
+    ListIter it;
+    size_t pos = rnd(ref_len + 1);
+    if (list_iter_range(lst, pos, ref_len, &it) != 0) {
+        printf("❌ %s: list_iter_range 失败\n", stage);
+        return -1;
+    }
+    Obj *span;
+    size_t n;
+    while ((n = list_iter_next(&it, &span)) > 0) {
+        for (size_t k = 0; k < n; k++, pos++) {
+            intptr_t v = (intptr_t)(it.reversed ? span[n - 1 - k] : span[k]);
+            if (v != ref[pos]) {
+                printf("❌ %s: 迭代到第 %zu 个元素为 %ld (期望 %ld)\n", stage, pos, (long)v, (long)ref[pos]);
+                return -1;
+            }
+        }
+    }
+    if (pos != ref_len) {
+        printf("❌ %s: 迭代结束于 %zu (期望 %zu)\n", stage, pos, ref_len);
+        return -1;
+    }
+    return 0;
+}
+
+/* 随机执行一步，偏向 grow 时插入多于删除 */
+static int random_step(LIST *lst, int grow) {
+    int op = (int)rnd(10);
+    if (ref_len == 0) op = 0;
+    
+    if (op < 3 + grow) {
+        size_t pos = rnd(ref_len + 1);
+        intptr_t v = next_value++;
+        if (list_insert(lst, pos, (Obj)v) != 0) {
+            printf("❌ list_insert(%zu) 失败\n", pos);
+            return -1;
+        }
+        ref_insert(pos, v);
+    } else if (op < 7) {
+        size_t pos = rnd(ref_len);
+        if (list_rm_index(lst, pos) != 0) {
+            printf("❌ list_rm_index(%zu) 失败\n", pos);
+            return -1;
+        }
+        ref_remove(pos);
+    } else if (op == 7) {
+        size_t pos = rnd(ref_len);
+        intptr_t v = next_value++;
+        if (list_set_index(lst, pos, (Obj)v) != 0) {
+            printf("❌ list_set_index(%zu) 失败\n", pos);
+            return -1;
+        }
+        ref[pos] = v;
+    } else if (op == 8) {
+        intptr_t v = next_value++;
+        if (rnd(2)) {
+            list_lpush(lst, (Obj)v);
+            ref_insert(0, v);
+        } else {
+            list_rpush(lst, (Obj)v);
+            ref[ref_len++] = v;
+        }
+    } else {
+        intptr_t want = rnd(2) ? ref[0] : ref[ref_len - 1];
+        Obj got = want == ref[0] ? list_lpop(lst) : list_rpop(lst);
+        if ((intptr_t)got != want) {
+            printf("❌ pop 得到 %ld (期望 %ld)\n", (long)(intptr_t)got, (long)want);
+            return -1;
+        }
+        if (want == ref[0]) ref_remove(0);
+        else ref_len--;
+    }
+    
+    if (lst->nblocks > max_blocks) max_blocks = lst->nblocks;
+    if (lst->index) saw_index = 1;
+    
+    /* 随机抽查几个位置 */
+    for (int k = 0; k < 4 && ref_len > 0; k++) {
+        size_t pos = rnd(ref_len);
+        if ((intptr_t)list_get_index(lst, pos) != ref[pos]) {
+            printf("❌ 第 %zu 个元素为 %ld (期望 %ld)\n", pos,
+                   (long)(intptr_t)list_get_index(lst, pos), (long)ref[pos]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int run_steps(LIST *lst, int count, int grow, const char *stage) {
+    for (int i = 0; i < count; i++) {
+        if (random_step(lst, grow) != 0) return -1;
+        if ((i + 1) % (count / 4) == 0 && check_all(lst, stage) != 0) return -1;
+    }
+    printf("✅ %s: %d 步随机操作，长度 %zu，块数 %zu\n", stage, count, ref_len, lst->nblocks);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--quick") == 0) steps = 4000;
+    
+    ref = malloc(sizeof(intptr_t) * (BIG * 2));
+    LIST *lst = list_create();
+    if (!ref || !lst) {
+        printf("❌ 初始化失败\n");
+        return 1;
+    }
+    
+    int ret = 0;
+    
+    /* 阶段 1：两端交替 push 到 BIG，中间夹杂随机操作 */
+    while (ret == 0 && ref_len < BIG) {
+        intptr_t v = next_value++;
+        if (rnd(2)) {
+            list_rpush(lst, (Obj)v);
+            ref[ref_len++] = v;
+        } else {
+            list_lpush(lst, (Obj)v);
+            ref_insert(0, v);
+        }
+        if (rnd(64) == 0) ret = random_step(lst, 1);
+    }
+    if (ret == 0) ret = check_all(lst, "增长");
+    if (ret == 0 && (!lst->index || lst->nblocks < LIST_INDEX_MIN_BLOCKS)) {
+        printf("❌ 增长到 %zu 个块后没有建立块目录\n", lst->nblocks);
+        ret = -1;
+    }
+    if (ret == 0) printf("✅ 增长: 长度 %zu，块数 %zu，已建立块目录\n", ref_len, lst->nblocks);
+    
+    /* 阶段 2、3：大列表上随机操作，反转后再来一遍 */
+    if (ret == 0) ret = run_steps(lst, steps, 0, "随机插入/删除");
+    if (ret == 0) {
+        list_reverse(lst);
+        ref_reverse();
+        ret = check_all(lst, "反转");
+    }
+    if (ret == 0) ret = run_steps(lst, steps, 0, "反转后随机插入/删除");
+    
+    /* 阶段 4：从中间删到少于 LIST_INDEX_MIN_BLOCKS 个块，再长回来 */
+    while (ret == 0 && lst->nblocks >= LIST_INDEX_MIN_BLOCKS / 2) {
+        size_t pos = rnd(ref_len);
+        if (list_rm_index(lst, pos) != 0) {
+            printf("❌ list_rm_index(%zu) 失败\n", pos);
+            ret = -1;
+            break;
+        }
+        ref_remove(pos);
+    }
+    if (ret == 0) ret = check_all(lst, "缩小");
+    if (ret == 0 && lst->index) {
+        printf("❌ 缩小到 %zu 个块后块目录没有释放\n", lst->nblocks);
+        ret = -1;
+    }
+    if (ret == 0) printf("✅ 缩小: 长度 %zu，块数 %zu，块目录已释放\n", ref_len, lst->nblocks);
+    while (ret == 0 && ref_len < BIG) {
+        intptr_t v = next_value++;
+        size_t pos = rnd(64) == 0 ? rnd(ref_len + 1) : ref_len;
+        if (list_insert(lst, pos, (Obj)v) != 0) {
+            printf("❌ list_insert(%zu) 失败\n", pos);
+            ret = -1;
+            break;
+        }
+        ref_insert(pos, v);
+    }
+    if (ret == 0) ret = check_all(lst, "再次增长");
+    if (ret == 0) printf("✅ 再次增长: 长度 %zu，块数 %zu\n", ref_len, lst->nblocks);
+    
+    if (ret == 0 && !saw_index) {
+        printf("❌ 随机操作期间从未建立块目录（最多 %zu 个块）\n", max_blocks);
+        ret = -1;
+    }
+    
+    free_list(lst);
+    free(ref);
+    
+    printf(ret == 0 ? "全部通过\n" : "存在失败\n");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+/*
+ * TABLE 的 DECIMAL(p,s) 字段存取测试
+ *
+ *   1. 写入再读出：正数、负数、零，多余的小数位截断，各精度的最大/最小值
+ *   2. 超出精度：add_record / set_value / update_record 返回 -1，表不变，传入的 BHS 仍归调用者
+ *   3. 空值与 sum_field
+ * 覆盖 8 字节格子（p <= 18）和 16 字节格子（p > 18，需要 __int128）
+ *
+ * 编译（在 test 目录下）：
+ *   gcc -O2 -std=gnu99 -DLOGEX_BUILD -I../src -I../src/lib test_tblh_decimal.c \
+ *       ../src/lib/tblh.c ../src/lib/decimal.c ../src/lib/bignum.c ../src/lib/list.c ../src/lib/bitmap.c \
+ *       ../src/lib/roaring.c ../src/lib/hll.c ../src/lib/filter.c ../src/lib/bitcpy.c -lm -pthread
+ *
+ * 检查失败时退出码为 1
+ */
+#include "../src/lib/tblh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NFIELDS 4
+
+static int types[NFIELDS] = {
+    FIELD_DECIMAL(10, 2),
+    FIELD_DECIMAL(18, 0),
+    FIELD_DECIMAL(DECIMAL_MAX_PRECISION, 10),
+    FIELD_DECIMAL(5, 5)
+};
+
+typedef struct {
+    int field;
+    const char *input;
+    const char *expect;     /* NULL 表示应当因超出精度被拒绝 */
+} Case;
+
+static const Case cases[] = {
+    {0, "123.45", "123.45"},
+    {0, "-123.45", "-123.45"},
+    {0, "0", "0"},
+    {0, "-0.01", "-0.01"},
+    {0, "1.239", "1.23"},                   /* 多余的小数位截断 */
+    {0, "-1.239", "-1.23"},
+    {0, "99999999.99", "99999999.99"},      /* p=10, s=2 的最大值 */
+    {0, "-99999999.99", "-99999999.99"},
+    {0, "100000000", NULL},
+    {0, "-100000000", NULL},
+    {0, "123456789.5", NULL},
+    {1, "999999999999999999", "999999999999999999"},
+    {1, "-999999999999999999", "-999999999999999999"},
+    {1, "1000000000000000000", NULL},
+    {1, "12.9", "12"},
+#if DECIMAL_MAX_PRECISION == 38
+    {2, "-1234567890123456789012345678.0123456789", "-1234567890123456789012345678.0123456789"},
+    {2, "9999999999999999999999999999.9999999999", "9999999999999999999999999999.9999999999"},
+    {2, "12345678901234567890123456789", NULL},
+#else
+    {2, "-12345678.0123456789", "-12345678.0123456789"},
+    {2, "123456789", NULL},
+#endif
+    {3, "0.12345", "0.12345"},
+    {3, "-0.99999", "-0.99999"},
+    {3, "0.123456", "0.12345"},
+    {3, "1", NULL},
+};
+
+#define NCASES (sizeof(cases) / sizeof(cases[0]))
+
+static TABLE *new_table(void) {
+    mstring *names = malloc(sizeof(mstring) * NFIELDS);
+    char name[16];
+    for (int i = 0; i < NFIELDS; i++) {
+        snprintf(name, sizeof(name), "d%d", i);
+        names[i] = mstr(name);
+    }
+    TABLE *t = create_table(types, names, NFIELDS, mstr("dec"));
+    free(names);
+    return t;
+}
+
+/* 读出 (row, field) 与 expect 比较，expect 为 NULL 时应为空值 */
+static int check_cell(TABLE *t, size_t row, int field, const char *expect, const char *what) {
+    BHS *got = get_value(t, row, field);
+    if (expect == NULL || got == NULL) {
+        if (expect != NULL || got != NULL) {
+            printf("❌ %s: 第 %zu 行字段 %d 应为%s\n", what, row, field, expect ? expect : "空值");
+            bignum_destroy(got);
+            return -1;
+        }
+        return 0;
+    }
+    
+    BHS *want = bignum_from_string(expect);
+    int ret = bignum_compare(got, want) == 0 ? 0 : -1;
+    if (ret != 0) {
+        char buf[128];
+        bignum_to_string(got, buf, sizeof(buf), 20);
+        printf("❌ %s: 第 %zu 行字段 %d 读出 %s (期望 %s)\n", what, row, field, buf, expect);
+    }
+    bignum_destroy(want);
+    bignum_destroy(got);
+    return ret;
+}
+
+/* 每个用例用 add_record 写一行（其他字段为空值），被拒绝的用例不能留下行 */
+static int test_round_trip(TABLE *t, size_t *rows_of_case) {
+    for (size_t c = 0; c < NCASES; c++) {
+        Obj values[NFIELDS] = {NULL};
+        BHS *num = bignum_from_string(cases[c].input);
+        values[cases[c].field] = num;
+        
+        size_t before = get_record_count(t);
+        int ret = add_record(t, values, NFIELDS);
+        if (cases[c].expect == NULL) {
+            if (ret == 0 || get_record_count(t) != before) {
+                printf("❌ %s 写入 DECIMAL 字段 %d 应被拒绝\n", cases[c].input, cases[c].field);
+                return -1;
+            }
+            bignum_destroy(num);   /* 被拒绝时所有权没有转移 */
+            rows_of_case[c] = SIZE_MAX;
+            continue;
+        }
+        if (ret != 0) {
+            printf("❌ %s 写入 DECIMAL 字段 %d 失败\n", cases[c].input, cases[c].field);
+            bignum_destroy(num);
+            return -1;
+        }
+        rows_of_case[c] = before;
+        
+        for (int f = 0; f < NFIELDS; f++) {
+            const char *expect = f == cases[c].field ? cases[c].expect : NULL;
+            if (check_cell(t, before, f, expect, cases[c].input) != 0) return -1;
+        }
+    }
+    printf("✅ add_record/get_value: %zu 个用例（含截断、负数、各精度边界和超出精度）\n", NCASES);
+    return 0;
+}
+
+/* set_value / update_record：超出精度时返回 -1，原值不变 */
+static int test_overwrite(TABLE *t, const size_t *rows_of_case) {
+    size_t row = rows_of_case[0];   /* 字段 0 为 123.45 的那一行 */
+    
+    BHS *ok = bignum_from_string("-7.5");
+    if (set_value(t, row, 0, ok) != 0 || check_cell(t, row, 0, "-7.50", "set_value") != 0) return -1;
+    
+    BHS *big = bignum_from_string("-123456789");
+    if (set_value(t, row, 0, big) == 0) {
+        printf("❌ set_value 写入超出精度的值未报错\n");
+        return -1;
+    }
+    bignum_destroy(big);
+    if (check_cell(t, row, 0, "-7.5", "set_value 失败后") != 0) return -1;
+    
+    /* update_record 要么全部写入，要么一个都不写 */
+    Obj values[NFIELDS] = {
+        bignum_from_string("1.01"),
+        bignum_from_string("-42"),
+        bignum_from_string("3.25"),
+        bignum_from_string("12.5")      /* DECIMAL(5,5) 放不下 */
+    };
+    if (update_record(t, row, values, NFIELDS) == 0) {
+        printf("❌ update_record 含超出精度的值未报错\n");
+        return -1;
+    }
+    if (check_cell(t, row, 0, "-7.5", "update_record 失败后") != 0 ||
+        check_cell(t, row, 1, NULL, "update_record 失败后") != 0) return -1;
+    
+    bignum_destroy(values[3]);
+    values[3] = bignum_from_string("-0.5");
+    if (update_record(t, row, values, NFIELDS) != 0) {
+        printf("❌ update_record 失败\n");
+        return -1;
+    }
+    if (check_cell(t, row, 0, "1.01", "update_record") != 0 ||
+        check_cell(t, row, 1, "-42", "update_record") != 0 ||
+        check_cell(t, row, 2, "3.25", "update_record") != 0 ||
+        check_cell(t, row, 3, "-0.5", "update_record") != 0) return -1;
+    
+    printf("✅ set_value/update_record: 超出精度时返回 -1 且表不变\n");
+    return 0;
+}
+
+/* 字段 0 求和，空值跳过 */
+static int test_sum(TABLE *t) {
+    BHS *sum = sum_field(t, 0);
+    BHS *want = bignum_from_string("0");
+    size_t rows = get_record_count(t);
+    for (size_t r = 0; r < rows; r++) {
+        BHS *v = get_value(t, r, 0);
+        if (v == NULL) continue;
+        BHS *next = bignum_add(want, v);
+        bignum_destroy(want);
+        bignum_destroy(v);
+        want = next;
+    }
+    
+    int ret = sum != NULL && bignum_compare(sum, want) == 0 ? 0 : -1;
+    if (ret != 0) printf("❌ sum_field 结果不对\n");
+    else printf("✅ sum_field: %zu 行中跳过空值求和\n", rows);
+    bignum_destroy(sum);
+    bignum_destroy(want);
+    return ret;
+}
+
+int main(void) {
+    TABLE *t = new_table();
+    if (!t) {
+        printf("❌ create_table 失败\n");
+        return 1;
+    }
+    
+    int bad[] = {FIELD_DECIMAL(0, 0), FIELD_DECIMAL(5, 6), FIELD_DECIMAL(DECIMAL_MAX_PRECISION + 1, 0)};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        mstring name = mstr("x");
+        if (add_field(t, bad[i], name) == 0) {
+            printf("❌ 非法的 DECIMAL(%d,%d) 被接受\n", FIELD_DEC_PRECISION(bad[i]), FIELD_DEC_SCALE(bad[i]));
+            free_table(t);
+            return 1;
+        }
+        free(name);
+    }
+    
+    size_t rows_of_case[NCASES];
+    int ret = test_round_trip(t, rows_of_case);
+    if (ret == 0) ret = test_overwrite(t, rows_of_case);
+    if (ret == 0) ret = test_sum(t);
+    
+    free_table(t);
+    
+    printf(ret == 0 ? "全部通过\n" : "存在失败\n");
+    return ret == 0 ? 0 : 1;
+}